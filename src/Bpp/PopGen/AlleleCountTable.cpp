@@ -0,0 +1,256 @@
+// SPDX-FileCopyrightText: The Bio++ Development Group
+//
+// SPDX-License-Identifier: CECILL-2.1
+
+#include "AlleleCountTable.h"
+#include "PolymorphismMultiGContainer.h"
+
+// From the STL
+#include <algorithm>
+
+using namespace bpp;
+using namespace std;
+
+AlleleCountTable::AlleleCountTable(const GenotypeMatrix& matrix) :
+  nbLoci_(matrix.getNumberOfLoci()),
+  groupIds_(),
+  alleleOffsets_(1, 0),
+  alleleKeys_(),
+  alleleCounts_(),
+  heterozygousCounts_(),
+  nonMissing_(),
+  biAllelic_(),
+  alleleCopies_(),
+  frequencies_(),
+  heterozygousFrequencies_(),
+  homozygosities_()
+{
+  size_t nbInd = matrix.getNumberOfIndividuals();
+  size_t ploidy = matrix.getPloidy();
+  vector<size_t> group = matrix.getGroupIds();
+  init_(group);
+
+  // Flags the allele keys seen at the current locus. Entries are reset
+  // after each locus.
+  vector<bool> seen(GenotypeMatrix::MISSING, false);
+  vector<size_t> keys;
+  for (size_t l = 0; l < nbLoci_; ++l)
+  {
+    const uint16_t* locus = matrix.getLocus(l);
+    keys.clear();
+    for (size_t k = 0; k < nbInd * ploidy; ++k)
+    {
+      if (locus[k] != GenotypeMatrix::MISSING && !seen[locus[k]])
+      {
+        seen[locus[k]] = true;
+        keys.push_back(locus[k]);
+      }
+    }
+    sort(keys.begin(), keys.end());
+    addAlleles_(keys);
+    for (size_t j = 0; j < nbInd; ++j)
+    {
+      count_(matrix, l, j, group[j]);
+    }
+    computeFrequencies_(l);
+
+    for (auto key : keys)
+    {
+      seen[key] = false;
+    }
+  }
+}
+
+/******************************************************************************/
+
+AlleleCountTable::AlleleCountTable(const PolymorphismMultiGContainer& pmgc) :
+  nbLoci_(0),
+  groupIds_(),
+  alleleOffsets_(1, 0),
+  alleleKeys_(),
+  alleleCounts_(),
+  heterozygousCounts_(),
+  nonMissing_(),
+  biAllelic_(),
+  alleleCopies_(),
+  frequencies_(),
+  heterozygousFrequencies_(),
+  homozygosities_()
+{
+  size_t nbInd = pmgc.size();
+  vector<size_t> group(nbInd);
+  for (size_t j = 0; j < nbInd; ++j)
+  {
+    size_t nbLoci = pmgc.multilocusGenotype(j).size();
+    nbLoci_ = j == 0 ? nbLoci : min(nbLoci_, nbLoci);
+    group[j] = pmgc.getGroupId(j);
+  }
+  init_(group);
+
+  vector<size_t> keys;
+  for (size_t l = 0; l < nbLoci_; ++l)
+  {
+    keys.clear();
+    for (size_t j = 0; j < nbInd; ++j)
+    {
+      const MultilocusGenotype& mg = pmgc.multilocusGenotype(j);
+      if (!mg.isMonolocusGenotypeMissing(l))
+      {
+        vector<size_t> alleles = mg.monolocusGenotype(l).getAlleleIndex();
+        keys.insert(keys.end(), alleles.begin(), alleles.end());
+      }
+    }
+    sort(keys.begin(), keys.end());
+    keys.erase(unique(keys.begin(), keys.end()), keys.end());
+    addAlleles_(keys);
+    for (size_t j = 0; j < nbInd; ++j)
+    {
+      const MultilocusGenotype& mg = pmgc.multilocusGenotype(j);
+      if (!mg.isMonolocusGenotypeMissing(l))
+      {
+        vector<size_t> alleles = mg.monolocusGenotype(l).getAlleleIndex();
+        count_(l, alleles.data(), alleles.size(), group[j]);
+      }
+    }
+    computeFrequencies_(l);
+  }
+}
+
+/******************************************************************************/
+
+void AlleleCountTable::recount(
+    const GenotypeMatrix& matrix,
+    const vector<size_t>& loci,
+    const vector<size_t>& individuals)
+{
+  size_t nbGroups = groupIds_.size();
+  for (auto l : loci)
+  {
+    fill(alleleCounts_.data() + alleleOffsets_[l] * nbGroups,
+        alleleCounts_.data() + alleleOffsets_[l + 1] * nbGroups, 0);
+    fill(heterozygousCounts_.data() + alleleOffsets_[l] * nbGroups,
+        heterozygousCounts_.data() + alleleOffsets_[l + 1] * nbGroups, 0);
+    fill(nonMissing_.data() + l * nbGroups,
+        nonMissing_.data() + (l + 1) * nbGroups, 0);
+    fill(biAllelic_.data() + l * nbGroups,
+        biAllelic_.data() + (l + 1) * nbGroups, 0);
+    fill(alleleCopies_.data() + l * nbGroups,
+        alleleCopies_.data() + (l + 1) * nbGroups, 0);
+    for (auto j : individuals)
+    {
+      size_t g = static_cast<size_t>(lower_bound(groupIds_.begin(), groupIds_.end(), matrix.getGroupId(j)) - groupIds_.begin());
+      count_(matrix, l, j, g);
+    }
+    computeFrequencies_(l);
+  }
+}
+
+/******************************************************************************/
+
+vector<size_t> AlleleCountTable::getGroupIndices(const set<size_t>& groupIds) const
+{
+  vector<size_t> indices;
+  for (auto id : groupIds)
+  {
+    auto it = lower_bound(groupIds_.begin(), groupIds_.end(), id);
+    if (it != groupIds_.end() && *it == id)
+      indices.push_back(static_cast<size_t>(it - groupIds_.begin()));
+  }
+  return indices;
+}
+
+/******************************************************************************/
+
+void AlleleCountTable::init_(vector<size_t>& group)
+{
+  groupIds_ = group;
+  sort(groupIds_.begin(), groupIds_.end());
+  groupIds_.erase(unique(groupIds_.begin(), groupIds_.end()), groupIds_.end());
+  for (auto& g : group)
+  {
+    g = static_cast<size_t>(lower_bound(groupIds_.begin(), groupIds_.end(), g) - groupIds_.begin());
+  }
+  size_t nbGroups = groupIds_.size();
+  nonMissing_.assign(nbLoci_ * nbGroups, 0);
+  biAllelic_.assign(nbLoci_ * nbGroups, 0);
+  alleleCopies_.assign(nbLoci_ * nbGroups, 0);
+  homozygosities_.assign(nbLoci_ * nbGroups, 0.);
+}
+
+/******************************************************************************/
+
+void AlleleCountTable::addAlleles_(const vector<size_t>& keys)
+{
+  size_t nbGroups = groupIds_.size();
+  alleleKeys_.insert(alleleKeys_.end(), keys.begin(), keys.end());
+  alleleOffsets_.push_back(alleleOffsets_.back() + keys.size());
+  alleleCounts_.resize(alleleOffsets_.back() * nbGroups, 0);
+  heterozygousCounts_.resize(alleleOffsets_.back() * nbGroups, 0);
+  frequencies_.resize(alleleOffsets_.back() * nbGroups, 0.);
+  heterozygousFrequencies_.resize(alleleOffsets_.back() * nbGroups, 0.);
+}
+
+/******************************************************************************/
+
+template<class Key>
+void AlleleCountTable::count_(size_t locus, const Key* alleles, size_t nbAlleles, size_t group)
+{
+  size_t nbGroups = groupIds_.size();
+  const size_t* first = alleleKeys_.data() + alleleOffsets_[locus];
+  const size_t* last = alleleKeys_.data() + alleleOffsets_[locus + 1];
+  nonMissing_[locus * nbGroups + group]++;
+  // The positions of the first two alleles in the count arrays.
+  size_t positions[2] = {0, 0};
+  for (size_t n = 0; n < nbAlleles; ++n)
+  {
+    size_t a = static_cast<size_t>(lower_bound(first, last, static_cast<size_t>(alleles[n])) - alleleKeys_.data());
+    alleleCounts_[a * nbGroups + group]++;
+    alleleCopies_[locus * nbGroups + group]++;
+    if (n < 2)
+      positions[n] = a;
+  }
+  if (nbAlleles == 2)
+  {
+    biAllelic_[locus * nbGroups + group]++;
+    if (positions[0] != positions[1])
+    {
+      heterozygousCounts_[positions[0] * nbGroups + group]++;
+      heterozygousCounts_[positions[1] * nbGroups + group]++;
+    }
+  }
+}
+
+/******************************************************************************/
+
+void AlleleCountTable::count_(const GenotypeMatrix& matrix, size_t locus, size_t individual, size_t group)
+{
+  const uint16_t* alleles = matrix.getAlleles(locus, individual);
+  if (alleles[0] == GenotypeMatrix::MISSING)
+    return;
+  size_t n = 1;
+  while (n < matrix.getPloidy() && alleles[n] != GenotypeMatrix::MISSING)
+  {
+    n++;
+  }
+  count_(locus, alleles, n, group);
+}
+
+/******************************************************************************/
+
+void AlleleCountTable::computeFrequencies_(size_t locus)
+{
+  size_t nbGroups = groupIds_.size();
+  for (size_t g = 0; g < nbGroups; ++g)
+  {
+    double copies = alleleCopies_[locus * nbGroups + g];
+    double biAllelic = biAllelic_[locus * nbGroups + g];
+    double homozygosity = 0.;
+    for (size_t i = alleleOffsets_[locus] * nbGroups + g; i < alleleOffsets_[locus + 1] * nbGroups; i += nbGroups)
+    {
+      frequencies_[i] = copies > 0. ? alleleCounts_[i] / copies : 0.;
+      heterozygousFrequencies_[i] = biAllelic > 0. ? heterozygousCounts_[i] / biAllelic : 0.;
+      homozygosity += frequencies_[i] * frequencies_[i];
+    }
+    homozygosities_[locus * nbGroups + g] = homozygosity;
+  }
+}
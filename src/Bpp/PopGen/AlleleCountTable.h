@@ -0,0 +1,230 @@
+// SPDX-FileCopyrightText: The Bio++ Development Group
+//
+// SPDX-License-Identifier: CECILL-2.1
+
+#ifndef _ALLELECOUNTTABLE_H_
+#define _ALLELECOUNTTABLE_H_
+
+#include <Bpp/Exceptions.h>
+
+// From the STL
+#include <set>
+#include <vector>
+
+#include "GenotypeMatrix.h"
+
+namespace bpp
+{
+/**
+ * @brief Per-locus and per-group allele counts of a set of genotypes.
+ *
+ * For each locus and each group of individuals, the table stores the
+ * number of copies of each allele, the number of copies of each allele in
+ * heterozygous bi-allelic genotypes, the number of non-missing genotypes
+ * and the number of bi-allelic genotypes. These are the quantities read by
+ * the allele frequency, heterozygosity and F-statistics methods of
+ * MultilocusGenotypeStatistics, which can then sum them over any set of
+ * groups instead of scanning all individuals.
+ *
+ * From these counts, the table also stores, for each locus and each group,
+ * the frequency of each allele, its frequency in bi-allelic genotypes as
+ * part of a heterozygote, and the homozygosity @f$J = \sum_i p_i^2@f$, which
+ * are shared by all the statistics and distances computed from the table.
+ *
+ * The table is built in a single pass over a GenotypeMatrix, or over the
+ * genotypes of a PolymorphismMultiGContainer. Alleles are indexed per
+ * locus, in increasing order of their keys, and only the alleles observed
+ * at a locus are stored. Groups are indexed in increasing
+ * order of their ids. All counts are stored in flat arrays, the counts of
+ * all groups for a (locus, allele) pair being contiguous.
+ *
+ * @see PolymorphismMultiGContainer::getAlleleCountTable
+ */
+class AlleleCountTable
+{
+private:
+  size_t nbLoci_;
+  std::vector<size_t> groupIds_;
+  std::vector<size_t> alleleOffsets_;
+  std::vector<size_t> alleleKeys_;
+  std::vector<unsigned int> alleleCounts_;
+  std::vector<unsigned int> heterozygousCounts_;
+  std::vector<unsigned int> nonMissing_;
+  std::vector<unsigned int> biAllelic_;
+  std::vector<unsigned int> alleleCopies_;
+  std::vector<double> frequencies_;
+  std::vector<double> heterozygousFrequencies_;
+  std::vector<double> homozygosities_;
+
+public:
+  /**
+   * @param matrix The genotypes and group ids to count.
+   */
+  explicit AlleleCountTable(const GenotypeMatrix& matrix);
+
+  /**
+   * @brief Count the genotypes of a container.
+   *
+   * Unlike a GenotypeMatrix, the container may hold genotypes of different
+   * sizes and allele keys of any value. Only the loci present in all
+   * genotypes are counted.
+   *
+   * @param pmgc The genotypes and group ids to count.
+   */
+  explicit AlleleCountTable(const PolymorphismMultiGContainer& pmgc);
+
+  virtual ~AlleleCountTable() {}
+
+public:
+  /**
+   * @brief Count again the genotypes of some individuals at some loci.
+   *
+   * This is used by permutation tests, which count the same alleles many
+   * times with individuals assigned to other groups or alleles carried by
+   * other individuals. The alleles and groups of the table are kept, so the
+   * alleles and group ids of the matrix must be the ones the table was
+   * built from, possibly permuted. The counts of all groups at these loci
+   * are reset, then only the given individuals are counted. No memory is
+   * allocated.
+   *
+   * @param matrix The genotypes and group ids.
+   * @param loci The loci to count.
+   * @param individuals The individuals to count.
+   */
+  void recount(
+      const GenotypeMatrix& matrix,
+      const std::vector<size_t>& loci,
+      const std::vector<size_t>& individuals);
+
+  size_t getNumberOfLoci() const { return nbLoci_; }
+
+  size_t getNumberOfGroups() const { return groupIds_.size(); }
+
+  /**
+   * @return The group ids, in increasing order.
+   */
+  const std::vector<size_t>& getGroupIds() const { return groupIds_; }
+
+  /**
+   * @return The indices of the groups of a set which have individuals.
+   * Other ids are ignored.
+   */
+  std::vector<size_t> getGroupIndices(const std::set<size_t>& groupIds) const;
+
+  /**
+   * @return The number of alleles observed at a locus, in any group.
+   */
+  size_t getNumberOfAlleles(size_t locus) const
+  {
+    return alleleOffsets_[locus + 1] - alleleOffsets_[locus];
+  }
+
+  /**
+   * @return The key of the allele with a given index at a locus.
+   */
+  size_t getAlleleKey(size_t locus, size_t allele) const
+  {
+    return alleleKeys_[alleleOffsets_[locus] + allele];
+  }
+
+  /**
+   * @return The number of copies of an allele in a group.
+   */
+  unsigned int getAlleleCount(size_t locus, size_t allele, size_t group) const
+  {
+    return alleleCounts_[(alleleOffsets_[locus] + allele) * groupIds_.size() + group];
+  }
+
+  /**
+   * @return The number of copies of an allele in heterozygous bi-allelic
+   * genotypes of a group.
+   */
+  unsigned int getHeterozygousCount(size_t locus, size_t allele, size_t group) const
+  {
+    return heterozygousCounts_[(alleleOffsets_[locus] + allele) * groupIds_.size() + group];
+  }
+
+  /**
+   * @return The number of individuals of a group without missing genotype at a locus.
+   */
+  unsigned int getNumberOfNonMissing(size_t locus, size_t group) const
+  {
+    return nonMissing_[locus * groupIds_.size() + group];
+  }
+
+  /**
+   * @return The number of individuals of a group with two alleles at a locus.
+   */
+  unsigned int getNumberOfBiAllelic(size_t locus, size_t group) const
+  {
+    return biAllelic_[locus * groupIds_.size() + group];
+  }
+
+  /**
+   * @return The number of allele copies of a group at a locus.
+   */
+  unsigned int getNumberOfAlleleCopies(size_t locus, size_t group) const
+  {
+    return alleleCopies_[locus * groupIds_.size() + group];
+  }
+
+  /**
+   * @return The frequency of an allele in a group, 0 if the group has no
+   * allele at the locus.
+   */
+  double getAlleleFrequency(size_t locus, size_t allele, size_t group) const
+  {
+    return frequencies_[(alleleOffsets_[locus] + allele) * groupIds_.size() + group];
+  }
+
+  /**
+   * @return The number of copies of an allele in heterozygous bi-allelic
+   * genotypes of a group, divided by the number of bi-allelic genotypes of
+   * the group, 0 if there is none.
+   */
+  double getHeterozygousFrequency(size_t locus, size_t allele, size_t group) const
+  {
+    return heterozygousFrequencies_[(alleleOffsets_[locus] + allele) * groupIds_.size() + group];
+  }
+
+  /**
+   * @return The sum of the squared allele frequencies of a group at a locus.
+   */
+  double getHomozygosity(size_t locus, size_t group) const
+  {
+    return homozygosities_[locus * groupIds_.size() + group];
+  }
+
+private:
+  /**
+   * @brief Set the group ids from the group of each individual, replaced by
+   * its index, and allocate the per-locus counts.
+   */
+  void init_(std::vector<size_t>& group);
+
+  /**
+   * @brief Add the sorted keys of the alleles of the next locus, and
+   * allocate their counts.
+   */
+  void addAlleles_(const std::vector<size_t>& keys);
+
+  /**
+   * @brief Add the genotype of an individual at a locus to the counts of a group.
+   */
+  void count_(const GenotypeMatrix& matrix, size_t locus, size_t individual, size_t group);
+
+  /**
+   * @brief Add a non-missing genotype, given by the keys of its alleles, to
+   * the counts of a group at a locus.
+   */
+  template<class Key>
+  void count_(size_t locus, const Key* alleles, size_t nbAlleles, size_t group);
+
+  /**
+   * @brief Compute the frequencies of all groups at a locus from the counts.
+   */
+  void computeFrequencies_(size_t locus);
+};
+} // end of namespace bpp;
+
+#endif // _ALLELECOUNTTABLE_H_
@@ -0,0 +1,110 @@
+// SPDX-FileCopyrightText: The Bio++ Development Group
+//
+// SPDX-License-Identifier: CECILL-2.1
+
+#include "CoalescentSimulator.h"
+
+using namespace bpp;
+using namespace std;
+
+CoalescentSimulator::CoalescentSimulator(size_t sampleSize) :
+  sampleSize_(sampleSize),
+  lineages_(),
+  branchSizes_(),
+  branchLengths_(),
+  cumulatedLengths_(),
+  nbMutations_()
+{
+  if (sampleSize < 2)
+    throw Exception("CoalescentSimulator: the sample size must be at least 2.");
+  lineages_.reserve(sampleSize);
+  // Branches are stored as one segment per lineage and per coalescent
+  // interval: n + (n - 1) + ... + 2 segments.
+  size_t nbSegments = sampleSize * (sampleSize + 1) / 2 - 1;
+  branchSizes_.reserve(nbSegments);
+  branchLengths_.reserve(nbSegments);
+  cumulatedLengths_.reserve(nbSegments);
+  nbMutations_.reserve(nbSegments);
+}
+
+/******************************************************************************/
+
+void CoalescentSimulator::simulateTheta(double theta, CounterBasedGenerator& generator, SiteCountTable& table)
+{
+  simulateGenealogy_(generator);
+  // Draw the number of mutations on each branch first, to size the table.
+  nbMutations_.assign(branchSizes_.size(), 0);
+  size_t nbSites = 0;
+  for (size_t b = 0; b < branchSizes_.size(); ++b)
+  {
+    double mean = theta * branchLengths_[b] / 2.;
+    if (mean <= 0.)
+      continue;
+    nbMutations_[b] = static_cast<unsigned int>(generator.drawPoisson(mean));
+    nbSites += nbMutations_[b];
+  }
+  table.reset(nbSites, 2, sampleSize_);
+  unsigned int n = static_cast<unsigned int>(sampleSize_);
+  size_t site = 0;
+  for (size_t b = 0; b < branchSizes_.size(); ++b)
+  {
+    for (unsigned int m = 0; m < nbMutations_[b]; ++m)
+    {
+      table.setCount(site, 0, n - branchSizes_[b]);
+      table.setCount(site, 1, branchSizes_[b]);
+      table.setAncestralState(site, 0);
+      site++;
+    }
+  }
+}
+
+/******************************************************************************/
+
+void CoalescentSimulator::simulateSegregatingSites(size_t nbSegregatingSites, CounterBasedGenerator& generator, SiteCountTable& table)
+{
+  simulateGenealogy_(generator);
+  cumulatedLengths_.resize(branchLengths_.size());
+  for (size_t b = 0; b < branchLengths_.size(); ++b)
+  {
+    cumulatedLengths_[b] = (b > 0 ? cumulatedLengths_[b - 1] : 0.) + branchLengths_[b];
+  }
+  table.reset(nbSegregatingSites, 2, sampleSize_);
+  unsigned int n = static_cast<unsigned int>(sampleSize_);
+  for (size_t site = 0; site < nbSegregatingSites; ++site)
+  {
+    unsigned int size = branchSizes_[generator.drawIndex(cumulatedLengths_)];
+    table.setCount(site, 0, n - size);
+    table.setCount(site, 1, size);
+    table.setAncestralState(site, 0);
+  }
+}
+
+/******************************************************************************/
+
+double CoalescentSimulator::simulateGenealogy_(CounterBasedGenerator& generator)
+{
+  lineages_.assign(sampleSize_, 1);
+  branchSizes_.clear();
+  branchLengths_.clear();
+  double total = 0.;
+  for (size_t k = sampleSize_; k > 1; --k)
+  {
+    double kk = static_cast<double>(k);
+    double t = generator.drawExponential(kk * (kk - 1.) / 2.);
+    for (auto size : lineages_)
+    {
+      branchSizes_.push_back(size);
+      branchLengths_.push_back(t);
+    }
+    total += kk * t;
+    // Merge two distinct lineages chosen at random.
+    size_t i = static_cast<size_t>(generator.drawInteger(k));
+    size_t j = static_cast<size_t>(generator.drawInteger(k - 1));
+    if (j >= i)
+      j++;
+    lineages_[i] += lineages_[j];
+    lineages_[j] = lineages_.back();
+    lineages_.pop_back();
+  }
+  return total;
+}
@@ -0,0 +1,95 @@
+// SPDX-FileCopyrightText: The Bio++ Development Group
+//
+// SPDX-License-Identifier: CECILL-2.1
+
+#ifndef _COALESCENTSIMULATOR_H_
+#define _COALESCENTSIMULATOR_H_
+
+#include <Bpp/Exceptions.h>
+
+// From the STL
+#include <vector>
+
+#include "CounterBasedGenerator.h"
+#include "SiteCountTable.h"
+
+namespace bpp
+{
+/**
+ * @brief Simulation of samples under the standard neutral coalescent.
+ *
+ * Genealogies of a sample of n sequences are simulated for a panmictic
+ * population of constant size, without recombination (Kingman 1982). Time is
+ * measured in units of 2N generations, so that while there are k lineages the
+ * time to the next coalescence is exponential with rate k(k-1)/2.
+ * Mutations follow the infinite-sites model: each mutation creates a new
+ * biallelic site, the derived state being carried by all the descendants of
+ * the branch where it occurred.
+ *
+ * Only the number of descendants of each branch is tracked, and the
+ * simulated sites are written directly into a SiteCountTable with two states:
+ * 0 for the ancestral state and 1 for the derived state, the ancestral state of
+ * each site being set to 0. All the buffers are kept between calls, so that
+ * simulating many replicates does not allocate memory.
+ *
+ * @see NeutralityTests
+ */
+class CoalescentSimulator
+{
+private:
+  size_t sampleSize_;
+  std::vector<unsigned int> lineages_;
+  std::vector<unsigned int> branchSizes_;
+  std::vector<double> branchLengths_;
+  std::vector<double> cumulatedLengths_;
+  std::vector<unsigned int> nbMutations_;
+
+public:
+  /**
+   * @param sampleSize The number of sequences in a sample.
+   * @throw Exception if sampleSize is lower than 2.
+   */
+  explicit CoalescentSimulator(size_t sampleSize);
+
+  virtual ~CoalescentSimulator() {}
+
+public:
+  size_t getSampleSize() const { return sampleSize_; }
+
+  /**
+   * @brief Simulate a sample for a given population mutation rate.
+   *
+   * The number of mutations on a branch of length t is Poisson distributed
+   * with mean theta * t / 2, so that the expected number of segregating sites
+   * is theta * a1.
+   *
+   * @param theta The population mutation rate 4Nu of the whole sequence.
+   * @param generator The random number generator to use.
+   * @param table The table where sites are written.
+   */
+  void simulateTheta(double theta, CounterBasedGenerator& generator, SiteCountTable& table);
+
+  /**
+   * @brief Simulate a sample with a given number of segregating sites.
+   *
+   * The S mutations are placed on the branches of the genealogy with
+   * probabilities proportional to their lengths (Hudson 1993).
+   *
+   * @param nbSegregatingSites The number S of segregating sites.
+   * @param generator The random number generator to use.
+   * @param table The table where sites are written.
+   */
+  void simulateSegregatingSites(size_t nbSegregatingSites, CounterBasedGenerator& generator, SiteCountTable& table);
+
+private:
+  /**
+   * @brief Simulate a genealogy and store its branches, as segments
+   * spanning one coalescent interval each.
+   *
+   * @return The total length of the genealogy.
+   */
+  double simulateGenealogy_(CounterBasedGenerator& generator);
+};
+} // end of namespace bpp;
+
+#endif // _COALESCENTSIMULATOR_H_
@@ -0,0 +1,43 @@
+// SPDX-FileCopyrightText: The Bio++ Development Group
+//
+// SPDX-License-Identifier: CECILL-2.1
+
+#include "CodonDifferenceTable.h"
+
+// From the bpp-seq library
+#include <Bpp/Seq/CodonSiteTools.h>
+
+using namespace bpp;
+using namespace std;
+
+CodonDifferenceTable::CodonDifferenceTable(const GeneticCode& gc, bool minchange, double ratio) :
+  gc_(&gc),
+  size_(gc.codonAlphabet().getSize()),
+  sense_(size_, false),
+  differences_(size_ * size_, 0.),
+  synonymousDifferences_(size_ * size_, 0.),
+  synonymousPositions_(size_, 0.),
+  minchange_(minchange),
+  ratio_(ratio)
+{
+  const CodonAlphabet& ca = gc.codonAlphabet();
+  for (size_t i = 0; i < size_; ++i)
+  {
+    sense_[i] = !gc.isStop(static_cast<int>(i));
+  }
+  for (size_t i = 0; i < size_; ++i)
+  {
+    if (!sense_[i])
+      continue;
+    int ci = static_cast<int>(i);
+    synonymousPositions_[i] = CodonSiteTools::numberOfSynonymousPositions(ci, gc, ratio);
+    for (size_t j = 0; j < size_; ++j)
+    {
+      if (!sense_[j] || i == j)
+        continue;
+      int cj = static_cast<int>(j);
+      differences_[i * size_ + j] = static_cast<double>(CodonSiteTools::numberOfDifferences(ci, cj, ca));
+      synonymousDifferences_[i * size_ + j] = CodonSiteTools::numberOfSynonymousDifferences(ci, cj, gc, minchange);
+    }
+  }
+}
@@ -0,0 +1,136 @@
+// SPDX-FileCopyrightText: The Bio++ Development Group
+//
+// SPDX-License-Identifier: CECILL-2.1
+
+#ifndef _CODONDIFFERENCETABLE_H_
+#define _CODONDIFFERENCETABLE_H_
+
+// From the bpp-seq library
+#include <Bpp/Seq/GeneticCode/GeneticCode.h>
+
+// From the STL
+#include <vector>
+
+namespace bpp
+{
+/**
+ * @brief Precomputed comparisons between all pairs of codons.
+ *
+ * For a given genetic code, this class stores the number of nucleotide
+ * differences and the number of synonymous differences between every pair
+ * of sense codons, as well as the number of synonymous positions of every
+ * sense codon (Nei & Gojobori 1986, Mol. Biol. Evol. 3 pp418-426).
+ * All values are computed once with CodonSiteTools at construction, so that
+ * comparing two codons afterwards is a simple lookup in a flat table.
+ *
+ * Stop codons and unresolved states have no entry in the tables: check them
+ * with isSenseCodon() before any lookup.
+ *
+ * The table keeps a reference to the genetic code, which must therefore
+ * outlive it.
+ */
+class CodonDifferenceTable
+{
+private:
+  const GeneticCode* gc_;
+  size_t size_;
+  std::vector<bool> sense_;
+  std::vector<double> differences_;
+  std::vector<double> synonymousDifferences_;
+  std::vector<double> synonymousPositions_;
+  bool minchange_;
+  double ratio_;
+
+public:
+  /**
+   * @brief Build the tables for a genetic code.
+   *
+   * @param gc The genetic code to use.
+   * @param minchange Passed to CodonSiteTools::numberOfSynonymousDifferences:
+   * if true, only the path with the minimum number of non-synonymous changes
+   * is considered.
+   * @param ratio Transition/transversion ratio passed to
+   * CodonSiteTools::numberOfSynonymousPositions.
+   */
+  CodonDifferenceTable(const GeneticCode& gc, bool minchange = false, double ratio = 1.);
+
+  virtual ~CodonDifferenceTable() {}
+
+public:
+  /**
+   * @return The genetic code used to build the tables.
+   */
+  const GeneticCode& getGeneticCode() const { return *gc_; }
+
+  /**
+   * @return The number of codon states in the tables.
+   */
+  size_t getSize() const { return size_; }
+
+  /**
+   * @return True if the state is a resolved codon which is not a stop codon.
+   */
+  bool isSenseCodon(int codon) const
+  {
+    return codon >= 0 && static_cast<size_t>(codon) < size_ && sense_[static_cast<size_t>(codon)];
+  }
+
+  /**
+   * @return The number of nucleotide differences between two sense codons.
+   */
+  double getNumberOfDifferences(int i, int j) const
+  {
+    return differences_[index_(i, j)];
+  }
+
+  /**
+   * @return The number of synonymous differences between two sense codons.
+   */
+  double getNumberOfSynonymousDifferences(int i, int j) const
+  {
+    return synonymousDifferences_[index_(i, j)];
+  }
+
+  /**
+   * @return The number of non-synonymous differences between two sense codons.
+   */
+  double getNumberOfNonSynonymousDifferences(int i, int j) const
+  {
+    return differences_[index_(i, j)] - synonymousDifferences_[index_(i, j)];
+  }
+
+  /**
+   * @return The number of synonymous positions of a sense codon.
+   */
+  double getNumberOfSynonymousPositions(int i) const
+  {
+    return synonymousPositions_[static_cast<size_t>(i)];
+  }
+
+  /**
+   * @return The number of non-synonymous positions of a sense codon.
+   */
+  double getNumberOfNonSynonymousPositions(int i) const
+  {
+    return 3. - synonymousPositions_[static_cast<size_t>(i)];
+  }
+
+  /**
+   * @return The minchange option used to build the table.
+   */
+  bool getMinChange() const { return minchange_; }
+
+  /**
+   * @return The transition/transversion ratio used to build the table.
+   */
+  double getRatio() const { return ratio_; }
+
+private:
+  size_t index_(int i, int j) const
+  {
+    return static_cast<size_t>(i) * size_ + static_cast<size_t>(j);
+  }
+};
+} // end of namespace bpp;
+
+#endif // _CODONDIFFERENCETABLE_H_
@@ -0,0 +1,230 @@
+// SPDX-FileCopyrightText: The Bio++ Development Group
+//
+// SPDX-License-Identifier: CECILL-2.1
+
+#ifndef _COUNTERBASEDGENERATOR_H_
+#define _COUNTERBASEDGENERATOR_H_
+
+// From the STL
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+namespace bpp
+{
+/**
+ * @brief A counter-based pseudo-random number generator.
+ *
+ * The i-th number of the stream (seed, stream) is a pure function of seed,
+ * stream and i: it is obtained by applying the SplitMix64 finalizer
+ * (Steele et al. 2014) to a counter offset by a key derived from the seed and
+ * the stream id. Building a generator is therefore free, and independent
+ * streams can be given to every replicate of a randomised procedure, for
+ * instance CounterBasedGenerator(seed, replicate). Results do not depend on
+ * how replicates are distributed between threads, nor on the order in which
+ * they are computed.
+ *
+ * This class satisfies the requirements of UniformRandomBitGenerator, and
+ * can be used with std::shuffle and the distributions of the standard
+ * library. The algorithms of these are implementation-defined, though, so
+ * the numbers they draw from the same stream differ between standard
+ * libraries. The draw methods of this class are the ones to use where
+ * results are meant to only depend on the seed: drawInteger, drawUniform,
+ * drawIndex and shuffle only use the stream and IEEE arithmetic, and give
+ * the same results on every platform. drawExponential and drawPoisson also
+ * call functions of cmath, which are not always correctly rounded.
+ * A generator must not be shared between threads, but generators of
+ * different streams can be used concurrently.
+ *
+ * It is not suitable for cryptographic use.
+ */
+class CounterBasedGenerator
+{
+public:
+  typedef uint64_t result_type;
+
+private:
+  uint64_t key_;
+  uint64_t counter_;
+
+public:
+  /**
+   * @param seed The seed of the generator.
+   * @param stream The id of the stream, e.g. a replicate number.
+   */
+  explicit CounterBasedGenerator(uint64_t seed = 0, uint64_t stream = 0) :
+    key_(mix_(mix_(seed) ^ (stream * 0xD1B54A32D192ED03ULL + 0x8CB92BA72F3D8DD7ULL))),
+    counter_(0)
+  {}
+
+public:
+  static constexpr result_type min() { return 0; }
+
+  static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+
+  result_type operator()()
+  {
+    return mix_(key_ + (++counter_) * 0x9E3779B97F4A7C15ULL);
+  }
+
+  /**
+   * @brief Skip the next n numbers of the stream.
+   */
+  void discard(uint64_t n) { counter_ += n; }
+
+  /**
+   * @return The number of values drawn so far.
+   */
+  uint64_t getCounter() const { return counter_; }
+
+  /**
+   * @brief Move to an arbitrary position in the stream.
+   */
+  void setCounter(uint64_t counter) { counter_ = counter; }
+
+  /**
+   * @brief Draw an integer uniformly in [0, n).
+   *
+   * Numbers below @f$2^{64} \bmod n@f$ are rejected, so that all values
+   * are equally likely.
+   *
+   * @param n The number of values, which must be positive.
+   */
+  uint64_t drawInteger(uint64_t n)
+  {
+    uint64_t threshold = (max() - n + 1) % n;
+    uint64_t x;
+    do
+    {
+      x = (*this)();
+    }
+    while (x < threshold);
+    return x % n;
+  }
+
+  /**
+   * @brief Draw a real number uniformly in [0, 1), from the 53 high bits of a number.
+   */
+  double drawUniform()
+  {
+    return static_cast<double>((*this)() >> 11) * (1. / 9007199254740992.);
+  }
+
+  /**
+   * @brief Draw a real number from an exponential distribution, by inversion.
+   *
+   * @param rate The rate of the distribution, which must be positive.
+   */
+  double drawExponential(double rate)
+  {
+    return -std::log1p(-drawUniform()) / rate;
+  }
+
+  /**
+   * @brief Draw an integer from a Poisson distribution.
+   *
+   * Small means use inversion, larger ones the transformed rejection method
+   * of Hörmann (1993).
+   *
+   * @param mean The mean of the distribution, which must not be negative.
+   */
+  uint64_t drawPoisson(double mean)
+  {
+    if (mean < 10.)
+    {
+      double u = drawUniform();
+      double p = std::exp(-mean);
+      double cumulated = p;
+      uint64_t k = 0;
+      while (u >= cumulated && p > 0.)
+      {
+        k++;
+        p *= mean / static_cast<double>(k);
+        cumulated += p;
+      }
+      return k;
+    }
+    double logMean = std::log(mean);
+    double b = 0.931 + 2.53 * std::sqrt(mean);
+    double a = -0.059 + 0.02483 * b;
+    double invAlpha = 1.1239 + 1.1328 / (b - 3.4);
+    double vr = 0.9277 - 3.6224 / (b - 2.);
+    while (true)
+    {
+      double u = drawUniform() - 0.5;
+      double v = drawUniform();
+      double us = 0.5 - std::fabs(u);
+      double k = std::floor((2. * a / us + b) * u + mean + 0.43);
+      if (us >= 0.07 && v <= vr)
+        return static_cast<uint64_t>(k);
+      if (k < 0. || (us < 0.013 && v > us))
+        continue;
+      if (std::log(v) + std::log(invAlpha) - std::log(a / (us * us) + b) <= -mean + k * logMean - logFactorial_(k))
+        return static_cast<uint64_t>(k);
+    }
+  }
+
+  /**
+   * @brief Draw an index with probability proportional to a weight.
+   *
+   * @param cumulatedWeights The cumulated sums of the non-negative weights
+   * of the indices, whose last one must be positive.
+   * @return An index i such that the weight of i is positive.
+   */
+  size_t drawIndex(const std::vector<double>& cumulatedWeights)
+  {
+    double x = drawUniform() * cumulatedWeights.back();
+    size_t i = static_cast<size_t>(std::upper_bound(cumulatedWeights.begin(), cumulatedWeights.end(), x) - cumulatedWeights.begin());
+    // x may be rounded up to the total weight.
+    while (i == cumulatedWeights.size() || (i > 0 && cumulatedWeights[i] == cumulatedWeights[i - 1]))
+    {
+      i--;
+    }
+    return i;
+  }
+
+  /**
+   * @brief Shuffle a range with the Fisher-Yates algorithm.
+   */
+  template<class RandomIt>
+  void shuffle(RandomIt first, RandomIt last)
+  {
+    for (auto n = last - first; n > 1; --n)
+    {
+      using std::swap;
+      swap(first[n - 1], first[static_cast<decltype(n)>(drawInteger(static_cast<uint64_t>(n)))]);
+    }
+  }
+
+private:
+  /**
+   * @return log(k!), from a table for k < 10 and from the Stirling series
+   * otherwise. std::lgamma is not used, as it writes the global signgam and
+   * is therefore not thread-safe.
+   */
+  static double logFactorial_(double k)
+  {
+    static const double table[10] = {
+      0., 0., 0.6931471805599453, 1.791759469228055, 3.1780538303479458,
+      4.787491742782046, 6.579251212010101, 8.525161361065415, 10.60460290274525, 12.801827480081469
+    };
+    if (k < 10.)
+      return table[static_cast<size_t>(k)];
+    double k2 = k * k;
+    return (k + 0.5) * std::log(k) - k + 0.91893853320467274 + (1. / 12. - (1. / 360. - (1. / 1260. - 1. / (1680. * k2)) / k2) / k2) / k;
+  }
+
+  static uint64_t mix_(uint64_t z)
+  {
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+  }
+};
+} // end of namespace bpp;
+
+#endif // _COUNTERBASEDGENERATOR_H_
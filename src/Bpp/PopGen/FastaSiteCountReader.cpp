@@ -0,0 +1,208 @@
+// SPDX-FileCopyrightText: The Bio++ Development Group
+//
+// SPDX-License-Identifier: CECILL-2.1
+
+#include "FastaSiteCountReader.h"
+
+#include <Bpp/Seq/Alphabet/AlphabetTools.h>
+#include <Bpp/Seq/SequenceExceptions.h>
+
+// From the STL
+#include <algorithm>
+#include <cctype>
+#include <limits>
+
+using namespace bpp;
+using namespace std;
+
+namespace
+{
+const int INVALID_STATE = numeric_limits<int>::min();
+}
+
+FastaSiteCountReader::FastaSiteCountReader(
+    const string& path,
+    shared_ptr<const Alphabet> alphabet,
+    size_t chunkSize) :
+  alphabet_(alphabet),
+  chunkSize_(chunkSize),
+  input_(path.c_str(), ios::in | ios::binary),
+  records_(),
+  nbSites_(0),
+  ancestral_(0),
+  position_(0),
+  states_(256, INVALID_STATE),
+  buffer_()
+{
+  if (chunkSize == 0)
+    throw Exception("FastaSiteCountReader: the chunk size must be positive.");
+  if (AlphabetTools::isCodonAlphabet(*alphabet))
+    throw Exception("FastaSiteCountReader: codon alphabets are not supported.");
+  if (!input_)
+    throw IOException("FastaSiteCountReader: fail to open file " + path + ".");
+  for (size_t c = 0; c < states_.size(); ++c)
+  {
+    char ch = static_cast<char>(c);
+    if (isspace(static_cast<int>(c)))
+      continue;
+    try
+    {
+      states_[c] = alphabet_->charToInt(string(1, ch));
+    }
+    catch (Exception&)
+    {
+      try
+      {
+        states_[c] = alphabet_->charToInt(string(1, static_cast<char>(toupper(static_cast<int>(c)))));
+      }
+      catch (Exception&) {}
+    }
+  }
+  index_();
+  ancestral_ = records_.size();
+}
+
+/******************************************************************************/
+
+vector<string> FastaSiteCountReader::getSequenceNames() const
+{
+  vector<string> names;
+  for (size_t j = 0; j < records_.size(); ++j)
+  {
+    if (j != ancestral_)
+      names.push_back(records_[j].name);
+  }
+  return names;
+}
+
+/******************************************************************************/
+
+void FastaSiteCountReader::setAncestralSequence(const string& name)
+{
+  for (size_t j = 0; j < records_.size(); ++j)
+  {
+    if (records_[j].name == name)
+    {
+      ancestral_ = j;
+      return;
+    }
+  }
+  throw SequenceNotFoundException("FastaSiteCountReader::setAncestralSequence.", name);
+}
+
+/******************************************************************************/
+
+bool FastaSiteCountReader::nextChunk(SiteCountTable& table)
+{
+  if (position_ >= nbSites_)
+    return false;
+  size_t nbSites = min(chunkSize_, nbSites_ - position_);
+  size_t nbStates = alphabet_->getSize();
+  table.reset(nbSites, nbStates, getNumberOfSequences());
+  for (size_t j = 0; j < records_.size(); ++j)
+  {
+    read_(records_[j], position_, nbSites);
+    for (size_t i = 0; i < nbSites; ++i)
+    {
+      int state = states_[static_cast<unsigned char>(buffer_[i])];
+      if (state == INVALID_STATE)
+        throw IOException("FastaSiteCountReader::nextChunk: invalid character '" + string(1, buffer_[i]) + "' in sequence " + records_[j].name + ".");
+      if (j != ancestral_)
+        table.addState(i, state);
+      else
+        table.setAncestralState(i, (state >= 0 && static_cast<size_t>(state) < nbStates) ? state : -1);
+    }
+  }
+  position_ += nbSites;
+  return true;
+}
+
+/******************************************************************************/
+
+void FastaSiteCountReader::index_()
+{
+  string line;
+  streamoff offset = 0;
+  size_t length = 0;
+  // True once a line shorter than the others, or a blank line, has been read.
+  bool ended = false;
+  while (getline(input_, line))
+  {
+    size_t bytes = line.size() + 1;
+    if (!line.empty() && line[line.size() - 1] == '\r')
+      line.erase(line.size() - 1);
+    if (!line.empty() && line[0] == '>')
+    {
+      if (!records_.empty())
+      {
+        if (records_.size() == 1)
+          nbSites_ = length;
+        else if (length != nbSites_)
+          throw IOException("FastaSiteCountReader: sequence " + records_.back().name + " does not have the same length as the first one.");
+      }
+      Record_ record;
+      size_t end = line.find_first_of(" \t", 1);
+      record.name = line.substr(1, end == string::npos ? string::npos : end - 1);
+      record.offset = offset + static_cast<streamoff>(bytes);
+      record.lineLength = 0;
+      record.lineBytes = 0;
+      records_.push_back(record);
+      length = 0;
+      ended = false;
+    }
+    else if (!line.empty())
+    {
+      if (records_.empty())
+        throw IOException("FastaSiteCountReader: the file does not start with a sequence header.");
+      Record_& record = records_.back();
+      if (ended)
+        throw IOException("FastaSiteCountReader: the lines of sequence " + record.name + " do not have the same length.");
+      if (record.lineLength == 0)
+      {
+        record.lineLength = line.size();
+        record.lineBytes = bytes;
+      }
+      else if (line.size() > record.lineLength || (line.size() == record.lineLength && bytes != record.lineBytes))
+        throw IOException("FastaSiteCountReader: the lines of sequence " + record.name + " do not have the same length.");
+      if (line.size() < record.lineLength)
+        ended = true;
+      length += line.size();
+    }
+    else
+      ended = true;
+    offset += static_cast<streamoff>(bytes);
+  }
+  if (records_.empty())
+    throw IOException("FastaSiteCountReader: no sequence found.");
+  if (records_.size() == 1)
+    nbSites_ = length;
+  else if (length != nbSites_)
+    throw IOException("FastaSiteCountReader: sequence " + records_.back().name + " does not have the same length as the first one.");
+}
+
+/******************************************************************************/
+
+void FastaSiteCountReader::read_(const Record_& record, size_t start, size_t nbSites)
+{
+  size_t line = start / record.lineLength;
+  size_t column = start % record.lineLength;
+  // Upper bound on the number of bytes spanned, line ends included.
+  size_t nbLines = (column + nbSites) / record.lineLength + 1;
+  size_t span = nbSites + nbLines * (record.lineBytes - record.lineLength);
+  if (buffer_.size() < span)
+    buffer_.resize(span);
+  input_.clear();
+  input_.seekg(record.offset + static_cast<streamoff>(line * record.lineBytes + column));
+  input_.read(&buffer_[0], static_cast<streamsize>(span));
+  size_t nbRead = static_cast<size_t>(input_.gcount());
+  // Remove line ends in place.
+  size_t k = 0;
+  for (size_t i = 0; i < nbRead && k < nbSites; ++i)
+  {
+    char c = buffer_[i];
+    if (c != '\n' && c != '\r')
+      buffer_[k++] = c;
+  }
+  if (k < nbSites)
+    throw IOException("FastaSiteCountReader: unexpected end of file in sequence " + record.name + ".");
+}
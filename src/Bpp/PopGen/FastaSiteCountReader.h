@@ -0,0 +1,113 @@
+// SPDX-FileCopyrightText: The Bio++ Development Group
+//
+// SPDX-License-Identifier: CECILL-2.1
+
+#ifndef _FASTASITECOUNTREADER_H_
+#define _FASTASITECOUNTREADER_H_
+
+#include <Bpp/Exceptions.h>
+#include <Bpp/Seq/Alphabet/Alphabet.h>
+
+// From the STL
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "SiteCountSource.h"
+
+namespace bpp
+{
+/**
+ * @brief Read the site counts of an aligned FASTA file chunk by chunk.
+ *
+ * The file is indexed when the reader is built: the offset of each sequence
+ * is recorded, as in a samtools .fai index, and the sequences are never
+ * loaded. Each chunk is then read by seeking to the corresponding columns in
+ * every sequence, so that memory use is proportional to the chunk size and
+ * not to the length of the alignment.
+ *
+ * As for indexed FASTA files, all the lines of a sequence but the last one
+ * must have the same length. All sequences must have the same length.
+ * Gaps and unresolved characters are counted as missing states.
+ *
+ * An ancestral sequence can be designated with setAncestralSequence: it is
+ * then excluded from the counts, and its resolved states are used as the
+ * ancestral states of the sites.
+ */
+class FastaSiteCountReader :
+  public virtual SiteCountSource
+{
+private:
+  struct Record_
+  {
+    std::string name;
+    std::streamoff offset;
+    size_t lineLength;
+    size_t lineBytes;
+  };
+
+  std::shared_ptr<const Alphabet> alphabet_;
+  size_t chunkSize_;
+  std::ifstream input_;
+  std::vector<Record_> records_;
+  size_t nbSites_;
+  size_t ancestral_;
+  size_t position_;
+  std::vector<int> states_;
+  std::vector<char> buffer_;
+
+public:
+  /**
+   * @param path The path of the FASTA file.
+   * @param alphabet The alphabet of the sequences.
+   * @param chunkSize The maximum number of sites in a chunk.
+   * @throw IOException if the file cannot be opened or is not a valid
+   * aligned FASTA file.
+   */
+  FastaSiteCountReader(
+      const std::string& path,
+      std::shared_ptr<const Alphabet> alphabet,
+      size_t chunkSize = 100000);
+
+  virtual ~FastaSiteCountReader() {}
+
+private:
+  FastaSiteCountReader(const FastaSiteCountReader&) = delete;
+  FastaSiteCountReader& operator=(const FastaSiteCountReader&) = delete;
+
+public:
+  size_t getNumberOfSequences() const
+  {
+    return records_.size() - (ancestral_ < records_.size() ? 1 : 0);
+  }
+
+  std::vector<std::string> getSequenceNames() const;
+
+  size_t getNumberOfSites() const { return nbSites_; }
+
+  size_t getChunkSize() const { return chunkSize_; }
+
+  bool nextChunk(SiteCountTable& table);
+
+  void reset() { position_ = 0; }
+
+  /**
+   * @brief Use a sequence of the file as the ancestral sequence.
+   *
+   * @param name The name of the sequence.
+   * @throw SequenceNotFoundException if there is no sequence with this name.
+   */
+  void setAncestralSequence(const std::string& name);
+
+private:
+  void index_();
+
+  /**
+   * @brief Read nbSites states of a record, starting at site start, into buffer_.
+   */
+  void read_(const Record_& record, size_t start, size_t nbSites);
+};
+} // end of namespace bpp;
+
+#endif // _FASTASITECOUNTREADER_H_
@@ -0,0 +1,115 @@
+// SPDX-FileCopyrightText: The Bio++ Development Group
+//
+// SPDX-License-Identifier: CECILL-2.1
+
+#include "GapProfile.h"
+
+// From the STL
+#include <bitset>
+
+using namespace bpp;
+using namespace std;
+
+GapProfile::GapProfile(const PolymorphismSequenceView& view) :
+  nbSites_(view.getNumberOfSites()),
+  gaps_((nbSites_ + 63) / 64, 0),
+  incomplete_((nbSites_ + 63) / 64, 0),
+  gapRanks_(),
+  incompleteRanks_(),
+  begin_(0),
+  end_(0)
+{
+  const PolymorphismSequenceContainer& psc = view.getContainer();
+  const Alphabet& alpha = psc.alphabet();
+  int size = static_cast<int>(alpha.getSize());
+  size_t nbSeq = view.getNumberOfSequences();
+  for (size_t i = 0; i < nbSites_; ++i)
+  {
+    const Site& site = psc.site(view.getSitePosition(i));
+    bool gap = false, incomplete = false;
+    for (size_t j = 0; j < nbSeq && !gap; ++j)
+    {
+      int state = site[view.getSequencePosition(j)];
+      // Resolved states are never gaps.
+      if (state < 0 || state >= size)
+      {
+        incomplete = true;
+        gap = alpha.isGap(state);
+      }
+    }
+    if (gap)
+      gaps_[i / 64] |= 1ULL << (i % 64);
+    if (incomplete)
+      incomplete_[i / 64] |= 1ULL << (i % 64);
+  }
+  init_();
+}
+
+/******************************************************************************/
+
+GapProfile::GapProfile(const PackedAlignment& alignment) :
+  nbSites_(alignment.getNumberOfSites()),
+  gaps_((nbSites_ + 63) / 64, 0),
+  incomplete_((nbSites_ + 63) / 64, 0),
+  gapRanks_(),
+  incompleteRanks_(),
+  begin_(0),
+  end_(0)
+{
+  for (size_t i = 0; i < nbSites_; ++i)
+  {
+    if (alignment.hasGap(i))
+      gaps_[i / 64] |= 1ULL << (i % 64);
+    if (alignment.hasMissingData(i))
+      incomplete_[i / 64] |= 1ULL << (i % 64);
+  }
+  init_();
+}
+
+/******************************************************************************/
+
+void GapProfile::init_()
+{
+  size_t nbWords = gaps_.size();
+  gapRanks_.assign(nbWords + 1, 0);
+  incompleteRanks_.assign(nbWords + 1, 0);
+  for (size_t w = 0; w < nbWords; ++w)
+  {
+    gapRanks_[w + 1] = gapRanks_[w] + bitset<64>(gaps_[w]).count();
+    incompleteRanks_[w + 1] = incompleteRanks_[w] + bitset<64>(incomplete_[w]).count();
+  }
+  begin_ = 0;
+  while (begin_ < nbSites_ && hasGap(begin_))
+  {
+    begin_++;
+  }
+  end_ = nbSites_;
+  while (end_ > begin_ && hasGap(end_ - 1))
+  {
+    end_--;
+  }
+}
+
+/******************************************************************************/
+
+size_t GapProfile::rank_(const vector<uint64_t>& bits, const vector<size_t>& ranks, size_t i)
+{
+  size_t r = ranks[i / 64];
+  if (i % 64 != 0)
+    r += bitset<64>(bits[i / 64] & ((1ULL << (i % 64)) - 1)).count();
+  return r;
+}
+
+/******************************************************************************/
+
+vector<size_t> GapProfile::getClearedBits_(const vector<uint64_t>& bits) const
+{
+  vector<size_t> sites;
+  sites.reserve(nbSites_ - rank_(bits, &bits == &gaps_ ? gapRanks_ : incompleteRanks_, nbSites_));
+  for (size_t i = 0; i < nbSites_; ++i)
+  {
+    if (!((bits[i / 64] >> (i % 64)) & 1))
+      sites.push_back(i);
+  }
+  return sites;
+}
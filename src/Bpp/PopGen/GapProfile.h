@@ -0,0 +1,137 @@
+// SPDX-FileCopyrightText: The Bio++ Development Group
+//
+// SPDX-License-Identifier: CECILL-2.1
+
+#ifndef _GAPPROFILE_H_
+#define _GAPPROFILE_H_
+
+// From the STL
+#include <cstdint>
+#include <vector>
+
+#include "PackedAlignment.h"
+#include "PolymorphismSequenceView.h"
+
+namespace bpp
+{
+/**
+ * @brief Which sites of an alignment have gaps or unresolved states.
+ *
+ * The profile is computed in a single pass over the sites and stored as two
+ * bit sets, one bit per site, with the cumulated number of flagged sites
+ * before each 64-bit word. The status of a site, the number of gap-free or
+ * complete sites in any range of sites and the bounds of the alignment
+ * without flanking gaps are then all answered in constant time.
+ */
+class GapProfile
+{
+private:
+  size_t nbSites_;
+  std::vector<uint64_t> gaps_;
+  std::vector<uint64_t> incomplete_;
+  std::vector<size_t> gapRanks_;
+  std::vector<size_t> incompleteRanks_;
+  size_t begin_;
+  size_t end_;
+
+public:
+  /**
+   * @param view The sequences and sites to profile.
+   */
+  explicit GapProfile(const PolymorphismSequenceView& view);
+
+  /**
+   * @param alignment The alignment to profile. Only the packed masks are read.
+   */
+  explicit GapProfile(const PackedAlignment& alignment);
+
+  virtual ~GapProfile() {}
+
+public:
+  size_t getNumberOfSites() const { return nbSites_; }
+
+  /**
+   * @return True if at least one sequence has a gap at the site.
+   */
+  bool hasGap(size_t site) const
+  {
+    return (gaps_[site / 64] >> (site % 64)) & 1;
+  }
+
+  bool isGapFree(size_t site) const { return !hasGap(site); }
+
+  /**
+   * @return True if all sequences have a resolved state at the site.
+   */
+  bool isComplete(size_t site) const
+  {
+    return !((incomplete_[site / 64] >> (site % 64)) & 1);
+  }
+
+  size_t getNumberOfGapFreeSites() const
+  {
+    return nbSites_ - rank_(gaps_, gapRanks_, nbSites_);
+  }
+
+  size_t getNumberOfCompleteSites() const
+  {
+    return nbSites_ - rank_(incomplete_, incompleteRanks_, nbSites_);
+  }
+
+  /**
+   * @return The number of gap-free sites in [begin, end).
+   */
+  size_t getNumberOfGapFreeSites(size_t begin, size_t end) const
+  {
+    return end - begin - (rank_(gaps_, gapRanks_, end) - rank_(gaps_, gapRanks_, begin));
+  }
+
+  /**
+   * @return The number of complete sites in [begin, end).
+   */
+  size_t getNumberOfCompleteSites(size_t begin, size_t end) const
+  {
+    return end - begin - (rank_(incomplete_, incompleteRanks_, end) - rank_(incomplete_, incompleteRanks_, begin));
+  }
+
+  /**
+   * @return The first site of the alignment without its flanking sites with
+   * gaps, that is, the first gap-free site.
+   */
+  size_t getFlankingGapBegin() const { return begin_; }
+
+  /**
+   * @return One past the last gap-free site. Equal to getFlankingGapBegin()
+   * if all sites have gaps.
+   */
+  size_t getFlankingGapEnd() const { return end_; }
+
+  /**
+   * @return The positions of the gap-free sites.
+   */
+  std::vector<size_t> getGapFreeSites() const
+  {
+    return getClearedBits_(gaps_);
+  }
+
+  /**
+   * @return The positions of the complete sites.
+   */
+  std::vector<size_t> getCompleteSites() const
+  {
+    return getClearedBits_(incomplete_);
+  }
+
+private:
+  void init_();
+
+  /**
+   * @return The number of bits set before position i.
+   */
+  static size_t rank_(const std::vector<uint64_t>& bits, const std::vector<size_t>& ranks, size_t i);
+
+  std::vector<size_t> getClearedBits_(const std::vector<uint64_t>& bits) const;
+};
+} // end of namespace bpp;
+
+#endif // _GAPPROFILE_H_
@@ -0,0 +1,88 @@
+// SPDX-FileCopyrightText: The Bio++ Development Group
+//
+// SPDX-License-Identifier: CECILL-2.1
+
+#include "GenotypeCountTable.h"
+
+// From the STL
+#include <algorithm>
+
+using namespace bpp;
+using namespace std;
+
+GenotypeCountTable::GenotypeCountTable(const GenotypeMatrix& matrix) :
+  nbLoci_(matrix.getNumberOfLoci()),
+  groupIds_(),
+  alleleOffsets_(1, 0),
+  alleleKeys_(),
+  genotypeOffsets_(1, 0),
+  counts_()
+{
+  size_t nbInd = matrix.getNumberOfIndividuals();
+  size_t ploidy = matrix.getPloidy();
+
+  groupIds_ = matrix.getGroupIds();
+  sort(groupIds_.begin(), groupIds_.end());
+  groupIds_.erase(unique(groupIds_.begin(), groupIds_.end()), groupIds_.end());
+  size_t nbGroups = groupIds_.size();
+  vector<size_t> group(nbInd);
+  for (size_t j = 0; j < nbInd; ++j)
+  {
+    group[j] = static_cast<size_t>(lower_bound(groupIds_.begin(), groupIds_.end(), matrix.getGroupId(j)) - groupIds_.begin());
+  }
+
+  // Flags the allele keys seen at the current locus. Entries are reset
+  // after each locus.
+  vector<bool> seen(GenotypeMatrix::MISSING, false);
+  vector<size_t> keys;
+  for (size_t l = 0; l < nbLoci_; ++l)
+  {
+    const uint16_t* locus = matrix.getLocus(l);
+    keys.clear();
+    for (size_t k = 0; k < nbInd * ploidy; ++k)
+    {
+      if (locus[k] != GenotypeMatrix::MISSING && !seen[locus[k]])
+      {
+        seen[locus[k]] = true;
+        keys.push_back(locus[k]);
+      }
+    }
+    sort(keys.begin(), keys.end());
+    alleleKeys_.insert(alleleKeys_.end(), keys.begin(), keys.end());
+    alleleOffsets_.push_back(alleleOffsets_.back() + keys.size());
+    genotypeOffsets_.push_back(genotypeOffsets_.back() + keys.size() * (keys.size() + 1) / 2);
+    counts_.resize(genotypeOffsets_.back() * nbGroups, 0);
+
+    const size_t* first = alleleKeys_.data() + alleleOffsets_[l];
+    const size_t* last = alleleKeys_.data() + alleleOffsets_[l + 1];
+    for (size_t j = 0; j < nbInd; ++j)
+    {
+      const uint16_t* alleles = locus + j * ploidy;
+      if (ploidy < 2 || alleles[0] == GenotypeMatrix::MISSING || alleles[1] == GenotypeMatrix::MISSING
+          || (ploidy > 2 && alleles[2] != GenotypeMatrix::MISSING))
+        continue;
+      size_t a1 = static_cast<size_t>(lower_bound(first, last, alleles[0]) - first);
+      size_t a2 = static_cast<size_t>(lower_bound(first, last, alleles[1]) - first);
+      counts_[(genotypeOffsets_[l] + getGenotypeIndex(a1, a2)) * nbGroups + group[j]]++;
+    }
+
+    for (auto key : keys)
+    {
+      seen[key] = false;
+    }
+  }
+}
+
+/******************************************************************************/
+
+vector<size_t> GenotypeCountTable::getGroupIndices(const set<size_t>& groupIds) const
+{
+  vector<size_t> indices;
+  for (auto id : groupIds)
+  {
+    auto it = lower_bound(groupIds_.begin(), groupIds_.end(), id);
+    if (it != groupIds_.end() && *it == id)
+      indices.push_back(static_cast<size_t>(it - groupIds_.begin()));
+  }
+  return indices;
+}
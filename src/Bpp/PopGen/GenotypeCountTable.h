@@ -0,0 +1,104 @@
+// SPDX-FileCopyrightText: The Bio++ Development Group
+//
+// SPDX-License-Identifier: CECILL-2.1
+
+#ifndef _GENOTYPECOUNTTABLE_H_
+#define _GENOTYPECOUNTTABLE_H_
+
+#include <Bpp/Exceptions.h>
+
+// From the STL
+#include <set>
+#include <vector>
+
+#include "GenotypeMatrix.h"
+
+namespace bpp
+{
+/**
+ * @brief Per-locus and per-group counts of the diploid genotypes of a set of individuals.
+ *
+ * For each locus and each group of individuals, the table stores the number
+ * of individuals carrying each unordered pair of alleles. Only bi-allelic
+ * genotypes are counted: missing genotypes, and genotypes with one or more
+ * than two alleles, are ignored. These are the counts used by the
+ * Hardy-Weinberg tests of MultilocusGenotypeStatistics.
+ *
+ * The table is built in a single pass over a GenotypeMatrix. Alleles are
+ * indexed per locus, in increasing order of their keys, as in
+ * AlleleCountTable, and the genotype made of alleles i and j, with
+ * @f$j \leq i@f$, has index @f$i(i+1)/2+j@f$. Groups are indexed in increasing
+ * order of their ids. All counts are stored in a flat array, the counts of
+ * all groups for a (locus, genotype) pair being contiguous.
+ *
+ * @see PolymorphismMultiGContainer::getGenotypeCountTable
+ */
+class GenotypeCountTable
+{
+private:
+  size_t nbLoci_;
+  std::vector<size_t> groupIds_;
+  std::vector<size_t> alleleOffsets_;
+  std::vector<size_t> alleleKeys_;
+  std::vector<size_t> genotypeOffsets_;
+  std::vector<unsigned int> counts_;
+
+public:
+  /**
+   * @param matrix The genotypes and group ids to count.
+   */
+  explicit GenotypeCountTable(const GenotypeMatrix& matrix);
+
+  virtual ~GenotypeCountTable() {}
+
+public:
+  size_t getNumberOfLoci() const { return nbLoci_; }
+
+  size_t getNumberOfGroups() const { return groupIds_.size(); }
+
+  /**
+   * @return The group ids, in increasing order.
+   */
+  const std::vector<size_t>& getGroupIds() const { return groupIds_; }
+
+  /**
+   * @return The indices of the groups of a set which have individuals.
+   * Other ids are ignored.
+   */
+  std::vector<size_t> getGroupIndices(const std::set<size_t>& groupIds) const;
+
+  /**
+   * @return The number of alleles observed at a locus, in any genotype.
+   */
+  size_t getNumberOfAlleles(size_t locus) const
+  {
+    return alleleOffsets_[locus + 1] - alleleOffsets_[locus];
+  }
+
+  /**
+   * @return The key of the allele with a given index at a locus.
+   */
+  size_t getAlleleKey(size_t locus, size_t allele) const
+  {
+    return alleleKeys_[alleleOffsets_[locus] + allele];
+  }
+
+  /**
+   * @return The index of the genotype made of two alleles, in any order.
+   */
+  static size_t getGenotypeIndex(size_t allele1, size_t allele2)
+  {
+    return allele1 >= allele2 ? allele1 * (allele1 + 1) / 2 + allele2 : allele2 * (allele2 + 1) / 2 + allele1;
+  }
+
+  /**
+   * @return The number of individuals of a group with a given genotype at a locus.
+   */
+  unsigned int getGenotypeCount(size_t locus, size_t allele1, size_t allele2, size_t group) const
+  {
+    return counts_[(genotypeOffsets_[locus] + getGenotypeIndex(allele1, allele2)) * groupIds_.size() + group];
+  }
+};
+} // end of namespace bpp;
+
+#endif // _GENOTYPECOUNTTABLE_H_
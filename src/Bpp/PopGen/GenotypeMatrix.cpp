@@ -0,0 +1,124 @@
+// SPDX-FileCopyrightText: The Bio++ Development Group
+//
+// SPDX-License-Identifier: CECILL-2.1
+
+#include "GenotypeMatrix.h"
+#include "PolymorphismMultiGContainer.h"
+
+// From the STL
+#include <algorithm>
+#include <string>
+
+using namespace bpp;
+using namespace std;
+
+GenotypeMatrix::GenotypeMatrix(size_t nbIndividuals, size_t nbLoci, size_t ploidy) :
+  nbIndividuals_(nbIndividuals),
+  nbLoci_(nbLoci),
+  ploidy_(ploidy),
+  alleles_(nbIndividuals * nbLoci * ploidy, MISSING),
+  groups_(nbIndividuals, 0)
+{
+  if (ploidy == 0)
+    throw BadIntegerException("GenotypeMatrix: ploidy must be > 0.", 0);
+}
+
+/******************************************************************************/
+
+GenotypeMatrix::GenotypeMatrix(const PolymorphismMultiGContainer& pmgc) :
+  nbIndividuals_(pmgc.size()),
+  nbLoci_(pmgc.getNumberOfLoci()),
+  ploidy_(1),
+  alleles_(),
+  groups_(pmgc.size())
+{
+  for (size_t j = 0; j < nbIndividuals_; ++j)
+  {
+    const MultilocusGenotype& mg = pmgc.multilocusGenotype(j);
+    for (size_t l = 0; l < nbLoci_; ++l)
+    {
+      if (!mg.isMonolocusGenotypeMissing(l))
+        ploidy_ = max(ploidy_, mg.monolocusGenotype(l).getAlleleIndex().size());
+    }
+    groups_[j] = pmgc.getGroupId(j);
+  }
+  alleles_.assign(nbIndividuals_ * nbLoci_ * ploidy_, MISSING);
+  for (size_t j = 0; j < nbIndividuals_; ++j)
+  {
+    const MultilocusGenotype& mg = pmgc.multilocusGenotype(j);
+    for (size_t l = 0; l < nbLoci_; ++l)
+    {
+      if (!mg.isMonolocusGenotypeMissing(l))
+        setAlleleKeys(l, j, mg.monolocusGenotype(l).getAlleleIndex());
+    }
+  }
+}
+
+/******************************************************************************/
+
+vector<size_t> GenotypeMatrix::getAlleleKeys(size_t locus, size_t individual) const
+{
+  const uint16_t* alleles = getAlleles(locus, individual);
+  vector<size_t> keys;
+  for (size_t k = 0; k < ploidy_ && alleles[k] != MISSING; ++k)
+  {
+    keys.push_back(alleles[k]);
+  }
+  return keys;
+}
+
+/******************************************************************************/
+
+void GenotypeMatrix::setAlleleKeys(size_t locus, size_t individual, const vector<size_t>& alleleKeys)
+{
+  checkPosition_("GenotypeMatrix::setAlleleKeys", locus, individual);
+  if (alleleKeys.size() > ploidy_)
+    throw BadSizeException("GenotypeMatrix::setAlleleKeys: more alleles than the ploidy.", alleleKeys.size(), ploidy_);
+  for (auto key : alleleKeys)
+  {
+    if (key >= MISSING)
+      throw BadIntegerException("GenotypeMatrix::setAlleleKeys: allele key too large.", static_cast<int>(key));
+  }
+  uint16_t* alleles = getAlleles_(locus, individual);
+  for (size_t k = 0; k < ploidy_; ++k)
+  {
+    alleles[k] = k < alleleKeys.size() ? static_cast<uint16_t>(alleleKeys[k]) : MISSING;
+  }
+}
+
+/******************************************************************************/
+
+void GenotypeMatrix::setMissing(size_t locus, size_t individual)
+{
+  checkPosition_("GenotypeMatrix::setMissing", locus, individual);
+  uint16_t* alleles = getAlleles_(locus, individual);
+  fill(alleles, alleles + ploidy_, MISSING);
+}
+
+/******************************************************************************/
+
+unique_ptr<PolymorphismMultiGContainer> GenotypeMatrix::materialize() const
+{
+  auto pmgc = make_unique<PolymorphismMultiGContainer>();
+  for (size_t j = 0; j < nbIndividuals_; ++j)
+  {
+    auto mg = make_unique<MultilocusGenotype>(nbLoci_);
+    for (size_t l = 0; l < nbLoci_; ++l)
+    {
+      if (!isMissing(l, j))
+        mg->setMonolocusGenotypeByAlleleKey(l, getAlleleKeys(l, j));
+    }
+    pmgc->addMultilocusGenotype(mg, groups_[j]);
+  }
+  return pmgc;
+}
+
+/******************************************************************************/
+
+void GenotypeMatrix::checkPosition_(const char* method, size_t locus, size_t individual) const
+{
+  if (locus >= nbLoci_)
+    throw IndexOutOfBoundsException(string(method) + ": locus out of bounds.", locus, 0, nbLoci_);
+  if (individual >= nbIndividuals_)
+    throw IndexOutOfBoundsException(string(method) + ": individual out of bounds.", individual, 0, nbIndividuals_);
+}
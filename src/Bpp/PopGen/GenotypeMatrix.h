@@ -0,0 +1,163 @@
+// SPDX-FileCopyrightText: The Bio++ Development Group
+//
+// SPDX-License-Identifier: CECILL-2.1
+
+#ifndef _GENOTYPEMATRIX_H_
+#define _GENOTYPEMATRIX_H_
+
+#include <Bpp/Exceptions.h>
+
+// From the STL
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace bpp
+{
+class PolymorphismMultiGContainer;
+
+/**
+ * @brief Dense storage of the genotypes of many individuals at many loci.
+ *
+ * PolymorphismMultiGContainer stores one MultilocusGenotype object per
+ * individual, which holds one MonolocusGenotype object per locus, which
+ * holds a vector of allele keys. This class stores the same allele keys in
+ * a single array of 16-bit codes: loci one after the other, and for each
+ * locus the individuals one after the other, each with ploidy codes. The
+ * genotypes of all individuals at a locus, which are what allele counts
+ * and F-statistics read, are therefore contiguous.
+ *
+ * Missing genotypes have all their codes equal to MISSING. Genotypes with
+ * less alleles than the ploidy (e.g. a MonoAlleleMonolocusGenotype in a
+ * diploid data set) are padded with MISSING after their alleles.
+ *
+ * A matrix can be filled directly, which avoids building the objects of a
+ * PolymorphismMultiGContainer for large data sets, or copied from a
+ * container.
+ *
+ * @see PolymorphismMultiGContainer::getGenotypeMatrix
+ */
+class GenotypeMatrix
+{
+public:
+  /**
+   * @brief The code of missing alleles.
+   */
+  static constexpr uint16_t MISSING = 0xFFFF;
+
+private:
+  size_t nbIndividuals_;
+  size_t nbLoci_;
+  size_t ploidy_;
+  std::vector<uint16_t> alleles_;
+  std::vector<size_t> groups_;
+
+public:
+  /**
+   * @brief Build a matrix with all genotypes missing, in group 0.
+   *
+   * @param nbIndividuals The number of individuals.
+   * @param nbLoci The number of loci.
+   * @param ploidy The maximum number of alleles of a genotype.
+   * @throw BadIntegerException if ploidy is 0.
+   */
+  GenotypeMatrix(size_t nbIndividuals, size_t nbLoci, size_t ploidy);
+
+  /**
+   * @brief Copy the genotypes of a container.
+   *
+   * The ploidy is the largest number of alleles of a genotype.
+   *
+   * @param pmgc The container, whose genotypes must be aligned.
+   * @throw Exception if the genotypes are not aligned.
+   * @throw BadIntegerException if an allele key is too large to be stored.
+   */
+  explicit GenotypeMatrix(const PolymorphismMultiGContainer& pmgc);
+
+  virtual ~GenotypeMatrix() {}
+
+public:
+  size_t getNumberOfIndividuals() const { return nbIndividuals_; }
+
+  size_t getNumberOfLoci() const { return nbLoci_; }
+
+  size_t getPloidy() const { return ploidy_; }
+
+  /**
+   * @return A pointer to the getNumberOfIndividuals() * getPloidy() codes of a locus.
+   */
+  const uint16_t* getLocus(size_t locus) const
+  {
+    return alleles_.data() + locus * nbIndividuals_ * ploidy_;
+  }
+
+  /**
+   * @return A pointer to the codes of a locus, which can be modified in place.
+   */
+  uint16_t* getLocus(size_t locus)
+  {
+    return alleles_.data() + locus * nbIndividuals_ * ploidy_;
+  }
+
+  /**
+   * @return A pointer to the getPloidy() codes of an individual at a locus.
+   */
+  const uint16_t* getAlleles(size_t locus, size_t individual) const
+  {
+    return getLocus(locus) + individual * ploidy_;
+  }
+
+  bool isMissing(size_t locus, size_t individual) const
+  {
+    return getAlleles(locus, individual)[0] == MISSING;
+  }
+
+  /**
+   * @return The allele keys of an individual at a locus, empty if missing.
+   */
+  std::vector<size_t> getAlleleKeys(size_t locus, size_t individual) const;
+
+  /**
+   * @brief Set the alleles of an individual at a locus.
+   *
+   * @param locus The locus.
+   * @param individual The individual.
+   * @param alleleKeys The allele keys, at most getPloidy() of them. The
+   * genotype is missing if there is none.
+   * @throw IndexOutOfBoundsException if locus or individual is out of range.
+   * @throw BadSizeException if there are more alleles than the ploidy.
+   * @throw BadIntegerException if an allele key is too large to be stored.
+   */
+  void setAlleleKeys(size_t locus, size_t individual, const std::vector<size_t>& alleleKeys);
+
+  /**
+   * @brief Set the genotype of an individual at a locus as missing.
+   *
+   * @throw IndexOutOfBoundsException if locus or individual is out of range.
+   */
+  void setMissing(size_t locus, size_t individual);
+
+  size_t getGroupId(size_t individual) const { return groups_[individual]; }
+
+  void setGroupId(size_t individual, size_t groupId) { groups_[individual] = groupId; }
+
+  const std::vector<size_t>& getGroupIds() const { return groups_; }
+
+  /**
+   * @return A container with the same genotypes and groups. Group names
+   * are not stored in the matrix: groups are named after their ids.
+   * @throw Exception if there is no locus.
+   */
+  std::unique_ptr<PolymorphismMultiGContainer> materialize() const;
+
+private:
+  uint16_t* getAlleles_(size_t locus, size_t individual)
+  {
+    return alleles_.data() + (locus * nbIndividuals_ + individual) * ploidy_;
+  }
+
+  void checkPosition_(const char* method, size_t locus, size_t individual) const;
+};
+} // end of namespace bpp;
+
+#endif // _GENOTYPEMATRIX_H_
@@ -0,0 +1,275 @@
+// SPDX-FileCopyrightText: The Bio++ Development Group
+//
+// SPDX-License-Identifier: CECILL-2.1
+
+#include <Bpp/Text/TextTools.h>
+
+#include "GeneralExceptions.h"
+#include "MultiPopulationStatistics.h"
+#include "ParallelTools.h"
+#include "SequenceStatistics.h"
+
+// From the STL
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <map>
+#include <set>
+
+using namespace bpp;
+using namespace std;
+
+double MultiPopulationStatistics::Estimates::getPbs(size_t a, size_t b, size_t c) const
+{
+  double tab = -log(1. - fst(a, b));
+  double tac = -log(1. - fst(a, c));
+  double tbc = -log(1. - fst(b, c));
+  return (tab + tac - tbc) / 2.;
+}
+
+/******************************************************************************/
+
+RowMatrix<double> MultiPopulationStatistics::Estimates::getPbs(size_t a) const
+{
+  size_t nbPop = pi.size();
+  RowMatrix<double> pbs(nbPop, nbPop);
+  for (size_t b = 0; b < nbPop; ++b)
+  {
+    for (size_t c = 0; c < nbPop; ++c)
+    {
+      pbs(b, c) = (b == c || b == a || c == a) ? numeric_limits<double>::quiet_NaN() : getPbs(a, b, c);
+    }
+  }
+  return pbs;
+}
+
+/******************************************************************************/
+
+MultiPopulationStatistics::MultiPopulationStatistics(
+    const PolymorphismSequenceContainer& psc,
+    bool weighted) :
+  MultiPopulationStatistics(psc, getGroupIds_(psc), weighted)
+{}
+
+/******************************************************************************/
+
+MultiPopulationStatistics::MultiPopulationStatistics(
+    const PolymorphismSequenceContainer& psc,
+    const vector<size_t>& groupIds,
+    bool weighted) :
+  groupIds_(groupIds),
+  nbSites_(psc.getNumberOfSites()),
+  counts_(),
+  pi_(groupIds.size())
+{
+  map<size_t, size_t> populations;
+  for (size_t k = 0; k < groupIds_.size(); ++k)
+  {
+    if (!populations.insert(make_pair(groupIds_[k], k)).second)
+      throw Exception("MultiPopulationStatistics: group " + TextTools::toString(groupIds_[k]) + " is given twice.");
+  }
+
+  // Population and weight of each sequence, -1 for the ignored ones.
+  size_t nbSeq = psc.getNumberOfSequences();
+  vector<size_t> population(nbSeq, static_cast<size_t>(-1));
+  vector<unsigned int> weights(nbSeq, 1);
+  vector<size_t> sampleSizes(groupIds_.size(), 0);
+  for (size_t j = 0; j < nbSeq; ++j)
+  {
+    auto it = populations.find(psc.getGroupId(j));
+    if (it == populations.end())
+      continue;
+    population[j] = it->second;
+    if (weighted)
+      weights[j] = psc.getSequenceCount(j);
+    sampleSizes[it->second] += weights[j];
+  }
+
+  size_t nbStates = psc.alphabet().getSize();
+  counts_.reserve(groupIds_.size());
+  for (size_t k = 0; k < groupIds_.size(); ++k)
+  {
+    if (sampleSizes[k] == 0)
+      throw GroupNotFoundException("MultiPopulationStatistics: group without sequence.", groupIds_[k]);
+    counts_.push_back(SiteCountTable(nbSites_, nbStates));
+    counts_.back().reset(nbSites_, nbStates, sampleSizes[k]);
+  }
+
+  // One pass over the sites, each sequence being added to its population.
+  for (size_t i = 0; i < nbSites_; ++i)
+  {
+    const Site& site = psc.site(i);
+    for (size_t j = 0; j < nbSeq; ++j)
+    {
+      if (population[j] != static_cast<size_t>(-1))
+        counts_[population[j]].addState(i, site[j], weights[j]);
+    }
+  }
+
+  for (size_t k = 0; k < groupIds_.size(); ++k)
+  {
+    pi_[k].resize(nbSites_);
+    for (size_t i = 0; i < nbSites_; ++i)
+    {
+      pi_[k][i] = getPi_(counts_[k], i);
+    }
+  }
+}
+
+/******************************************************************************/
+
+MultiPopulationStatistics::Estimates MultiPopulationStatistics::getEstimates(unsigned int nbThreads) const
+{
+  return getEstimates(0, nbSites_, nbThreads);
+}
+
+/******************************************************************************/
+
+MultiPopulationStatistics::Estimates MultiPopulationStatistics::getEstimates(size_t begin, size_t end, unsigned int nbThreads) const
+{
+  if (end > nbSites_)
+    throw IndexOutOfBoundsException("MultiPopulationStatistics::getEstimates: end out of bounds.", end, 0, nbSites_);
+  if (begin > end)
+    throw IndexOutOfBoundsException("MultiPopulationStatistics::getEstimates: begin after end.", begin, 0, end);
+  return getEstimates_(vector<pair<size_t, size_t>>(1, make_pair(begin, end)), nbThreads).front();
+}
+
+/******************************************************************************/
+
+vector<MultiPopulationStatistics::Estimates> MultiPopulationStatistics::getWindowEstimates(size_t windowSize, size_t step, unsigned int nbThreads) const
+{
+  if (windowSize == 0 || step == 0)
+    throw Exception("MultiPopulationStatistics::getWindowEstimates: window size and step must be positive.");
+  vector<pair<size_t, size_t>> ranges;
+  size_t begin = 0, end = 0;
+  do
+  {
+    end = min(begin + windowSize, nbSites_);
+    ranges.push_back(make_pair(begin, end));
+    begin += step;
+  }
+  while (end < nbSites_ && begin < nbSites_);
+  return getEstimates_(ranges, nbThreads);
+}
+
+/******************************************************************************/
+
+vector<MultiPopulationStatistics::Estimates> MultiPopulationStatistics::getEstimates_(
+    const vector<pair<size_t, size_t>>& ranges,
+    unsigned int nbThreads) const
+{
+  size_t nbPop = groupIds_.size();
+  double nan = numeric_limits<double>::quiet_NaN();
+  vector<Estimates> estimates(ranges.size());
+  // Only the sites covered by the ranges are read.
+  size_t first = ranges.front().first, last = 0;
+  for (size_t w = 0; w < ranges.size(); ++w)
+  {
+    estimates[w].begin = ranges[w].first;
+    estimates[w].end = ranges[w].second;
+    estimates[w].pi.assign(nbPop, nan);
+    estimates[w].dxy.resize(nbPop, nbPop);
+    estimates[w].fst.resize(nbPop, nbPop);
+    last = max(last, ranges[w].second);
+  }
+  size_t length = last - first;
+
+  // Each population, then each pair, is a task, which only writes its own
+  // cells. Cumulated sums over sites are reused by the tasks of a thread.
+  vector<pair<size_t, size_t>> tasks;
+  for (size_t a = 0; a < nbPop; ++a)
+  {
+    tasks.push_back(make_pair(a, a));
+  }
+  for (size_t a = 0; a < nbPop; ++a)
+  {
+    for (size_t b = a + 1; b < nbPop; ++b)
+    {
+      tasks.push_back(make_pair(a, b));
+    }
+  }
+  nbThreads = ParallelTools::getNumberOfThreads(nbThreads, tasks.size());
+  vector<vector<double>> sums1(nbThreads, vector<double>(length + 1));
+  vector<vector<double>> sums2(nbThreads, vector<double>(length + 1));
+  vector<vector<double>> sums3(nbThreads, vector<double>(length + 1));
+  vector<vector<size_t>> nbs1(nbThreads, vector<size_t>(length + 1));
+
+  ParallelTools::parallelFor(tasks.size(), nbThreads,
+      [&](size_t t, unsigned int thread) {
+        size_t a = tasks[t].first;
+        size_t b = tasks[t].second;
+        vector<double>& sum1 = sums1[thread];
+        vector<double>& sum2 = sums2[thread];
+        vector<double>& sum3 = sums3[thread];
+        vector<size_t>& nb1 = nbs1[thread];
+        sum1[0] = sum2[0] = sum3[0] = 0.;
+        nb1[0] = 0;
+        if (a == b)
+        {
+          for (size_t i = 0; i < length; ++i)
+          {
+            double pi = pi_[a][first + i];
+            bool ok = !std::isnan(pi);
+            sum1[i + 1] = sum1[i] + (ok ? pi : 0.);
+            nb1[i + 1] = nb1[i] + (ok ? 1 : 0);
+          }
+          for (auto& e : estimates)
+          {
+            size_t n = nb1[e.end - first] - nb1[e.begin - first];
+            e.pi[a] = n > 0 ? (sum1[e.end - first] - sum1[e.begin - first]) / static_cast<double>(n) : nan;
+            e.dxy(a, a) = e.pi[a];
+            e.fst(a, a) = 0.;
+          }
+          return;
+        }
+        // sum1/nb1: dxy over the sites where it is defined,
+        // sum2/sum3: mean pi and dxy over the sites where Fst is defined.
+        for (size_t i = 0; i < length; ++i)
+        {
+          size_t site = first + i;
+          double dxy = SequenceStatistics::getDxy_(counts_[a], counts_[b], site);
+          bool ok = !std::isnan(dxy);
+          bool both = ok && !std::isnan(pi_[a][site]) && !std::isnan(pi_[b][site]);
+          sum1[i + 1] = sum1[i] + (ok ? dxy : 0.);
+          nb1[i + 1] = nb1[i] + (ok ? 1 : 0);
+          sum2[i + 1] = sum2[i] + (both ? (pi_[a][site] + pi_[b][site]) / 2. : 0.);
+          sum3[i + 1] = sum3[i] + (both ? dxy : 0.);
+        }
+        for (auto& e : estimates)
+        {
+          size_t begin = e.begin - first, end = e.end - first;
+          size_t n = nb1[end] - nb1[begin];
+          double dxy = n > 0 ? (sum1[end] - sum1[begin]) / static_cast<double>(n) : nan;
+          double hb = sum3[end] - sum3[begin];
+          double fst = hb > 0. ? 1. - (sum2[end] - sum2[begin]) / hb : nan;
+          e.dxy(a, b) = e.dxy(b, a) = dxy;
+          e.fst(a, b) = e.fst(b, a) = fst;
+        }
+      });
+  return estimates;
+}
+
+/******************************************************************************/
+
+vector<size_t> MultiPopulationStatistics::getGroupIds_(const PolymorphismSequenceContainer& psc)
+{
+  set<size_t> ids = psc.getAllGroupsIds();
+  return vector<size_t>(ids.begin(), ids.end());
+}
+
+/******************************************************************************/
+
+double MultiPopulationStatistics::getPi_(const SiteCountTable& table, size_t site)
+{
+  const unsigned int* counts = table.getCounts(site);
+  double n = 0., same = 0.;
+  for (size_t s = 0; s < table.getNumberOfStates(); ++s)
+  {
+    double c = static_cast<double>(counts[s]);
+    n += c;
+    same += c * (c - 1.);
+  }
+  if (n < 2.)
+    return numeric_limits<double>::quiet_NaN();
+  return 1. - same / (n * (n - 1.));
+}
@@ -0,0 +1,180 @@
+// SPDX-FileCopyrightText: The Bio++ Development Group
+//
+// SPDX-License-Identifier: CECILL-2.1
+
+#ifndef _MULTIPOPULATIONSTATISTICS_H_
+#define _MULTIPOPULATIONSTATISTICS_H_
+
+#include <Bpp/Numeric/Matrix/Matrix.h>
+
+// From the STL
+#include <utility>
+#include <vector>
+
+#include "PolymorphismSequenceContainer.h"
+#include "SiteCountTable.h"
+
+namespace bpp
+{
+/**
+ * @brief Diversity and divergence statistics between many populations.
+ *
+ * The sequences of a PolymorphismSequenceContainer are split by group id,
+ * and the states of each group are counted once per site. All the
+ * statistics are then computed from these counts, without comparing
+ * sequences pairwise:
+ * - @f$\pi@f$, the probability that two sequences of a population differ
+ *   at a site;
+ * - @f$d_{xy}@f$, the probability that two sequences taken in two
+ *   populations differ at a site;
+ * - Hudson's @f$F_{st}@f$ (Hudson, Slatkin and Maddison 1992, eq. 3),
+ *   @f$1 - \frac{(\pi_x + \pi_y) / 2}{d_{xy}}@f$, the ratio of the sums
+ *   over sites being taken, as recommended by Bhatia et al. 2013
+ *   (Genome Research 23:1514);
+ * - the population branch statistic (Yi et al. 2010, Science 329:75) of
+ *   each triplet of populations.
+ *
+ * Statistics are computed for the whole alignment, a range of sites or
+ * sliding windows of sites. For each pair of populations, the per-site
+ * values are computed once over the sites covered by the requested ranges,
+ * and summed over windows with cumulated sums, so that overlapping windows
+ * do not cost more than disjoint ones. Populations and pairs may be
+ * distributed between several threads, with the same results.
+ *
+ * Gaps and unresolved states are ignored: a site is used for @f$\pi@f$ in a
+ * population if at least two of its sequences are resolved at this site, and
+ * for @f$d_{xy}@f$ if at least one sequence of each population is. The
+ * @f$F_{st}@f$ of a pair only uses the sites where both @f$\pi@f$ and
+ * @f$d_{xy}@f$ are defined. Statistics are NaN when no site is usable.
+ */
+class MultiPopulationStatistics
+{
+public:
+  /**
+   * @brief The statistics of a range of sites.
+   *
+   * Populations are indexed in the order of getGroupIds(). @f$\pi@f$ and
+   * @f$d_{xy}@f$ are averaged over the usable sites. The diagonal of dxy
+   * holds @f$\pi@f$, and the one of fst is 0.
+   */
+  struct Estimates
+  {
+    /** @brief The first site of the range. */
+    size_t begin;
+    /** @brief One past the last site of the range. */
+    size_t end;
+    std::vector<double> pi;
+    RowMatrix<double> dxy;
+    RowMatrix<double> fst;
+
+    /**
+     * @return The population branch statistic of population a, compared to
+     * populations b and c: @f$(T_{ab} + T_{ac} - T_{bc}) / 2@f$, with
+     * @f$T = -\log(1 - F_{st})@f$.
+     */
+    double getPbs(size_t a, size_t b, size_t c) const;
+
+    /**
+     * @return The population branch statistic of population a, compared to
+     * each pair of other populations (b, c), as a symmetric matrix. Entries
+     * with b = c or involving a are NaN.
+     */
+    RowMatrix<double> getPbs(size_t a) const;
+  };
+
+private:
+  std::vector<size_t> groupIds_;
+  size_t nbSites_;
+  std::vector<SiteCountTable> counts_;
+  std::vector<std::vector<double>> pi_;
+
+public:
+  /**
+   * @brief Count the states of all groups of a container.
+   *
+   * @param psc The sequences.
+   * @param weighted If true, each sequence is counted as many times as its count.
+   */
+  MultiPopulationStatistics(
+      const PolymorphismSequenceContainer& psc,
+      bool weighted = false);
+
+  /**
+   * @brief Count the states of some groups of a container.
+   *
+   * @param psc The sequences.
+   * @param groupIds The ids of the groups to compare, in the order in which
+   * they are indexed in the results.
+   * @param weighted If true, each sequence is counted as many times as its count.
+   * @throw GroupNotFoundException if a group has no sequence.
+   * @throw Exception if a group is given twice.
+   */
+  MultiPopulationStatistics(
+      const PolymorphismSequenceContainer& psc,
+      const std::vector<size_t>& groupIds,
+      bool weighted = false);
+
+  virtual ~MultiPopulationStatistics() {}
+
+public:
+  size_t getNumberOfPopulations() const { return groupIds_.size(); }
+
+  const std::vector<size_t>& getGroupIds() const { return groupIds_; }
+
+  size_t getNumberOfSites() const { return nbSites_; }
+
+  /**
+   * @return The state counts of a population.
+   */
+  const SiteCountTable& getSiteCounts(size_t population) const { return counts_[population]; }
+
+  /**
+   * @return The statistics of the whole alignment.
+   *
+   * @param nbThreads The number of threads, or 0 to use all hardware threads.
+   */
+  Estimates getEstimates(unsigned int nbThreads = 1) const;
+
+  /**
+   * @return The statistics of a range of sites. Only the sites of the range
+   * are read.
+   *
+   * @param begin The first site.
+   * @param end One past the last site.
+   * @param nbThreads The number of threads, or 0 to use all hardware threads.
+   * @throw IndexOutOfBoundsException if the range is not valid.
+   */
+  Estimates getEstimates(size_t begin, size_t end, unsigned int nbThreads = 1) const;
+
+  /**
+   * @brief Compute the statistics in sliding windows.
+   *
+   * Windows start at sites 0, step, 2 * step, ... until one reaches the end
+   * of the alignment, which may therefore be shorter than windowSize, or
+   * the next start is past the last site. If step is larger than
+   * windowSize, the sites between two windows are not used.
+   *
+   * @param windowSize The number of sites in a window.
+   * @param step The number of sites between the starts of two windows.
+   * @param nbThreads The number of threads, or 0 to use all hardware threads.
+   * @throw Exception if windowSize or step is 0.
+   */
+  std::vector<Estimates> getWindowEstimates(size_t windowSize, size_t step, unsigned int nbThreads = 1) const;
+
+private:
+  /**
+   * @brief Compute the statistics of a non-empty list of ranges, sorted by start.
+   */
+  std::vector<Estimates> getEstimates_(const std::vector<std::pair<size_t, size_t>>& ranges, unsigned int nbThreads) const;
+
+  static std::vector<size_t> getGroupIds_(const PolymorphismSequenceContainer& psc);
+
+  /**
+   * @return The probability that two resolved sequences differ at a site,
+   * or NaN if there are less than two.
+   */
+  static double getPi_(const SiteCountTable& table, size_t site);
+};
+} // end of namespace bpp;
+
+#endif // _MULTIPOPULATIONSTATISTICS_H_
@@ -10,10 +10,16 @@
 //
 // SPDX-License-Identifier: CECILL-2.1
 
+#include <Bpp/Numeric/Random/RandomTools.h>
 #include <Bpp/Utils/MapTools.h>
 
+#include "AlleleCountTable.h"
+#include "GenotypeCountTable.h"
 #include "MultilocusGenotypeStatistics.h"
 #include "PolymorphismMultiGContainerTools.h"
+#include "CounterBasedGenerator.h"
+#include "ParallelTools.h"
+#include "VarianceComponentTable.h"
 
 using namespace bpp;
 
@@ -62,24 +68,17 @@ size_t MultilocusGenotypeStatistics::countGametesForGroups(const PolymorphismMul
 map<size_t, size_t> MultilocusGenotypeStatistics::getAllelesMapForGroups(const PolymorphismMultiGContainer& pmgc, size_t locusPosition, const set<size_t>& groups)
 {
   map<size_t, size_t> alleles_count;
-  for (size_t i = 0; i < pmgc.size(); i++)
+  auto table = pmgc.getAlleleCountTable();
+  vector<size_t> g = getGroupIndices_(*table, locusPosition, groups, "MultilocusGenotypeStatistics::getAllelesMapForGroups");
+  for (size_t a = 0; a < table->getNumberOfAlleles(locusPosition); ++a)
   {
-    try
+    size_t count = 0;
+    for (auto i : g)
     {
-      if (!pmgc.multilocusGenotype(i).isMonolocusGenotypeMissing(locusPosition) &&  (groups.find(pmgc.getGroupId(i)) != groups.end()) )
-      {
-        // if (! pmgc.getMultilocusGenotype(i)->isMonolocusGenotypeMissing(locusPosition) &&  (find(groups.begin(), groups.end(), pmgc.getGroupId(i)) != groups.end()) ) {
-        vector<size_t> tmp_alleles = pmgc.multilocusGenotype(i).monolocusGenotype(locusPosition).getAlleleIndex();
-        for (size_t j = 0; j < tmp_alleles.size(); j++)
-        {
-          alleles_count[tmp_alleles[j]]++;
-        }
-      }
-    }
-    catch (IndexOutOfBoundsException& ioobe)
-    {
-      throw IndexOutOfBoundsException("MultilocusGenotypeStatistics::getAllelesMapForGroups: locusPosition out of bounds.", ioobe.getBadIndex(), ioobe.getBounds()[0], ioobe.getBounds()[1]);
+      count += table->getAlleleCount(locusPosition, a, i);
     }
+    if (count > 0)
+      alleles_count[table->getAlleleKey(locusPosition, a)] = count;
   }
   return alleles_count;
 }
@@ -114,18 +113,10 @@ map<size_t, double> MultilocusGenotypeStatistics::getAllelesFrqForGroups(const P
 size_t MultilocusGenotypeStatistics::countNonMissingForGroups(const PolymorphismMultiGContainer& pmgc, size_t locusPosition, const set<size_t>& groups)
 {
   size_t counter = 0;
-  for (size_t i = 0; i < pmgc.size(); i++)
+  auto table = pmgc.getAlleleCountTable();
+  for (auto i : getGroupIndices_(*table, locusPosition, groups, "MultilocusGenotypeStatistics::countNonMissing"))
   {
-    try
-    {
-      // if (! pmgc.getMultilocusGenotype(i)->isMonolocusGenotypeMissing(locusPosition) &&  (find(groups.begin(), groups.end(), pmgc.getGroupId(i)) != groups.end()) )
-      if (!pmgc.multilocusGenotype(i).isMonolocusGenotypeMissing(locusPosition) &&  (groups.find(pmgc.getGroupId(i) ) != groups.end()) )
-        counter++;
-    }
-    catch (IndexOutOfBoundsException& ioobe)
-    {
-      throw IndexOutOfBoundsException("MultilocusGenotypeStatistics::countNonMissing: locusPosition out of bounds.", ioobe.getBadIndex(), ioobe.getBounds()[0], ioobe.getBounds()[1]);
-    }
+    counter += table->getNumberOfNonMissing(locusPosition, i);
   }
   return counter;
 }
@@ -133,19 +124,10 @@ size_t MultilocusGenotypeStatistics::countNonMissingForGroups(const Polymorphism
 size_t MultilocusGenotypeStatistics::countBiAllelicForGroups(const PolymorphismMultiGContainer& pmgc, size_t locusPosition, const set<size_t>& groups)
 {
   size_t counter = 0;
-  for (size_t i = 0; i < pmgc.size(); i++)
+  auto table = pmgc.getAlleleCountTable();
+  for (auto i : getGroupIndices_(*table, locusPosition, groups, "MultilocusGenotypeStatistics::countBiAllelic"))
   {
-    try
-    {
-      // if (! pmgc.getMultilocusGenotype(i)->isMonolocusGenotypeMissing(locusPosition) && (find(groups.begin(), groups.end(), pmgc.getGroupId(i)) != groups.end()) )
-      if (!pmgc.multilocusGenotype(i).isMonolocusGenotypeMissing(locusPosition) && (groups.find(pmgc.getGroupId(i)) != groups.end()) )
-        if ((pmgc.multilocusGenotype(i).monolocusGenotype(locusPosition).getAlleleIndex()).size() == 2)
-          counter++;
-    }
-    catch (IndexOutOfBoundsException& ioobe)
-    {
-      throw IndexOutOfBoundsException("MultilocusGenotypeStatistics::countBiAllelic: locusPosition out of bounds.", ioobe.getBadIndex(), ioobe.getBounds()[0], ioobe.getBounds()[1]);
-    }
+    counter += table->getNumberOfBiAllelic(locusPosition, i);
   }
   return counter;
 }
@@ -153,30 +135,17 @@ size_t MultilocusGenotypeStatistics::countBiAllelicForGroups(const PolymorphismM
 map<size_t, size_t> MultilocusGenotypeStatistics::countHeterozygousForGroups(const PolymorphismMultiGContainer& pmgc, size_t locusPosition, const set<size_t>& groups)
 {
   map<size_t, size_t> counter;
-  for (size_t i = 0; i < pmgc.size(); i++)
+  auto table = pmgc.getAlleleCountTable();
+  vector<size_t> g = getGroupIndices_(*table, locusPosition, groups, "MultilocusGenotypeStatistics::countHeterozygous");
+  for (size_t a = 0; a < table->getNumberOfAlleles(locusPosition); ++a)
   {
-    try
+    size_t count = 0;
+    for (auto i : g)
     {
-      if (!pmgc.multilocusGenotype(i).isMonolocusGenotypeMissing(locusPosition) && (groups.find(pmgc.getGroupId(i)) != groups.end() ))
-      {
-        const auto& tmpMg = pmgc.multilocusGenotype(i).monolocusGenotype(locusPosition);
-        if ((tmpMg.getAlleleIndex()).size() == 2)
-        {
-          if (!dynamic_cast<const BiAlleleMonolocusGenotype&>(tmpMg).isHomozygous())
-          {
-            vector<size_t> tmpAlleles = tmpMg.getAlleleIndex();
-            for (size_t j = 0; j < tmpAlleles.size(); j++)
-            {
-              counter[tmpAlleles[j]]++;
-            }
-          }
-        }
-      }
-    }
-    catch (IndexOutOfBoundsException& ioobe)
-    {
-      throw IndexOutOfBoundsException("MultilocusGenotypeStatistics::countHeterozygous: locusPosition out of bounds.", ioobe.getBadIndex(), ioobe.getBounds()[0], ioobe.getBounds()[1]);
+      count += table->getHeterozygousCount(locusPosition, a, i);
     }
+    if (count > 0)
+      counter[table->getAlleleKey(locusPosition, a)] = count;
   }
   return counter;
 }
@@ -185,37 +154,23 @@ map<size_t, double> MultilocusGenotypeStatistics::getHeterozygousFrqForGroups(co
 {
   map<size_t, double> freq;
   size_t counter = 0;
-  for (size_t i = 0; i < pmgc.size(); i++)
+  auto table = pmgc.getAlleleCountTable();
+  vector<size_t> g = getGroupIndices_(*table, locusPosition, groups, "MultilocusGenotypeStatistics::getHeterozygousFrqForGroups");
+  for (auto i : g)
   {
-    try
-    {
-      if (!pmgc.multilocusGenotype(i).isMonolocusGenotypeMissing(locusPosition) && (groups.find(pmgc.getGroupId(i)) != groups.end()) )
-      {
-        const auto& tmpMg = pmgc.multilocusGenotype(i).monolocusGenotype(locusPosition);
-        if ((tmpMg.getAlleleIndex()).size() == 2)
-        {
-          counter++;
-          if (!dynamic_cast<const BiAlleleMonolocusGenotype&>(tmpMg).isHomozygous())
-          {
-            vector<size_t> tmpAlleles = tmpMg.getAlleleIndex();
-            for (size_t j = 0; j < tmpAlleles.size(); j++)
-            {
-              freq[tmpAlleles[j]]++;
-            }
-          }
-        }
-      }
-    }
-    catch (IndexOutOfBoundsException& ioobe)
-    {
-      throw IndexOutOfBoundsException("MultilocusGenotypeStatistics::getHeterozygousFrqForGroups: locusPosition out of bounds.", ioobe.getBadIndex(), ioobe.getBounds()[0], ioobe.getBounds()[1]);
-    }
+    counter += table->getNumberOfBiAllelic(locusPosition, i);
   }
   if (counter == 0)
     throw ZeroDivisionException("MultilocusGenotypeStatistics::getHeterozygousFrqForGroups.");
-  for (map<size_t, double>::iterator i = freq.begin(); i != freq.end(); i++)
+  for (size_t a = 0; a < table->getNumberOfAlleles(locusPosition); ++a)
   {
-    i->second = (double) i->second / (double) counter;
+    size_t count = 0;
+    for (auto i : g)
+    {
+      count += table->getHeterozygousCount(locusPosition, a, i);
+    }
+    if (count > 0)
+      freq[table->getAlleleKey(locusPosition, a)] = static_cast<double>(count) / static_cast<double>(counter);
   }
   return freq;
 }
@@ -286,102 +241,86 @@ double MultilocusGenotypeStatistics::getHnbForGroups(const PolymorphismMultiGCon
   return 2 * static_cast<double>(nb_alleles) * Hexp  / static_cast<double>((2 * nb_alleles) - 1);
 }
 
-double MultilocusGenotypeStatistics::getDnei72(const PolymorphismMultiGContainer& pmgc, vector<size_t> locusPositions, size_t grp1, size_t grp2)
+MultilocusGenotypeStatistics::HWResults MultilocusGenotypeStatistics::getHWExactTest(
+    const PolymorphismMultiGContainer& pmgc,
+    size_t locusPosition,
+    const set<size_t>& groups,
+    unsigned int dememorization,
+    unsigned int nbBatches,
+    unsigned int nbIterations,
+    uint64_t seed)
 {
-  map<size_t, double> allele_frq1, allele_frq2;
-  vector<size_t> allele_ids;
-  set<size_t> group1_id;
-  set<size_t> group2_id;
-  set<size_t> groups_id;
-  double Jx = 0.;
-  double Jy = 0.;
-  double Jxy = 0.;
-  group1_id.insert(grp1);
-  group2_id.insert(grp2);
-  groups_id.insert(grp1);
-  groups_id.insert(grp2);
-  for (size_t i = 0; i < locusPositions.size(); i++)
-  {
-    allele_ids.clear();
-    allele_frq1.clear();
-    allele_frq2.clear();
-    try
-    {
-      allele_ids = getAllelesIdsForGroups(pmgc, locusPositions[i], groups_id);
-      allele_frq1 = getAllelesFrqForGroups(pmgc, locusPositions[i], group1_id);
-      allele_frq2 = getAllelesFrqForGroups(pmgc, locusPositions[i], group2_id);
-    }
-    catch (Exception& e)
-    {
-      throw e;
-    }
-    for (size_t j = 0; j < allele_ids.size(); j++)
-    {
-      map<size_t, double>::iterator it1 = allele_frq1.find(allele_ids[j]);
-      map<size_t, double>::iterator it2 = allele_frq2.find(allele_ids[j]);
-      double tmp_frq1 = (it1 != allele_frq1.end()) ? it1->second : 0.;
-      double tmp_frq2 = (it2 != allele_frq2.end()) ? it2->second : 0.;
-      Jx += tmp_frq1 * tmp_frq1;
-      Jy += tmp_frq2 * tmp_frq2;
-      Jxy += tmp_frq1 * tmp_frq2;
-    }
+  if (nbBatches == 0 || nbIterations == 0)
+    throw BadIntegerException("MultilocusGenotypeStatistics::getHWExactTest: nbBatches and nbIterations must be > 0.", 0);
+  auto table = pmgc.getGenotypeCountTable();
+  if (locusPosition >= table->getNumberOfLoci())
+    throw IndexOutOfBoundsException("MultilocusGenotypeStatistics::getHWExactTest: locusPosition out of bounds.", locusPosition, 0, table->getNumberOfLoci());
+  return hwExactTest_(*table, locusPosition, table->getGroupIndices(groups), dememorization, nbBatches, nbIterations, seed);
+}
+
+map<size_t, vector<MultilocusGenotypeStatistics::HWResults>> MultilocusGenotypeStatistics::getHWExactTests(
+    const PolymorphismMultiGContainer& pmgc,
+    const vector<size_t>& locusPositions,
+    const set<size_t>& groups,
+    unsigned int dememorization,
+    unsigned int nbBatches,
+    unsigned int nbIterations,
+    uint64_t seed,
+    unsigned int nbThreads)
+{
+  if (nbBatches == 0 || nbIterations == 0)
+    throw BadIntegerException("MultilocusGenotypeStatistics::getHWExactTests: nbBatches and nbIterations must be > 0.", 0);
+  auto table = pmgc.getGenotypeCountTable();
+  for (auto locus : locusPositions)
+  {
+    if (locus >= table->getNumberOfLoci())
+      throw IndexOutOfBoundsException("MultilocusGenotypeStatistics::getHWExactTests: locusPosition out of bounds.", locus, 0, table->getNumberOfLoci());
+  }
+  // The results are allocated first, and each (group, locus) task writes its own.
+  map<size_t, vector<HWResults>> results;
+  vector<size_t> ids(groups.begin(), groups.end());
+  vector<vector<size_t>> indices;
+  vector<vector<HWResults>*> tests;
+  for (auto id : ids)
+  {
+    indices.push_back(table->getGroupIndices({id}));
+    tests.push_back(&results[id]);
+    tests.back()->resize(locusPositions.size());
   }
-  if (Jx * Jy == 0.)
+  size_t nbTasks = ids.size() * locusPositions.size();
+  ParallelTools::parallelFor(nbTasks, ParallelTools::getNumberOfThreads(nbThreads, nbTasks),
+      [&](size_t i, unsigned int) {
+        size_t g = i / locusPositions.size();
+        size_t l = i % locusPositions.size();
+        (*tests[g])[l] = hwExactTest_(*table, locusPositions[l], indices[g], dememorization, nbBatches, nbIterations, getGroupSeed(seed, ids[g]));
+      });
+  return results;
+}
+
+uint64_t MultilocusGenotypeStatistics::getGroupSeed(uint64_t seed, size_t groupId)
+{
+  // Each group has its own seed, so that the chains of the groups at a locus are independent.
+  return CounterBasedGenerator(seed, static_cast<uint64_t>(groupId))();
+}
+
+double MultilocusGenotypeStatistics::getDnei72(const PolymorphismMultiGContainer& pmgc, vector<size_t> locusPositions, size_t grp1, size_t grp2)
+{
+  auto table = pmgc.getAlleleCountTable();
+  vector<size_t> g1 = table->getGroupIndices({grp1});
+  vector<size_t> g2 = table->getGroupIndices({grp2});
+  if (g1.empty() || g2.empty())
     throw ZeroDivisionException("MultilocusGenotypeStatistics::getDnei72.");
-  return -log(Jxy / sqrt(Jx * Jy));
+  return getDistance_(*table, locusPositions, {g1[0], g2[0]}, 2, "nei72", "MultilocusGenotypeStatistics::getDnei72");
 }
 
 double MultilocusGenotypeStatistics::getDnei78(const PolymorphismMultiGContainer& pmgc, vector<size_t> locusPositions, size_t grp1, size_t grp2)
 {
-  map<size_t, double> allele_frq1, allele_frq2;
-  vector<size_t> allele_ids;
-  set<size_t> group1_id;
-  set<size_t> group2_id;
-  set<size_t> groups_id;
-  double Jx = 0.;
-  double Jy = 0.;
-  double Jxy = 0.;
-  size_t nx = 0, ny = 0;
-  group1_id.insert(grp1);
-  group2_id.insert(grp2);
-  groups_id.insert(grp1);
-  groups_id.insert(grp2);
-  for (size_t i = 0; i < locusPositions.size(); i++)
-  {
-    allele_ids.clear();
-    allele_frq1.clear();
-    allele_frq2.clear();
-    try
-    {
-      allele_ids = getAllelesIdsForGroups(pmgc, locusPositions[i], groups_id);
-      allele_frq1 = getAllelesFrqForGroups(pmgc, locusPositions[i], group1_id);
-      allele_frq2 = getAllelesFrqForGroups(pmgc, locusPositions[i], group2_id);
-      nx = countBiAllelicForGroups(pmgc, locusPositions[i], group1_id);
-      ny = countBiAllelicForGroups(pmgc, locusPositions[i], group2_id);
-    }
-    catch (Exception& e)
-    {
-      throw e;
-    }
-    double tmp_Jx = 0.;
-    double tmp_Jy = 0.;
-    for (size_t j = 0; j < allele_ids.size(); j++)
-    {
-      map<size_t, double>::iterator it1 = allele_frq1.find(allele_ids[j]);
-      map<size_t, double>::iterator it2 = allele_frq2.find(allele_ids[j]);
-      double tmp_frq1 = (it1 != allele_frq1.end()) ? it1->second : 0.;
-      double tmp_frq2 = (it2 != allele_frq2.end()) ? it2->second : 0.;
-      tmp_Jx += tmp_frq1 * tmp_frq1;
-      tmp_Jy += tmp_frq2 * tmp_frq2;
-      Jxy += tmp_frq1 * tmp_frq2;
-    }
-    Jx += ((2. * (double) nx * tmp_Jx) - 1.) / ((2. * (double) nx) - 1.);
-    Jy += ((2. * (double) ny * tmp_Jy) - 1.) / ((2. * (double) ny) - 1.);
-  }
-  double denom = Jx * Jy;
-  if (denom == 0.)
+  auto table = pmgc.getAlleleCountTable();
+  vector<size_t> g1 = table->getGroupIndices({grp1});
+  vector<size_t> g2 = table->getGroupIndices({grp2});
+  if (g1.empty() || g2.empty())
     throw ZeroDivisionException("MultilocusGenotypeStatistics::getDnei78.");
-  return -log(Jxy / sqrt(denom));
+  return getDistance_(*table, locusPositions, {g1[0], g2[0]}, 2, "nei78", "MultilocusGenotypeStatistics::getDnei78");
 }
 
 map<size_t, MultilocusGenotypeStatistics::Fstats> MultilocusGenotypeStatistics::getAllelesFstats(const PolymorphismMultiGContainer& pmgc, size_t locusPosition, const set<size_t>& groups)
@@ -398,6 +337,7 @@ map<size_t, MultilocusGenotypeStatistics::Fstats> MultilocusGenotypeStatistics::
       f_stats[it->first].Fit = NAN;
       f_stats[it->first].Fst = NAN;
     }
+    else
     {
       f_stats[it->first].Fit = 1. - it->second.c / abc;
       f_stats[it->first].Fst = it->second.a / abc;
@@ -456,343 +396,962 @@ map<size_t, double> MultilocusGenotypeStatistics::getAllelesFis(const Polymorphi
 
 map<size_t, MultilocusGenotypeStatistics::VarComp> MultilocusGenotypeStatistics::getVarianceComponents(const PolymorphismMultiGContainer& pmgc, size_t locusPosition, const set<size_t>& groups)
 {
+  auto table = pmgc.getAlleleCountTable();
+  vector<size_t> g = getGroupIndices_(*table, locusPosition, groups, "MultilocusGenotypeStatistics::getVarianceComponents");
+  vector<size_t> alleles;
+  vector<VarComp> components;
+  getAlleles_(*table, locusPosition, g, alleles);
+  getVarianceComponents_(*table, locusPosition, g, groups.size(), alleles, components);
   map<size_t, MultilocusGenotypeStatistics::VarComp> values;
-  // Base values computation
-  double nbar = 0.;
-  double nc = 0.;
-  vector<size_t> ids = getAllelesIdsForGroups(pmgc, locusPosition, groups);
-  map<size_t, double> pbar;
-  map<size_t, double> s2;
-  map<size_t, double> hbar;
-  for (size_t i = 0; i < ids.size(); i++)
-  {
-    pbar[ids[i]] = 0.;
-    s2[ids[i]] = 0.;
-    hbar[ids[i]] = 0.;
-  }
-  double r = static_cast<double>(groups.size());
-  for (set<size_t>::iterator set_it = groups.begin(); set_it != groups.end(); set_it++)
-  {
-    size_t i  = (*set_it);
-    double ni = static_cast<double>(pmgc.getLocusGroupSize(i, locusPosition));
-    set<size_t> group_id;
-    group_id.insert( i );
-    map<size_t, double> pi = getAllelesFrqForGroups(pmgc, locusPosition, group_id);
-    map<size_t, double> hi = getHeterozygousFrqForGroups(pmgc, locusPosition, group_id);
-    nbar += ni;
-    if (r > 1)
-      nc += ni * ni;
+  for (size_t t = 0; t < alleles.size(); ++t)
+  {
+    values[table->getAlleleKey(locusPosition, alleles[t])] = components[t];
+  }
+  return values;
+}
 
-    for (map<size_t, double>::iterator it = pi.begin(); it != pi.end(); it++)
-    {
-      pbar[it->first] += ni * it->second;
-    }
-    for (map<size_t, double>::iterator it = hi.begin(); it != hi.end(); it++)
-    {
-      hbar[it->first] += ni * it->second;
-    }
+unique_ptr<VarianceComponentTable> MultilocusGenotypeStatistics::getVarianceComponentTable(const PolymorphismMultiGContainer& pmgc, const set<size_t>& groups, unsigned int nbThreads)
+{
+  return make_unique<VarianceComponentTable>(*pmgc.getAlleleCountTable(), groups, nbThreads);
+}
 
-    group_id.clear();
-  }
-  nbar = nbar / r;
-  if (nbar <= 1)
-    throw ZeroDivisionException("MultilocusGenotypeStatistics::getVarianceComponents.");
-  if (r > 1)
-    nc = (r * nbar) - (nc / (r * nbar)) / (r - 1.);
-  for (map<size_t, double>::iterator it = pbar.begin(); it != pbar.end(); it++)
+double MultilocusGenotypeStatistics::getWCMultilocusFst(const PolymorphismMultiGContainer& pmgc, vector<size_t> locusPositions, const set<size_t>& groups, unsigned int nbThreads)
+{
+  auto table = pmgc.getAlleleCountTable();
+  VarComp sums = sumVarianceComponents_(*table, locusPositions, table->getGroupIndices(groups), groups.size(), "MultilocusGenotypeStatistics::getWCMultilocusFst", nbThreads);
+  if ((sums.a + sums.b + sums.c) == 0)
+    throw ZeroDivisionException("MultilocusGenotypeStatistics::getWCMultilocusFst.");
+  return sums.a / (sums.a + sums.b + sums.c);
+}
+
+double MultilocusGenotypeStatistics::getWCMultilocusFis(const PolymorphismMultiGContainer& pmgc, vector<size_t> locusPositions, const set<size_t>& groups, unsigned int nbThreads)
+{
+  auto table = pmgc.getAlleleCountTable();
+  VarComp sums = sumVarianceComponents_(*table, locusPositions, table->getGroupIndices(groups), groups.size(), "MultilocusGenotypeStatistics::getWCMultilocusFis", nbThreads);
+  if ((sums.b + sums.c) == 0)
+    throw ZeroDivisionException("MultilocusGenotypeStatistics::getWCMultilocusFis.");
+  return 1.0 - sums.c / (sums.b + sums.c);
+}
+
+MultilocusGenotypeStatistics::PermResults MultilocusGenotypeStatistics::getWCMultilocusFstAndPerm(
+    const PolymorphismMultiGContainer& pmgc,
+    vector<size_t> locusPositions,
+    set<size_t> groups,
+    unsigned int nbPerm)
+{
+  return wcPermutationTest_(pmgc, locusPositions, groups, nbPerm, false, 1,
+      [](unsigned int, const GenotypeMatrix& source, GenotypeMatrix& target, PolymorphismMultiGContainerTools::PermutationWorkspace& workspace) {
+        PolymorphismMultiGContainerTools::permuteMultiG(source, target, workspace, RandomTools::DEFAULT_GENERATOR);
+      });
+}
+
+MultilocusGenotypeStatistics::PermResults MultilocusGenotypeStatistics::getWCMultilocusFstAndPerm(
+    const PolymorphismMultiGContainer& pmgc,
+    vector<size_t> locusPositions,
+    set<size_t> groups,
+    unsigned int nbPerm,
+    uint64_t seed,
+    unsigned int nbThreads)
+{
+  return wcPermutationTest_(pmgc, locusPositions, groups, nbPerm, false, nbThreads,
+      [seed](unsigned int i, const GenotypeMatrix& source, GenotypeMatrix& target, PolymorphismMultiGContainerTools::PermutationWorkspace& workspace) {
+        CounterBasedGenerator generator(seed, i);
+        PolymorphismMultiGContainerTools::permuteMultiG(source, target, workspace, generator);
+      });
+}
+
+MultilocusGenotypeStatistics::PermResults MultilocusGenotypeStatistics::getWCMultilocusFisAndPerm(
+    const PolymorphismMultiGContainer& pmgc,
+    vector<size_t> locusPositions,
+    set<size_t> groups,
+    unsigned int nbPerm)
+{
+  return wcPermutationTest_(pmgc, locusPositions, groups, nbPerm, true, 1,
+      [](unsigned int, const GenotypeMatrix& source, GenotypeMatrix& target, PolymorphismMultiGContainerTools::PermutationWorkspace& workspace) {
+        PolymorphismMultiGContainerTools::permuteIntraGroupAlleles(source, target, workspace, RandomTools::DEFAULT_GENERATOR);
+      });
+}
+
+MultilocusGenotypeStatistics::PermResults MultilocusGenotypeStatistics::getWCMultilocusFisAndPerm(
+    const PolymorphismMultiGContainer& pmgc,
+    vector<size_t> locusPositions,
+    set<size_t> groups,
+    unsigned int nbPerm,
+    uint64_t seed,
+    unsigned int nbThreads)
+{
+  return wcPermutationTest_(pmgc, locusPositions, groups, nbPerm, true, nbThreads,
+      [seed](unsigned int i, const GenotypeMatrix& source, GenotypeMatrix& target, PolymorphismMultiGContainerTools::PermutationWorkspace& workspace) {
+        CounterBasedGenerator generator(seed, i);
+        PolymorphismMultiGContainerTools::permuteIntraGroupAlleles(source, target, workspace, generator);
+      });
+}
+
+map<pair<size_t, size_t>, MultilocusGenotypeStatistics::PermResults> MultilocusGenotypeStatistics::getWCPairwiseFstAndPerm(
+    const PolymorphismMultiGContainer& pmgc,
+    const vector<size_t>& locusPositions,
+    const set<size_t>& groups,
+    unsigned int nbPerm)
+{
+  return wcPairwisePermutationTest_(pmgc, locusPositions, groups, nbPerm, 1,
+      [](const pair<size_t, size_t>&, unsigned int, const GenotypeMatrix& source, GenotypeMatrix& target, PolymorphismMultiGContainerTools::PermutationWorkspace& workspace) {
+        PolymorphismMultiGContainerTools::permuteMultiG(source, target, workspace, RandomTools::DEFAULT_GENERATOR);
+      });
+}
+
+map<pair<size_t, size_t>, MultilocusGenotypeStatistics::PermResults> MultilocusGenotypeStatistics::getWCPairwiseFstAndPerm(
+    const PolymorphismMultiGContainer& pmgc,
+    const vector<size_t>& locusPositions,
+    const set<size_t>& groups,
+    unsigned int nbPerm,
+    uint64_t seed,
+    unsigned int nbThreads)
+{
+  return wcPairwisePermutationTest_(pmgc, locusPositions, groups, nbPerm, nbThreads,
+      [seed](const pair<size_t, size_t>& ids, unsigned int i, const GenotypeMatrix& source, GenotypeMatrix& target, PolymorphismMultiGContainerTools::PermutationWorkspace& workspace) {
+        CounterBasedGenerator generator(getPairSeed(seed, ids.first, ids.second), i);
+        PolymorphismMultiGContainerTools::permuteMultiG(source, target, workspace, generator);
+      });
+}
+
+uint64_t MultilocusGenotypeStatistics::getPairSeed(uint64_t seed, size_t grp1, size_t grp2)
+{
+  CounterBasedGenerator generator(seed, static_cast<uint64_t>(grp1));
+  generator.discard(static_cast<uint64_t>(grp2));
+  return generator();
+}
+
+MultilocusGenotypeStatistics::PermResults MultilocusGenotypeStatistics::wcPermutationTest_(
+    const PolymorphismMultiGContainer& pmgc,
+    const vector<size_t>& locusPositions,
+    const set<size_t>& groups,
+    unsigned int nbPerm,
+    bool fis,
+    unsigned int nbThreads,
+    const function<void(
+        unsigned int,
+        const GenotypeMatrix&,
+        GenotypeMatrix&,
+        PolymorphismMultiGContainerTools::PermutationWorkspace&)>& permute)
+{
+  string method = fis ? "MultilocusGenotypeStatistics::getWCMultilocusFisAndPerm" : "MultilocusGenotypeStatistics::getWCMultilocusFstAndPerm";
+  auto matrix = pmgc.getGenotypeMatrix();
+  // The permuted data sets are counted in a copy of the table of the
+  // container, and their variance components computed again, at the tested
+  // loci only.
+  AlleleCountTable table(*pmgc.getAlleleCountTable());
+  for (auto locus : locusPositions)
   {
-    it->second = it->second / (r * nbar);
+    checkLocus_(table, locus, method);
   }
-  for (map<size_t, double>::iterator it = hbar.begin(); it != hbar.end(); it++)
+  VarianceComponentTable components(table, groups);
+  auto statistic = [&](const VarianceComponentTable& values) {
+    return fis ? values.getFis(locusPositions) : values.getFst(locusPositions);
+  };
+  double observed = statistic(components);
+
+  // Each thread permutes its own copy of the matrix, and counts it in its
+  // own copies of the tables.
+  nbThreads = ParallelTools::getNumberOfThreads(nbThreads, nbPerm);
+  vector<GenotypeMatrix> permutedMatrices(nbThreads, *matrix);
+  vector<PolymorphismMultiGContainerTools::PermutationWorkspace> workspaces(nbThreads, PolymorphismMultiGContainerTools::PermutationWorkspace(*matrix, groups, locusPositions));
+  vector<AlleleCountTable> tables(nbThreads, table);
+  vector<VarianceComponentTable> componentTables(nbThreads, components);
+  return permutationTest_(observed, nbPerm, nbThreads,
+      [&](unsigned int i, unsigned int t) {
+        permute(i, *matrix, permutedMatrices[t], workspaces[t]);
+        tables[t].recount(permutedMatrices[t], locusPositions, workspaces[t].getIndividuals());
+        componentTables[t].update(tables[t], locusPositions);
+        return statistic(componentTables[t]);
+      });
+}
+
+map<pair<size_t, size_t>, MultilocusGenotypeStatistics::PermResults> MultilocusGenotypeStatistics::wcPairwisePermutationTest_(
+    const PolymorphismMultiGContainer& pmgc,
+    const vector<size_t>& locusPositions,
+    const set<size_t>& groups,
+    unsigned int nbPerm,
+    unsigned int nbThreads,
+    const function<void(
+        const pair<size_t, size_t>&,
+        unsigned int,
+        const GenotypeMatrix&,
+        GenotypeMatrix&,
+        PolymorphismMultiGContainerTools::PermutationWorkspace&)>& permute)
+{
+  string method = "MultilocusGenotypeStatistics::getWCPairwiseFstAndPerm";
+  auto matrix = pmgc.getGenotypeMatrix();
+  auto observedTable = pmgc.getAlleleCountTable();
+  for (auto locus : locusPositions)
   {
-    it->second = it->second / ( r * nbar);
+    checkLocus_(*observedTable, locus, method);
   }
+  // The permuted data sets of all pairs are written in the same copy of the
+  // genotype matrix, and counted in the same copy of the table, one per
+  // thread. Only the individuals of the tested pair are counted, and only
+  // their two groups are read.
+  nbThreads = ParallelTools::getNumberOfThreads(nbThreads, nbPerm);
+  vector<AlleleCountTable> tables(nbThreads, *observedTable);
+  vector<GenotypeMatrix> permutedMatrices(nbThreads, *matrix);
+  auto fst = [&](const AlleleCountTable& counts, const vector<size_t>& pair) {
+    VarComp sums = sumVarianceComponents_(counts, locusPositions, pair, 2, method);
+    if ((sums.a + sums.b + sums.c) == 0)
+      throw ZeroDivisionException(method + ".");
+    return sums.a / (sums.a + sums.b + sums.c);
+  };
 
-  for (set<size_t>::iterator set_it = groups.begin(); set_it != groups.end(); set_it++)
+  map<pair<size_t, size_t>, PermResults> results;
+  vector<size_t> ids(groups.begin(), groups.end());
+  for (size_t j = 0; j + 1 < ids.size(); ++j)
   {
-    size_t i  = (*set_it);
-    double ni = static_cast<double>(pmgc.getLocusGroupSize( i, locusPosition));
-    set<size_t> group_id;
-    group_id.insert( i );
-    map<size_t, double> pi = getAllelesFrqForGroups(pmgc, locusPosition, group_id);
-    for (size_t j = 0; j < ids.size(); j++)
-    {
-      pi[ids[j]];
-    }
-    for (map<size_t, double>::iterator it = pi.begin(); it != pi.end(); it++)
+    for (size_t k = j + 1; k < ids.size(); ++k)
     {
-      s2[it->first] += ni * (it->second - pbar[it->first]) * (it->second - pbar[it->first]);
+      set<size_t> pairIds = {ids[j], ids[k]};
+      std::pair<size_t, size_t> key = make_pair(ids[j], ids[k]);
+      vector<size_t> pair = observedTable->getGroupIndices(pairIds);
+      double observed = fst(*observedTable, pair);
+      vector<PolymorphismMultiGContainerTools::PermutationWorkspace> workspaces(nbThreads, PolymorphismMultiGContainerTools::PermutationWorkspace(*matrix, pairIds, locusPositions));
+      results[key] = permutationTest_(observed, nbPerm, nbThreads,
+          [&](unsigned int i, unsigned int t) {
+            permute(key, i, *matrix, permutedMatrices[t], workspaces[t]);
+            tables[t].recount(permutedMatrices[t], locusPositions, workspaces[t].getIndividuals());
+            return fst(tables[t], pair);
+          });
     }
-    group_id.clear();
   }
-  for (map<size_t, double>::iterator it = s2.begin(); it != s2.end(); it++)
+  return results;
+}
+
+MultilocusGenotypeStatistics::PermResults MultilocusGenotypeStatistics::permutationTest_(
+    double statistic,
+    unsigned int nbPerm,
+    unsigned int nbThreads,
+    const std::function<double(unsigned int, unsigned int)>& permutedStatistic)
+{
+  PermResults results;
+  results.statistic = statistic;
+  results.percentSup = 0.0;
+  results.percentInf = 0.0;
+  if (nbPerm == 0)
+    return results;
+
+  // Each thread counts its own permutations, so that the results do not
+  // depend on the scheduling.
+  vector<unsigned int> nbSup(nbThreads, 0);
+  vector<unsigned int> nbInf(nbThreads, 0);
+  ParallelTools::parallelFor(nbPerm, nbThreads,
+      [&](size_t i, unsigned int t) {
+        double statPerm = permutedStatistic(static_cast<unsigned int>(i), t);
+        if (statPerm > statistic)
+          nbSup[t]++;
+        if (statPerm < statistic)
+          nbInf[t]++;
+      });
+
+  double sup = 0.0;
+  double inf = 0.0;
+  for (unsigned int t = 0; t < nbThreads; ++t)
   {
-    it->second = it->second / ((r - 1.) * nbar);
+    sup += nbSup[t];
+    inf += nbInf[t];
   }
+  results.percentSup = sup / static_cast<double>(nbPerm);
+  results.percentInf = inf / static_cast<double>(nbPerm);
+  return results;
+}
+
+double MultilocusGenotypeStatistics::getRHMultilocusFst(
+    const PolymorphismMultiGContainer& pmgc,
+    vector<size_t> locusPositions,
+    const set<size_t>& groups)
+{
+  auto table = pmgc.getAlleleCountTable();
+  return getDistance_(*table, locusPositions, table->getGroupIndices(groups), groups.size(), "RH", "MultilocusGenotypeStatistics::getRHMultilocusFst");
+}
 
-  // a, b, c computation
-  for (size_t i = 0; i < ids.size(); i++)
+std::unique_ptr<DistanceMatrix> MultilocusGenotypeStatistics::getDistanceMatrix(const PolymorphismMultiGContainer& pmgc, vector<size_t> locusPositions, const set<size_t>& groups, string distance_methode, unsigned int nbThreads)
+{
+  vector<string> names = pmgc.getAllGroupsNames();
+  vector<size_t> grp_ids_vect(groups.begin(), groups.end());
+
+  unique_ptr<DistanceMatrix> _dist(new DistanceMatrix(names));
+  for (size_t i = 0; i < groups.size(); i++)
   {
-    values[ids[i]];
+    (*_dist)(i, i) = 0;
   }
 
-  for (map<size_t, MultilocusGenotypeStatistics::VarComp>::iterator it = values.begin(); it != values.end(); it++)
+  // All pairs read the allele frequencies of the groups from the allele
+  // count table of the container, which are computed only once.
+  auto table = pmgc.getAlleleCountTable();
+  for (auto locus : locusPositions)
   {
-    it->second.a = (nbar / nc) * (s2[it->first] - ((1. / (nbar - 1.)) * ((pbar[it->first] * (1. - pbar[it->first])) - (s2[it->first] * ((double) r - 1.) / r) - ((1. / 4.) * hbar[it->first]))));
-    it->second.b = (nbar / (nbar - 1.)) * ((pbar[it->first] * (1. - pbar[it->first])) - (s2[it->first] * ((double) r - 1.) / (double) r) - ((((2. * nbar) - 1.) / (4. * nbar)) * hbar[it->first]));
-    it->second.c = hbar[it->first] / 2.;
+    checkLocus_(*table, locus, "MultilocusGenotypeStatistics::getDistanceMatrix");
   }
-  return values;
+  // Pairs are distributed between threads, each writing only its own cells.
+  vector<pair<size_t, size_t>> pairs;
+  for (size_t j = 0; j + 1 < groups.size(); j++)
+  {
+    for (size_t k = j + 1; k < groups.size(); k++)
+    {
+      pairs.push_back(make_pair(j, k));
+    }
+  }
+  nbThreads = ParallelTools::getNumberOfThreads(nbThreads, pairs.size());
+  ParallelTools::parallelFor(pairs.size(), nbThreads,
+      [&](size_t p, unsigned int) {
+        size_t j = pairs[p].first;
+        size_t k = pairs[p].second;
+        vector<size_t> pair = table->getGroupIndices({grp_ids_vect[j], grp_ids_vect[k]});
+        double distance = 0;
+        if (isDistance_(distance_methode))
+          distance = getDistance_(*table, locusPositions, pair, 2, distance_methode, "MultilocusGenotypeStatistics::getDistanceMatrix");
+        (*_dist)(k, j) =  distance;
+        (*_dist)(j, k) =  distance;
+      });
+
+  return _dist;
 }
 
-double MultilocusGenotypeStatistics::getWCMultilocusFst(const PolymorphismMultiGContainer& pmgc, vector<size_t> locusPositions, const set<size_t>& groups)
+vector<double> MultilocusGenotypeStatistics::getWCMultilocusFstBootstrap(
+    const PolymorphismMultiGContainer& pmgc,
+    const vector<size_t>& locusPositions,
+    const set<size_t>& groups,
+    size_t nbReplicates,
+    uint64_t seed,
+    unsigned int nbThreads)
 {
-  double A, B, C;
-  A = B = C = 0.0;
-  for (size_t i = 0; i < locusPositions.size(); i++)
+  auto table = pmgc.getAlleleCountTable();
+  vector<double> terms;
+  getDistanceTerms_(*table, locusPositions, table->getGroupIndices(groups), groups.size(), "WC", "MultilocusGenotypeStatistics::getWCMultilocusFstBootstrap", terms);
+  vector<double> replicates(nbReplicates);
+  nbThreads = ParallelTools::getNumberOfThreads(nbThreads, nbReplicates);
+  vector<vector<unsigned int>> weights(nbThreads);
+  ParallelTools::parallelFor(nbReplicates, nbThreads,
+      [&](size_t r, unsigned int t) {
+        drawLoci_(locusPositions.size(), seed, r, weights[t]);
+        replicates[r] = getReplicateDistance_(terms, weights[t], "WC");
+      });
+  return replicates;
+}
+
+vector<unique_ptr<DistanceMatrix>> MultilocusGenotypeStatistics::getDistanceMatrixBootstrap(
+    const PolymorphismMultiGContainer& pmgc,
+    const vector<size_t>& locusPositions,
+    const set<size_t>& groups,
+    const string& distance_methode,
+    size_t nbReplicates,
+    uint64_t seed,
+    unsigned int nbThreads)
+{
+  string method = "MultilocusGenotypeStatistics::getDistanceMatrixBootstrap";
+  if (!isDistance_(distance_methode))
+    throw Exception(method + ": unknown distance " + distance_methode + ".");
+  vector<string> names = pmgc.getAllGroupsNames();
+  vector<size_t> ids(groups.begin(), groups.end());
+  auto table = pmgc.getAlleleCountTable();
+
+  // The terms of all pairs at all loci, computed once.
+  vector<pair<size_t, size_t>> pairs;
+  for (size_t j = 0; j + 1 < ids.size(); ++j)
   {
-    // count total number of individuals without missing data
-    size_t ni = 0;
-    for (set<size_t>::iterator setIt = groups.begin(); setIt != groups.end(); setIt++)
+    for (size_t k = j + 1; k < ids.size(); ++k)
     {
-      ni += pmgc.getLocusGroupSize( (*setIt), i);
+      pairs.push_back(make_pair(j, k));
     }
+  }
+  for (auto locus : locusPositions)
+  {
+    checkLocus_(*table, locus, method);
+  }
+  vector<vector<double>> terms(pairs.size());
+  ParallelTools::parallelFor(pairs.size(), ParallelTools::getNumberOfThreads(nbThreads, pairs.size()),
+      [&](size_t p, unsigned int) {
+        getDistanceTerms_(*table, locusPositions, table->getGroupIndices({ids[pairs[p].first], ids[pairs[p].second]}), 2, distance_methode, method, terms[p]);
+      });
 
-    // reduce computation for polymorphic loci for that groups
-    vector<size_t> ids = getAllelesIdsForGroups(pmgc, i, groups);
-    if (ids.size() >= 2 && ni >= 1)
+  // Each replicate writes its own matrix.
+  vector<unique_ptr<DistanceMatrix>> replicates(nbReplicates);
+  nbThreads = ParallelTools::getNumberOfThreads(nbThreads, nbReplicates);
+  vector<vector<unsigned int>> weights(nbThreads);
+  ParallelTools::parallelFor(nbReplicates, nbThreads,
+      [&](size_t r, unsigned int t) {
+        drawLoci_(locusPositions.size(), seed, r, weights[t]);
+        unique_ptr<DistanceMatrix> dist(new DistanceMatrix(names));
+        for (size_t i = 0; i < ids.size(); ++i)
+        {
+          (*dist)(i, i) = 0;
+        }
+        for (size_t p = 0; p < pairs.size(); ++p)
+        {
+          double distance = getReplicateDistance_(terms[p], weights[t], distance_methode);
+          (*dist)(pairs[p].second, pairs[p].first) = distance;
+          (*dist)(pairs[p].first, pairs[p].second) = distance;
+        }
+        replicates[r] = move(dist);
+      });
+  return replicates;
+}
+
+vector<size_t> MultilocusGenotypeStatistics::getGroupIndices_(
+    const AlleleCountTable& table,
+    size_t locusPosition,
+    const set<size_t>& groups,
+    const string& method)
+{
+  checkLocus_(table, locusPosition, method);
+  return table.getGroupIndices(groups);
+}
+
+void MultilocusGenotypeStatistics::checkLocus_(
+    const AlleleCountTable& table,
+    size_t locusPosition,
+    const string& method)
+{
+  if (locusPosition >= table.getNumberOfLoci())
+    throw IndexOutOfBoundsException(method + ": locusPosition out of bounds.", locusPosition, 0, table.getNumberOfLoci());
+}
+
+MultilocusGenotypeStatistics::VarComp MultilocusGenotypeStatistics::sumVarianceComponents_(
+    const AlleleCountTable& table,
+    const vector<size_t>& locusPositions,
+    const vector<size_t>& groups,
+    size_t nbGroups,
+    const string& method,
+    unsigned int nbThreads)
+{
+  for (auto locus : locusPositions)
+  {
+    checkLocus_(table, locus, method);
+  }
+  // The components of each locus are computed in a slot of their own, and
+  // summed in the order of the loci, so that the result does not depend on
+  // the number of threads.
+  vector<vector<VarComp>> values(locusPositions.size());
+  nbThreads = ParallelTools::getNumberOfThreads(nbThreads, locusPositions.size());
+  vector<vector<size_t>> alleles(nbThreads);
+  ParallelTools::parallelFor(locusPositions.size(), nbThreads,
+      [&](size_t i, unsigned int t) {
+        size_t locus = locusPositions[i];
+        // count total number of individuals without missing data
+        size_t ni = 0;
+        for (auto j : groups)
+        {
+          ni += table.getNumberOfNonMissing(locus, j);
+        }
+
+        // reduce computation for polymorphic loci for that groups
+        getAlleles_(table, locus, groups, alleles[t]);
+        if (alleles[t].size() >= 2 && ni >= 1)
+          getVarianceComponents_(table, locus, groups, nbGroups, alleles[t], values[i]);
+      });
+  VarComp sums = {0., 0., 0.};
+  for (const auto& locusValues : values)
+  {
+    for (const auto& v : locusValues)
     {
-      map<size_t, MultilocusGenotypeStatistics::VarComp> values = getVarianceComponents(pmgc, locusPositions[i], groups);
-      for (map<size_t, MultilocusGenotypeStatistics::VarComp>::iterator it = values.begin(); it != values.end(); it++)
-      {
-        A += it->second.a;
-        B += it->second.b;
-        C += it->second.c;
-      }
+      sums.a += v.a;
+      sums.b += v.b;
+      sums.c += v.c;
     }
   }
-  if ((A + B + C) == 0)
-    throw ZeroDivisionException("MultilocusGenotypeStatistics::getWCMultilocusFst.");
-  return A / (A + B + C);
+  return sums;
+}
+
+bool MultilocusGenotypeStatistics::isDistance_(const string& distance_methode)
+{
+  return distance_methode == "nei72" || distance_methode == "nei78" || distance_methode == "WC"
+         || distance_methode == "RH" || distance_methode == "Nm" || distance_methode == "D"
+         || distance_methode == "Rousset";
 }
 
-double MultilocusGenotypeStatistics::getWCMultilocusFis(const PolymorphismMultiGContainer& pmgc, vector<size_t> locusPositions, const set<size_t>& groups)
+void MultilocusGenotypeStatistics::getDistanceTerms_(
+    const AlleleCountTable& table,
+    const vector<size_t>& locusPositions,
+    const vector<size_t>& groups,
+    size_t nbGroups,
+    const string& distance_methode,
+    const string& method,
+    vector<double>& terms)
 {
-  double B, C;
-  B = C = 0.0;
-  for (size_t i = 0; i < locusPositions.size(); i++)
+  // Groups without individuals have no allele frequency.
+  if (groups.size() < nbGroups)
+    throw ZeroDivisionException(method + ".");
+  terms.assign(3 * locusPositions.size(), 0.);
+  bool nei = distance_methode == "nei72" || distance_methode == "nei78";
+  vector<size_t> alleles;
+  vector<VarComp> values;
+  for (size_t i = 0; i < locusPositions.size(); ++i)
   {
-    // count total number of individuals without missing data
-    size_t ni = 0;
-    for (set<size_t>::iterator setIt = groups.begin(); setIt != groups.end(); setIt++)
+    size_t locus = locusPositions[i];
+    checkLocus_(table, locus, method);
+    double* t = &terms[3 * i];
+    if (nei)
     {
-      ni += pmgc.getLocusGroupSize( (*setIt), i);
+      // Jx, Jy and Jxy
+      size_t g1 = groups[0];
+      size_t g2 = groups[1];
+      if (table.getNumberOfAlleleCopies(locus, g1) == 0 || table.getNumberOfAlleleCopies(locus, g2) == 0)
+        throw ZeroDivisionException(method + ".");
+      for (size_t a = 0; a < table.getNumberOfAlleles(locus); ++a)
+      {
+        t[2] += table.getAlleleFrequency(locus, a, g1) * table.getAlleleFrequency(locus, a, g2);
+      }
+      if (distance_methode == "nei78")
+      {
+        double nx = table.getNumberOfBiAllelic(locus, g1);
+        double ny = table.getNumberOfBiAllelic(locus, g2);
+        t[0] = ((2. * nx * table.getHomozygosity(locus, g1)) - 1.) / ((2. * nx) - 1.);
+        t[1] = ((2. * ny * table.getHomozygosity(locus, g2)) - 1.) / ((2. * ny) - 1.);
+      }
+      else
+      {
+        t[0] = table.getHomozygosity(locus, g1);
+        t[1] = table.getHomozygosity(locus, g2);
+      }
+      continue;
     }
 
     // reduce computation for polymorphic loci for that groups
-    vector<size_t> ids = getAllelesIdsForGroups(pmgc, i, groups);
-    if (ids.size() >= 2 && ni >= 1)
+    getAlleles_(table, locus, groups, alleles);
+    if (alleles.size() < 2)
+      continue;
+    getVarianceComponents_(table, locus, groups, nbGroups, alleles, values);
+    if (distance_methode == "RH")
     {
-      map<size_t, MultilocusGenotypeStatistics::VarComp> values = getVarianceComponents(pmgc, locusPositions[i], groups);
-      for (map<size_t, MultilocusGenotypeStatistics::VarComp>::iterator it = values.begin(); it != values.end(); it++)
+      // Fst of each allele weighted by 1 - its mean frequency, and the
+      // number of independent alleles
+      double total = 0.;
+      for (size_t u = 0; u < alleles.size(); ++u)
       {
-        B += it->second.b;
-        C += it->second.c;
+        for (auto j : groups)
+        {
+          total += table.getAlleleCount(locus, alleles[u], j);
+        }
+      }
+      int nbAlleles = 0;
+      for (size_t u = 0; u < alleles.size(); ++u)
+      {
+        double abc = values[u].a + values[u].b + values[u].c;
+        if (abc != 0)
+        {
+          double Pu = 0.;
+          for (auto j : groups)
+          {
+            Pu += table.getAlleleCount(locus, alleles[u], j);
+          }
+          Pu /= total;
+          t[0] += (1 - Pu) * values[u].a / abc;
+          nbAlleles++;
+        }
+      }
+      t[1] = nbAlleles - 1.;
+    }
+    else
+    {
+      // a, b and c
+      for (const auto& v : values)
+      {
+        t[0] += v.a;
+        t[1] += v.b;
+        t[2] += v.c;
       }
     }
   }
-  if ((B + C) == 0)
-    throw ZeroDivisionException("MultilocusGenotypeStatistics::getWCMultilocusFis.");
-  return 1.0 - C / (B + C);
 }
 
-MultilocusGenotypeStatistics::PermResults MultilocusGenotypeStatistics::getWCMultilocusFstAndPerm(
-    const PolymorphismMultiGContainer& pmgc,
-    vector<size_t> locusPositions,
-    set<size_t> groups,
-    unsigned int nbPerm)
+double MultilocusGenotypeStatistics::getDistance_(
+    const AlleleCountTable& table,
+    const vector<size_t>& locusPositions,
+    const vector<size_t>& groups,
+    size_t nbGroups,
+    const string& distance_methode,
+    const string& method)
 {
-  // extract a PolymorphismMultiGContainer with only those groups
-  auto subPmgc = PolymorphismMultiGContainerTools::extractGroups(pmgc, groups);
-  double nbSup = 0.0;
-  double nbInf = 0.0;
-  PermResults results;
-  results.statistic = getWCMultilocusFst(*subPmgc, locusPositions, groups);
-  if (nbPerm > 0)
+  vector<double> terms;
+  getDistanceTerms_(table, locusPositions, groups, nbGroups, distance_methode, method, terms);
+  double sums[3] = {0., 0., 0.};
+  for (size_t i = 0; i < terms.size(); ++i)
   {
-    for (size_t i = 0; i < nbPerm; ++i)
-    {
-      auto permutedPmgc = PolymorphismMultiGContainerTools::permuteMultiG(*subPmgc);
-      double FstPerm = getWCMultilocusFst(*permutedPmgc, locusPositions, groups);
-      // cout << Fst_perm << endl;
-      if (FstPerm > results.statistic)
-        nbSup++;
-      if (FstPerm < results.statistic)
-        nbInf++;
-    }
+    sums[i % 3] += terms[i];
+  }
+  return getDistanceFromTerms_(sums, distance_methode, method);
+}
 
-    nbSup /= static_cast<double>(nbPerm);
-    nbInf /= static_cast<double>(nbPerm);
+double MultilocusGenotypeStatistics::getDistanceFromTerms_(
+    const double* sums,
+    const string& distance_methode,
+    const string& method)
+{
+  if (distance_methode == "nei72" || distance_methode == "nei78")
+  {
+    if (sums[0] * sums[1] == 0.)
+      throw ZeroDivisionException(method + ".");
+    return -log(sums[2] / sqrt(sums[0] * sums[1]));
+  }
+  if (distance_methode == "RH") // Fst multilocus selon ponderation Robertson & Hill
+  {
+    if (sums[1] == 0)
+      throw ZeroDivisionException(method + ".");
+    return sums[0] / sums[1];
   }
 
-  results.percentSup = nbSup;
-  results.percentInf = nbInf;
-  return results;
+  // Fst multilocus selon W&C
+  if ((sums[0] + sums[1] + sums[2]) == 0)
+    throw ZeroDivisionException(method + ".");
+  double distance = sums[0] / (sums[0] + sums[1] + sums[2]);
+  if (distance_methode == "Nm") // Nm déduit des Fst multilocus selon W&C modèle en îles Fst = 1/(1+4Nm)
+  {
+    if (distance != 0)
+      distance = 0.25 * (1 - distance) / distance;
+    else
+      distance = NAN;
+  }
+  else if (distance_methode == "D") // D=-ln(1-Fst) of Reynolds, Weir and Cockerham, 1983
+  {
+    if (distance != 1)
+      distance =  -log(1 - distance);
+    else
+      distance = NAN;
+  }
+  else if (distance_methode == "Rousset") // Calcul de Fst/(1-Fst). Rousset F. 1997
+  {
+    if (distance != 1)
+      distance = distance / (1 - distance);
+    else
+      distance = NAN;
+  }
+  return distance;
 }
 
-MultilocusGenotypeStatistics::PermResults MultilocusGenotypeStatistics::getWCMultilocusFisAndPerm(
-    const PolymorphismMultiGContainer& pmgc,
-    vector<size_t> locusPositions,
-    set<size_t> groups,
-    unsigned int nbPerm)
+void MultilocusGenotypeStatistics::drawLoci_(
+    size_t nbLoci,
+    uint64_t seed,
+    size_t replicate,
+    vector<unsigned int>& weights)
 {
-  // extract a PolymorphismMultiGContainer with only those groups
-  auto subPmgc =  PolymorphismMultiGContainerTools::extractGroups(pmgc, groups);
-  double nbSup = 0.0;
-  double nbInf = 0.0;
-  PermResults results;
-  results.statistic =  getWCMultilocusFis(*subPmgc, locusPositions, groups);
-  if (nbPerm > 0)
+  weights.assign(nbLoci, 0);
+  if (nbLoci == 0)
+    return;
+  CounterBasedGenerator generator(seed, static_cast<uint64_t>(replicate));
+  for (size_t k = 0; k < nbLoci; ++k)
   {
-    for (unsigned int i = 0; i < nbPerm; ++i)
-    {
-      auto permutedPmgc = PolymorphismMultiGContainerTools::permuteIntraGroupAlleles(*subPmgc, groups);
-      double FisPerm = getWCMultilocusFis(*permutedPmgc, locusPositions, groups);
+    weights[generator.drawInteger(nbLoci)]++;
+  }
+}
+
+double MultilocusGenotypeStatistics::getReplicateDistance_(
+    const vector<double>& terms,
+    const vector<unsigned int>& weights,
+    const string& distance_methode)
+{
+  double sums[3] = {0., 0., 0.};
+  for (size_t l = 0; l < weights.size(); ++l)
+  {
+    if (weights[l] == 0)
+      continue;
+    sums[0] += weights[l] * terms[3 * l];
+    sums[1] += weights[l] * terms[3 * l + 1];
+    sums[2] += weights[l] * terms[3 * l + 2];
+  }
+  try
+  {
+    return getDistanceFromTerms_(sums, distance_methode, "");
+  }
+  catch (ZeroDivisionException&)
+  {
+    return NAN;
+  }
+}
 
-      if (FisPerm > results.statistic)
-        nbSup++;
-      if (FisPerm < results.statistic)
-        nbInf++;
+void MultilocusGenotypeStatistics::getAlleles_(
+    const AlleleCountTable& table,
+    size_t locusPosition,
+    const vector<size_t>& groups,
+    vector<size_t>& alleles)
+{
+  alleles.clear();
+  for (size_t a = 0; a < table.getNumberOfAlleles(locusPosition); ++a)
+  {
+    for (auto g : groups)
+    {
+      if (table.getAlleleCount(locusPosition, a, g) > 0)
+      {
+        alleles.push_back(a);
+        break;
+      }
     }
+  }
+}
 
-    nbSup /= static_cast<double>(nbPerm);
-    nbInf /= static_cast<double>(nbPerm);
+void MultilocusGenotypeStatistics::getVarianceComponents_(
+    const AlleleCountTable& table,
+    size_t locusPosition,
+    const vector<size_t>& groups,
+    size_t nbGroups,
+    const vector<size_t>& alleles,
+    vector<VarComp>& values)
+{
+  // Groups without individuals have no allele frequency.
+  if (groups.size() < nbGroups)
+    throw ZeroDivisionException("MultilocusGenotypeStatistics::getVarianceComponents.");
+  size_t k = alleles.size();
+  vector<double> pbar(k, 0.), hbar(k, 0.), s2(k, 0.);
+  double r = static_cast<double>(nbGroups);
+  double nbar = 0.;
+  double sumN2 = 0.;
+  for (auto g : groups)
+  {
+    if (table.getNumberOfAlleleCopies(locusPosition, g) == 0 || table.getNumberOfBiAllelic(locusPosition, g) == 0)
+      throw ZeroDivisionException("MultilocusGenotypeStatistics::getVarianceComponents.");
+    double ni = static_cast<double>(table.getNumberOfNonMissing(locusPosition, g));
+    nbar += ni;
+    sumN2 += ni * ni;
+    for (size_t t = 0; t < k; ++t)
+    {
+      pbar[t] += ni * table.getAlleleFrequency(locusPosition, alleles[t], g);
+      hbar[t] += ni * table.getHeterozygousFrequency(locusPosition, alleles[t], g);
+    }
+  }
+  nbar = nbar / r;
+  if (nbar <= 1)
+    throw ZeroDivisionException("MultilocusGenotypeStatistics::getVarianceComponents.");
+  double nc = r > 1 ? ((r * nbar) - sumN2 / (r * nbar)) / (r - 1.) : 0.;
+  for (size_t t = 0; t < k; ++t)
+  {
+    pbar[t] /= r * nbar;
+    hbar[t] /= r * nbar;
+  }
+  for (auto g : groups)
+  {
+    double ni = static_cast<double>(table.getNumberOfNonMissing(locusPosition, g));
+    for (size_t t = 0; t < k; ++t)
+    {
+      double d = table.getAlleleFrequency(locusPosition, alleles[t], g) - pbar[t];
+      s2[t] += ni * d * d;
+    }
   }
 
-  results.percentSup = nbSup;
-  results.percentInf = nbInf;
-  return results;
+  values.resize(k);
+  for (size_t t = 0; t < k; ++t)
+  {
+    s2[t] /= (r - 1.) * nbar;
+    double pq = pbar[t] * (1. - pbar[t]);
+    values[t].a = (nbar / nc) * (s2[t] - ((1. / (nbar - 1.)) * (pq - (s2[t] * (r - 1.) / r) - ((1. / 4.) * hbar[t]))));
+    values[t].b = (nbar / (nbar - 1.)) * (pq - (s2[t] * (r - 1.) / r) - ((((2. * nbar) - 1.) / (4. * nbar)) * hbar[t]));
+    values[t].c = hbar[t] / 2.;
+  }
 }
 
-double MultilocusGenotypeStatistics::getRHMultilocusFst(
-    const PolymorphismMultiGContainer& pmgc,
-    vector<size_t> locusPositions,
-    const set<size_t>& groups)
+MultilocusGenotypeStatistics::HWResults MultilocusGenotypeStatistics::hwExactTest_(
+    const GenotypeCountTable& table,
+    size_t locusPosition,
+    const vector<size_t>& groups,
+    unsigned int dememorization,
+    unsigned int nbBatches,
+    unsigned int nbIterations,
+    uint64_t seed)
 {
-  double Au, Bu, Cu;
-  double RH = 0.0;
-  int nb_alleles = 0;
-  int total_alleles = 0;
-
-  for (size_t i = 0; i < locusPositions.size(); i++)
+  // Alleles present in the genotypes of the groups
+  size_t k = table.getNumberOfAlleles(locusPosition);
+  vector<size_t> alleles;
+  for (size_t i = 0; i < k; ++i)
   {
-    // reduce computation for polymorphic loci for that groups
-    vector<size_t> ids = getAllelesIdsForGroups(pmgc, i, groups);
-    if (ids.size() >= 2)
+    bool present = false;
+    for (size_t j = 0; j < k && !present; ++j)
     {
-      nb_alleles = 0;
-      // mean allelic frequencies
-      map<size_t, double> P = MultilocusGenotypeStatistics::getAllelesFrqForGroups (pmgc, locusPositions[i], groups);
-      // variance components from W&C
-      map<size_t, MultilocusGenotypeStatistics::VarComp> values = getVarianceComponents(pmgc, locusPositions[i], groups);
-      for (map<size_t, MultilocusGenotypeStatistics::VarComp>::iterator it = values.begin(); it != values.end(); it++)
+      for (auto g : groups)
       {
-        Au = it->second.a;
-        Bu = it->second.b;
-        Cu = it->second.c;
-        if ((Au + Bu + Cu) != 0)
+        if (table.getGenotypeCount(locusPosition, i, j, g) > 0)
         {
-          double Pu = P[it->first]; // it->first is the allele number
-          RH += (1 - Pu) * Au / (Au + Bu + Cu);
-          nb_alleles++;
+          present = true;
+          break;
         }
       }
-      total_alleles += (nb_alleles - 1);
     }
+    if (present)
+      alleles.push_back(i);
   }
-  if (total_alleles == 0)
-    throw ZeroDivisionException("MultilocusGenotypeStatistics::getRHMultilocusFst.");
-  return RH / double(total_alleles);
+
+  HWResults results;
+  if (alleles.size() < 2)
+  {
+    results.pValue = NAN;
+    results.standardError = NAN;
+    return results;
+  }
+
+  // Pooled genotype counts of the present alleles
+  vector<unsigned int> genotypes(alleles.size() * (alleles.size() + 1) / 2, 0);
+  for (size_t i = 0; i < alleles.size(); ++i)
+  {
+    for (size_t j = 0; j <= i; ++j)
+    {
+      for (auto g : groups)
+      {
+        genotypes[GenotypeCountTable::getGenotypeIndex(i, j)] += table.getGenotypeCount(locusPosition, alleles[i], alleles[j], g);
+      }
+    }
+  }
+
+  if (alleles.size() == 2)
+  {
+    results.pValue = hwBiAllelicTest_(genotypes[0], genotypes[1], genotypes[2]);
+    results.standardError = 0.;
+    return results;
+  }
+  CounterBasedGenerator generator(seed, static_cast<uint64_t>(locusPosition));
+  return hwMarkovChainTest_(genotypes, alleles.size(), dememorization, nbBatches, nbIterations, generator);
 }
 
-std::unique_ptr<DistanceMatrix> MultilocusGenotypeStatistics::getDistanceMatrix(const PolymorphismMultiGContainer& pmgc, vector<size_t> locusPositions, const set<size_t>& groups, string distance_methode)
+double MultilocusGenotypeStatistics::hwBiAllelicTest_(
+    unsigned int homozygotes1,
+    unsigned int heterozygotes,
+    unsigned int homozygotes2)
 {
-  vector<string> names = pmgc.getAllGroupsNames();
-  vector<size_t> grp_ids_vect;
-  for (set<size_t>::iterator i = groups.begin(); i != groups.end(); i++)
+  // Homozygotes for the rare and the common allele
+  unsigned int homr = min(homozygotes1, homozygotes2);
+  unsigned int homc = max(homozygotes1, homozygotes2);
+  unsigned int n = homr + heterozygotes + homc;
+  unsigned int rare = 2 * homr + heterozygotes;
+
+  // Probabilities of the numbers of heterozygotes, computed from the most
+  // likely one, which has the parity of the number of rare alleles
+  vector<double> probs(rare + 1, 0.);
+  unsigned int mid = static_cast<unsigned int>(static_cast<uint64_t>(rare) * (2 * n - rare) / (2 * n));
+  if ((rare & 1) != (mid & 1))
+    mid++;
+  probs[mid] = 1.;
+  double sum = 1.;
+  double r = (rare - mid) / 2;
+  double c = n - mid - r;
+  for (unsigned int h = mid; h > 1; h -= 2)
   {
-    grp_ids_vect.push_back(*i);
+    probs[h - 2] = probs[h] * h * (h - 1.) / (4. * (r + 1.) * (c + 1.));
+    sum += probs[h - 2];
+    r++;
+    c++;
   }
-
-  unique_ptr<DistanceMatrix> _dist(new DistanceMatrix(names));
-  for (size_t i = 0; i < groups.size(); i++)
+  r = (rare - mid) / 2;
+  c = n - mid - r;
+  for (unsigned int h = mid; h + 2 <= rare; h += 2)
   {
-    (*_dist)(i, i) = 0;
+    probs[h + 2] = probs[h] * 4. * r * c / ((h + 2.) * (h + 1.));
+    sum += probs[h + 2];
+    r--;
+    c--;
   }
 
-  set<size_t> pairwise_grp;
+  double observed = probs[heterozygotes];
+  double pValue = 0.;
+  for (auto p : probs)
+  {
+    // Tolerance for rounding errors on tables as probable as the observed one
+    if (p <= observed * (1. + 1e-7))
+      pValue += p;
+  }
+  return min(1., pValue / sum);
+}
 
-  for (size_t j = 0; j < groups.size () - 1; j++)
+MultilocusGenotypeStatistics::HWResults MultilocusGenotypeStatistics::hwMarkovChainTest_(
+    vector<unsigned int>& genotypes,
+    size_t nbAlleles,
+    unsigned int dememorization,
+    unsigned int nbBatches,
+    unsigned int nbIterations,
+    CounterBasedGenerator& generator)
+{
+  unsigned int n = 0;
+  for (auto count : genotypes)
+  {
+    n += count;
+  }
+  // The log of the probability of a table, up to a constant, is the sum
+  // over genotypes of n_ij log(2) for heterozygotes minus log(n_ij!).
+  vector<double> logFactorials(n + 3, 0.);
+  for (size_t i = 2; i < logFactorials.size(); ++i)
   {
-    for (size_t k = j + 1; k < groups.size (); k++)
+    logFactorials[i] = logFactorials[i - 1] + log(static_cast<double>(i));
+  }
+  double log2 = log(2.);
+  auto term = [&](unsigned int count, bool heterozygote) {
+    return (heterozygote ? count * log2 : 0.) - logFactorials[count];
+  };
+  double observed = 0.;
+  for (size_t i = 0; i < nbAlleles; ++i)
+  {
+    for (size_t j = 0; j <= i; ++j)
     {
-      double distance = 0;
-      if (distance_methode ==  "nei72")
-        distance = MultilocusGenotypeStatistics::getDnei72( pmgc, locusPositions, grp_ids_vect[j], grp_ids_vect[k] );
-      else if  (distance_methode == "nei78")
-        distance = MultilocusGenotypeStatistics::getDnei78( pmgc, locusPositions, grp_ids_vect[j], grp_ids_vect[k] );
-      else if (distance_methode == "WC") // Fst multilocus selon W&C
-      {
-        pairwise_grp.insert(grp_ids_vect[j] );
-        pairwise_grp.insert(grp_ids_vect[k] );
-        distance = MultilocusGenotypeStatistics::getWCMultilocusFst( pmgc, locusPositions, pairwise_grp);
-        pairwise_grp.clear();
-      }
-      else if (distance_methode == "RH") // Fst multilocus selon ponderation Robertson & Hill
-      {
-        pairwise_grp.insert(grp_ids_vect[j] );
-        pairwise_grp.insert(grp_ids_vect[k] );
-        distance = MultilocusGenotypeStatistics::getRHMultilocusFst( pmgc, locusPositions, pairwise_grp);
-        pairwise_grp.clear();
-      }
-      else if (distance_methode == "Nm") // Nm déduit des Fst multilocus selon W&C modèle en îles Fst = 1/(1+4Nm)
-      {
-        pairwise_grp.insert(grp_ids_vect[j] );
-        pairwise_grp.insert(grp_ids_vect[k] );
-        distance = MultilocusGenotypeStatistics::getWCMultilocusFst( pmgc, locusPositions, pairwise_grp);
-        if (distance != 0)
-          distance = 0.25 * (1 - distance) / distance;
-        else
-          distance = NAN;
-        pairwise_grp.clear();
-      }
-      else if (distance_methode == "D") // D=-ln(1-Fst) of Reynolds, Weir and Cockerham, 1983
-      {
-        pairwise_grp.insert(grp_ids_vect[j] );
-        pairwise_grp.insert(grp_ids_vect[k] );
-        distance = MultilocusGenotypeStatistics::getWCMultilocusFst( pmgc, locusPositions, pairwise_grp);
-        if (distance != 1)
-          distance =  -log(1 - distance);
-        else
-          distance = NAN;
-        pairwise_grp.clear();
-      }
-      else if (distance_methode == "Rousset") // Calcul de Fst/(1-Fst). Rousset F. 1997
-      {
-        pairwise_grp.insert(grp_ids_vect[j] );
-        pairwise_grp.insert(grp_ids_vect[k] );
-        distance = MultilocusGenotypeStatistics::getWCMultilocusFst( pmgc, locusPositions, pairwise_grp);
-        if (distance != 1)
-          distance = distance / (1 - distance);
-        else
-          distance = NAN;
-        pairwise_grp.clear();
-      }
+      observed += term(genotypes[GenotypeCountTable::getGenotypeIndex(i, j)], i != j);
+    }
+  }
+  double current = observed;
+  double tolerance = 1e-7 * max(1., fabs(observed));
 
-      (*_dist)(k, j) =  distance;
-      (*_dist)(j, k) =  distance;
-    } // for k
-  } // for j
+  // One step: the genotypes {i1, j1} and {i2, j2} gain one individual and
+  // {i1, j2} and {i2, j1} lose one, which keeps the allele counts. The
+  // reverse move is drawn with the same probability, by swapping j1 and j2.
+  auto step = [&]() {
+    size_t i1 = generator.drawInteger(nbAlleles);
+    size_t i2 = generator.drawInteger(nbAlleles);
+    size_t j1 = generator.drawInteger(nbAlleles);
+    size_t j2 = generator.drawInteger(nbAlleles);
+    if (i1 == i2 || j1 == j2)
+      return;
+    size_t plus1 = GenotypeCountTable::getGenotypeIndex(i1, j1);
+    size_t plus2 = GenotypeCountTable::getGenotypeIndex(i2, j2);
+    size_t minus1 = GenotypeCountTable::getGenotypeIndex(i1, j2);
+    size_t minus2 = GenotypeCountTable::getGenotypeIndex(i2, j1);
+    double delta = 0.;
+    if (minus1 == minus2)
+    {
+      if (genotypes[minus1] < 2)
+        return;
+      delta += term(genotypes[minus1] - 2, i1 != j2) - term(genotypes[minus1], i1 != j2);
+    }
+    else
+    {
+      if (genotypes[minus1] == 0 || genotypes[minus2] == 0)
+        return;
+      delta += term(genotypes[minus1] - 1, i1 != j2) - term(genotypes[minus1], i1 != j2);
+      delta += term(genotypes[minus2] - 1, i2 != j1) - term(genotypes[minus2], i2 != j1);
+    }
+    if (plus1 == plus2)
+      delta += term(genotypes[plus1] + 2, i1 != j1) - term(genotypes[plus1], i1 != j1);
+    else
+    {
+      delta += term(genotypes[plus1] + 1, i1 != j1) - term(genotypes[plus1], i1 != j1);
+      delta += term(genotypes[plus2] + 1, i2 != j2) - term(genotypes[plus2], i2 != j2);
+    }
+    if (delta < 0. && generator.drawUniform() >= exp(delta))
+      return;
+    genotypes[minus1]--;
+    genotypes[minus2]--;
+    genotypes[plus1]++;
+    genotypes[plus2]++;
+    current += delta;
+  };
 
-  return _dist;
+  for (unsigned int t = 0; t < dememorization; ++t)
+  {
+    step();
+  }
+  double mean = 0.;
+  double sumOfSquares = 0.;
+  for (unsigned int b = 0; b < nbBatches; ++b)
+  {
+    unsigned int hits = 0;
+    for (unsigned int t = 0; t < nbIterations; ++t)
+    {
+      step();
+      if (current <= observed + tolerance)
+        hits++;
+    }
+    double p = static_cast<double>(hits) / nbIterations;
+    mean += p;
+    sumOfSquares += p * p;
+  }
+  HWResults results;
+  results.pValue = mean / nbBatches;
+  results.standardError = nbBatches > 1 ? sqrt(max(0., sumOfSquares / nbBatches - results.pValue * results.pValue) / (nbBatches - 1.)) : NAN;
+  return results;
 }
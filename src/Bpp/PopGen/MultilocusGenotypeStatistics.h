@@ -11,6 +11,8 @@
 #include <map>
 #include <set>
 #include <memory>
+#include <cstdint>
+#include <functional>
 
 #include <Bpp/Exceptions.h>
 
@@ -19,16 +21,26 @@
 
 // From bpp-popgen
 #include "PolymorphismMultiGContainer.h"
+#include "PolymorphismMultiGContainerTools.h"
 #include "MultilocusGenotype.h"
+#include "CounterBasedGenerator.h"
 #include "GeneralExceptions.h"
 
 namespace bpp
 {
+class AlleleCountTable;
+class GenotypeCountTable;
+class VarianceComponentTable;
+
 /**
  * @brief The MultilocusGenotypeStatistics class
  *
  * This class is a set of static method for PolymorphismMultiGContainer.
  *
+ * Allele and genotype counts are read from the allele count table of the
+ * container (see PolymorphismMultiGContainer::getAlleleCountTable), which
+ * is built once and shared by all methods until the container is modified.
+ *
  * @author Sylvain Gaillard
  */
 class MultilocusGenotypeStatistics
@@ -55,6 +67,12 @@ public:
     double percentInf;
   };
 
+  struct HWResults
+  {
+    double pValue;
+    double standardError;
+  };
+
   /**
    * @brief Get the alleles' id at one locus for a set of groups.
    *
@@ -181,6 +199,76 @@ public:
       size_t locusPosition,
       const std::set<size_t>& groups);
 
+  /**
+   * @brief Exact test of Hardy-Weinberg equilibrium at one locus, on the pooled genotypes of a set of groups.
+   *
+   * Given the allele counts @f$m_i@f$ of @f$N@f$ diploid genotypes, the probability of the genotype
+   * counts @f$n_{ij}@f$ under Hardy-Weinberg equilibrium is (Levene 1949)
+   * @f[
+   * P(\{n_{ij}\})=rac{N!\,2^H\prod_i m_i!}{(2N)!\prod_{i \leq j} n_{ij}!}
+   * @f]
+   * where @f$H@f$ is the number of heterozygotes. The p-value is the probability of the tables with the
+   * same allele counts which are not more probable than the observed one:
+   * - at loci with two alleles, it is computed exactly with the recursion over the number of heterozygotes
+   *   of Wigginton et al. (2005);
+   * - at loci with more alleles, it is estimated with the Markov chain of Guo and Thompson (1992): after
+   *   dememorization steps, the chain is run for nbBatches batches of nbIterations steps. The p-value is the
+   *   mean of the estimates of the batches, and its standard error is computed from their variance.
+   *
+   * Only bi-allelic genotypes are counted, see GenotypeCountTable. The standard error is 0 for exact tests.
+   * Both values are NaN if there are less than two alleles. The Markov chain draws its numbers from
+   * CounterBasedGenerator(seed, locusPosition), so that results only depend on the seed. The seed is used
+   * as is: the test of a group by getHWExactTests with a given seed is the one of this function on this
+   * group with getGroupSeed(seed, groupId).
+   *
+   * Genotypes are counted from a GenotypeMatrix, so the container must be aligned.
+   *
+   * @throw IndexOutOfBoundsException if locusPosition exceeds the number of loci.
+   * @throw BadIntegerException if nbBatches or nbIterations is 0.
+   * @throw Exception if the genotypes are not aligned.
+   * @throw BadIntegerException if an allele key is too large to be stored in a GenotypeMatrix.
+   */
+  static HWResults getHWExactTest(
+      const PolymorphismMultiGContainer& pmgc,
+      size_t locusPosition,
+      const std::set<size_t>& groups,
+      unsigned int dememorization,
+      unsigned int nbBatches,
+      unsigned int nbIterations,
+      uint64_t seed);
+
+  /**
+   * @brief Exact tests of Hardy-Weinberg equilibrium at a set of loci in each group.
+   *
+   * All tests read the genotype count table of the container. The test of a group at a locus is the one of
+   * getHWExactTest on this group alone, with getGroupSeed(seed, groupId) as seed: the Markov chains of the
+   * groups are independent, and the results of a group do not depend on the other groups tested.
+   *
+   * The tests of all (group, locus) pairs are distributed between nbThreads threads, with the same results.
+   *
+   * @param nbThreads The number of threads, or 0 to use all hardware threads.
+   * @return The results of each group id, one per locus of locusPositions.
+   * @throw IndexOutOfBoundsException if a locus position exceeds the number of loci.
+   * @throw BadIntegerException if nbBatches or nbIterations is 0.
+   * @throw Exception if the genotypes are not aligned.
+   * @throw BadIntegerException if an allele key is too large to be stored in a GenotypeMatrix.
+   */
+  static std::map<size_t, std::vector<HWResults>> getHWExactTests(
+      const PolymorphismMultiGContainer& pmgc,
+      const std::vector<size_t>& locusPositions,
+      const std::set<size_t>& groups,
+      unsigned int dememorization,
+      unsigned int nbBatches,
+      unsigned int nbIterations,
+      uint64_t seed,
+      unsigned int nbThreads = 1);
+
+  /**
+   * @return The seed of the tests of a group in getHWExactTests: the first number of
+   * CounterBasedGenerator(seed, groupId).
+   */
+  static uint64_t getGroupSeed(uint64_t seed, size_t groupId);
+
   /**
    * @brief Compute the Nei distance between two groups at one locus.
    *
@@ -260,35 +348,77 @@ public:
 
   /**
    * @brief Get the variance components a, b and c (Weir and Cockerham, 1983).
+   *
+   * @throw ZeroDivisionException if a group has no allele or no bi-allelic
+   * genotype at the locus, or if the mean group size is not above 1.
    */
   static std::map<size_t, VarComp> getVarianceComponents(
       const PolymorphismMultiGContainer& pmgc,
       size_t locusPosition,
       const std::set<size_t>& groups);
 
+  /**
+   * @brief Get the variance components a, b and c of all alleles at all loci.
+   *
+   * The components are computed once from the allele count table of the
+   * container, and the multilocus and per-allele statistics of any set of
+   * loci can then be read from the returned table.
+   *
+   * @param pmgc The container.
+   * @param groups The groups.
+   * @param nbThreads The number of threads, or 0 to use all hardware threads.
+   */
+  static std::unique_ptr<VarianceComponentTable> getVarianceComponentTable(
+      const PolymorphismMultiGContainer& pmgc,
+      const std::set<size_t>& groups,
+      unsigned int nbThreads = 1);
+
   /**
    * @brief Compute the Weir and Cockerham @f$\theta{wc}@f$ on a set of groups for a given set of loci.
    * The variance components for each allele are calculated and then combined over loci using Weir and Cockerham weighting.
+   *
+   * All loci are computed from the allele count table of the container,
+   * which is built in a single pass over the genotypes. Loci may be
+   * distributed between several threads, with the same result.
+   *
+   * @param pmgc The container.
+   * @param locusPositions The loci.
+   * @param groups The groups.
+   * @param nbThreads The number of threads, or 0 to use all hardware threads.
    */
   static double getWCMultilocusFst(
       const PolymorphismMultiGContainer& pmgc,
       std::vector<size_t> locusPositions,
-      const std::set<size_t>& groups);
+      const std::set<size_t>& groups,
+      unsigned int nbThreads = 1);
 
   /**
    * @brief Compute the Weir and Cockerham Fis on a set of groups for a given set of loci.
    * The variance components for each allele are calculated and then combined over loci using Weir and Cockerham weighting.
+   *
+   * @param pmgc The container.
+   * @param locusPositions The loci.
+   * @param groups The groups.
+   * @param nbThreads The number of threads, or 0 to use all hardware threads.
    */
   static double getWCMultilocusFis(
       const PolymorphismMultiGContainer& pmgc,
       std::vector<size_t> locusPositions,
-      const std::set<size_t>& groups);
+      const std::set<size_t>& groups,
+      unsigned int nbThreads = 1);
 
   /**
    * @brief Compute the Weir and Cockerham @f$\theta_{wc}@f$ on a set of groups for a given set of loci and make a permutation test.
    * Multilocus @f$\theta@f$ is calculated as in getWCMultilocusFst on the original data set and on nb_perm data sets obtained after
    * a permutation of individuals between the different groups.
    * Return values are theta, % of values > theta and % of values < theta.
+   *
+   * Permutations do not copy the container: the group ids of the
+   * individuals are shuffled in a copy of its genotype matrix, and only the
+   * allele counts of the tested loci are updated.
+   *
+   * @throw Exception if the genotypes are not aligned.
+   * @throw BadIntegerException if an allele key is too large to be stored in a GenotypeMatrix.
    */
   static PermResults getWCMultilocusFstAndPerm(
       const PolymorphismMultiGContainer& pmgc,
@@ -301,6 +431,13 @@ public:
    * Multilocus Fis is calculated as in getWCMultilocusFis on the original data set and on nb_perm data sets obtained after
    * a permutation of alleles between individual of each group.
    * Return values are Fis, % of values > Fis and % of values < Fis.
+   *
+   * Permutations do not copy the container: the alleles of each group are
+   * shuffled in a copy of its genotype matrix, at the tested loci only, and
+   * only the counts of these loci are updated.
+   *
+   * @throw Exception if the genotypes are not aligned.
+   * @throw BadIntegerException if an allele key is too large to be stored in a GenotypeMatrix.
    */
   static PermResults getWCMultilocusFisAndPerm(
       const PolymorphismMultiGContainer& pmgc,
@@ -308,6 +445,91 @@ public:
       std::set<size_t> groups,
       unsigned int nbPerm);
 
+  /**
+   * @brief Same as getWCMultilocusFstAndPerm, with reproducible permutations.
+   *
+   * Permutation i is drawn from CounterBasedGenerator(seed, i), so that
+   * results only depend on the seed, and not on the number of threads.
+   * Permutations are distributed between nbThreads threads, each of which
+   * permutes its own copy of the genotype matrix.
+   *
+   * @param nbThreads The number of threads, or 0 to use all hardware threads.
+   */
+  static PermResults getWCMultilocusFstAndPerm(
+      const PolymorphismMultiGContainer& pmgc,
+      std::vector<size_t> locusPositions,
+      std::set<size_t> groups,
+      unsigned int nbPerm,
+      uint64_t seed,
+      unsigned int nbThreads = 1);
+
+  /**
+   * @brief Same as getWCMultilocusFisAndPerm, with reproducible permutations.
+   *
+   * Permutation i is drawn from CounterBasedGenerator(seed, i), so that
+   * results only depend on the seed, and not on the number of threads.
+   * Permutations are distributed between nbThreads threads, each of which
+   * permutes its own copy of the genotype matrix.
+   *
+   * @param nbThreads The number of threads, or 0 to use all hardware threads.
+   */
+  static PermResults getWCMultilocusFisAndPerm(
+      const PolymorphismMultiGContainer& pmgc,
+      std::vector<size_t> locusPositions,
+      std::set<size_t> groups,
+      unsigned int nbPerm,
+      uint64_t seed,
+      unsigned int nbThreads = 1);
+
+  /**
+   * @brief Compute the Weir and Cockerham @f$\theta_{wc}@f$ between all pairs of groups for a given set of loci and make a permutation test on each pair.
+   * The @f$\theta@f$ of a pair is the one of getWCMultilocusFstAndPerm on the two groups, with nbPerm permutations of individuals
+   * between the two groups. No permutation is made if nbPerm is 0.
+   *
+   * The variance components of each pair are computed from the sample
+   * sizes, allele frequencies and heterozygosities of the two groups stored
+   * in the allele count table of the container, in O(alleles) per locus.
+   * All pairs share the same copy of the genotype matrix and of the table,
+   * in which the allele counts of the tested loci are updated.
+   *
+   * @return The results of each pair of group ids (grp1, grp2), with grp1 < grp2.
+   * @throw IndexOutOfBoundsException if a locus position is out of range.
+   * @throw ZeroDivisionException if the @f$\theta@f$ of a pair cannot be computed.
+   * @throw Exception if the genotypes are not aligned.
+   * @throw BadIntegerException if an allele key is too large to be stored in a GenotypeMatrix.
+   */
+  static std::map<std::pair<size_t, size_t>, PermResults> getWCPairwiseFstAndPerm(
+      const PolymorphismMultiGContainer& pmgc,
+      const std::vector<size_t>& locusPositions,
+      const std::set<size_t>& groups,
+      unsigned int nbPerm);
+
+  /**
+   * @brief Same as getWCPairwiseFstAndPerm, with reproducible permutations.
+   *
+   * Each pair (grp1, grp2) has its own seed, getPairSeed(seed, grp1, grp2),
+   * so that the permutations of different pairs are independent, and the
+   * results of a pair are the ones of getWCMultilocusFstAndPerm on the two
+   * groups with this seed. The permutations of each pair are distributed
+   * between nbThreads threads, each of which permutes its own copy of the
+   * genotype matrix.
+   *
+   * @param nbThreads The number of threads, or 0 to use all hardware threads.
+   */
+  static std::map<std::pair<size_t, size_t>, PermResults> getWCPairwiseFstAndPerm(
+      const PolymorphismMultiGContainer& pmgc,
+      const std::vector<size_t>& locusPositions,
+      const std::set<size_t>& groups,
+      unsigned int nbPerm,
+      uint64_t seed,
+      unsigned int nbThreads = 1);
+
+  /**
+   * @return The seed of the permutations of the pair of groups (grp1, grp2)
+   * in getWCPairwiseFstAndPerm: the number drawn at counter grp2 by
+   * CounterBasedGenerator(seed, grp1).
+   */
+  static uint64_t getPairSeed(uint64_t seed, size_t grp1, size_t grp2);
 
   /**
    * @brief Compute the @f$\theta_{RH}@f$ on a set of groups for a given set of loci.
@@ -322,12 +544,355 @@ public:
    * @brief Compute pairwise distances on a set of groups for a given set of loci.
    * distance is either Nei72, Nei78, Fst W&C or Fst Robertson & Hill, Nm,
    * D=-ln(1-Fst) of Reynolds et al. 1983, Rousset 1997 Fst/(1-Fst)
+   *
+   * All pairs are computed from the allele frequencies and heterozygosities
+   * of the groups stored in the allele count table of the container, which
+   * are computed once, instead of counting alleles again for each pair.
+   * Pairs may be distributed between several threads, with the same results.
+   *
+   * @param pmgc The container.
+   * @param locusPositions The loci.
+   * @param groups The groups.
+   * @param distance_method The name of the distance.
+   * @param nbThreads The number of threads, or 0 to use all hardware threads.
    */
   static std::unique_ptr<DistanceMatrix> getDistanceMatrix(
       const PolymorphismMultiGContainer& pmgc,
       std::vector<size_t> locusPositions,
       const std::set<size_t>& groups,
-      std::string distance_method);
+      std::string distance_method,
+      unsigned int nbThreads = 1);
+
+  /**
+   * @name Bootstrap over loci
+   *
+   * Multilocus statistics are ratios of sums over loci of per-locus terms
+   * (e.g. the variance components a, b and c for @f$\theta_{WC}@f$). These
+   * terms are computed once, and each replicate sums them over as many loci
+   * as in locusPositions, drawn with replacement, so that a replicate costs
+   * O(number of loci) per statistic.
+   *
+   * Replicate i draws its loci from CounterBasedGenerator(seed, i), so that
+   * results only depend on the seed, and not on the number of threads
+   * between which replicates are distributed. Replicates in which a
+   * statistic is not defined (for instance if only monomorphic loci are
+   * drawn) are NaN.
+   *
+   * @{
+   */
+
+  /**
+   * @brief Bootstrap over loci of getWCMultilocusFst.
+   *
+   * @param nbThreads The number of threads, or 0 to use all hardware threads.
+   * @return The Fst of each replicate.
+   * @throw IndexOutOfBoundsException if a locus position is out of range.
+   * @throw ZeroDivisionException if a group has no individual, or in the
+   * same cases as getVarianceComponents at a locus.
+   */
+  static std::vector<double> getWCMultilocusFstBootstrap(
+      const PolymorphismMultiGContainer& pmgc,
+      const std::vector<size_t>& locusPositions,
+      const std::set<size_t>& groups,
+      size_t nbReplicates,
+      uint64_t seed,
+      unsigned int nbThreads = 1);
+
+  /**
+   * @brief Bootstrap over loci of getDistanceMatrix, e.g. to build bootstrapped trees.
+   *
+   * The terms of the pairs of groups, then the replicates, are distributed
+   * between the threads.
+   *
+   * @param nbThreads The number of threads, or 0 to use all hardware threads.
+   * @return The distance matrix of each replicate.
+   * @throw Exception if the distance is unknown.
+   * @throw IndexOutOfBoundsException if a locus position is out of range.
+   * @throw ZeroDivisionException if the distance cannot be computed at a
+   * locus for a pair of groups.
+   */
+  static std::vector<std::unique_ptr<DistanceMatrix>> getDistanceMatrixBootstrap(
+      const PolymorphismMultiGContainer& pmgc,
+      const std::vector<size_t>& locusPositions,
+      const std::set<size_t>& groups,
+      const std::string& distance_method,
+      size_t nbReplicates,
+      uint64_t seed,
+      unsigned int nbThreads = 1);
+  /** @} */
+
+private:
+  friend class VarianceComponentTable;
+
+  /**
+   * @brief Compare a statistic to its values on nbPerm permuted data sets.
+   *
+   * Permutations are distributed between nbThreads threads with
+   * ParallelTools::parallelFor, so that permutedStatistic can use data owned
+   * by each thread number.
+   *
+   * @param statistic The observed value.
+   * @param nbPerm The number of permutations.
+   * @param nbThreads The number of threads, at least 1.
+   * @param permutedStatistic Compute the statistic on the i-th permuted data set, in a given thread.
+   * @throw Exception Any exception thrown by permutedStatistic, once all threads are done.
+   */
+  static PermResults permutationTest_(
+      double statistic,
+      unsigned int nbPerm,
+      unsigned int nbThreads,
+      const std::function<double(unsigned int, unsigned int)>& permutedStatistic);
+
+  /**
+   * @brief Permutation test on the multilocus Weir and Cockerham Fst or Fis.
+   *
+   * @param pmgc The container.
+   * @param locusPositions The tested loci.
+   * @param groups The tested groups.
+   * @param nbPerm The number of permutations.
+   * @param fis If true, Fis is tested, else Fst.
+   * @param nbThreads The number of threads, or 0 to use all hardware threads.
+   * @param permute Write the i-th permutation of a source matrix in a target
+   * matrix, with a workspace for the tested groups and loci. It is called
+   * concurrently if nbThreads is not 1.
+   */
+  static PermResults wcPermutationTest_(
+      const PolymorphismMultiGContainer& pmgc,
+      const std::vector<size_t>& locusPositions,
+      const std::set<size_t>& groups,
+      unsigned int nbPerm,
+      bool fis,
+      unsigned int nbThreads,
+      const std::function<void(
+          unsigned int,
+          const GenotypeMatrix&,
+          GenotypeMatrix&,
+          PolymorphismMultiGContainerTools::PermutationWorkspace&)>& permute);
+
+  /**
+   * @brief Permutation test on the multilocus Weir and Cockerham Fst of each pair of groups.
+   *
+   * @param pmgc The container.
+   * @param locusPositions The tested loci.
+   * @param groups The groups.
+   * @param nbPerm The number of permutations of each pair.
+   * @param nbThreads The number of threads, or 0 to use all hardware threads.
+   * @param permute Write the i-th permutation of a source matrix for the pair
+   * of group ids (grp1, grp2) in a target matrix, with a workspace for the
+   * tested pair and loci. It is called concurrently if nbThreads is not 1.
+   */
+  static std::map<std::pair<size_t, size_t>, PermResults> wcPairwisePermutationTest_(
+      const PolymorphismMultiGContainer& pmgc,
+      const std::vector<size_t>& locusPositions,
+      const std::set<size_t>& groups,
+      unsigned int nbPerm,
+      unsigned int nbThreads,
+      const std::function<void(
+          const std::pair<size_t, size_t>&,
+          unsigned int,
+          const GenotypeMatrix&,
+          GenotypeMatrix&,
+          PolymorphismMultiGContainerTools::PermutationWorkspace&)>& permute);
+
+  /**
+   * @brief Sum the variance components of all alleles over some loci.
+   *
+   * Loci which are monomorphic in the groups are skipped. Loci are
+   * distributed between nbThreads threads, each locus writing its
+   * components in a slot of its own.
+   *
+   * @param table The allele counts.
+   * @param locusPositions The loci.
+   * @param groups The indices of the groups in the table.
+   * @param nbGroups The number of groups requested, see getVarianceComponents_.
+   * @param method The name of the calling method, for exceptions.
+   * @param nbThreads The number of threads, or 0 to use all hardware threads.
+   * @throw IndexOutOfBoundsException if a locus position is out of range.
+   * @throw ZeroDivisionException in the same cases as getVarianceComponents.
+   */
+  static VarComp sumVarianceComponents_(
+      const AlleleCountTable& table,
+      const std::vector<size_t>& locusPositions,
+      const std::vector<size_t>& groups,
+      size_t nbGroups,
+      const std::string& method,
+      unsigned int nbThreads = 1);
+
+  /**
+   * @return true if the name of a distance of getDistanceMatrix is known.
+   */
+  static bool isDistance_(const std::string& distance_methode);
+
+  /**
+   * @brief Compute the terms of a multilocus distance at each locus.
+   *
+   * All the distances of getDistanceMatrix, and getRHMultilocusFst, are
+   * computed from three sums over loci of per-locus terms:
+   * - @f$J_X@f$, @f$J_Y@f$ and @f$J_{XY}@f$ for Nei's distances;
+   * - the sums of a, b and c over alleles for Weir and Cockerham's Fst, from
+   *   which Nm, D and Rousset's distance are derived;
+   * - the sum of the weighted Fst of the alleles and the number of
+   *   independent alleles for Robertson and Hill's Fst.
+   *
+   * @param table The allele counts.
+   * @param locusPositions The loci.
+   * @param groups The indices of the groups in the table, two for Nei's distances.
+   * @param nbGroups The number of groups requested, see getVarianceComponents_.
+   * @param distance_methode The name of the distance, as in getDistanceMatrix.
+   * @param method The name of the calling method, for exceptions.
+   * @param terms The three terms of each locus, one after the other.
+   * @throw IndexOutOfBoundsException if a locus position is out of range.
+   * @throw ZeroDivisionException if a group has no allele at a locus, or
+   * in the same cases as getVarianceComponents.
+   */
+  static void getDistanceTerms_(
+      const AlleleCountTable& table,
+      const std::vector<size_t>& locusPositions,
+      const std::vector<size_t>& groups,
+      size_t nbGroups,
+      const std::string& distance_methode,
+      const std::string& method,
+      std::vector<double>& terms);
+
+  /**
+   * @brief Compute a distance from all loci, with the parameters of getDistanceTerms_.
+   */
+  static double getDistance_(
+      const AlleleCountTable& table,
+      const std::vector<size_t>& locusPositions,
+      const std::vector<size_t>& groups,
+      size_t nbGroups,
+      const std::string& distance_methode,
+      const std::string& method);
+
+  /**
+   * @brief Compute a distance from the sums over loci of its three terms.
+   *
+   * @throw ZeroDivisionException if the distance is not defined.
+   */
+  static double getDistanceFromTerms_(
+      const double* sums,
+      const std::string& distance_methode,
+      const std::string& method);
+
+  /**
+   * @brief Draw the loci of a bootstrap replicate.
+   *
+   * @param nbLoci The number of loci.
+   * @param seed The seed of the bootstrap.
+   * @param replicate The replicate number.
+   * @param weights The number of times each locus is drawn.
+   */
+  static void drawLoci_(
+      size_t nbLoci,
+      uint64_t seed,
+      size_t replicate,
+      std::vector<unsigned int>& weights);
+
+  /**
+   * @return The distance computed from the terms of getDistanceTerms_
+   * weighted by the number of times each locus is drawn, or NaN if it is
+   * not defined.
+   */
+  static double getReplicateDistance_(
+      const std::vector<double>& terms,
+      const std::vector<unsigned int>& weights,
+      const std::string& distance_methode);
+
+  /**
+   * @throw IndexOutOfBoundsException if locusPosition is out of range.
+   */
+  static void checkLocus_(
+      const AlleleCountTable& table,
+      size_t locusPosition,
+      const std::string& method);
+
+  /**
+   * @brief Check a locus position and get the indices of a set of groups in a table.
+   *
+   * @throw IndexOutOfBoundsException if locusPosition is out of range.
+   */
+  static std::vector<size_t> getGroupIndices_(
+      const AlleleCountTable& table,
+      size_t locusPosition,
+      const std::set<size_t>& groups,
+      const std::string& method);
+
+  /**
+   * @brief Get the indices of the alleles present in some groups at a locus.
+   */
+  static void getAlleles_(
+      const AlleleCountTable& table,
+      size_t locusPosition,
+      const std::vector<size_t>& groups,
+      std::vector<size_t>& alleles);
+
+  /**
+   * @brief Compute the variance components of some alleles at a locus.
+   *
+   * @param table The allele counts.
+   * @param locusPosition The locus.
+   * @param groups The indices of the groups in the table.
+   * @param nbGroups The number of groups requested, including those without
+   * individuals, which make the computation fail.
+   * @param alleles The indices of the alleles, see getAlleles_.
+   * @param values The components of each allele, resized to alleles.size().
+   * @throw ZeroDivisionException in the same cases as getVarianceComponents.
+   */
+  static void getVarianceComponents_(
+      const AlleleCountTable& table,
+      size_t locusPosition,
+      const std::vector<size_t>& groups,
+      size_t nbGroups,
+      const std::vector<size_t>& alleles,
+      std::vector<VarComp>& values);
+
+  /**
+   * @brief Hardy-Weinberg test at a locus on the pooled genotypes of some groups, see getHWExactTest.
+   *
+   * @param table The genotype counts.
+   * @param locusPosition The locus.
+   * @param groups The indices of the groups in the table.
+   * @param dememorization The number of steps of the Markov chain before sampling.
+   * @param nbBatches The number of batches.
+   * @param nbIterations The number of steps of each batch.
+   * @param seed The seed of the Markov chain.
+   */
+  static HWResults hwExactTest_(
+      const GenotypeCountTable& table,
+      size_t locusPosition,
+      const std::vector<size_t>& groups,
+      unsigned int dememorization,
+      unsigned int nbBatches,
+      unsigned int nbIterations,
+      uint64_t seed);
+
+  /**
+   * @brief Exact p-value of a Hardy-Weinberg test at a bi-allelic locus (Wigginton et al. 2005).
+   */
+  static double hwBiAllelicTest_(
+      unsigned int homozygotes1,
+      unsigned int heterozygotes,
+      unsigned int homozygotes2);
+
+  /**
+   * @brief Estimate the p-value of a Hardy-Weinberg test with the Markov chain of Guo and Thompson (1992).
+   *
+   * @param genotypes The genotype counts, indexed as in GenotypeCountTable,
+   * used as the state of the chain.
+   * @param nbAlleles The number of alleles, all present.
+   * @param dememorization The number of steps before sampling.
+   * @param nbBatches The number of batches.
+   * @param nbIterations The number of steps of each batch.
+   * @param generator The random number generator.
+   */
+  static HWResults hwMarkovChainTest_(
+      std::vector<unsigned int>& genotypes,
+      size_t nbAlleles,
+      unsigned int dememorization,
+      unsigned int nbBatches,
+      unsigned int nbIterations,
+      CounterBasedGenerator& generator);
 };
 } // end of namespace bpp;
 
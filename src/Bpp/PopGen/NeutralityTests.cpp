@@ -0,0 +1,107 @@
+// SPDX-FileCopyrightText: The Bio++ Development Group
+//
+// SPDX-License-Identifier: CECILL-2.1
+
+#include "NeutralityTests.h"
+#include "CoalescentSimulator.h"
+#include "ParallelTools.h"
+#include "SequenceResampling.h"
+#include "SequenceStatistics.h"
+
+// From the STL
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+using namespace bpp;
+using namespace std;
+
+vector<NeutralityTests::Result> NeutralityTests::testGivenSegregatingSites(
+    const SiteCountTable& observed,
+    const vector<string>& statistics,
+    size_t nbReplicates,
+    uint64_t seed,
+    unsigned int nbThreads)
+{
+  return test_(observed, statistics, false, 0., nbReplicates, seed, nbThreads);
+}
+
+/******************************************************************************/
+
+vector<NeutralityTests::Result> NeutralityTests::testGivenTheta(
+    const SiteCountTable& observed,
+    const vector<string>& statistics,
+    double theta,
+    size_t nbReplicates,
+    uint64_t seed,
+    unsigned int nbThreads)
+{
+  return test_(observed, statistics, true, theta, nbReplicates, seed, nbThreads);
+}
+
+/******************************************************************************/
+
+vector<NeutralityTests::Result> NeutralityTests::test_(
+    const SiteCountTable& observed,
+    const vector<string>& statistics,
+    bool givenTheta,
+    double theta,
+    size_t nbReplicates,
+    uint64_t seed,
+    unsigned int nbThreads)
+{
+  double nan = numeric_limits<double>::quiet_NaN();
+  vector<Result> results(statistics.size());
+  for (size_t s = 0; s < statistics.size(); ++s)
+  {
+    results[s].statistic = statistics[s];
+    // Throws if the name is unknown.
+    results[s].observed = SequenceResampling::computeStatistic(statistics[s], observed);
+    results[s].null.assign(nbReplicates, nan);
+    results[s].nbValidReplicates = 0;
+    results[s].pValueLower = nan;
+    results[s].pValueUpper = nan;
+    results[s].pValue = nan;
+  }
+
+  size_t nbSegregatingSites = SequenceStatistics::numberOfPolymorphicSites(observed);
+  // Each thread simulates in its own simulator and table.
+  nbThreads = ParallelTools::getNumberOfThreads(nbThreads, nbReplicates);
+  vector<CoalescentSimulator> simulators(nbThreads, CoalescentSimulator(observed.getSampleSize()));
+  vector<SiteCountTable> simulated(nbThreads, SiteCountTable(0, 2));
+  ParallelTools::parallelFor(nbReplicates, nbThreads,
+      [&](size_t r, unsigned int t) {
+        CounterBasedGenerator gen = SequenceResampling::getReplicateGenerator(seed, r);
+        if (givenTheta)
+          simulators[t].simulateTheta(theta, gen, simulated[t]);
+        else
+          simulators[t].simulateSegregatingSites(nbSegregatingSites, gen, simulated[t]);
+        for (auto& res : results)
+        {
+          res.null[r] = SequenceResampling::computeStatistic(res.statistic, simulated[t]);
+        }
+      });
+
+  for (auto& res : results)
+  {
+    if (std::isnan(res.observed))
+      continue;
+    size_t lower = 0, upper = 0;
+    for (auto x : res.null)
+    {
+      if (std::isnan(x))
+        continue;
+      res.nbValidReplicates++;
+      if (x <= res.observed)
+        lower++;
+      if (x >= res.observed)
+        upper++;
+    }
+    // The observed sample is counted as one of the samples (Davison & Hinkley 1997).
+    double m = static_cast<double>(res.nbValidReplicates + 1);
+    res.pValueLower = static_cast<double>(lower + 1) / m;
+    res.pValueUpper = static_cast<double>(upper + 1) / m;
+    res.pValue = min(1., 2. * min(res.pValueLower, res.pValueUpper));
+  }
+  return results;
+}
@@ -0,0 +1,114 @@
+// SPDX-FileCopyrightText: The Bio++ Development Group
+//
+// SPDX-License-Identifier: CECILL-2.1
+
+#ifndef _NEUTRALITYTESTS_H_
+#define _NEUTRALITYTESTS_H_
+
+#include <Bpp/Exceptions.h>
+
+// From the STL
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "SiteCountTable.h"
+
+namespace bpp
+{
+/**
+ * @brief Significance of neutrality tests against the standard neutral coalescent.
+ *
+ * The observed statistics are computed on a SiteCountTable, and compared to
+ * their distribution over samples simulated with CoalescentSimulator, with
+ * the same sample size. Samples can be simulated either for a given number
+ * of segregating sites (the usual approach for Tajima's D and Fu and Li's
+ * tests, which is robust to the uncertainty on theta), or for a given theta.
+ *
+ * Statistics are designated by the names used by
+ * SequenceResampling::computeStatistic, typically "tajimaD", "fuLiDStar",
+ * "fuLiFStar" and "fayWuH". Fay and Wu's H needs the ancestral states of the
+ * observed sites (see SiteCountTable::setAncestralStates).
+ *
+ * Each replicate uses the random number generator returned by
+ * SequenceResampling::getReplicateGenerator, so that results are reproducible
+ * and do not depend on the order in which replicates are simulated.
+ * Replicates can therefore be distributed between threads, each of which
+ * simulates in its own CoalescentSimulator.
+ */
+class NeutralityTests
+{
+public:
+  /**
+   * @brief The result of a test for one statistic.
+   */
+  struct Result
+  {
+    std::string statistic;
+    /** @brief The value of the statistic on the observed data. */
+    double observed;
+    /** @brief The values of the statistic on the simulated samples (NaN if not defined). */
+    std::vector<double> null;
+    /** @brief The number of simulated samples where the statistic is defined. */
+    size_t nbValidReplicates;
+    /** @brief P(X <= observed) under the null hypothesis. */
+    double pValueLower;
+    /** @brief P(X >= observed) under the null hypothesis. */
+    double pValueUpper;
+    /** @brief Two-sided p-value, twice the smallest one-sided p-value. */
+    double pValue;
+  };
+
+public:
+  /**
+   * @brief Test neutrality conditioning on the observed number of segregating sites.
+   *
+   * @param observed The observed site counts.
+   * @param statistics The names of the statistics to test.
+   * @param nbReplicates The number of simulated samples.
+   * @param seed The seed of the random number generators.
+   * @param nbThreads The number of threads, or 0 to use all hardware threads.
+   * @return One Result per statistic, in the same order.
+   * @throw Exception if a statistic name is unknown or if the sample size is lower than 2.
+   */
+  static std::vector<Result> testGivenSegregatingSites(
+      const SiteCountTable& observed,
+      const std::vector<std::string>& statistics,
+      size_t nbReplicates,
+      uint64_t seed,
+      unsigned int nbThreads = 1);
+
+  /**
+   * @brief Test neutrality for a given population mutation rate.
+   *
+   * @param observed The observed site counts.
+   * @param statistics The names of the statistics to test.
+   * @param theta The population mutation rate of the whole sequence, for
+   * instance SequenceStatistics::watterson75(observed).
+   * @param nbReplicates The number of simulated samples.
+   * @param seed The seed of the random number generators.
+   * @param nbThreads The number of threads, or 0 to use all hardware threads.
+   * @return One Result per statistic, in the same order.
+   * @throw Exception if a statistic name is unknown or if the sample size is lower than 2.
+   */
+  static std::vector<Result> testGivenTheta(
+      const SiteCountTable& observed,
+      const std::vector<std::string>& statistics,
+      double theta,
+      size_t nbReplicates,
+      uint64_t seed,
+      unsigned int nbThreads = 1);
+
+private:
+  static std::vector<Result> test_(
+      const SiteCountTable& observed,
+      const std::vector<std::string>& statistics,
+      bool givenTheta,
+      double theta,
+      size_t nbReplicates,
+      uint64_t seed,
+      unsigned int nbThreads);
+};
+} // end of namespace bpp;
+
+#endif // _NEUTRALITYTESTS_H_
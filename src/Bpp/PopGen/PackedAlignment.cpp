@@ -0,0 +1,454 @@
+// SPDX-FileCopyrightText: The Bio++ Development Group
+//
+// SPDX-License-Identifier: CECILL-2.1
+
+#include "PackedAlignment.h"
+
+#include <Bpp/Seq/SequenceExceptions.h>
+
+// From the STL
+#include <algorithm>
+#include <bitset>
+#include <cstring>
+#include <fstream>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define BPP_PACKEDALIGNMENT_MMAP
+#endif
+
+using namespace bpp;
+using namespace std;
+
+namespace
+{
+const char MAGIC[8] = {'B', 'p', 'p', 'P', 'a', 'c', 'k', '1'};
+const uint32_t BYTE_ORDER_MARK = 0x01020304;
+const uint64_t EVEN_BITS = 0x5555555555555555ULL;
+
+template<class T>
+void writeRaw(ostream& out, const T& value)
+{
+  out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+/**
+ * @brief Sequential reader of the header, with bound checking.
+ */
+class HeaderReader
+{
+private:
+  const char* data_;
+  size_t size_;
+  size_t position_;
+
+public:
+  HeaderReader(const char* data, size_t size) : data_(data), size_(size), position_(0) {}
+
+  size_t getPosition() const { return position_; }
+
+  void skip(size_t n)
+  {
+    if (n > size_ - position_)
+      throw IOException("PackedAlignment: truncated file.");
+    position_ += n;
+  }
+
+  template<class T>
+  T read()
+  {
+    T value;
+    const char* p = data_ + position_;
+    skip(sizeof(T));
+    memcpy(&value, p, sizeof(T));
+    return value;
+  }
+
+  string readString(size_t n)
+  {
+    const char* p = data_ + position_;
+    skip(n);
+    return string(p, n);
+  }
+};
+
+/**
+ * @brief Insert a 0 bit before each bit of a 32-bit word, so that mask bits
+ * line up with the low bits of the packed 2-bit values.
+ */
+uint64_t spreadBits(uint32_t x)
+{
+  uint64_t v = x;
+  v = (v | (v << 16)) & 0x0000FFFF0000FFFFULL;
+  v = (v | (v << 8)) & 0x00FF00FF00FF00FFULL;
+  v = (v | (v << 4)) & 0x0F0F0F0F0F0F0F0FULL;
+  v = (v | (v << 2)) & 0x3333333333333333ULL;
+  v = (v | (v << 1)) & EVEN_BITS;
+  return v;
+}
+
+unsigned int popCount(uint64_t x)
+{
+  return static_cast<unsigned int>(bitset<64>(x).count());
+}
+}
+
+/******************************************************************************/
+
+PackedAlignment::PackedAlignment(
+    const string& path,
+    shared_ptr<const Alphabet> alphabet,
+    size_t chunkSize) :
+  alphabet_(alphabet),
+  names_(),
+  counts_(),
+  ingroup_(),
+  groups_(),
+  nbSites_(0),
+  valueWords_(0),
+  maskWords_(0),
+  data_(nullptr),
+  size_(0),
+  coordinates_(nullptr),
+  body_(nullptr),
+  mapped_(false),
+  buffer_(),
+  chunkSize_(chunkSize),
+  position_(0),
+  weighted_(false)
+{
+  if (chunkSize == 0)
+    throw Exception("PackedAlignment: the chunk size must be positive.");
+  if (alphabet->getSize() != 4)
+    throw AlphabetMismatchException("PackedAlignment: only alphabets with 4 resolved states can be packed.", alphabet.get());
+  open_(path);
+  try
+  {
+    parseHeader_();
+  }
+  catch (...)
+  {
+#ifdef BPP_PACKEDALIGNMENT_MMAP
+    if (mapped_)
+      munmap(const_cast<char*>(data_), size_);
+#endif
+    throw;
+  }
+}
+
+/******************************************************************************/
+
+PackedAlignment::~PackedAlignment()
+{
+#ifdef BPP_PACKEDALIGNMENT_MMAP
+  if (mapped_)
+    munmap(const_cast<char*>(data_), size_);
+#endif
+}
+
+/******************************************************************************/
+
+void PackedAlignment::write(
+    const PolymorphismSequenceContainer& psc,
+    const string& path)
+{
+  const Alphabet& alpha = psc.alphabet();
+  if (alpha.getSize() != 4)
+    throw AlphabetMismatchException("PackedAlignment::write: only alphabets with 4 resolved states can be packed.", &alpha);
+  ofstream out(path.c_str(), ios::out | ios::binary);
+  if (!out)
+    throw IOException("PackedAlignment::write: fail to open file " + path + ".");
+
+  size_t nbSeq = psc.getNumberOfSequences();
+  size_t nbSites = psc.getNumberOfSites();
+  out.write(MAGIC, sizeof(MAGIC));
+  writeRaw(out, BYTE_ORDER_MARK);
+  string type = alpha.getAlphabetType();
+  writeRaw(out, static_cast<uint32_t>(type.size()));
+  out.write(type.data(), static_cast<streamsize>(type.size()));
+  writeRaw(out, static_cast<uint64_t>(nbSeq));
+  writeRaw(out, static_cast<uint64_t>(nbSites));
+  vector<string> names = psc.getSequenceNames();
+  for (size_t j = 0; j < nbSeq; ++j)
+  {
+    writeRaw(out, static_cast<uint32_t>(names[j].size()));
+    out.write(names[j].data(), static_cast<streamsize>(names[j].size()));
+    writeRaw(out, static_cast<uint32_t>(psc.getSequenceCount(j)));
+    writeRaw(out, static_cast<uint64_t>(psc.getGroupId(j)));
+    writeRaw(out, static_cast<uint8_t>(psc.isIngroupMember(j) ? 1 : 0));
+  }
+  for (size_t i = 0; i < nbSites; ++i)
+  {
+    writeRaw(out, static_cast<int32_t>(psc.site(i).getCoordinate()));
+  }
+  // Site records are aligned on 8 bytes.
+  size_t headerSize = static_cast<size_t>(out.tellp());
+  for (size_t k = headerSize; k % 8 != 0; ++k)
+  {
+    out.put(0);
+  }
+
+  size_t valueWords = (nbSeq + 31) / 32;
+  size_t maskWords = (nbSeq + 63) / 64;
+  vector<uint64_t> record(valueWords + maskWords);
+  int gap = alpha.getGapCharacterCode();
+  for (size_t i = 0; i < nbSites; ++i)
+  {
+    std::fill(record.begin(), record.end(), 0);
+    const Site& site = psc.site(i);
+    for (size_t j = 0; j < nbSeq; ++j)
+    {
+      int state = site[j];
+      uint64_t value;
+      if (state >= 0 && state < 4)
+        value = static_cast<uint64_t>(state);
+      else
+      {
+        record[valueWords + j / 64] |= 1ULL << (j % 64);
+        value = (state == gap) ? 0 : 1;
+      }
+      record[j / 32] |= value << (2 * (j % 32));
+    }
+    out.write(reinterpret_cast<const char*>(record.data()), static_cast<streamsize>(record.size() * sizeof(uint64_t)));
+  }
+  if (!out)
+    throw IOException("PackedAlignment::write: fail to write file " + path + ".");
+}
+
+/******************************************************************************/
+
+int PackedAlignment::getSiteCoordinate(size_t site) const
+{
+  int32_t coordinate;
+  memcpy(&coordinate, coordinates_ + site * sizeof(int32_t), sizeof(int32_t));
+  return static_cast<int>(coordinate);
+}
+
+/******************************************************************************/
+
+int PackedAlignment::getValue(size_t index, size_t site) const
+{
+  uint64_t value = (values_(site)[index / 32] >> (2 * (index % 32))) & 3;
+  if (isMissing(index, site))
+    return value == 0 ? alphabet_->getGapCharacterCode() : alphabet_->getUnknownCharacterCode();
+  return static_cast<int>(value);
+}
+
+/******************************************************************************/
+
+bool PackedAlignment::hasGap(size_t site) const
+{
+  // Gaps are the missing states with a packed value of 0.
+  const uint64_t* values = values_(site);
+  const uint64_t* mask = mask_(site);
+  for (size_t w = 0; w < valueWords_; ++w)
+  {
+    uint32_t missing = static_cast<uint32_t>(mask[w / 2] >> (32 * (w % 2)));
+    if (spreadBits(missing) & ~(values[w] | (values[w] >> 1)))
+      return true;
+  }
+  return false;
+}
+
+/******************************************************************************/
+
+bool PackedAlignment::hasMissingData(size_t site) const
+{
+  const uint64_t* mask = mask_(site);
+  for (size_t w = 0; w < maskWords_; ++w)
+  {
+    if (mask[w] != 0)
+      return true;
+  }
+  return false;
+}
+
+/******************************************************************************/
+
+unique_ptr<PolymorphismSequenceContainer> PackedAlignment::materialize() const
+{
+  size_t nbSeq = names_.size();
+  auto psc = make_unique<PolymorphismSequenceContainer>(nbSeq, alphabet_);
+  psc->setSequenceNames(names_, false);
+  for (size_t j = 0; j < nbSeq; ++j)
+  {
+    psc->setSequenceCount(j, counts_[j]);
+    if (ingroup_[j])
+      psc->setAsIngroupMember(j);
+    else
+      psc->setAsOutgroupMember(j);
+    psc->setGroupId(j, groups_[j]);
+  }
+  vector<int> values(nbSeq);
+  for (size_t i = 0; i < nbSites_; ++i)
+  {
+    for (size_t j = 0; j < nbSeq; ++j)
+    {
+      values[j] = getValue(j, i);
+    }
+    auto site = make_unique<Site>(values, alphabet_, getSiteCoordinate(i));
+    psc->addSite(site);
+  }
+  return psc;
+}
+
+/******************************************************************************/
+
+bool PackedAlignment::nextChunk(SiteCountTable& table)
+{
+  if (position_ >= nbSites_)
+    return false;
+  size_t nbSites = min(chunkSize_, nbSites_ - position_);
+  countSites(position_, nbSites, table);
+  position_ += nbSites;
+  return true;
+}
+
+/******************************************************************************/
+
+void PackedAlignment::countSites(size_t start, size_t nbSites, SiteCountTable& table) const
+{
+  if (start > nbSites_ || nbSites > nbSites_ - start)
+    throw IndexOutOfBoundsException("PackedAlignment::countSites.", start + nbSites, 0, nbSites_);
+  size_t nbSeq = names_.size();
+  size_t sampleSize = nbSeq;
+  if (weighted_)
+  {
+    sampleSize = 0;
+    for (auto c : counts_)
+    {
+      sampleSize += c;
+    }
+  }
+  table.reset(nbSites, 4, sampleSize);
+  for (size_t i = 0; i < nbSites; ++i)
+  {
+    size_t site = start + i;
+    if (weighted_)
+    {
+      for (size_t j = 0; j < nbSeq; ++j)
+      {
+        if (isMissing(j, site))
+          table.addState(i, -1, counts_[j]);
+        else
+          table.addState(i, getValue(j, site), counts_[j]);
+      }
+      continue;
+    }
+    // Count the four states of 32 sequences at once.
+    const uint64_t* values = values_(site);
+    const uint64_t* mask = mask_(site);
+    unsigned int c[4] = {0, 0, 0, 0};
+    for (size_t w = 0; w < valueWords_; ++w)
+    {
+      uint32_t missing = static_cast<uint32_t>(mask[w / 2] >> (32 * (w % 2)));
+      uint64_t valid = EVEN_BITS & ~spreadBits(missing);
+      size_t nbInWord = min(static_cast<size_t>(32), nbSeq - 32 * w);
+      if (nbInWord < 32)
+        valid &= (1ULL << (2 * nbInWord)) - 1;
+      uint64_t lo = values[w] & valid;
+      uint64_t hi = (values[w] >> 1) & valid;
+      c[0] += popCount(valid & ~(lo | hi));
+      c[1] += popCount(lo & ~hi);
+      c[2] += popCount(hi & ~lo);
+      c[3] += popCount(lo & hi);
+    }
+    unsigned int nbMissing = 0;
+    for (size_t w = 0; w < maskWords_; ++w)
+    {
+      nbMissing += popCount(mask[w]);
+    }
+    for (size_t k = 0; k < 4; ++k)
+    {
+      table.setCount(i, k, c[k]);
+    }
+    if (nbMissing > 0)
+      table.addState(i, -1, nbMissing);
+  }
+}
+
+/******************************************************************************/
+
+void PackedAlignment::open_(const string& path)
+{
+#ifdef BPP_PACKEDALIGNMENT_MMAP
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0)
+    throw IOException("PackedAlignment: fail to open file " + path + ".");
+  struct stat st;
+  if (fstat(fd, &st) != 0)
+  {
+    ::close(fd);
+    throw IOException("PackedAlignment: fail to read file " + path + ".");
+  }
+  size_ = static_cast<size_t>(st.st_size);
+  if (size_ == 0)
+  {
+    ::close(fd);
+    throw IOException("PackedAlignment: empty file " + path + ".");
+  }
+  void* p = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+  if (p == MAP_FAILED)
+    throw IOException("PackedAlignment: fail to map file " + path + ".");
+  data_ = static_cast<const char*>(p);
+  mapped_ = true;
+#else
+  ifstream in(path.c_str(), ios::in | ios::binary | ios::ate);
+  if (!in)
+    throw IOException("PackedAlignment: fail to open file " + path + ".");
+  size_ = static_cast<size_t>(in.tellg());
+  // A vector of 64-bit words keeps site records aligned.
+  buffer_.resize((size_ + 7) / 8);
+  in.seekg(0);
+  in.read(reinterpret_cast<char*>(buffer_.data()), static_cast<streamsize>(size_));
+  if (!in)
+    throw IOException("PackedAlignment: fail to read file " + path + ".");
+  data_ = reinterpret_cast<const char*>(buffer_.data());
+#endif
+}
+
+/******************************************************************************/
+
+void PackedAlignment::parseHeader_()
+{
+  HeaderReader reader(data_, size_);
+  if (reader.readString(sizeof(MAGIC)) != string(MAGIC, sizeof(MAGIC)))
+    throw IOException("PackedAlignment: not a packed alignment file.");
+  if (reader.read<uint32_t>() != BYTE_ORDER_MARK)
+    throw IOException("PackedAlignment: the file was written with another byte order.");
+  string type = reader.readString(reader.read<uint32_t>());
+  if (type != alphabet_->getAlphabetType())
+    throw AlphabetMismatchException("PackedAlignment: the file holds sequences of type " + type + ".", alphabet_.get());
+  size_t nbSeq = static_cast<size_t>(reader.read<uint64_t>());
+  nbSites_ = static_cast<size_t>(reader.read<uint64_t>());
+  // Each sequence takes at least 17 bytes of header.
+  if (nbSeq > size_ / 17)
+    throw IOException("PackedAlignment: truncated file.");
+  names_.resize(nbSeq);
+  counts_.resize(nbSeq);
+  ingroup_.resize(nbSeq);
+  groups_.resize(nbSeq);
+  for (size_t j = 0; j < nbSeq; ++j)
+  {
+    names_[j] = reader.readString(reader.read<uint32_t>());
+    counts_[j] = reader.read<uint32_t>();
+    groups_[j] = static_cast<size_t>(reader.read<uint64_t>());
+    ingroup_[j] = reader.read<uint8_t>() != 0;
+  }
+  coordinates_ = data_ + reader.getPosition();
+  if (nbSites_ > size_ / sizeof(int32_t))
+    throw IOException("PackedAlignment: truncated file.");
+  reader.skip(nbSites_ * sizeof(int32_t));
+  size_t offset = reader.getPosition();
+  offset += (8 - offset % 8) % 8;
+  valueWords_ = (nbSeq + 31) / 32;
+  maskWords_ = (nbSeq + 63) / 64;
+  size_t recordSize = (valueWords_ + maskWords_) * sizeof(uint64_t);
+  if (offset > size_ || (recordSize > 0 && nbSites_ > (size_ - offset) / recordSize))
+    throw IOException("PackedAlignment: truncated file.");
+  body_ = reinterpret_cast<const uint64_t*>(data_ + offset);
+}
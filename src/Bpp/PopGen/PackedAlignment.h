@@ -0,0 +1,202 @@
+// SPDX-FileCopyrightText: The Bio++ Development Group
+//
+// SPDX-License-Identifier: CECILL-2.1
+
+#ifndef _PACKEDALIGNMENT_H_
+#define _PACKEDALIGNMENT_H_
+
+#include <Bpp/Exceptions.h>
+#include <Bpp/Seq/Alphabet/Alphabet.h>
+
+// From the STL
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "PolymorphismSequenceContainer.h"
+#include "SiteCountSource.h"
+
+namespace bpp
+{
+/**
+ * @brief A read-only nucleotide alignment stored in a binary, site-major file.
+ *
+ * The file starts with a header holding the alphabet type, the name, count,
+ * ingroup flag and group id of each sequence, and the coordinate of each
+ * site. It is followed by one fixed-size record per site: the states of all
+ * sequences packed on 2 bits, then a bit mask of missing states. For a
+ * missing state, the packed value tells a gap (0) from an unresolved state
+ * (1), which is read back as the unknown character: ambiguity codes are
+ * therefore not preserved. Only alphabets with 4 resolved states (DNA, RNA)
+ * can be stored.
+ *
+ * On POSIX systems the file is memory-mapped, so that opening it only reads
+ * the header, and sites are decoded when they are accessed. On other systems
+ * the file is read into memory.
+ *
+ * The alignment can be read site by site, counted chunk by chunk as a
+ * SiteCountSource (counting uses bit operations on the packed records), or
+ * converted into a PolymorphismSequenceContainer with materialize().
+ *
+ * Files are written in the byte order of the machine, which is checked when
+ * they are opened.
+ */
+class PackedAlignment :
+  public virtual SiteCountSource
+{
+private:
+  std::shared_ptr<const Alphabet> alphabet_;
+  std::vector<std::string> names_;
+  std::vector<unsigned int> counts_;
+  std::vector<bool> ingroup_;
+  std::vector<size_t> groups_;
+  size_t nbSites_;
+  size_t valueWords_;
+  size_t maskWords_;
+  const char* data_;
+  size_t size_;
+  const char* coordinates_;
+  const uint64_t* body_;
+  bool mapped_;
+  std::vector<uint64_t> buffer_;
+  size_t chunkSize_;
+  size_t position_;
+  bool weighted_;
+
+public:
+  /**
+   * @brief Open a file.
+   *
+   * @param path The path of the file.
+   * @param alphabet The alphabet of the sequences, which must be of the
+   * type stored in the file.
+   * @param chunkSize The maximum number of sites in a chunk, when the
+   * alignment is used as a SiteCountSource.
+   * @throw IOException if the file cannot be read or is not a valid file.
+   * @throw AlphabetMismatchException if the alphabet does not match the file.
+   */
+  PackedAlignment(
+      const std::string& path,
+      std::shared_ptr<const Alphabet> alphabet,
+      size_t chunkSize = 100000);
+
+  virtual ~PackedAlignment();
+
+private:
+  PackedAlignment(const PackedAlignment&) = delete;
+  PackedAlignment& operator=(const PackedAlignment&) = delete;
+
+public:
+  /**
+   * @brief Write a container in the binary format.
+   *
+   * @param psc The container to write.
+   * @param path The path of the file.
+   * @throw AlphabetMismatchException if the alphabet of the container does
+   * not have 4 resolved states.
+   * @throw IOException if the file cannot be written.
+   */
+  static void write(
+      const PolymorphismSequenceContainer& psc,
+      const std::string& path);
+
+public:
+  std::shared_ptr<const Alphabet> getAlphabet() const { return alphabet_; }
+
+  size_t getNumberOfSequences() const { return names_.size(); }
+
+  std::vector<std::string> getSequenceNames() const { return names_; }
+
+  size_t getNumberOfSites() const { return nbSites_; }
+
+  unsigned int getSequenceCount(size_t index) const { return counts_[index]; }
+
+  bool isIngroupMember(size_t index) const { return ingroup_[index]; }
+
+  size_t getGroupId(size_t index) const { return groups_[index]; }
+
+  int getSiteCoordinate(size_t site) const;
+
+  /**
+   * @return True if the file is memory-mapped.
+   */
+  bool isMapped() const { return mapped_; }
+
+  /**
+   * @return The state of a sequence at a site.
+   */
+  int getValue(size_t index, size_t site) const;
+
+  /**
+   * @return True if the state of a sequence at a site is a gap or is unresolved.
+   */
+  bool isMissing(size_t index, size_t site) const
+  {
+    return (mask_(site)[index / 64] >> (index % 64)) & 1;
+  }
+
+  /**
+   * @return True if at least one sequence has a gap at a site.
+   */
+  bool hasGap(size_t site) const;
+
+  /**
+   * @return True if at least one sequence has a gap or an unresolved state at a site.
+   */
+  bool hasMissingData(size_t site) const;
+
+  /**
+   * @return A container with all the sequences and sites.
+   */
+  std::unique_ptr<PolymorphismSequenceContainer> materialize() const;
+
+  /**
+   * @name The SiteCountSource interface.
+   *
+   * @{
+   */
+  size_t getChunkSize() const { return chunkSize_; }
+
+  bool nextChunk(SiteCountTable& table);
+
+  void reset() { position_ = 0; }
+  /** @} */
+
+  /**
+   * @brief Count each sequence as many times as its count.
+   *
+   * Applies to the chunks read with nextChunk.
+   */
+  void setWeighted(bool weighted) { weighted_ = weighted; }
+
+  bool isWeighted() const { return weighted_; }
+
+  /**
+   * @brief Count the states of some sites.
+   *
+   * @param start The first site to count.
+   * @param nbSites The number of sites to count.
+   * @param table The table where counts are written, resized to nbSites.
+   * @throw IndexOutOfBoundsException if the sites are out of range.
+   */
+  void countSites(size_t start, size_t nbSites, SiteCountTable& table) const;
+
+private:
+  const uint64_t* values_(size_t site) const
+  {
+    return body_ + site * (valueWords_ + maskWords_);
+  }
+
+  const uint64_t* mask_(size_t site) const
+  {
+    return values_(site) + valueWords_;
+  }
+
+  void open_(const std::string& path);
+
+  void parseHeader_();
+};
+} // end of namespace bpp;
+
+#endif // _PACKEDALIGNMENT_H_
@@ -0,0 +1,110 @@
+// SPDX-FileCopyrightText: The Bio++ Development Group
+//
+// SPDX-License-Identifier: CECILL-2.1
+
+#ifndef _PARALLELTOOLS_H_
+#define _PARALLELTOOLS_H_
+
+// From the STL
+#include <algorithm>
+#include <cstddef>
+#include <exception>
+#include <thread>
+#include <vector>
+
+namespace bpp
+{
+/**
+ * @brief Run independent tasks on several threads.
+ *
+ * Task i is run by thread i mod nbThreads, so that the tasks of a thread
+ * are known in advance: a task can use scratch data owned by its thread
+ * number, and results written by task i to a slot of its own do not depend
+ * on the number of threads. Randomised tasks must draw their numbers from a
+ * stream of their own, e.g. CounterBasedGenerator(seed, i).
+ */
+class ParallelTools
+{
+public:
+  /**
+   * @return The number of threads to use for nbTasks tasks: nbThreads, or
+   * the number of hardware threads if nbThreads is 0, but at most nbTasks
+   * and at least 1.
+   */
+  static unsigned int getNumberOfThreads(unsigned int nbThreads, size_t nbTasks)
+  {
+    if (nbThreads == 0)
+      nbThreads = std::thread::hardware_concurrency();
+    if (nbTasks < nbThreads)
+      nbThreads = static_cast<unsigned int>(nbTasks);
+    return std::max(1u, nbThreads);
+  }
+
+  /**
+   * @brief Run task(i, t) for i in [0, nbTasks), where t is the number of the thread.
+   *
+   * The calling thread is thread 0. Calls made with the same thread number
+   * are never concurrent, and are made in increasing order of i.
+   *
+   * @param nbTasks The number of tasks.
+   * @param nbThreads The number of threads, at least 1, see getNumberOfThreads.
+   * @param task The task.
+   * @throw Exception Any exception thrown by a task, once all threads are done.
+   */
+  template<class Task>
+  static void parallelFor(size_t nbTasks, unsigned int nbThreads, const Task& task)
+  {
+    if (nbThreads <= 1)
+    {
+      for (size_t i = 0; i < nbTasks; ++i)
+      {
+        task(i, 0u);
+      }
+      return;
+    }
+    std::vector<std::exception_ptr> errors(nbThreads);
+    auto run = [&](unsigned int t) {
+      try
+      {
+        for (size_t i = t; i < nbTasks; i += nbThreads)
+        {
+          task(i, t);
+        }
+      }
+      catch (...)
+      {
+        errors[t] = std::current_exception();
+      }
+    };
+    std::vector<std::thread> threads;
+    threads.reserve(nbThreads - 1);
+    try
+    {
+      for (unsigned int t = 1; t < nbThreads; ++t)
+      {
+        threads.emplace_back(run, t);
+      }
+    }
+    catch (...)
+    {
+      for (auto& th : threads)
+      {
+        th.join();
+      }
+      throw;
+    }
+    run(0);
+    for (auto& th : threads)
+    {
+      th.join();
+    }
+    for (auto& error : errors)
+    {
+      if (error)
+        std::rethrow_exception(error);
+    }
+  }
+};
+} // end of namespace bpp;
+
+#endif // _PARALLELTOOLS_H_
@@ -2,6 +2,9 @@
 //
 // SPDX-License-Identifier: CECILL-2.1
 
+#include "AlleleCountTable.h"
+#include "GenotypeCountTable.h"
+#include "GenotypeMatrix.h"
 #include "PolymorphismMultiGContainer.h"
 
 using namespace bpp;
@@ -12,7 +15,9 @@ using namespace std;
 PolymorphismMultiGContainer::PolymorphismMultiGContainer(const PolymorphismMultiGContainer& pmgc) :
   multilocusGenotypes_(pmgc.size()),
   groups_(pmgc.size()),
-  groupsNames_()
+  groupsNames_(),
+  alleleCountTable_(atomic_load(&pmgc.alleleCountTable_)),
+  genotypeCountTable_(atomic_load(&pmgc.genotypeCountTable_))
 {
   for (size_t i = 0; i < pmgc.size(); ++i)
   {
@@ -41,6 +46,8 @@ PolymorphismMultiGContainer& PolymorphismMultiGContainer::operator=(const Polymo
     string name = pmgc.getGroupName(id);
     groupsNames_[id] = name;
   }
+  atomic_store(&alleleCountTable_, atomic_load(&pmgc.alleleCountTable_));
+  atomic_store(&genotypeCountTable_, atomic_load(&pmgc.genotypeCountTable_));
 
   return *this;
 }
@@ -51,6 +58,7 @@ void PolymorphismMultiGContainer::addMultilocusGenotype(unique_ptr<MultilocusGen
 {
   multilocusGenotypes_.push_back(std::move(mg));
   groups_.push_back(group);
+  invalidateCountTables();
   auto it = groupsNames_.find(group);
   if (!(it != groupsNames_.end()) )
   {
@@ -77,6 +85,7 @@ unique_ptr<MultilocusGenotype> PolymorphismMultiGContainer::removeMultilocusGeno
   unique_ptr<MultilocusGenotype> tmpMg = std::move(multilocusGenotypes_[position]);
   multilocusGenotypes_.erase(multilocusGenotypes_.begin() + static_cast<ptrdiff_t>(position));
   groups_.erase(groups_.begin() + static_cast<ptrdiff_t>(position));
+  invalidateCountTables();
   return tmpMg;
 }
 
@@ -88,6 +97,7 @@ void PolymorphismMultiGContainer::deleteMultilocusGenotype(size_t position)
     throw IndexOutOfBoundsException("PolymorphismMultiGContainer::deleteMultilocusGenotype: position out of bounds.", position, 0, size() - 1);
   multilocusGenotypes_.erase(multilocusGenotypes_.begin() + static_cast<ptrdiff_t>(position));
   groups_.erase(groups_.begin() + static_cast<ptrdiff_t>(position));
+  invalidateCountTables();
 }
 
 /******************************************************************************/
@@ -132,6 +142,7 @@ void PolymorphismMultiGContainer::setGroupId(size_t position, size_t group_id)
   if (position >= size())
     throw IndexOutOfBoundsException("PolymorphismMultiGContainer::setGroupId: position out of bounds.", position, 0, size() - 1);
   groups_[position] = group_id;
+  invalidateCountTables();
 }
 
 /******************************************************************************/
@@ -223,20 +234,11 @@ void PolymorphismMultiGContainer::addGroupName(size_t groupId, const string& nam
 
 size_t PolymorphismMultiGContainer::getLocusGroupSize(size_t group, size_t locusPosition) const
 {
-  size_t counter = 0;
-  for (size_t i = 0; i < size(); ++i)
-  {
-    try
-    {
-      if (groups_[i] == group && !multilocusGenotypes_[i]->isMonolocusGenotypeMissing(locusPosition))
-        counter++;
-    }
-    catch (IndexOutOfBoundsException& ioobe)
-    {
-      throw IndexOutOfBoundsException("PolymorphismMultiGContainer::getGroupSize: locusPosition out of bounds.", ioobe.getBadIndex(), ioobe.getBounds()[0], ioobe.getBounds()[1]);
-    }
-  }
-  return counter;
+  auto table = getAlleleCountTable();
+  if (locusPosition >= table->getNumberOfLoci())
+    throw IndexOutOfBoundsException("PolymorphismMultiGContainer::getGroupSize: locusPosition out of bounds.", locusPosition, 0, table->getNumberOfLoci());
+  vector<size_t> index = table->getGroupIndices(set<size_t>{group});
+  return index.empty() ? 0 : table->getNumberOfNonMissing(locusPosition, index[0]);
 }
 
 /******************************************************************************/
@@ -253,6 +255,42 @@ void PolymorphismMultiGContainer::clear()
   multilocusGenotypes_.clear();
   groups_.clear();
   groupsNames_.clear();
+  invalidateCountTables();
+}
+
+/******************************************************************************/
+
+unique_ptr<GenotypeMatrix> PolymorphismMultiGContainer::getGenotypeMatrix() const
+{
+  return make_unique<GenotypeMatrix>(*this);
+}
+
+/******************************************************************************/
+
+shared_ptr<const AlleleCountTable> PolymorphismMultiGContainer::getAlleleCountTable() const
+{
+  // Threads building a table at the same time each store an identical one:
+  // the last stored is kept, the others are released with their users.
+  shared_ptr<const AlleleCountTable> table = atomic_load(&alleleCountTable_);
+  if (!table)
+  {
+    table = make_shared<const AlleleCountTable>(*this);
+    atomic_store(&alleleCountTable_, table);
+  }
+  return table;
+}
+
+/******************************************************************************/
+
+shared_ptr<const GenotypeCountTable> PolymorphismMultiGContainer::getGenotypeCountTable() const
+{
+  shared_ptr<const GenotypeCountTable> table = atomic_load(&genotypeCountTable_);
+  if (!table)
+  {
+    table = make_shared<const GenotypeCountTable>(*getGenotypeMatrix());
+    atomic_store(&genotypeCountTable_, table);
+  }
+  return table;
 }
 
 /******************************************************************************/
@@ -19,15 +19,34 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <memory>
 #include <set>
 
 namespace bpp
 {
+class AlleleCountTable;
+class GenotypeCountTable;
+class GenotypeMatrix;
+
 /**
  * @brief The PolymorphismMultiGContainer class
  *
  * This class is a container of MultilocusGenotype.
  *
+ * Genotypes are stored as objects, since multilocusGenotype() returns
+ * references to them. Statistics do not read these objects: they use the
+ * per-locus and per-group allele and genotype counts, built on demand by
+ * getAlleleCountTable() and getGenotypeCountTable(), and kept until the
+ * container is modified. These tables only hold one count per allele or genotype and
+ * group, so that the container uses about as much memory as without them.
+ * Large data sets are best stored in a GenotypeMatrix filled directly, which
+ * only needs two bytes per allele, and converted with
+ * GenotypeMatrix::materialize() when a container is needed.
+ *
+ * Const methods, including the ones filling these caches, may be called
+ * from several threads at the same time. Modifying the container while it
+ * is read by another thread is not supported.
+ *
  * @author Sylvain Gaillard
  */
 class PolymorphismMultiGContainer :
@@ -37,6 +56,8 @@ private:
   std::vector<std::unique_ptr<MultilocusGenotype>> multilocusGenotypes_;
   std::vector<size_t> groups_; // group id for each multilocusgenotype
   std::map<size_t, std::string> groupsNames_;
+  mutable std::shared_ptr<const AlleleCountTable> alleleCountTable_;
+  mutable std::shared_ptr<const GenotypeCountTable> genotypeCountTable_;
 
 public:
   // Constructors and destructor
@@ -46,7 +67,9 @@ public:
   PolymorphismMultiGContainer() :
     multilocusGenotypes_(),
     groups_(std::vector<size_t>()),
-    groupsNames_(std::map<size_t, std::string>())
+    groupsNames_(std::map<size_t, std::string>()),
+    alleleCountTable_(),
+    genotypeCountTable_()
   {}
 
   /**
@@ -179,6 +202,47 @@ public:
    * @brief Clear the container.
    */
   void clear();
+
+  /**
+   * @brief Get a dense copy of the genotypes and group ids.
+   *
+   * A new copy is built on each call: it is not kept by the container, and
+   * is not updated when the container is modified.
+   *
+   * @throw Exception if the genotypes are not aligned.
+   * @throw BadIntegerException if an allele key is too large to be stored.
+   */
+  std::unique_ptr<GenotypeMatrix> getGenotypeMatrix() const;
+
+  /**
+   * @brief Get the allele counts of each group at each locus.
+   *
+   * The table is built from the genotypes on first use, and kept until the
+   * container is modified. If the genotypes are not aligned, only the loci
+   * present in all genotypes are counted.
+   */
+  std::shared_ptr<const AlleleCountTable> getAlleleCountTable() const;
+
+  /**
+   * @brief Get the diploid genotype counts of each group at each locus.
+   *
+   * The table is built from getGenotypeMatrix() on first use, and kept
+   * until the container is modified.
+   *
+   * @throw Exception if the genotypes are not aligned.
+   * @throw BadIntegerException if an allele key is too large to be stored in a GenotypeMatrix.
+   */
+  std::shared_ptr<const GenotypeCountTable> getGenotypeCountTable() const;
+
+  /**
+   * @brief Discard the count tables, see getAlleleCountTable() and
+   * getGenotypeCountTable().
+   */
+  void invalidateCountTables() const
+  {
+    std::atomic_store(&alleleCountTable_, std::shared_ptr<const AlleleCountTable>());
+    std::atomic_store(&genotypeCountTable_, std::shared_ptr<const GenotypeCountTable>());
+  }
 };
 } // end of namespace bpp;
 
@@ -6,6 +6,7 @@
 
 #include <Bpp/Numeric/Random/RandomTools.h>
 #include <algorithm>
+#include <map>
 
 using namespace std;
 using namespace bpp;
@@ -15,18 +16,7 @@ using namespace bpp;
 unique_ptr<PolymorphismMultiGContainer> PolymorphismMultiGContainerTools::permuteMultiG(
     const PolymorphismMultiGContainer& pmgc)
 {
-  auto permutedPmgc = make_unique<PolymorphismMultiGContainer>(pmgc);
-  vector<size_t> groups;
-  for (size_t i = 0; i < permutedPmgc->size(); ++i)
-  {
-    groups.push_back(permutedPmgc->getGroupId(i));
-  }
-  std::shuffle(groups.begin(), groups.end(), RandomTools::DEFAULT_GENERATOR);
-  for (size_t i = 0; i < permutedPmgc->size(); ++i)
-  {
-    permutedPmgc->setGroupId(i, groups[i]);
-  }
-  return permutedPmgc;
+  return permuteMultiG(pmgc, RandomTools::DEFAULT_GENERATOR);
 }
 
 /******************************************************************************/
@@ -35,317 +25,390 @@ unique_ptr<PolymorphismMultiGContainer> PolymorphismMultiGContainerTools::permut
     const PolymorphismMultiGContainer& pmgc,
     const std::set<size_t>& groups)
 {
-  unique_ptr<PolymorphismMultiGContainer> permutedPmgc;
-  size_t locNum = pmgc.getNumberOfLoci();
-  vector<vector<unique_ptr<const MonolocusGenotypeInterface>>> monoGens;
-  monoGens.resize(locNum);
-  // Get all the MonolocusGenotypes to permute
-  for (size_t i = 0; i < pmgc.size(); ++i)
-  {
-    if (groups.find(pmgc.getGroupId(i)) != groups.end())
-    {
-      for (size_t j = 0; j < locNum; ++j)
-      {
-        monoGens[j].push_back(unique_ptr<const MonolocusGenotypeInterface>(pmgc.multilocusGenotype(i).monolocusGenotype(j).clone()));
-      }
-    }
-  }
-  // PermutE the MonolocusGenotypes
-  for (size_t i = 0; i < locNum; ++i)
-  {
-    std::shuffle(monoGens[i].begin(), monoGens[i].end(), RandomTools::DEFAULT_GENERATOR);
-  }
-  // Build the new PolymorphismMultiGContainer
-  size_t k = 0;
-  for (size_t i = 0; i < pmgc.size(); ++i)
-  {
-    if (groups.find(pmgc.getGroupId(i)) != groups.end())
-    {
-      auto tmpMg = make_unique<MultilocusGenotype>(locNum);
-      for (size_t j = 0; j < locNum; ++j)
-      {
-        if (monoGens[j][k])
-          tmpMg->setMonolocusGenotype(j, *(monoGens[j][k]));
-      }
-      permutedPmgc->addMultilocusGenotype(tmpMg, pmgc.getGroupId(i));
-      k++;
-    }
-    else
-    {
-      auto tmpMg = make_unique<MultilocusGenotype>(pmgc.multilocusGenotype(i));
-      permutedPmgc->addMultilocusGenotype(tmpMg, pmgc.getGroupId(i));
-    }
-  }
+  return permuteMonoG(pmgc, groups, RandomTools::DEFAULT_GENERATOR);
+}
 
-  // update group names
-  set<size_t> grpIds = pmgc.getAllGroupsIds();
-  for (auto& id : grpIds)
-  {
-    string name = pmgc.getGroupName(id);
-    permutedPmgc->setGroupName(id, name);
-  }
+/******************************************************************************/
 
-  return permutedPmgc;
+unique_ptr<PolymorphismMultiGContainer> PolymorphismMultiGContainerTools::permuteIntraGroupMonoG(
+    const PolymorphismMultiGContainer& pmgc,
+    const set<size_t>& groups)
+{
+  return permuteIntraGroupMonoG(pmgc, groups, RandomTools::DEFAULT_GENERATOR);
 }
 
 /******************************************************************************/
 
-unique_ptr<PolymorphismMultiGContainer> PolymorphismMultiGContainerTools::permuteIntraGroupMonoG(
+unique_ptr<PolymorphismMultiGContainer> PolymorphismMultiGContainerTools::permuteAlleles(
+    const PolymorphismMultiGContainer& pmgc,
+    const std::set<size_t>& groups)
+{
+  return permuteAlleles(pmgc, groups, RandomTools::DEFAULT_GENERATOR);
+}
+
+/******************************************************************************/
+
+unique_ptr<PolymorphismMultiGContainer> PolymorphismMultiGContainerTools::permuteIntraGroupAlleles(
     const PolymorphismMultiGContainer& pmgc,
     const set<size_t>& groups)
 {
-  auto permutedPmgc = make_unique<PolymorphismMultiGContainer>();
-  size_t locNum = pmgc.getNumberOfLoci();
-  vector<vector<unique_ptr<const MonolocusGenotypeInterface>>> monoGens;
-  monoGens.resize(locNum);
+  return permuteIntraGroupAlleles(pmgc, groups, RandomTools::DEFAULT_GENERATOR);
+}
 
+/******************************************************************************/
+
+unique_ptr<PolymorphismMultiGContainer> PolymorphismMultiGContainerTools::extractGroups(
+    const PolymorphismMultiGContainer& pmgc,
+    const set<size_t>& groups)
+{
+  auto subPmgc = make_unique<PolymorphismMultiGContainer>();
   for (auto& g : groups) // for each group
   {
-    size_t nbIndInGroup = 0;
-    // Get all the MonolocusGenotypes of group g to permute
+    // Get all the MonolocusGenotypes of group g to extract
     for (size_t i = 0; i < pmgc.size(); ++i)
     {
       size_t indivGrp = pmgc.getGroupId(i);
-      if (groups.find(indivGrp) != groups.end())
+      if (groups.find(indivGrp) != groups.end() )
       {
         if (indivGrp == g)
         {
-          nbIndInGroup++;
-
-          for (size_t j = 0; j < locNum; ++j)
-          {
-            monoGens[j].push_back(unique_ptr<const MonolocusGenotypeInterface>(pmgc.multilocusGenotype(i).monolocusGenotype(j).clone()));
-          }
+          auto tmpMg = make_unique<MultilocusGenotype>(pmgc.multilocusGenotype(i));
+          subPmgc->addMultilocusGenotype(tmpMg, indivGrp);
         }
       }
-      else // insert as is
-      {
-        auto tmpMg = make_unique<MultilocusGenotype>(pmgc.multilocusGenotype(i));
-        permutedPmgc->addMultilocusGenotype(tmpMg, indivGrp);
-      }
     } // for i
-
-    // Permut the MonolocusGenotypes
-    if (nbIndInGroup > 0)
-    {
-      for (size_t j = 0; j < locNum; ++j)
-      {
-        std::shuffle(monoGens[j].begin(), monoGens[j].end(), RandomTools::DEFAULT_GENERATOR);
-      }
-
-      // Build the new multilocus genotypes
-      auto tmpMg = make_unique<MultilocusGenotype>(locNum);
-      for (size_t k = 0; k < nbIndInGroup; ++k)
-      {
-        for (size_t j = 0; j < locNum; ++j)
-        {
-          if (monoGens[j][k])
-            tmpMg->setMonolocusGenotype(j, *(monoGens[j][k]));
-        } // for j
-
-        permutedPmgc->addMultilocusGenotype(tmpMg, g);
-      } // for k
-    } // if nbIndInGroup
   } // for g
 
-  // update groups names
-  set<size_t> grpIds = pmgc.getAllGroupsIds();
+  // update group names
+  auto grpIds = subPmgc->getAllGroupsIds();
   for (auto& id : grpIds)
   {
     string name = pmgc.getGroupName(id);
-    permutedPmgc->setGroupName(id, name);
+    subPmgc->setGroupName(id, name);
+  }
+
+  return subPmgc;
+}
+
+/******************************************************************************/
+
+PolymorphismMultiGContainerTools::PermutationWorkspace::PermutationWorkspace(
+    const GenotypeMatrix& matrix,
+    const set<size_t>& groups) :
+  PermutationWorkspace(matrix, groups, vector<size_t>())
+{
+  loci_.resize(matrix.getNumberOfLoci());
+  for (size_t l = 0; l < loci_.size(); ++l)
+  {
+    loci_[l] = l;
+  }
+}
+
+/******************************************************************************/
+
+PolymorphismMultiGContainerTools::PermutationWorkspace::PermutationWorkspace(
+    const GenotypeMatrix& matrix,
+    const set<size_t>& groups,
+    const vector<size_t>& loci) :
+  individuals_(),
+  groupOffsets_(1, 0),
+  loci_(loci),
+  buffer_()
+{
+  for (auto l : loci)
+  {
+    if (l >= matrix.getNumberOfLoci())
+      throw IndexOutOfBoundsException("PolymorphismMultiGContainerTools::PermutationWorkspace: locus out of bounds.", l, 0, matrix.getNumberOfLoci());
+  }
+  for (auto g : groups)
+  {
+    for (size_t i = 0; i < matrix.getNumberOfIndividuals(); ++i)
+    {
+      if (matrix.getGroupId(i) == g)
+        individuals_.push_back(i);
+    }
+    groupOffsets_.push_back(individuals_.size());
+  }
+  // Large enough for the alleles of all the individuals at a locus.
+  buffer_.reserve(individuals_.size() * matrix.getPloidy());
+}
+
+/******************************************************************************/
+
+vector<size_t> PolymorphismMultiGContainerTools::getPermutation_(size_t n, const Shuffler& shuffler)
+{
+  vector<size_t> perm(n);
+  for (size_t i = 0; i < n; ++i)
+  {
+    perm[i] = i;
   }
+  shuffler(perm);
+  return perm;
+}
 
+/******************************************************************************/
+
+unique_ptr<PolymorphismMultiGContainer> PolymorphismMultiGContainerTools::permuteMultiG_(
+    const PolymorphismMultiGContainer& pmgc,
+    const Shuffler& shuffler)
+{
+  auto permutedPmgc = make_unique<PolymorphismMultiGContainer>(pmgc);
+  vector<size_t> perm = getPermutation_(pmgc.size(), shuffler);
+  for (size_t i = 0; i < pmgc.size(); ++i)
+  {
+    permutedPmgc->setGroupId(i, pmgc.getGroupId(perm[i]));
+  }
   return permutedPmgc;
 }
 
 /******************************************************************************/
 
-unique_ptr<PolymorphismMultiGContainer> PolymorphismMultiGContainerTools::permuteAlleles(
+unique_ptr<PolymorphismMultiGContainer> PolymorphismMultiGContainerTools::permuteMonoG_(
     const PolymorphismMultiGContainer& pmgc,
-    const std::set<size_t>& groups)
+    const set<size_t>& groups,
+    bool intraGroup,
+    const Shuffler& shuffler)
 {
   auto permutedPmgc = make_unique<PolymorphismMultiGContainer>();
   size_t locNum = pmgc.getNumberOfLoci();
-  vector<vector<size_t>> alleles;
-  alleles.resize(locNum);
-  // Get all the alleles to permut
+  // Individuals to permute, by pool (one pool per group, or a single one)
+  map<size_t, vector<size_t>> pools;
   for (size_t i = 0; i < pmgc.size(); ++i)
   {
-    if (groups.find(pmgc.getGroupId(i)) != groups.end())
-    {
-      for (size_t j = 0; j < locNum; ++j)
-      {
-        if (!pmgc.multilocusGenotype(i).isMonolocusGenotypeMissing(j))
-          for (size_t k = 0; k < pmgc.multilocusGenotype(i).monolocusGenotype(j).getAlleleIndex().size(); ++k)
-          {
-            alleles[j].push_back(pmgc.multilocusGenotype(i).monolocusGenotype(j).getAlleleIndex()[k]);
-          }
-      }
-    }
+    size_t g = pmgc.getGroupId(i);
+    if (groups.find(g) != groups.end())
+      pools[intraGroup ? g : 0].push_back(i);
   }
-  // Permut the alleles
-  for (size_t i = 0; i < locNum; ++i)
+  // One permutation per pool and per locus
+  map<size_t, vector<vector<size_t>>> perms;
+  for (auto& pool : pools)
   {
-    std::shuffle(alleles[i].begin(), alleles[i].end(), RandomTools::DEFAULT_GENERATOR);
+    perms[pool.first].resize(locNum);
+    for (size_t j = 0; j < locNum; ++j)
+    {
+      perms[pool.first][j] = getPermutation_(pool.second.size(), shuffler);
+    }
   }
-  // Build the new PolymorphismMultiGContainer
-  vector<size_t> k(locNum, 0);
+  // Build the new PolymorphismMultiGContainer, keeping the order of the individuals
+  map<size_t, size_t> ranks;
   for (size_t i = 0; i < pmgc.size(); ++i)
   {
-    if (groups.find(pmgc.getGroupId(i)) != groups.end())
+    size_t g = pmgc.getGroupId(i);
+    if (groups.find(g) != groups.end())
     {
+      size_t p = intraGroup ? g : 0;
+      size_t k = ranks[p]++;
       auto tmpMg = make_unique<MultilocusGenotype>(locNum);
       for (size_t j = 0; j < locNum; ++j)
       {
-        if (!pmgc.multilocusGenotype(i).isMonolocusGenotypeMissing(j))
-        {
-          if (pmgc.multilocusGenotype(i).monolocusGenotype(j).getAlleleIndex().size() == 1)
-            tmpMg->setMonolocusGenotype(j, MonoAlleleMonolocusGenotype(alleles[j][k[j]++]));
-          if (pmgc.multilocusGenotype(i).monolocusGenotype(j).getAlleleIndex().size() == 2)
-            tmpMg->setMonolocusGenotype(j, BiAlleleMonolocusGenotype(alleles[j][k[j]++], alleles[j][k[j]++]));
-        }
+        const MultilocusGenotype& source = pmgc.multilocusGenotype(pools[p][perms[p][j][k]]);
+        if (!source.isMonolocusGenotypeMissing(j))
+          tmpMg->setMonolocusGenotype(j, source.monolocusGenotype(j));
       }
-      permutedPmgc->addMultilocusGenotype(tmpMg, pmgc.getGroupId(i));
+      permutedPmgc->addMultilocusGenotype(tmpMg, g);
     }
     else
     {
       auto tmpMg = make_unique<MultilocusGenotype>(pmgc.multilocusGenotype(i));
-      permutedPmgc->addMultilocusGenotype(tmpMg, pmgc.getGroupId(i));
+      permutedPmgc->addMultilocusGenotype(tmpMg, g);
     }
   }
-
-  // update groups names
-  set<size_t> grpIds = pmgc.getAllGroupsIds();
-  for (auto& id : grpIds)
-  {
-    string name = pmgc.getGroupName(id);
-    permutedPmgc->setGroupName(id, name);
-  }
-
+  copyGroupNames_(pmgc, *permutedPmgc);
   return permutedPmgc;
 }
 
 /******************************************************************************/
 
-unique_ptr<PolymorphismMultiGContainer> PolymorphismMultiGContainerTools::permuteIntraGroupAlleles(
+unique_ptr<PolymorphismMultiGContainer> PolymorphismMultiGContainerTools::permuteAlleles_(
     const PolymorphismMultiGContainer& pmgc,
-    const set<size_t>& groups)
+    const set<size_t>& groups,
+    bool intraGroup,
+    const Shuffler& shuffler)
 {
   auto permutedPmgc = make_unique<PolymorphismMultiGContainer>();
   size_t locNum = pmgc.getNumberOfLoci();
-  vector<vector<size_t>> alleles;
-  alleles.resize(locNum);
-
-  for (auto& g : groups) // for each group
+  // Alleles to permute, by pool (one pool per group, or a single one) and by locus
+  map<size_t, vector<vector<size_t>>> alleles;
+  for (size_t i = 0; i < pmgc.size(); ++i)
   {
-    size_t nbIndInGroup = 0;
-
-    vector<vector<size_t>> nbAllelesForInds;
-    nbAllelesForInds.resize(locNum);
-    // Get all the alleles to permute
-    for (size_t i = 0; i < pmgc.size(); ++i)
+    size_t g = pmgc.getGroupId(i);
+    if (groups.find(g) == groups.end())
+      continue;
+    vector<vector<size_t>>& pool = alleles[intraGroup ? g : 0];
+    pool.resize(locNum);
+    for (size_t j = 0; j < locNum; ++j)
     {
-      size_t indivGrp = pmgc.getGroupId(i);
-      if (groups.find(indivGrp) != groups.end() )
+      if (!pmgc.multilocusGenotype(i).isMonolocusGenotypeMissing(j))
       {
-        if (indivGrp == g)
-        {
-          nbIndInGroup++;
-          for (size_t j = 0; j < locNum; ++j)
-          {
-            if (!pmgc.multilocusGenotype(i).isMonolocusGenotypeMissing(j))
-            {
-              size_t nbAlls = pmgc.multilocusGenotype(i).monolocusGenotype(j).getAlleleIndex().size();
-              nbAllelesForInds[j].push_back(nbAlls);
-              for (size_t k = 0; k < nbAlls; ++k)
-              {
-                alleles[j].push_back(pmgc.multilocusGenotype(i).monolocusGenotype(j).getAlleleIndex()[k]);
-              }
-            }
-          }
-        }
+        vector<size_t> keys = pmgc.multilocusGenotype(i).monolocusGenotype(j).getAlleleIndex();
+        pool[j].insert(pool[j].end(), keys.begin(), keys.end());
       }
-      else // insert as is
+    }
+  }
+  // Permute the alleles
+  for (auto& pool : alleles)
+  {
+    for (size_t j = 0; j < locNum; ++j)
+    {
+      vector<size_t> perm = getPermutation_(pool.second[j].size(), shuffler);
+      vector<size_t> permuted(perm.size());
+      for (size_t k = 0; k < perm.size(); ++k)
       {
-        auto tmpMg = make_unique<MultilocusGenotype>(pmgc.multilocusGenotype(i));
-        permutedPmgc->addMultilocusGenotype(tmpMg, indivGrp);
+        permuted[k] = pool.second[j][perm[k]];
       }
-    } // for i
-
-    // Permute the alleles
-    if (nbIndInGroup > 0)
+      pool.second[j].swap(permuted);
+    }
+  }
+  // Build the new PolymorphismMultiGContainer, keeping the order of the
+  // individuals and their number of alleles at each locus
+  map<size_t, vector<size_t>> next;
+  for (size_t i = 0; i < pmgc.size(); ++i)
+  {
+    size_t g = pmgc.getGroupId(i);
+    if (groups.find(g) != groups.end())
     {
-      for (size_t i = 0; i < locNum; ++i)
+      size_t p = intraGroup ? g : 0;
+      vector<size_t>& k = next[p];
+      k.resize(locNum, 0);
+      auto tmpMg = make_unique<MultilocusGenotype>(locNum);
+      for (size_t j = 0; j < locNum; ++j)
       {
-        // alleles[i] = RandomTools::getSample(alleles[i], alleles[i].size());
-        std::shuffle(alleles[i].begin(), alleles[i].end(), RandomTools::DEFAULT_GENERATOR);
+        if (pmgc.multilocusGenotype(i).isMonolocusGenotypeMissing(j))
+          continue;
+        size_t nbAlls = pmgc.multilocusGenotype(i).monolocusGenotype(j).getAlleleIndex().size();
+        vector<size_t> keys(alleles[p][j].begin() + static_cast<ptrdiff_t>(k[j]), alleles[p][j].begin() + static_cast<ptrdiff_t>(k[j] + nbAlls));
+        k[j] += nbAlls;
+        tmpMg->setMonolocusGenotypeByAlleleKey(j, keys);
       }
+      permutedPmgc->addMultilocusGenotype(tmpMg, g);
+    }
+    else
+    {
+      auto tmpMg = make_unique<MultilocusGenotype>(pmgc.multilocusGenotype(i));
+      permutedPmgc->addMultilocusGenotype(tmpMg, g);
+    }
+  }
+  copyGroupNames_(pmgc, *permutedPmgc);
+  return permutedPmgc;
+}
 
-      // Build the new PolymorphismMultiGContainer
-      vector<size_t> k(locNum, 0);
+/******************************************************************************/
 
-      for (size_t ind = 0; ind < nbIndInGroup; ind++)
-      {
-        auto tmpMg = make_unique<MultilocusGenotype>(locNum);
-        for (size_t j = 0; j < locNum; ++j)
-        {
-          if (nbAllelesForInds[j][ind] == 1)
-            tmpMg->setMonolocusGenotype(j, MonoAlleleMonolocusGenotype(alleles[j][k[j]++]));
-          if (nbAllelesForInds[j][ind] == 2)
-            tmpMg->setMonolocusGenotype(j, BiAlleleMonolocusGenotype(alleles[j][k[j]++], alleles[j][k[j]++]));
-        } // for j
-
-        permutedPmgc->addMultilocusGenotype(tmpMg, g);
-      } // for ind
-    } // if nbIndInGroup
-  } // for g
+void PolymorphismMultiGContainerTools::permuteMultiG_(
+    const GenotypeMatrix& source,
+    GenotypeMatrix& target,
+    PermutationWorkspace& workspace,
+    const Shuffler& shuffler)
+{
+  const vector<size_t>& individuals = workspace.individuals_;
+  vector<size_t>& groupIds = workspace.buffer_;
+  groupIds.resize(individuals.size());
+  for (size_t k = 0; k < individuals.size(); ++k)
+  {
+    groupIds[k] = source.getGroupId(individuals[k]);
+  }
+  shuffler(groupIds);
+  for (size_t k = 0; k < individuals.size(); ++k)
+  {
+    target.setGroupId(individuals[k], groupIds[k]);
+  }
+}
 
+/******************************************************************************/
 
-  // update groups names
-  auto grpIds = pmgc.getAllGroupsIds();
-  for (auto& id : grpIds)
+void PolymorphismMultiGContainerTools::permuteMonoG_(
+    const GenotypeMatrix& source,
+    GenotypeMatrix& target,
+    PermutationWorkspace& workspace,
+    bool intraGroup,
+    const Shuffler& shuffler)
+{
+  const vector<size_t>& individuals = workspace.individuals_;
+  const vector<size_t>& offsets = workspace.groupOffsets_;
+  vector<size_t>& perm = workspace.buffer_;
+  size_t ploidy = source.getPloidy();
+  // Individuals to permute, by pool (one pool per group, or a single one)
+  size_t nbPools = intraGroup ? offsets.size() - 1 : 1;
+  for (size_t p = 0; p < nbPools; ++p)
   {
-    string name = pmgc.getGroupName(id);
-    permutedPmgc->setGroupName(id, name);
+    size_t begin = intraGroup ? offsets[p] : 0;
+    size_t end = intraGroup ? offsets[p + 1] : individuals.size();
+    for (auto locus : workspace.loci_)
+    {
+      perm.resize(end - begin);
+      for (size_t k = 0; k < perm.size(); ++k)
+      {
+        perm[k] = k;
+      }
+      shuffler(perm);
+      const uint16_t* codes = source.getLocus(locus);
+      uint16_t* permutedCodes = target.getLocus(locus);
+      for (size_t k = 0; k < perm.size(); ++k)
+      {
+        const uint16_t* alleles = codes + individuals[begin + perm[k]] * ploidy;
+        copy(alleles, alleles + ploidy, permutedCodes + individuals[begin + k] * ploidy);
+      }
+    }
   }
-
-  return permutedPmgc;
 }
 
 /******************************************************************************/
 
-unique_ptr<PolymorphismMultiGContainer> PolymorphismMultiGContainerTools::extractGroups(
-    const PolymorphismMultiGContainer& pmgc,
-    const set<size_t>& groups)
+void PolymorphismMultiGContainerTools::permuteAlleles_(
+    const GenotypeMatrix& source,
+    GenotypeMatrix& target,
+    PermutationWorkspace& workspace,
+    bool intraGroup,
+    const Shuffler& shuffler)
 {
-  auto subPmgc = make_unique<PolymorphismMultiGContainer>();
-  for (auto& g : groups) // for each group
+  const vector<size_t>& individuals = workspace.individuals_;
+  const vector<size_t>& offsets = workspace.groupOffsets_;
+  vector<size_t>& pool = workspace.buffer_;
+  size_t ploidy = source.getPloidy();
+  size_t nbPools = intraGroup ? offsets.size() - 1 : 1;
+  for (size_t p = 0; p < nbPools; ++p)
   {
-    // Get all the MonolocusGenotypes of group g to extract
-    for (size_t i = 0; i < pmgc.size(); ++i)
+    size_t begin = intraGroup ? offsets[p] : 0;
+    size_t end = intraGroup ? offsets[p + 1] : individuals.size();
+    for (auto locus : workspace.loci_)
     {
-      size_t indivGrp = pmgc.getGroupId(i);
-      if (groups.find(indivGrp) != groups.end() )
+      // Alleles of the pool at this locus, then written back in the same
+      // positions, so that each individual keeps its number of alleles.
+      const uint16_t* codes = source.getLocus(locus);
+      uint16_t* permutedCodes = target.getLocus(locus);
+      pool.clear();
+      for (size_t k = begin; k < end; ++k)
       {
-        if (indivGrp == g)
+        const uint16_t* alleles = codes + individuals[k] * ploidy;
+        for (size_t a = 0; a < ploidy && alleles[a] != GenotypeMatrix::MISSING; ++a)
         {
-          auto tmpMg = make_unique<MultilocusGenotype>(pmgc.multilocusGenotype(i));
-          subPmgc->addMultilocusGenotype(tmpMg, indivGrp);
+          pool.push_back(alleles[a]);
         }
       }
-    } // for i
-  } // for g
+      shuffler(pool);
+      size_t n = 0;
+      for (size_t k = begin; k < end; ++k)
+      {
+        const uint16_t* alleles = codes + individuals[k] * ploidy;
+        for (size_t a = 0; a < ploidy && alleles[a] != GenotypeMatrix::MISSING; ++a)
+        {
+          permutedCodes[individuals[k] * ploidy + a] = static_cast<uint16_t>(pool[n++]);
+        }
+      }
+    }
+  }
+}
 
-  // update group names
-  auto grpIds = subPmgc->getAllGroupsIds();
+/******************************************************************************/
+
+void PolymorphismMultiGContainerTools::copyGroupNames_(
+    const PolymorphismMultiGContainer& pmgc,
+    PolymorphismMultiGContainer& permutedPmgc)
+{
+  set<size_t> grpIds = pmgc.getAllGroupsIds();
   for (auto& id : grpIds)
   {
     string name = pmgc.getGroupName(id);
-    subPmgc->setGroupName(id, name);
+    permutedPmgc.setGroupName(id, name);
   }
-
-  return subPmgc;
 }
-
-/******************************************************************************/
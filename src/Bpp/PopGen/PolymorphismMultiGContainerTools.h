@@ -6,9 +6,14 @@
 #define _POLYMORPHISMMULTIGCONTAINERTOOLS_H_
 
 // From the STL
+#include <algorithm>
+#include <functional>
 #include <set>
+#include <vector>
 
 // From the PolGenLib library
+#include "CounterBasedGenerator.h"
+#include "GenotypeMatrix.h"
 #include "PolymorphismMultiGContainer.h"
 
 #include <Bpp/Numeric/Random/RandomTools.h>
@@ -20,11 +25,72 @@ namespace bpp
  *
  * Provides static methods for permutations.
  *
+ * Every permutation method has an overload taking the random number
+ * generator to use, which can be any UniformRandomBitGenerator, for instance
+ * a CounterBasedGenerator built from a seed and a replicate number for
+ * reproducible results across threads. Permutations drawn from a
+ * CounterBasedGenerator are the same on every platform. With other
+ * generators they go through std::shuffle, whose results depend on the
+ * standard library. The overloads without generator use
+ * RandomTools::DEFAULT_GENERATOR, which must not be shared between threads.
+ *
+ * The permutations of a container build a new container, with new
+ * MultilocusGenotype objects. Permutation tests, which need many permuted
+ * data sets, can use the permutations of a GenotypeMatrix instead: they
+ * write the permuted genotypes of a source matrix in place in a target
+ * matrix, using the index arrays and buffers of a PermutationWorkspace built
+ * once, and do not allocate memory.
+ *
  * @author Sylvain Gaillard
  */
 class PolymorphismMultiGContainerTools
 {
 public:
+  /**
+   * @brief Index arrays and buffers reused by the permutations of a GenotypeMatrix.
+   *
+   * A workspace holds the individuals of some groups of a matrix, ordered
+   * by group, and the loci to permute. It must only be used with this
+   * matrix, or one with the same groups, dimensions and missing genotypes.
+   *
+   * Permutations within groups draw the same permutations as the methods
+   * on containers with the same generator. Permutations between groups
+   * draw other ones, as individuals are taken in order of their group.
+   */
+  class PermutationWorkspace
+  {
+private:
+    std::vector<size_t> individuals_;
+    std::vector<size_t> groupOffsets_;
+    std::vector<size_t> loci_;
+    std::vector<size_t> buffer_;
+
+public:
+    /**
+     * @param matrix The genotypes to permute.
+     * @param groups The groups whose individuals are permuted.
+     */
+    PermutationWorkspace(const GenotypeMatrix& matrix, const std::set<size_t>& groups);
+
+    /**
+     * @param matrix The genotypes to permute.
+     * @param groups The groups whose individuals are permuted.
+     * @param loci The loci to permute. Genotypes at other loci are not written.
+     * @throw IndexOutOfBoundsException if a locus is out of range.
+     */
+    PermutationWorkspace(const GenotypeMatrix& matrix, const std::set<size_t>& groups, const std::vector<size_t>& loci);
+
+public:
+    /**
+     * @return The permuted individuals, ordered by group id.
+     */
+    const std::vector<size_t>& getIndividuals() const { return individuals_; }
+
+    const std::vector<size_t>& getLoci() const { return loci_; }
+
+    friend class PolymorphismMultiGContainerTools;
+  };
+
   /**
    * @brief Permut the MultilocusGenotype in the whole PolymorphismMultiGContainer.
    *
@@ -81,6 +147,186 @@ public:
   static std::unique_ptr<PolymorphismMultiGContainer> permuteIntraGroupAlleles(const PolymorphismMultiGContainer& pmgc, const std::set<size_t>& groups);
 
   static std::unique_ptr<PolymorphismMultiGContainer> extractGroups(const PolymorphismMultiGContainer& pmgc, const std::set<size_t>& groups);
+
+  /**
+   * @name Permutations with a given random number generator
+   *
+   * Same as above, drawing the permutations from generator.
+   *
+   * @{
+   */
+  template<class URBG>
+  static std::unique_ptr<PolymorphismMultiGContainer> permuteMultiG(const PolymorphismMultiGContainer& pmgc, URBG& generator)
+  {
+    return permuteMultiG_(pmgc, getShuffler_(generator));
+  }
+
+  template<class URBG>
+  static std::unique_ptr<PolymorphismMultiGContainer> permuteMonoG(const PolymorphismMultiGContainer& pmgc, const std::set<size_t>& groups, URBG& generator)
+  {
+    return permuteMonoG_(pmgc, groups, false, getShuffler_(generator));
+  }
+
+  template<class URBG>
+  static std::unique_ptr<PolymorphismMultiGContainer> permuteIntraGroupMonoG(const PolymorphismMultiGContainer& pmgc, const std::set<size_t>& groups, URBG& generator)
+  {
+    return permuteMonoG_(pmgc, groups, true, getShuffler_(generator));
+  }
+
+  template<class URBG>
+  static std::unique_ptr<PolymorphismMultiGContainer> permuteAlleles(const PolymorphismMultiGContainer& pmgc, const std::set<size_t>& groups, URBG& generator)
+  {
+    return permuteAlleles_(pmgc, groups, false, getShuffler_(generator));
+  }
+
+  template<class URBG>
+  static std::unique_ptr<PolymorphismMultiGContainer> permuteIntraGroupAlleles(const PolymorphismMultiGContainer& pmgc, const std::set<size_t>& groups, URBG& generator)
+  {
+    return permuteAlleles_(pmgc, groups, true, getShuffler_(generator));
+  }
+  /** @} */
+
+  /**
+   * @name Permutations of a genotype matrix
+   *
+   * The permuted genotypes of source are written in target, which must be a
+   * copy of source, or of the target of a previous permutation: only the
+   * genotypes of the individuals and loci of the workspace, or only their
+   * group ids, are written. Each call draws a new permutation of source, so
+   * the same target and workspace can be reused for all the replicates of a
+   * test, and no memory is allocated.
+   *
+   * @{
+   */
+
+  /**
+   * @brief Permute the individuals of the workspace between their groups,
+   * by shuffling their group ids.
+   */
+  template<class URBG>
+  static void permuteMultiG(const GenotypeMatrix& source, GenotypeMatrix& target, PermutationWorkspace& workspace, URBG& generator)
+  {
+    permuteMultiG_(source, target, workspace, getShuffler_(generator));
+  }
+
+  /**
+   * @brief Permute the genotypes of the individuals of the workspace at each locus.
+   */
+  template<class URBG>
+  static void permuteMonoG(const GenotypeMatrix& source, GenotypeMatrix& target, PermutationWorkspace& workspace, URBG& generator)
+  {
+    permuteMonoG_(source, target, workspace, false, getShuffler_(generator));
+  }
+
+  /**
+   * @brief Permute the genotypes of the individuals of each group of the workspace at each locus.
+   */
+  template<class URBG>
+  static void permuteIntraGroupMonoG(const GenotypeMatrix& source, GenotypeMatrix& target, PermutationWorkspace& workspace, URBG& generator)
+  {
+    permuteMonoG_(source, target, workspace, true, getShuffler_(generator));
+  }
+
+  /**
+   * @brief Permute the alleles of the individuals of the workspace at each
+   * locus. Each individual keeps its number of alleles.
+   */
+  template<class URBG>
+  static void permuteAlleles(const GenotypeMatrix& source, GenotypeMatrix& target, PermutationWorkspace& workspace, URBG& generator)
+  {
+    permuteAlleles_(source, target, workspace, false, getShuffler_(generator));
+  }
+
+  /**
+   * @brief Permute the alleles of the individuals of each group of the
+   * workspace at each locus. Each individual keeps its number of alleles.
+   */
+  template<class URBG>
+  static void permuteIntraGroupAlleles(const GenotypeMatrix& source, GenotypeMatrix& target, PermutationWorkspace& workspace, URBG& generator)
+  {
+    permuteAlleles_(source, target, workspace, true, getShuffler_(generator));
+  }
+  /** @} */
+
+private:
+  /**
+   * @brief A function shuffling a vector of indices in place.
+   */
+  typedef std::function<void (std::vector<size_t>&)> Shuffler;
+
+  template<class URBG>
+  static Shuffler getShuffler_(URBG& generator)
+  {
+    return [&generator](std::vector<size_t>& v) {
+             std::shuffle(v.begin(), v.end(), generator);
+           };
+  }
+
+  /**
+   * @brief The shuffler of a CounterBasedGenerator, which does not depend
+   * on the standard library, unlike std::shuffle.
+   */
+  static Shuffler getShuffler_(CounterBasedGenerator& generator)
+  {
+    return [&generator](std::vector<size_t>& v) {
+             generator.shuffle(v.begin(), v.end());
+           };
+  }
+
+  /**
+   * @return A random permutation of 0 ... n-1.
+   */
+  static std::vector<size_t> getPermutation_(size_t n, const Shuffler& shuffler);
+
+  static std::unique_ptr<PolymorphismMultiGContainer> permuteMultiG_(
+      const PolymorphismMultiGContainer& pmgc,
+      const Shuffler& shuffler);
+
+  /**
+   * @brief Permute the MonolocusGenotypes of the individuals of some groups,
+   * independently for each locus, either between all these individuals or
+   * only within each group.
+   */
+  static std::unique_ptr<PolymorphismMultiGContainer> permuteMonoG_(
+      const PolymorphismMultiGContainer& pmgc,
+      const std::set<size_t>& groups,
+      bool intraGroup,
+      const Shuffler& shuffler);
+
+  /**
+   * @brief Permute the alleles of the individuals of some groups,
+   * independently for each locus, either between all these individuals or
+   * only within each group. Each individual keeps its number of alleles.
+   */
+  static std::unique_ptr<PolymorphismMultiGContainer> permuteAlleles_(
+      const PolymorphismMultiGContainer& pmgc,
+      const std::set<size_t>& groups,
+      bool intraGroup,
+      const Shuffler& shuffler);
+
+  static void permuteMultiG_(
+      const GenotypeMatrix& source,
+      GenotypeMatrix& target,
+      PermutationWorkspace& workspace,
+      const Shuffler& shuffler);
+
+  static void permuteMonoG_(
+      const GenotypeMatrix& source,
+      GenotypeMatrix& target,
+      PermutationWorkspace& workspace,
+      bool intraGroup,
+      const Shuffler& shuffler);
+
+  static void permuteAlleles_(
+      const GenotypeMatrix& source,
+      GenotypeMatrix& target,
+      PermutationWorkspace& workspace,
+      bool intraGroup,
+      const Shuffler& shuffler);
+
+  static void copyGroupNames_(
+      const PolymorphismMultiGContainer& pmgc,
+      PolymorphismMultiGContainer& permutedPmgc);
 };
 } // end of namespace bpp;
 
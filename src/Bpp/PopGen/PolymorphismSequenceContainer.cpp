@@ -3,6 +3,8 @@
 // SPDX-License-Identifier: CECILL-2.1
 
 #include "PolymorphismSequenceContainer.h"
+#include "PolymorphismSequenceView.h"
+#include "SequenceMatrix.h"
 
 #include <Bpp/Seq/SequenceTools.h>
 
@@ -15,7 +17,8 @@ PolymorphismSequenceContainer::PolymorphismSequenceContainer(const SequenceConta
   VectorSiteContainer(sc.getAlphabet()),
   ingroup_(),
   count_(),
-  group_()
+  group_(),
+  sequenceMatrix_()
 {
   if (sc.getNumberOfSequences() == 0)
     return; // done.
@@ -52,7 +55,8 @@ PolymorphismSequenceContainer::PolymorphismSequenceContainer(const PolymorphismS
   VectorSiteContainer(psc),
   ingroup_(psc.getNumberOfSequences()),
   count_(psc.getNumberOfSequences()),
-  group_(psc.getNumberOfSequences())
+  group_(psc.getNumberOfSequences()),
+  sequenceMatrix_(atomic_load(&psc.sequenceMatrix_))
 {
   for (size_t i = 0; i < psc.getNumberOfSequences(); i++)
   {
@@ -67,6 +71,7 @@ PolymorphismSequenceContainer::PolymorphismSequenceContainer(const PolymorphismS
 PolymorphismSequenceContainer& PolymorphismSequenceContainer::operator=(const PolymorphismSequenceContainer& psc)
 {
   VectorSiteContainer::operator=(psc);
+  atomic_store(&sequenceMatrix_, atomic_load(&psc.sequenceMatrix_));
   // Setting up the sequences comments, numbers and ingroup state
   size_t nbSeq = psc.getNumberOfSequences();
   count_.resize(nbSeq);
@@ -101,6 +106,7 @@ std::unique_ptr<Sequence> PolymorphismSequenceContainer::removeSequence(size_t s
   count_.erase(count_.begin() + static_cast<ptrdiff_t>(sequencePosition));
   ingroup_.erase(ingroup_.begin() + static_cast<ptrdiff_t>(sequencePosition));
   group_.erase(group_.begin() + static_cast<ptrdiff_t>(sequencePosition));
+  invalidateSequenceMatrix();
   return VectorSiteContainer::removeSequence(sequencePosition);
 }
 
@@ -351,3 +357,18 @@ unique_ptr<SiteContainerInterface> PolymorphismSequenceContainer::toSiteContaine
 }
 
 /******************************************************************************/
+
+/******************************************************************************/
+
+shared_ptr<const SequenceMatrix> PolymorphismSequenceContainer::getSequenceMatrix() const
+{
+  // Threads building a matrix at the same time each store an identical one:
+  // the last stored is kept, the others are released with their users.
+  shared_ptr<const SequenceMatrix> matrix = atomic_load(&sequenceMatrix_);
+  if (!matrix)
+  {
+    matrix = make_shared<const SequenceMatrix>(PolymorphismSequenceView(*this));
+    atomic_store(&sequenceMatrix_, matrix);
+  }
+  return matrix;
+}
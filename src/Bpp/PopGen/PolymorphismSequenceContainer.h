@@ -5,6 +5,7 @@
 #ifndef _POLYMORPHISMSEQUENCECONTAINER_H_
 #define _POLYMORPHISMSEQUENCECONTAINER_H_
 
+#include <memory>
 #include <set>
 #include <string>
 
@@ -55,12 +56,20 @@
 
 namespace bpp
 {
+class SequenceMatrix;
+
 /**
  * @brief The PolymorphismSequenceContainer class.
  *
  * This is a VectorSiteContainer with effectif for each sequence.
  * It also has flag for ingroup and outgroup.
  *
+ * Sites are stored contiguously, which suits per-site statistics. A
+ * sequence-major copy of the states, for operations comparing whole
+ * sequences, is built on demand by getSequenceMatrix() and kept until the
+ * states are modified. Const methods, including the one filling this
+ * cache, may be called from several threads at the same time.
+ *
  * @author Sylvain Gaillard
  */
 class PolymorphismSequenceContainer :
@@ -70,6 +79,7 @@ private:
   std::vector<bool> ingroup_;
   std::vector<unsigned int> count_;
   std::vector<size_t> group_;
+  mutable std::shared_ptr<const SequenceMatrix> sequenceMatrix_;
 
 public:
   // Constructors and destructor
@@ -80,7 +90,8 @@ public:
     VectorSiteContainer(alpha),
     ingroup_(std::vector<bool>()),
     count_(0),
-    group_(0)
+    group_(0),
+    sequenceMatrix_()
   {}
 
   /**
@@ -89,8 +100,9 @@ public:
   PolymorphismSequenceContainer(size_t size, std::shared_ptr<const Alphabet> alpha) :
     VectorSiteContainer(size, alpha),
     ingroup_(size),
-    count_(size),
-    group_(size)
+    count_(size, 1),
+    group_(size),
+    sequenceMatrix_()
   {}
 
   /**
@@ -99,8 +111,9 @@ public:
   PolymorphismSequenceContainer(const std::vector<std::string>& names, std::shared_ptr<const Alphabet> alpha) :
     VectorSiteContainer(names, alpha),
     ingroup_(names.size()),
-    count_(names.size()),
-    group_(names.size())
+    count_(names.size(), 1),
+    group_(names.size()),
+    sequenceMatrix_()
   {}
 
   /**
@@ -112,7 +125,8 @@ public:
     VectorSiteContainer(sc),
     ingroup_(sc.getNumberOfSequences(), true),
     count_(sc.getNumberOfSequences(), 1),
-    group_(sc.getNumberOfSequences(), 1)
+    group_(sc.getNumberOfSequences(), 1),
+    sequenceMatrix_()
   {}
 
   /**
@@ -172,6 +186,7 @@ public:
       unsigned int frequency)
   {
     VectorSiteContainer::addSequence(sequenceKey, sequence);
+    invalidateSequenceMatrix();
     count_.push_back(frequency);
     ingroup_.push_back(true);
     group_.push_back(0);
@@ -185,6 +200,7 @@ public:
       unsigned int frequency)
   {
     VectorSiteContainer::insertSequence(sequencePosition, sequence, sequenceKey);
+    invalidateSequenceMatrix();
     count_.insert(count_.begin() + static_cast<ptrdiff_t>(sequencePosition), frequency);
     ingroup_.insert(ingroup_.begin() + static_cast<ptrdiff_t>(sequencePosition), true);
     group_.insert(group_.begin() + static_cast<ptrdiff_t>(sequencePosition), 0);
@@ -202,12 +218,110 @@ public:
     insertSequenceWithFrequency(sequencePosition, sequence, sequenceKey, 1);
   }
 
+  /**
+   * @name Modifying the states
+   *
+   * These methods only discard the sequence-major copy, see
+   * getSequenceMatrix(). The non-const accessors also discard it, since
+   * states may be modified through the references they return.
+   * @{
+   */
+  using VectorSiteContainer::setSequence;
+  using VectorSiteContainer::site;
+  using VectorSiteContainer::valueAt;
+
+  void setSequence(const std::string& sequenceKey, std::unique_ptr<Sequence>& sequence) override
+  {
+    VectorSiteContainer::setSequence(sequenceKey, sequence);
+    invalidateSequenceMatrix();
+  }
+
+  void setSequence(size_t sequencePosition, std::unique_ptr<Sequence>& sequence) override
+  {
+    VectorSiteContainer::setSequence(sequencePosition, sequence);
+    invalidateSequenceMatrix();
+  }
+
+  void setSequence(size_t sequencePosition, std::unique_ptr<Sequence>& sequence, const std::string& sequenceKey) override
+  {
+    VectorSiteContainer::setSequence(sequencePosition, sequence, sequenceKey);
+    invalidateSequenceMatrix();
+  }
+
+  Site& site(size_t sitePosition) override
+  {
+    invalidateSequenceMatrix();
+    return VectorSiteContainer::site(sitePosition);
+  }
+
+  int& valueAt(const std::string& sequenceKey, size_t sitePosition) override
+  {
+    invalidateSequenceMatrix();
+    return VectorSiteContainer::valueAt(sequenceKey, sitePosition);
+  }
+
+  int& valueAt(size_t sequencePosition, size_t sitePosition) override
+  {
+    invalidateSequenceMatrix();
+    return VectorSiteContainer::valueAt(sequencePosition, sitePosition);
+  }
+
+  void setSite(size_t sitePosition, std::unique_ptr<Site>& site, bool checkCoordinate = true) override
+  {
+    VectorSiteContainer::setSite(sitePosition, site, checkCoordinate);
+    invalidateSequenceMatrix();
+  }
+
+  std::unique_ptr<Site> removeSite(size_t sitePosition) override
+  {
+    invalidateSequenceMatrix();
+    return VectorSiteContainer::removeSite(sitePosition);
+  }
+
+  void deleteSite(size_t sitePosition) override
+  {
+    VectorSiteContainer::deleteSite(sitePosition);
+    invalidateSequenceMatrix();
+  }
+
+  void deleteSites(size_t sitePosition, size_t length) override
+  {
+    VectorSiteContainer::deleteSites(sitePosition, length);
+    invalidateSequenceMatrix();
+  }
+
+  void addSite(std::unique_ptr<Site>& site, bool checkCoordinate = true) override
+  {
+    VectorSiteContainer::addSite(site, checkCoordinate);
+    invalidateSequenceMatrix();
+  }
+
+  void addSite(std::unique_ptr<Site>& site, int coordinate, bool checkCoordinate = true) override
+  {
+    VectorSiteContainer::addSite(site, coordinate, checkCoordinate);
+    invalidateSequenceMatrix();
+  }
+
+  void insertSite(size_t sitePosition, std::unique_ptr<Site>& site, bool checkCoordinate = true) override
+  {
+    VectorSiteContainer::insertSite(sitePosition, site, checkCoordinate);
+    invalidateSequenceMatrix();
+  }
+
+  void insertSite(size_t sitePosition, std::unique_ptr<Site>& site, int coordinate, bool checkCoordinate = true) override
+  {
+    VectorSiteContainer::insertSite(sitePosition, site, coordinate, checkCoordinate);
+    invalidateSequenceMatrix();
+  }
+  /** @} */
+
   /**
    * @brief Clear the container of all its sequences.
    */
   void clear() override
   {
     VectorSiteContainer::clear();
+    invalidateSequenceMatrix();
     count_.clear();
     ingroup_.clear();
     group_.clear();
@@ -413,6 +527,25 @@ public:
    * @return A SiteContainer object, eventually with duplicated sequences. Names of duplicated sequences are happened with _1, _2, etc.
    */
   std::unique_ptr<SiteContainerInterface> toSiteContainer() const;
+
+  /**
+   * @brief Get a sequence-major copy of all the sequences and sites.
+   *
+   * The copy is built on first use, and kept until the states are modified
+   * through one of the methods of this class. A reference to a site or a
+   * state obtained before such a call must not be used to modify it after:
+   * call invalidateSequenceMatrix() if it is. The returned matrix itself is
+   * never modified, and remains valid after invalidation.
+   */
+  std::shared_ptr<const SequenceMatrix> getSequenceMatrix() const;
+
+  /**
+   * @brief Discard the sequence-major copy, see getSequenceMatrix().
+   */
+  void invalidateSequenceMatrix() const
+  {
+    std::atomic_store(&sequenceMatrix_, std::shared_ptr<const SequenceMatrix>());
+  }
 };
 } // end of namespace bpp;
 
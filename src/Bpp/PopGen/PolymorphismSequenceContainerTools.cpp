@@ -3,6 +3,7 @@
 // SPDX-License-Identifier: CECILL-2.1
 
 #include "PolymorphismSequenceContainerTools.h"
+#include "GapProfile.h"
 
 #include <Bpp/Seq/CodonSiteTools.h>
 
@@ -42,93 +43,98 @@ unique_ptr<PolymorphismSequenceContainer> PolymorphismSequenceContainerTools::re
 
 unique_ptr<PolymorphismSequenceContainer> PolymorphismSequenceContainerTools::extractIngroup(
     const PolymorphismSequenceContainer& psc)
+{
+  return getIngroupView(psc).materialize();
+}
+
+/******************************************************************************/
+
+unique_ptr<PolymorphismSequenceContainer> PolymorphismSequenceContainerTools::extractOutgroup(
+    const PolymorphismSequenceContainer& psc)
+{
+  return getOutgroupView(psc).materialize();
+}
+
+/******************************************************************************/
+
+unique_ptr<PolymorphismSequenceContainer> PolymorphismSequenceContainerTools::extractGroup(
+    const PolymorphismSequenceContainer& psc,
+    size_t groupId)
+{
+  return getGroupView(psc, groupId).materialize();
+}
+
+/******************************************************************************/
+
+unique_ptr<PolymorphismSequenceContainer> PolymorphismSequenceContainerTools::getSelectedSequences(
+    const PolymorphismSequenceContainer& psc,
+    const SequenceSelection& ss)
+{
+  return getSelectedSequencesView(psc, ss).materialize();
+}
+
+/******************************************************************************/
+
+PolymorphismSequenceView PolymorphismSequenceContainerTools::getIngroupView(
+    const PolymorphismSequenceContainer& psc)
 {
   SequenceSelection ss;
-  auto psci = make_unique<PolymorphismSequenceContainer>(psc);
   for (size_t i = 0; i < psc.getNumberOfSequences(); ++i)
   {
-    if (!psc.isIngroupMember(i))
+    if (psc.isIngroupMember(i))
       ss.push_back(i);
   }
-  if (ss.size() == psc.getNumberOfSequences())
+  if (ss.size() == 0)
   {
-    throw Exception("PolymorphismSequenceContainerTools::extractIngroup: no Ingroup sequences found.");
+    throw Exception("PolymorphismSequenceContainerTools::getIngroupView: no Ingroup sequences found.");
   }
-  for (size_t i = ss.size(); i > 0; --i)
-  {
-    psci->deleteSequence(ss[i - 1]);
-  }
-  return psci;
+  return PolymorphismSequenceView(psc, ss);
 }
 
 /******************************************************************************/
 
-unique_ptr<PolymorphismSequenceContainer> PolymorphismSequenceContainerTools::extractOutgroup(
+PolymorphismSequenceView PolymorphismSequenceContainerTools::getOutgroupView(
     const PolymorphismSequenceContainer& psc)
 {
   SequenceSelection ss;
-  auto psci = make_unique<PolymorphismSequenceContainer>(psc);
   for (size_t i = 0; i < psc.getNumberOfSequences(); ++i)
   {
-    if (psc.isIngroupMember(i) )
+    if (!psc.isIngroupMember(i))
       ss.push_back(i);
   }
-  if (ss.size() == psc.getNumberOfSequences())
+  if (ss.size() == 0)
   {
-    throw Exception("PolymorphismSequenceContainerTools::extractOutgroup: no Outgroup sequences found.");
+    throw Exception("PolymorphismSequenceContainerTools::getOutgroupView: no Outgroup sequences found.");
   }
-  for (size_t i = ss.size(); i > 0; i--)
-  {
-    psci->deleteSequence(ss[i - 1]);
-  }
-  return psci;
+  return PolymorphismSequenceView(psc, ss);
 }
 
 /******************************************************************************/
 
-unique_ptr<PolymorphismSequenceContainer> PolymorphismSequenceContainerTools::extractGroup(
+PolymorphismSequenceView PolymorphismSequenceContainerTools::getGroupView(
     const PolymorphismSequenceContainer& psc,
     size_t groupId)
 {
   SequenceSelection ss;
-  auto psci = make_unique<PolymorphismSequenceContainer>(psc);
   for (size_t i = 0; i < psc.getNumberOfSequences(); ++i)
   {
-    if (psc.getGroupId(i) != groupId)
+    if (psc.getGroupId(i) == groupId)
       ss.push_back(i);
   }
-  if (ss.size() == psc.getNumberOfSequences())
+  if (ss.size() == 0)
   {
-    throw GroupNotFoundException("PolymorphismSequenceContainerTools::extractGroup: group_id not found.", groupId);
+    throw GroupNotFoundException("PolymorphismSequenceContainerTools::getGroupView: group_id not found.", groupId);
   }
-  for (size_t i = ss.size(); i > 0; i--)
-  {
-    psci->deleteSequence(ss[i - 1]);
-  }
-  return psci;
+  return PolymorphismSequenceView(psc, ss);
 }
 
 /******************************************************************************/
 
-unique_ptr<PolymorphismSequenceContainer> PolymorphismSequenceContainerTools::getSelectedSequences(
+PolymorphismSequenceView PolymorphismSequenceContainerTools::getSelectedSequencesView(
     const PolymorphismSequenceContainer& psc,
     const SequenceSelection& ss)
 {
-  auto newpsc = make_unique<PolymorphismSequenceContainer>(psc.getAlphabet());
-  for (size_t i = 0; i < ss.size(); ++i)
-  {
-    auto tmpSeq = make_unique<Sequence>(psc.sequence(ss[i]));
-    newpsc->addSequenceWithFrequency(tmpSeq->getName(), tmpSeq, psc.getSequenceCount(i));
-    if (psc.isIngroupMember(i))
-      newpsc->setAsIngroupMember(i);
-    else
-    {
-      newpsc->setAsOutgroupMember(i);
-      newpsc->setGroupId(i, psc.getGroupId(i));
-    }
-  }
-  newpsc->setComments(psc.getComments());
-  return newpsc;
+  return PolymorphismSequenceView(psc, ss);
 }
 
 /******************************************************************************/
@@ -155,28 +161,7 @@ unique_ptr<PolymorphismSequenceContainer> PolymorphismSequenceContainerTools::sa
 unique_ptr<PolymorphismSequenceContainer> PolymorphismSequenceContainerTools::getSitesWithoutGaps(
     const PolymorphismSequenceContainer& psc)
 {
-  auto seqNames = psc.getSequenceNames();
-  auto noGapCont = make_unique<PolymorphismSequenceContainer>(psc.getNumberOfSequences(), psc.getAlphabet());
-  noGapCont->setSequenceNames(seqNames, false);
-  size_t nbSeq = psc.getNumberOfSequences();
-  for (size_t i = 0; i < nbSeq; ++i)
-  {
-    noGapCont->setSequenceCount(i, psc.getSequenceCount(i));
-    if (psc.isIngroupMember(i))
-      noGapCont->setAsIngroupMember(i);
-    else
-    {
-      noGapCont->setAsOutgroupMember(i);
-      noGapCont->setGroupId(i, psc.getGroupId(i));
-    }
-  }
-  NoGapSiteContainerIterator ngsi(psc);
-  while (ngsi.hasMoreSites())
-  {
-    auto tmpSite = make_unique<Site>(ngsi.nextSite());
-    noGapCont->addSite(tmpSite);
-  }
-  return noGapCont;
+  return materializeSites_(getSitesWithoutGapsView(PolymorphismSequenceView(psc)));
 }
 
 /******************************************************************************/
@@ -185,20 +170,8 @@ size_t PolymorphismSequenceContainerTools::getNumberOfNonGapSites(
     const PolymorphismSequenceContainer& psc,
     bool ingroup)
 {
-  size_t count = psc.getNumberOfSites();
-  unique_ptr<PolymorphismSequenceContainer> npsc = nullptr;
-  unique_ptr<SimpleSiteContainerIterator> ssi = nullptr;
-  if (ingroup)
-  {
-    npsc = extractIngroup(psc);
-    ssi.reset(new SimpleSiteContainerIterator(*npsc));
-  }
-  else
-    ssi.reset(new SimpleTemplateSiteContainerIterator<Site, Sequence, string>(psc));
-  while (ssi->hasMoreSites())
-    if (SiteTools::hasGap(ssi->nextSite()))
-      count--;
-  return count;
+  PolymorphismSequenceView view = ingroup ? getIngroupView(psc) : PolymorphismSequenceView(psc);
+  return GapProfile(view).getNumberOfGapFreeSites();
 }
 
 /******************************************************************************/
@@ -207,20 +180,8 @@ size_t PolymorphismSequenceContainerTools::getNumberOfCompleteSites(
     const PolymorphismSequenceContainer& psc,
     bool ingroup)
 {
-  size_t count = psc.getNumberOfSites();
-  unique_ptr<PolymorphismSequenceContainer> npsc = nullptr;
-  unique_ptr<SimpleSiteContainerIterator> ssi = nullptr;
-  if (ingroup)
-  {
-    npsc = extractIngroup(psc);
-    ssi.reset(new SimpleSiteContainerIterator(*npsc));
-  }
-  else
-    ssi.reset(new SimpleSiteContainerIterator(psc));
-  while (ssi->hasMoreSites())
-    if (!SiteTools::isComplete(ssi->nextSite()))
-      count--;
-  return count;
+  PolymorphismSequenceView view = ingroup ? getIngroupView(psc) : PolymorphismSequenceView(psc);
+  return GapProfile(view).getNumberOfCompleteSites();
 }
 
 /******************************************************************************/
@@ -228,28 +189,7 @@ size_t PolymorphismSequenceContainerTools::getNumberOfCompleteSites(
 unique_ptr<PolymorphismSequenceContainer> PolymorphismSequenceContainerTools::getCompleteSites(
     const PolymorphismSequenceContainer& psc)
 {
-  auto seqNames = psc.getSequenceNames();
-  auto complete = make_unique<PolymorphismSequenceContainer>(psc.getNumberOfSequences(), psc.getAlphabet());
-  complete->setSequenceNames(seqNames, false);
-  size_t nbSeq = psc.getNumberOfSequences();
-  for (size_t i = 0; i < nbSeq; ++i)
-  {
-    complete->setSequenceCount(i, psc.getSequenceCount(i));
-    if (psc.isIngroupMember(i))
-      complete->setAsIngroupMember(i);
-    else
-    {
-      complete->setAsOutgroupMember(i);
-      complete->setGroupId(i, psc.getGroupId(i));
-    }
-  }
-  CompleteSiteContainerIterator csi(psc);
-  while (csi.hasMoreSites())
-  {
-    auto tmpSite = make_unique<Site>(csi.nextSite());
-    complete->addSite(tmpSite);
-  }
-  return complete;
+  return materializeSites_(getCompleteSitesView(PolymorphismSequenceView(psc)));
 }
 
 /******************************************************************************/
@@ -257,17 +197,15 @@ unique_ptr<PolymorphismSequenceContainer> PolymorphismSequenceContainerTools::ge
 unique_ptr<PolymorphismSequenceContainer> PolymorphismSequenceContainerTools::excludeFlankingGap(
     const PolymorphismSequenceContainer& psc)
 {
-  auto psci = make_unique<PolymorphismSequenceContainer>(psc);
-  while (SiteTools::hasGap(psci->site(0)))
-    psci->deleteSite(0);
-  size_t i = 0;
-  size_t n = psci->getNumberOfSites();
-  while (SiteTools::hasGap(psci->site(n - i - 1)))
+  PolymorphismSequenceView view(psc);
+  GapProfile profile(view);
+  vector<size_t> ss;
+  ss.reserve(profile.getFlankingGapEnd() - profile.getFlankingGapBegin());
+  for (size_t i = profile.getFlankingGapBegin(); i < profile.getFlankingGapEnd(); ++i)
   {
-    psci->deleteSite(n - i - 1);
-    i++;
+    ss.push_back(i);
   }
-  return psci;
+  return view.selectSites(ss).materialize();
 }
 
 /******************************************************************************/
@@ -277,28 +215,7 @@ unique_ptr<PolymorphismSequenceContainer> PolymorphismSequenceContainerTools::ge
     const string& setName,
     bool phase)
 {
-  auto pscc = MaseTools::getSelectedSites(psc, setName);
-  auto maseFileHeader = psc.getComments();
-  if (phase)
-  {
-    for (size_t i = 1; i < MaseTools::getPhase(maseFileHeader, setName); ++i)
-    {
-      pscc->deleteSite(0);
-    }
-  }
-  auto psci = make_unique<PolymorphismSequenceContainer>(*pscc);
-  for (size_t i = 0; i < psc.getNumberOfSequences(); ++i)
-  {
-    if (psc.isIngroupMember(i))
-      psci->setAsIngroupMember(i);
-    else
-    {
-      psci->setAsOutgroupMember(i);
-      psci->setGroupId(i, psc.getGroupId(i));
-    }
-  }
-  psci->clearComments();
-  return psci;
+  return materializeSites_(getSelectedSitesView(PolymorphismSequenceView(psc), setName, phase));
 }
 
 /******************************************************************************/
@@ -307,37 +224,145 @@ unique_ptr<PolymorphismSequenceContainer> PolymorphismSequenceContainerTools::ge
     const PolymorphismSequenceContainer& psc,
     const string& setName)
 {
-  SiteSelection ss;
+  return materializeSites_(getNonCodingSitesView(PolymorphismSequenceView(psc), setName));
+}
+
+/******************************************************************************/
+
+unique_ptr<PolymorphismSequenceContainer> PolymorphismSequenceContainerTools::getOnePosition(
+    const PolymorphismSequenceContainer& psc,
+    const string& setName,
+    size_t pos)
+{
+  return materializeSites_(getOnePositionView(PolymorphismSequenceView(psc), setName, pos));
+}
+
+/******************************************************************************/
+
+unique_ptr<PolymorphismSequenceContainer> PolymorphismSequenceContainerTools::getIntrons(
+    const PolymorphismSequenceContainer& psc,
+    const string& setName,
+    const GeneticCode& gCode)
+{
+  return materializeSites_(getIntronsView(PolymorphismSequenceView(psc), setName, gCode));
+}
+
+/******************************************************************************/
+
+unique_ptr<PolymorphismSequenceContainer> PolymorphismSequenceContainerTools::get5Prime(
+    const PolymorphismSequenceContainer& psc,
+    const string& setName)
+{
+  return materializeSites_(get5PrimeView(PolymorphismSequenceView(psc), setName));
+}
+
+/******************************************************************************/
+
+unique_ptr<PolymorphismSequenceContainer> PolymorphismSequenceContainerTools::get3Prime(
+    const PolymorphismSequenceContainer& psc,
+    const string& setName,
+    const GeneticCode& gCode)
+{
+  return materializeSites_(get3PrimeView(PolymorphismSequenceView(psc), setName, gCode));
+}
+
+/******************************************************************************/
+
+string PolymorphismSequenceContainerTools::getIngroupSpeciesName(const PolymorphismSequenceContainer& psc)
+{
+  string key;
+  string speciesName;
   auto maseFileHeader = psc.getComments();
-  auto codss = MaseTools::getSiteSet(maseFileHeader, setName);
-  for (size_t i = 0; i < psc.getNumberOfSites(); ++i)
-  {
-    if (find(codss.begin(), codss.end(), i) == codss.end())
-      ss.push_back(i);
-  }
-  auto sc = SiteContainerTools::getSelectedSites(psc, ss);
-  auto psci = make_unique<PolymorphismSequenceContainer>(*sc);
-  for (size_t i = 0; i < psc.getNumberOfSequences(); ++i)
+  if (!maseFileHeader.size())
+    return speciesName;
+  auto groupMap = MaseTools::getAvailableSequenceSelections(maseFileHeader);
+  for (auto& mi : groupMap)
   {
-    if (psc.isIngroupMember(i))
-      psci->setAsIngroupMember(i);
-    else
+    key = mi.first;
+    if (key.compare(0, 7, "INGROUP") == 0)
     {
-      psci->setAsOutgroupMember(i);
-      psci->setGroupId(i, psc.getGroupId(i));
+      StringTokenizer sptk(key, "_");
+      speciesName = sptk.getToken(1) + " " + sptk.getToken(2);
     }
   }
-  return psci;
+  return speciesName;
 }
 
 /******************************************************************************/
 
-unique_ptr<PolymorphismSequenceContainer> PolymorphismSequenceContainerTools::getOnePosition(
+unique_ptr<PolymorphismSequenceContainer> PolymorphismSequenceContainerTools::getSynonymousSites(
     const PolymorphismSequenceContainer& psc,
+    const GeneticCode& gCode)
+{
+  return materializeSites_(getSynonymousSitesView(PolymorphismSequenceView(psc), gCode));
+}
+
+/******************************************************************************/
+
+unique_ptr<PolymorphismSequenceContainer> PolymorphismSequenceContainerTools::getNonSynonymousSites(
+    const PolymorphismSequenceContainer& psc,
+    const GeneticCode& gCode)
+{
+  return materializeSites_(getNonSynonymousSitesView(PolymorphismSequenceView(psc), gCode));
+}
+
+/******************************************************************************/
+
+PolymorphismSequenceView PolymorphismSequenceContainerTools::getSitesWithoutGapsView(
+    const PolymorphismSequenceView& view)
+{
+  return view.selectSites(GapProfile(view).getGapFreeSites());
+}
+
+/******************************************************************************/
+
+PolymorphismSequenceView PolymorphismSequenceContainerTools::getCompleteSitesView(
+    const PolymorphismSequenceView& view)
+{
+  return view.selectSites(GapProfile(view).getCompleteSites());
+}
+
+/******************************************************************************/
+
+PolymorphismSequenceView PolymorphismSequenceContainerTools::getSelectedSitesView(
+    const PolymorphismSequenceView& view,
+    const string& setName,
+    bool phase)
+{
+  auto maseFileHeader = view.getContainer().getComments();
+  auto codss = MaseTools::getSiteSet(maseFileHeader, setName);
+  if (phase)
+  {
+    // Remove the sites before the first complete codon
+    size_t skip = MaseTools::getPhase(maseFileHeader, setName) - 1;
+    codss.erase(codss.begin(), codss.begin() + static_cast<ptrdiff_t>(min(skip, codss.size())));
+  }
+  vector<bool> mask(view.getContainer().getNumberOfSites(), false);
+  setMask_(mask, codss, true, "PolymorphismSequenceContainerTools::getSelectedSitesView");
+  return selectSites_(view, mask);
+}
+
+/******************************************************************************/
+
+PolymorphismSequenceView PolymorphismSequenceContainerTools::getNonCodingSitesView(
+    const PolymorphismSequenceView& view,
+    const string& setName)
+{
+  auto maseFileHeader = view.getContainer().getComments();
+  auto codss = MaseTools::getSiteSet(maseFileHeader, setName);
+  vector<bool> mask(view.getContainer().getNumberOfSites(), true);
+  setMask_(mask, codss, false, "PolymorphismSequenceContainerTools::getNonCodingSitesView");
+  return selectSites_(view, mask);
+}
+
+/******************************************************************************/
+
+PolymorphismSequenceView PolymorphismSequenceContainerTools::getOnePositionView(
+    const PolymorphismSequenceView& view,
     const string& setName,
     size_t pos)
 {
-  auto maseFileHeader = psc.getComments();
+  auto maseFileHeader = view.getContainer().getComments();
   size_t start;
   try
   {
@@ -347,41 +372,29 @@ unique_ptr<PolymorphismSequenceContainer> PolymorphismSequenceContainerTools::ge
   {
     start = 1;
   }
-  SiteSelection ss;
   size_t i;
   if (static_cast<int>(pos) - static_cast<int>(start) >= 0)
     i = pos - start;
   else
     i = pos - start + 3;
-  while (i < psc.getNumberOfSites())
+  vector<bool> mask(view.getContainer().getNumberOfSites(), false);
+  while (i < mask.size())
   {
-    ss.push_back(i);
+    mask[i] = true;
     i += 3;
   }
-  auto sc = SiteContainerTools::getSelectedSites(psc, ss);
-  auto newpsc = make_unique<PolymorphismSequenceContainer>(*sc);
-  for (size_t j = 0; j < psc.getNumberOfSequences(); ++j)
-  {
-    if (psc.isIngroupMember(j))
-      newpsc->setAsIngroupMember(j);
-    else
-    {
-      newpsc->setAsOutgroupMember(j);
-      newpsc->setGroupId(i, psc.getGroupId(j));
-    }
-  }
-  return newpsc;
+  return selectSites_(view, mask);
 }
 
 /******************************************************************************/
 
-unique_ptr<PolymorphismSequenceContainer> PolymorphismSequenceContainerTools::getIntrons(
-    const PolymorphismSequenceContainer& psc,
+PolymorphismSequenceView PolymorphismSequenceContainerTools::getIntronsView(
+    const PolymorphismSequenceView& view,
     const string& setName,
     const GeneticCode& gCode)
 {
+  const PolymorphismSequenceContainer& psc = view.getContainer();
   auto maseFileHeader = psc.getComments();
-  SiteSelection ss;
   auto codss = MaseTools::getSiteSet(maseFileHeader, setName);
   size_t start = MaseTools::getPhase(maseFileHeader, setName);
   size_t first = 0, last = psc.getNumberOfSites();
@@ -398,36 +411,23 @@ unique_ptr<PolymorphismSequenceContainer> PolymorphismSequenceContainerTools::ge
   if (gCode.isStop(gCode.codonAlphabet().getCodon(c1, c2, c3)))
     last = codss[codss.size() - 1];
   // Keep sites between AUG and STOP
-  for (size_t i = first; i < last; i++)
+  vector<bool> mask(psc.getNumberOfSites(), false);
+  for (size_t i = first; i < last; ++i)
   {
-    if (find(codss.begin(), codss.end(), i) == codss.end())
-    {
-      ss.push_back(i);
-    }
+    mask[i] = true;
   }
-  auto sc = SiteContainerTools::getSelectedSites(psc, ss);
-  auto psci = make_unique<PolymorphismSequenceContainer>(*sc);
-  for (size_t i = 0; i < psc.getNumberOfSequences(); ++i)
-  {
-    if (psc.isIngroupMember(i))
-      psci->setAsIngroupMember(i);
-    else
-    {
-      psci->setAsOutgroupMember(i);
-      psci->setGroupId(i, psc.getGroupId(i));
-    }
-  }
-  return psci;
+  setMask_(mask, codss, false, "PolymorphismSequenceContainerTools::getIntronsView");
+  return selectSites_(view, mask);
 }
 
 /******************************************************************************/
 
-unique_ptr<PolymorphismSequenceContainer> PolymorphismSequenceContainerTools::get5Prime(
-    const PolymorphismSequenceContainer& psc,
+PolymorphismSequenceView PolymorphismSequenceContainerTools::get5PrimeView(
+    const PolymorphismSequenceView& view,
     const string& setName)
 {
+  const PolymorphismSequenceContainer& psc = view.getContainer();
   auto maseFileHeader = psc.getComments();
-  SiteSelection ss;
   auto codss = MaseTools::getSiteSet(maseFileHeader, setName);
   size_t start = MaseTools::getPhase(maseFileHeader, setName);
   size_t last = 0;
@@ -437,37 +437,24 @@ unique_ptr<PolymorphismSequenceContainer> PolymorphismSequenceContainerTools::ge
       psc.site(codss[1]).getValue(0) == 3 &&
       psc.site(codss[2]).getValue(0) == 2)
     last = codss[0];
+  vector<bool> mask(psc.getNumberOfSites(), false);
   for (size_t i = 0; i < last; ++i)
   {
-    if (find(codss.begin(), codss.end(), i) == codss.end())
-    {
-      ss.push_back(i);
-    }
-  }
-  auto sc = SiteContainerTools::getSelectedSites(psc, ss);
-  auto psci = make_unique<PolymorphismSequenceContainer>(*sc);
-  for (size_t i = 0; i < psc.getNumberOfSequences(); ++i)
-  {
-    if (psc.isIngroupMember(i))
-      psci->setAsIngroupMember(i);
-    else
-    {
-      psci->setAsOutgroupMember(i);
-      psci->setGroupId(i, psc.getGroupId(i));
-    }
+    mask[i] = true;
   }
-  return psci;
+  setMask_(mask, codss, false, "PolymorphismSequenceContainerTools::get5PrimeView");
+  return selectSites_(view, mask);
 }
 
 /******************************************************************************/
 
-unique_ptr<PolymorphismSequenceContainer> PolymorphismSequenceContainerTools::get3Prime(
-    const PolymorphismSequenceContainer& psc,
+PolymorphismSequenceView PolymorphismSequenceContainerTools::get3PrimeView(
+    const PolymorphismSequenceView& view,
     const string& setName,
     const GeneticCode& gCode)
 {
+  const PolymorphismSequenceContainer& psc = view.getContainer();
   auto maseFileHeader = psc.getComments();
-  SiteSelection ss;
   auto codss = MaseTools::getSiteSet(maseFileHeader, setName);
   size_t first = psc.getNumberOfSites() - 1;
   // Check if the last codon is a STOP one
@@ -476,108 +463,82 @@ unique_ptr<PolymorphismSequenceContainer> PolymorphismSequenceContainerTools::ge
   int c3 = psc.site(codss[codss.size() - 1]).getValue(0);
   if (gCode.isStop(gCode.codonAlphabet().getCodon(c1, c2, c3)))
     first = codss[codss.size() - 1];
+  vector<bool> mask(psc.getNumberOfSites(), false);
   for (size_t i = first; i < psc.getNumberOfSites(); ++i)
   {
-    if (find(codss.begin(), codss.end(), i) == codss.end())
-    {
-      ss.push_back(i);
-    }
-  }
-  auto sc = SiteContainerTools::getSelectedSites(psc, ss);
-  auto psci = make_unique<PolymorphismSequenceContainer>(*sc);
-  for (size_t i = 0; i < psc.getNumberOfSequences(); ++i)
-  {
-    if (psc.isIngroupMember(i))
-      psci->setAsIngroupMember(i);
-    else
-    {
-      psci->setAsOutgroupMember(i);
-      psci->setGroupId(i, psc.getGroupId(i));
-    }
+    mask[i] = true;
   }
-  return psci;
+  setMask_(mask, codss, false, "PolymorphismSequenceContainerTools::get3PrimeView");
+  return selectSites_(view, mask);
 }
 
 /******************************************************************************/
 
-string PolymorphismSequenceContainerTools::getIngroupSpeciesName(const PolymorphismSequenceContainer& psc)
+PolymorphismSequenceView PolymorphismSequenceContainerTools::getSynonymousSitesView(
+    const PolymorphismSequenceView& view,
+    const GeneticCode& gCode)
 {
-  string key;
-  string speciesName;
-  auto maseFileHeader = psc.getComments();
-  if (!maseFileHeader.size())
-    return speciesName;
-  auto groupMap = MaseTools::getAvailableSequenceSelections(maseFileHeader);
-  for (auto& mi : groupMap)
+  vector<size_t> ss;
+  for (size_t i = 0; i < view.getNumberOfSites(); ++i)
   {
-    key = mi.first;
-    if (key.compare(0, 7, "INGROUP") == 0)
-    {
-      StringTokenizer sptk(key, "_");
-      speciesName = sptk.getToken(1) + " " + sptk.getToken(2);
-    }
+    if (CodonSiteTools::isSynonymousPolymorphic(*view.getSite(i), gCode))
+      ss.push_back(i);
   }
-  return speciesName;
+  return view.selectSites(ss);
 }
 
 /******************************************************************************/
 
-unique_ptr<PolymorphismSequenceContainer> PolymorphismSequenceContainerTools::getSynonymousSites(
-    const PolymorphismSequenceContainer& psc,
+PolymorphismSequenceView PolymorphismSequenceContainerTools::getNonSynonymousSitesView(
+    const PolymorphismSequenceView& view,
     const GeneticCode& gCode)
 {
-  auto psco = make_unique<PolymorphismSequenceContainer>(psc.getSequenceNames(), psc.getAlphabet());
-  for (size_t i = 0; i < psc.getNumberOfSites(); ++i)
-  {
-    const Site& site = psc.site(i);
-    if (CodonSiteTools::isSynonymousPolymorphic(site, gCode))
-    {
-      auto tmpSite = make_unique<Site>(site);
-      psco->addSite(tmpSite);
-    }
-  }
-  for (size_t i = 0; i < psc.getNumberOfSequences(); ++i)
+  vector<size_t> ss;
+  for (size_t i = 0; i < view.getNumberOfSites(); ++i)
   {
-    psco->setSequenceCount(i, psc.getSequenceCount(i));
-    if (psc.isIngroupMember(i))
-      psco->setAsIngroupMember(i);
-    else
-    {
-      psco->setAsOutgroupMember(i);
-      psco->setGroupId(i, psc.getGroupId(i));
-    }
+    if (!CodonSiteTools::isSynonymousPolymorphic(*view.getSite(i), gCode))
+      ss.push_back(i);
   }
-  return psco;
+  return view.selectSites(ss);
 }
 
 /******************************************************************************/
 
-unique_ptr<PolymorphismSequenceContainer> PolymorphismSequenceContainerTools::getNonSynonymousSites(
-    const PolymorphismSequenceContainer& psc,
-    const GeneticCode& gCode)
+PolymorphismSequenceView PolymorphismSequenceContainerTools::selectSites_(
+    const PolymorphismSequenceView& view,
+    const vector<bool>& mask)
 {
-  auto psco = make_unique<PolymorphismSequenceContainer>(psc.getSequenceNames(), psc.getAlphabet());
-  for (size_t i = 0; i < psc.getNumberOfSites(); ++i)
+  vector<size_t> ss;
+  for (size_t i = 0; i < view.getNumberOfSites(); ++i)
   {
-    const Site& site = psc.site(i);
-    if (!CodonSiteTools::isSynonymousPolymorphic(site, gCode))
-    {
-      auto tmpSite = make_unique<Site>(site);
-      psco->addSite(tmpSite);
-    }
+    if (mask[view.getSitePosition(i)])
+      ss.push_back(i);
   }
-  for (size_t i = 0; i < psc.getNumberOfSequences(); ++i)
+  return view.selectSites(ss);
+}
+
+/******************************************************************************/
+
+void PolymorphismSequenceContainerTools::setMask_(
+    vector<bool>& mask,
+    const vector<size_t>& sites,
+    bool value,
+    const string& method)
+{
+  for (auto i : sites)
   {
-    psco->setSequenceCount(i, psc.getSequenceCount(i));
-    if (psc.isIngroupMember(i))
-      psco->setAsIngroupMember(i);
-    else
-    {
-      psco->setAsOutgroupMember(i);
-      psco->setGroupId(i, psc.getGroupId(i));
-    }
+    if (i >= mask.size())
+      throw IndexOutOfBoundsException(method + ": site position out of bounds.", i, 0, mask.size());
+    mask[i] = value;
   }
-  return psco;
 }
 
 /******************************************************************************/
+
+unique_ptr<PolymorphismSequenceContainer> PolymorphismSequenceContainerTools::materializeSites_(
+    const PolymorphismSequenceView& view)
+{
+  auto psci = view.materialize();
+  psci->clearComments();
+  return psci;
+}
@@ -18,10 +18,15 @@
 #include <Bpp/Seq/SiteTools.h>
 
 // from STL
+#include <algorithm>
+#include <random>
 #include <string>
+#include <vector>
 
 // From Local
+#include "CounterBasedGenerator.h"
 #include "PolymorphismSequenceContainer.h"
+#include "PolymorphismSequenceView.h"
 #include "GeneralExceptions.h"
 
 namespace bpp
@@ -99,6 +104,50 @@ public:
       const PolymorphismSequenceContainer& psc,
       const SequenceSelection& ss);
 
+  /**
+   * @brief Get a view on the ingroup sequences of a PolymorphismSequenceContainer.
+   *
+   * @param psc a PolymorphismSequenceContainer reference
+   *
+   * @throw Exception if there is no ingroup sequence
+   */
+  static PolymorphismSequenceView getIngroupView(
+      const PolymorphismSequenceContainer& psc);
+
+  /**
+   * @brief Get a view on the outgroup sequences of a PolymorphismSequenceContainer.
+   *
+   * @param psc a PolymorphismSequenceContainer reference
+   *
+   * @throw Exception if there is no outgroup sequence
+   */
+  static PolymorphismSequenceView getOutgroupView(
+      const PolymorphismSequenceContainer& psc);
+
+  /**
+   * @brief Get a view on the sequences of a group of a PolymorphismSequenceContainer.
+   *
+   * @param psc a PolymorphismSequenceContainer reference.
+   * @param groupId the group identifier as an size_t.
+   *
+   * @throw GroupNotFoundException if group_id is not found.
+   */
+  static PolymorphismSequenceView getGroupView(
+      const PolymorphismSequenceContainer& psc,
+      size_t groupId);
+
+  /**
+   * @brief Get a view on selected sequences.
+   *
+   * @param psc a PolymorphismSequenceContainer reference.
+   * @param ss a sequence selection.
+   *
+   * @throw IndexOutOfBoundsException if a selected position is not valid.
+   */
+  static PolymorphismSequenceView getSelectedSequencesView(
+      const PolymorphismSequenceContainer& psc,
+      const SequenceSelection& ss);
+
   /**
    * @brief Get a random set of sequences
    *
@@ -111,6 +160,67 @@ public:
       size_t n,
       bool replace = true);
 
+  /**
+   * @brief Get a view on a random set of sequences.
+   *
+   * @param psc a PolymorphismSequenceContainer reference
+   * @param n the number of sequence to get
+   * @param replace a boolean flag true for sampling with replacement
+   * @param generator the random number generator to use. With a
+   * CounterBasedGenerator, the sample only depends on its stream, on every
+   * platform. Other generators go through std::uniform_int_distribution
+   * and std::shuffle, whose results depend on the standard library.
+   * @throw IndexOutOfBoundsException if n is greater than the number of
+   * sequences when sampling without replacement.
+   */
+  template<class URBG>
+  static PolymorphismSequenceView getSampleView(
+      const PolymorphismSequenceContainer& psc,
+      size_t n,
+      bool replace,
+      URBG& generator)
+  {
+    size_t nbSeq = psc.getNumberOfSequences();
+    SequenceSelection ss(n);
+    if (replace)
+    {
+      if (n > 0 && nbSeq == 0)
+        throw IndexOutOfBoundsException("PolymorphismSequenceContainerTools::getSampleView: no sequence to sample from.", n, 0, nbSeq);
+      for (size_t i = 0; i < n; ++i)
+      {
+        ss[i] = drawInteger_(nbSeq, generator);
+      }
+    }
+    else
+    {
+      if (n > nbSeq)
+        throw IndexOutOfBoundsException("PolymorphismSequenceContainerTools::getSampleView: sample size is greater than the number of sequences.", n, 0, nbSeq);
+      SequenceSelection all(nbSeq);
+      for (size_t i = 0; i < nbSeq; ++i)
+      {
+        all[i] = i;
+      }
+      shuffle_(all, generator);
+      std::copy(all.begin(), all.begin() + static_cast<std::ptrdiff_t>(n), ss.begin());
+    }
+    return PolymorphismSequenceView(psc, ss);
+  }
+
+  /**
+   * @brief Get a random set of sequences, drawn with a given random number generator.
+   *
+   * @see getSampleView
+   */
+  template<class URBG>
+  static std::unique_ptr<PolymorphismSequenceContainer> sample(
+      const PolymorphismSequenceContainer& psc,
+      size_t n,
+      bool replace,
+      URBG& generator)
+  {
+    return getSampleView(psc, n, replace, generator).materialize();
+  }
+
   /**
    * @brief Retrieves sites without gaps from PolymorphismSequenceContainer.
    *
@@ -157,6 +267,9 @@ public:
   /**
    * @brief exclude flanking sites with gap but keep gap sites within the alignment
    *
+   * The bounds are found with a GapProfile, and the remaining sites are
+   * copied at once. The container is empty if all sites have gaps.
+   *
    * @param psc a PolymorphismSequenceContainer reference
    */
   static std::unique_ptr<PolymorphismSequenceContainer> excludeFlankingGap(
@@ -270,6 +383,158 @@ public:
   static std::unique_ptr<PolymorphismSequenceContainer> getNonSynonymousSites(
       const PolymorphismSequenceContainer& psc,
       const GeneticCode& gCode);
+
+  /**
+   * @name Site selection views
+   *
+   * These methods select sites like their counterparts above, but return a
+   * PolymorphismSequenceView restricted to the selected sites instead of a
+   * new container. They take a view as input, so that filters can be chained
+   * without copying any data; use PolymorphismSequenceView(psc) to start from
+   * a whole container, and PolymorphismSequenceView::materialize() to get a
+   * new container.
+   *
+   * Site sets annotated in the mase comments always refer to site positions
+   * in the parent container, and the annotation checks (start and stop
+   * codons) are performed on the first sequence of the parent container.
+   *
+   * @{
+   */
+
+  /**
+   * @brief Get a view on the sites without gaps in the sequences of a view.
+   */
+  static PolymorphismSequenceView getSitesWithoutGapsView(
+      const PolymorphismSequenceView& view);
+
+  /**
+   * @brief Get a view on the complete sites of a view.
+   */
+  static PolymorphismSequenceView getCompleteSitesView(
+      const PolymorphismSequenceView& view);
+
+  /**
+   * @brief Get a view on the sites of a selection annotated in the mase comments.
+   *
+   * @param view a PolymorphismSequenceView.
+   * @param setName The name of the set to retrieve.
+   * @param phase a boolean set to true if you want to take the phase into account during the extraction. It removes the useless sites.
+   */
+  static PolymorphismSequenceView getSelectedSitesView(
+      const PolymorphismSequenceView& view,
+      const std::string& setName,
+      bool phase);
+
+  /**
+   * @brief Get a view on the non-coding sites defined in the mase file header.
+   */
+  static PolymorphismSequenceView getNonCodingSitesView(
+      const PolymorphismSequenceView& view,
+      const std::string& setName);
+
+  /**
+   * @brief Get a view on the sites at one codon position (1,2,3).
+   *
+   * If there is no phase information, the phase is set to 1.
+   */
+  static PolymorphismSequenceView getOnePositionView(
+      const PolymorphismSequenceView& view,
+      const std::string& setName,
+      size_t pos);
+
+  /**
+   * @brief Get a view on the intron sites.
+   */
+  static PolymorphismSequenceView getIntronsView(
+      const PolymorphismSequenceView& view,
+      const std::string& setName,
+      const GeneticCode& gCode);
+
+  /**
+   * @brief Get a view on the 5' sites.
+   */
+  static PolymorphismSequenceView get5PrimeView(
+      const PolymorphismSequenceView& view,
+      const std::string& setName);
+
+  /**
+   * @brief Get a view on the 3' sites.
+   */
+  static PolymorphismSequenceView get3PrimeView(
+      const PolymorphismSequenceView& view,
+      const std::string& setName,
+      const GeneticCode& gCode);
+
+  /**
+   * @brief Get a view on the synonymous codon sites, as seen from the sequences of the view.
+   */
+  static PolymorphismSequenceView getSynonymousSitesView(
+      const PolymorphismSequenceView& view,
+      const GeneticCode& gCode);
+
+  /**
+   * @brief Get a view on the non-synonymous codon sites, as seen from the sequences of the view.
+   */
+  static PolymorphismSequenceView getNonSynonymousSitesView(
+      const PolymorphismSequenceView& view,
+      const GeneticCode& gCode);
+
+  /** @} */
+
+private:
+  /**
+   * @brief Draw an integer uniformly in [0, n), with any generator.
+   */
+  template<class URBG>
+  static size_t drawInteger_(size_t n, URBG& generator)
+  {
+    return std::uniform_int_distribution<size_t>(0, n - 1)(generator);
+  }
+
+  static size_t drawInteger_(size_t n, CounterBasedGenerator& generator)
+  {
+    return static_cast<size_t>(generator.drawInteger(n));
+  }
+
+  /**
+   * @brief Shuffle a selection, with any generator.
+   */
+  template<class URBG>
+  static void shuffle_(SequenceSelection& selection, URBG& generator)
+  {
+    std::shuffle(selection.begin(), selection.end(), generator);
+  }
+
+  static void shuffle_(SequenceSelection& selection, CounterBasedGenerator& generator)
+  {
+    generator.shuffle(selection.begin(), selection.end());
+  }
+
+  /**
+   * @brief Restrict a view to the sites whose positions in the parent
+   * container are flagged in a mask.
+   */
+  static PolymorphismSequenceView selectSites_(
+      const PolymorphismSequenceView& view,
+      const std::vector<bool>& mask);
+
+  /**
+   * @brief Set the flags of a mask at the positions of a site set.
+   *
+   * @throw IndexOutOfBoundsException if a position is out of the mask.
+   */
+  static void setMask_(
+      std::vector<bool>& mask,
+      const std::vector<size_t>& sites,
+      bool value,
+      const std::string& method);
+
+  /**
+   * @brief Materialize a site selection, without the mase comments which
+   * are not valid anymore.
+   */
+  static std::unique_ptr<PolymorphismSequenceContainer> materializeSites_(
+      const PolymorphismSequenceView& view);
 };
 } // end of namespace bpp;
 
@@ -0,0 +1,202 @@
+// SPDX-FileCopyrightText: The Bio++ Development Group
+//
+// SPDX-License-Identifier: CECILL-2.1
+
+#include "PolymorphismSequenceView.h"
+
+using namespace bpp;
+using namespace std;
+
+PolymorphismSequenceView::PolymorphismSequenceView(const PolymorphismSequenceContainer& psc) :
+  psc_(&psc),
+  sequences_(psc.getNumberOfSequences()),
+  sites_(psc.getNumberOfSites())
+{
+  for (size_t i = 0; i < sequences_.size(); ++i)
+  {
+    sequences_[i] = i;
+  }
+  for (size_t i = 0; i < sites_.size(); ++i)
+  {
+    sites_[i] = i;
+  }
+}
+
+/******************************************************************************/
+
+PolymorphismSequenceView::PolymorphismSequenceView(
+    const PolymorphismSequenceContainer& psc,
+    const vector<size_t>& sequences) :
+  psc_(&psc),
+  sequences_(sequences),
+  sites_(psc.getNumberOfSites())
+{
+  for (auto i : sequences_)
+  {
+    if (i >= psc.getNumberOfSequences())
+      throw IndexOutOfBoundsException("PolymorphismSequenceView: sequence position out of bounds.", i, 0, psc.getNumberOfSequences());
+  }
+  for (size_t i = 0; i < sites_.size(); ++i)
+  {
+    sites_[i] = i;
+  }
+}
+
+/******************************************************************************/
+
+PolymorphismSequenceView::PolymorphismSequenceView(
+    const PolymorphismSequenceContainer& psc,
+    const vector<size_t>& sequences,
+    const vector<size_t>& sites) :
+  psc_(&psc),
+  sequences_(sequences),
+  sites_(sites)
+{
+  for (auto i : sequences_)
+  {
+    if (i >= psc.getNumberOfSequences())
+      throw IndexOutOfBoundsException("PolymorphismSequenceView: sequence position out of bounds.", i, 0, psc.getNumberOfSequences());
+  }
+  for (auto i : sites_)
+  {
+    if (i >= psc.getNumberOfSites())
+      throw IndexOutOfBoundsException("PolymorphismSequenceView: site position out of bounds.", i, 0, psc.getNumberOfSites());
+  }
+}
+
+/******************************************************************************/
+
+vector<string> PolymorphismSequenceView::getSequenceNames() const
+{
+  vector<string> allNames = psc_->getSequenceNames();
+  vector<string> names(sequences_.size());
+  for (size_t i = 0; i < sequences_.size(); ++i)
+  {
+    names[i] = allNames[sequences_[i]];
+  }
+  return names;
+}
+
+/******************************************************************************/
+
+size_t PolymorphismSequenceView::getSampleSize(bool weighted) const
+{
+  if (!weighted)
+    return sequences_.size();
+  size_t n = 0;
+  for (auto i : sequences_)
+  {
+    n += psc_->getSequenceCount(i);
+  }
+  return n;
+}
+
+/******************************************************************************/
+
+void PolymorphismSequenceView::getSiteCounts(
+    size_t sitePosition,
+    map<int, size_t>& counts,
+    bool weighted) const
+{
+  const Site& site = psc_->site(sites_[sitePosition]);
+  for (auto i : sequences_)
+  {
+    counts[site[i]] += weighted ? psc_->getSequenceCount(i) : 1;
+  }
+}
+
+/******************************************************************************/
+
+bool PolymorphismSequenceView::isGapFree(size_t sitePosition) const
+{
+  const Site& site = psc_->site(sites_[sitePosition]);
+  const Alphabet& alpha = psc_->alphabet();
+  for (auto i : sequences_)
+  {
+    if (alpha.isGap(site[i]))
+      return false;
+  }
+  return true;
+}
+
+/******************************************************************************/
+
+bool PolymorphismSequenceView::isComplete(size_t sitePosition) const
+{
+  const Site& site = psc_->site(sites_[sitePosition]);
+  int size = static_cast<int>(psc_->alphabet().getSize());
+  for (auto i : sequences_)
+  {
+    if (site[i] < 0 || site[i] >= size)
+      return false;
+  }
+  return true;
+}
+
+/******************************************************************************/
+
+unique_ptr<Site> PolymorphismSequenceView::getSite(size_t sitePosition) const
+{
+  const Site& site = psc_->site(sites_[sitePosition]);
+  vector<int> values(sequences_.size());
+  for (size_t i = 0; i < sequences_.size(); ++i)
+  {
+    values[i] = site[sequences_[i]];
+  }
+  auto alpha = psc_->getAlphabet();
+  return make_unique<Site>(values, alpha, site.getCoordinate());
+}
+
+/******************************************************************************/
+
+PolymorphismSequenceView PolymorphismSequenceView::selectSequences(const vector<size_t>& sequences) const
+{
+  vector<size_t> positions(sequences.size());
+  for (size_t i = 0; i < sequences.size(); ++i)
+  {
+    if (sequences[i] >= sequences_.size())
+      throw IndexOutOfBoundsException("PolymorphismSequenceView::selectSequences.", sequences[i], 0, sequences_.size());
+    positions[i] = sequences_[sequences[i]];
+  }
+  return PolymorphismSequenceView(*psc_, positions, sites_);
+}
+
+/******************************************************************************/
+
+PolymorphismSequenceView PolymorphismSequenceView::selectSites(const vector<size_t>& sites) const
+{
+  vector<size_t> positions(sites.size());
+  for (size_t i = 0; i < sites.size(); ++i)
+  {
+    if (sites[i] >= sites_.size())
+      throw IndexOutOfBoundsException("PolymorphismSequenceView::selectSites.", sites[i], 0, sites_.size());
+    positions[i] = sites_[sites[i]];
+  }
+  return PolymorphismSequenceView(*psc_, sequences_, positions);
+}
+
+/******************************************************************************/
+
+unique_ptr<PolymorphismSequenceContainer> PolymorphismSequenceView::materialize() const
+{
+  size_t nbSeq = sequences_.size();
+  auto npsc = make_unique<PolymorphismSequenceContainer>(nbSeq, psc_->getAlphabet());
+  npsc->setSequenceNames(getSequenceNames(), false);
+  for (size_t i = 0; i < nbSeq; ++i)
+  {
+    npsc->setSequenceCount(i, getSequenceCount(i));
+    if (isIngroupMember(i))
+      npsc->setAsIngroupMember(i);
+    else
+      npsc->setAsOutgroupMember(i);
+    npsc->setGroupId(i, getGroupId(i));
+  }
+  for (size_t j = 0; j < getNumberOfSites(); ++j)
+  {
+    auto tmpSite = getSite(j);
+    // Views may repeat sites, e.g. when built from bootstrap indices.
+    npsc->addSite(tmpSite, false);
+  }
+  npsc->setComments(psc_->getComments());
+  return npsc;
+}
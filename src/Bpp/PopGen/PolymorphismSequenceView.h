@@ -0,0 +1,188 @@
+// SPDX-FileCopyrightText: The Bio++ Development Group
+//
+// SPDX-License-Identifier: CECILL-2.1
+
+#ifndef _POLYMORPHISMSEQUENCEVIEW_H_
+#define _POLYMORPHISMSEQUENCEVIEW_H_
+
+#include <Bpp/Exceptions.h>
+
+// From bpp-seq
+#include <Bpp/Seq/Site.h>
+
+// From the STL
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "PolymorphismSequenceContainer.h"
+
+namespace bpp
+{
+/**
+ * @brief A read-only subset of the sequences and sites of a PolymorphismSequenceContainer.
+ *
+ * A view only stores a pointer to its parent container and the positions of
+ * the selected sequences and sites in it, so that it can be built without
+ * copying any data. Sequences and sites are accessed in the order of the
+ * selection. Views can be further restricted with selectSequences() and
+ * selectSites(), which makes it cheap to chain several filters.
+ * Use materialize() to get a stand-alone PolymorphismSequenceContainer.
+ *
+ * The parent container must outlive the view and must not be modified while
+ * the view is in use.
+ *
+ * @see PolymorphismSequenceContainerTools::getIngroupView
+ * @see PolymorphismSequenceContainerTools::getOutgroupView
+ * @see PolymorphismSequenceContainerTools::getGroupView
+ * @see PolymorphismSequenceContainerTools::getSelectedSequencesView
+ * @see PolymorphismSequenceContainerTools::getCompleteSitesView
+ */
+class PolymorphismSequenceView
+{
+private:
+  const PolymorphismSequenceContainer* psc_;
+  std::vector<size_t> sequences_;
+  std::vector<size_t> sites_;
+
+public:
+  /**
+   * @brief Build a view on all the sequences and sites of a container.
+   */
+  explicit PolymorphismSequenceView(const PolymorphismSequenceContainer& psc);
+
+  /**
+   * @brief Build a view on a selection of sequences of a container, with all its sites.
+   *
+   * @param psc The parent container.
+   * @param sequences The positions of the sequences in the parent container.
+   * @throw IndexOutOfBoundsException if a position is not valid.
+   */
+  PolymorphismSequenceView(
+      const PolymorphismSequenceContainer& psc,
+      const std::vector<size_t>& sequences);
+
+  /**
+   * @brief Build a view on a selection of sequences and sites of a container.
+   *
+   * @param psc The parent container.
+   * @param sequences The positions of the sequences in the parent container.
+   * @param sites The positions of the sites in the parent container.
+   * @throw IndexOutOfBoundsException if a position is not valid.
+   */
+  PolymorphismSequenceView(
+      const PolymorphismSequenceContainer& psc,
+      const std::vector<size_t>& sequences,
+      const std::vector<size_t>& sites);
+
+  virtual ~PolymorphismSequenceView() {}
+
+public:
+  /**
+   * @return The parent container.
+   */
+  const PolymorphismSequenceContainer& getContainer() const { return *psc_; }
+
+  size_t getNumberOfSequences() const { return sequences_.size(); }
+
+  size_t getNumberOfSites() const { return sites_.size(); }
+
+  /**
+   * @return The position in the parent container of a sequence of the view.
+   */
+  size_t getSequencePosition(size_t index) const { return sequences_[index]; }
+
+  /**
+   * @return The positions in the parent container of the sequences of the view.
+   */
+  const std::vector<size_t>& getSequencePositions() const { return sequences_; }
+
+  /**
+   * @return The position in the parent container of a site of the view.
+   */
+  size_t getSitePosition(size_t sitePosition) const { return sites_[sitePosition]; }
+
+  /**
+   * @return The positions in the parent container of the sites of the view.
+   */
+  const std::vector<size_t>& getSitePositions() const { return sites_; }
+
+  std::vector<std::string> getSequenceNames() const;
+
+  /**
+   * @return The state of a sequence of the view at a given site.
+   */
+  int getValue(size_t index, size_t sitePosition) const
+  {
+    return psc_->site(sites_[sitePosition])[sequences_[index]];
+  }
+
+  /**
+   * @return True if no sequence of the view has a gap at the given site.
+   */
+  bool isGapFree(size_t sitePosition) const;
+
+  /**
+   * @return True if all the sequences of the view have a resolved state
+   * (neither a gap nor an unknown character) at the given site.
+   */
+  bool isComplete(size_t sitePosition) const;
+
+  unsigned int getSequenceCount(size_t index) const { return psc_->getSequenceCount(sequences_[index]); }
+
+  bool isIngroupMember(size_t index) const { return psc_->isIngroupMember(sequences_[index]); }
+
+  size_t getGroupId(size_t index) const { return psc_->getGroupId(sequences_[index]); }
+
+  /**
+   * @return The sum of the counts of the sequences of the view if weighted
+   * is true, their number otherwise.
+   */
+  size_t getSampleSize(bool weighted = false) const;
+
+  /**
+   * @brief Count the states of the sequences of the view at a given site.
+   *
+   * @param sitePosition The position of the site.
+   * @param counts The map where counts are added.
+   * @param weighted If true, each sequence is counted as many times as its count.
+   */
+  void getSiteCounts(
+      size_t sitePosition,
+      std::map<int, size_t>& counts,
+      bool weighted = false) const;
+
+  /**
+   * @return A copy of a site, restricted to the sequences of the view.
+   */
+  std::unique_ptr<Site> getSite(size_t sitePosition) const;
+
+  /**
+   * @brief Restrict the view to some of its sequences.
+   *
+   * @param sequences Positions of sequences in this view (not in the parent container).
+   * @return A new view on the same parent container.
+   * @throw IndexOutOfBoundsException if a position is not valid.
+   */
+  PolymorphismSequenceView selectSequences(const std::vector<size_t>& sequences) const;
+
+  /**
+   * @brief Restrict the view to some of its sites.
+   *
+   * @param sites Positions of sites in this view (not in the parent container).
+   * @return A new view on the same parent container.
+   * @throw IndexOutOfBoundsException if a position is not valid.
+   */
+  PolymorphismSequenceView selectSites(const std::vector<size_t>& sites) const;
+
+  /**
+   * @return A new PolymorphismSequenceContainer with the sequences of the
+   * view, their counts, ingroup flags and group ids, and the comments of the
+   * parent container.
+   */
+  std::unique_ptr<PolymorphismSequenceContainer> materialize() const;
+};
+} // end of namespace bpp;
+
+#endif // _POLYMORPHISMSEQUENCEVIEW_H_
@@ -0,0 +1,96 @@
+// SPDX-FileCopyrightText: The Bio++ Development Group
+//
+// SPDX-License-Identifier: CECILL-2.1
+
+#include "SequenceMatrix.h"
+
+// From the STL
+#include <algorithm>
+
+using namespace bpp;
+using namespace std;
+
+SequenceMatrix::SequenceMatrix(const PolymorphismSequenceView& view) :
+  nbSequences_(view.getNumberOfSequences()),
+  nbSites_(view.getNumberOfSites()),
+  // 16 states of 4 bytes per cache line.
+  stride_((view.getNumberOfSites() + 15) / 16 * 16),
+  states_(view.getNumberOfSequences() * stride_, 0)
+{
+  const PolymorphismSequenceContainer& psc = view.getContainer();
+  for (size_t i0 = 0; i0 < nbSites_; i0 += BLOCK_SIZE)
+  {
+    size_t i1 = min(i0 + BLOCK_SIZE, nbSites_);
+    for (size_t j0 = 0; j0 < nbSequences_; j0 += BLOCK_SIZE)
+    {
+      size_t j1 = min(j0 + BLOCK_SIZE, nbSequences_);
+      for (size_t i = i0; i < i1; ++i)
+      {
+        const Site& site = psc.site(view.getSitePosition(i));
+        for (size_t j = j0; j < j1; ++j)
+        {
+          states_[j * stride_ + i] = site[view.getSequencePosition(j)];
+        }
+      }
+    }
+  }
+}
+
+/******************************************************************************/
+
+bool SequenceMatrix::areIdentical(size_t index1, size_t index2) const
+{
+  const int* s1 = getSequence(index1);
+  return equal(s1, s1 + nbSites_, getSequence(index2));
+}
+
+/******************************************************************************/
+
+bool SequenceMatrix::areIdentical(size_t index1, size_t index2, const vector<size_t>& sites) const
+{
+  const int* s1 = getSequence(index1);
+  const int* s2 = getSequence(index2);
+  for (size_t i : sites)
+  {
+    if (s1[i] != s2[i])
+      return false;
+  }
+  return true;
+}
+
+/******************************************************************************/
+
+bool SequenceMatrix::isLess(size_t index1, size_t index2) const
+{
+  const int* s1 = getSequence(index1);
+  const int* s2 = getSequence(index2);
+  return lexicographical_compare(s1, s1 + nbSites_, s2, s2 + nbSites_);
+}
+
+/******************************************************************************/
+
+bool SequenceMatrix::isLess(size_t index1, size_t index2, const vector<size_t>& sites) const
+{
+  const int* s1 = getSequence(index1);
+  const int* s2 = getSequence(index2);
+  for (size_t i : sites)
+  {
+    if (s1[i] != s2[i])
+      return s1[i] < s2[i];
+  }
+  return false;
+}
+
+/******************************************************************************/
+
+size_t SequenceMatrix::getNumberOfDifferences(size_t index1, size_t index2) const
+{
+  const int* s1 = getSequence(index1);
+  const int* s2 = getSequence(index2);
+  size_t nb = 0;
+  for (size_t i = 0; i < nbSites_; ++i)
+  {
+    nb += (s1[i] != s2[i]);
+  }
+  return nb;
+}
@@ -0,0 +1,96 @@
+// SPDX-FileCopyrightText: The Bio++ Development Group
+//
+// SPDX-License-Identifier: CECILL-2.1
+
+#ifndef _SEQUENCEMATRIX_H_
+#define _SEQUENCEMATRIX_H_
+
+// From the STL
+#include <vector>
+
+#include "PolymorphismSequenceView.h"
+
+namespace bpp
+{
+/**
+ * @brief A sequence-major copy of the states of a set of sequences.
+ *
+ * PolymorphismSequenceContainer stores sites contiguously, which suits
+ * per-site statistics. Operations comparing whole sequences (haplotype
+ * counts, pairwise differences) instead read every site of a sequence in
+ * turn, and are much faster on rows of contiguous states. This class holds
+ * such rows, each padded to a multiple of 16 states (64 bytes), so that all
+ * rows start at the same offset within a cache line. It is built by
+ * transposing the sites by blocks, so that both the sites read and the rows
+ * written stay in cache.
+ *
+ * A matrix is an immutable snapshot: it is not updated when the container
+ * it was built from is modified.
+ *
+ * @see PolymorphismSequenceContainer::getSequenceMatrix
+ */
+class SequenceMatrix
+{
+private:
+  size_t nbSequences_;
+  size_t nbSites_;
+  size_t stride_;
+  std::vector<int> states_;
+
+public:
+  /**
+   * @param view The sequences and sites to copy.
+   */
+  explicit SequenceMatrix(const PolymorphismSequenceView& view);
+
+  virtual ~SequenceMatrix() {}
+
+public:
+  size_t getNumberOfSequences() const { return nbSequences_; }
+
+  size_t getNumberOfSites() const { return nbSites_; }
+
+  /**
+   * @return A pointer to the getNumberOfSites() states of a sequence.
+   */
+  const int* getSequence(size_t index) const
+  {
+    return states_.data() + index * stride_;
+  }
+
+  int getValue(size_t index, size_t site) const
+  {
+    return states_[index * stride_ + site];
+  }
+
+  /**
+   * @return True if two sequences have the same states at all sites.
+   */
+  bool areIdentical(size_t index1, size_t index2) const;
+
+  /**
+   * @return True if two sequences have the same states at the given sites.
+   */
+  bool areIdentical(size_t index1, size_t index2, const std::vector<size_t>& sites) const;
+
+  /**
+   * @brief Compare two sequences lexicographically, for sorting.
+   */
+  bool isLess(size_t index1, size_t index2) const;
+
+  /**
+   * @brief Compare two sequences lexicographically at the given sites.
+   */
+  bool isLess(size_t index1, size_t index2, const std::vector<size_t>& sites) const;
+
+  /**
+   * @return The number of sites at which two sequences have different states.
+   */
+  size_t getNumberOfDifferences(size_t index1, size_t index2) const;
+
+private:
+  static constexpr size_t BLOCK_SIZE = 64;
+};
+} // end of namespace bpp;
+
+#endif // _SEQUENCEMATRIX_H_
@@ -0,0 +1,354 @@
+// SPDX-FileCopyrightText: The Bio++ Development Group
+//
+// SPDX-License-Identifier: CECILL-2.1
+
+#include "SequenceResampling.h"
+#include "ParallelTools.h"
+#include "SequenceStatistics.h"
+
+#include <Bpp/Numeric/Random/RandomTools.h>
+
+// From the STL
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+using namespace bpp;
+using namespace std;
+
+vector<SequenceResampling::Result> SequenceResampling::bootstrapSequences(
+    const PolymorphismSequenceView& view,
+    const vector<string>& statistics,
+    size_t nbReplicates,
+    uint64_t seed,
+    double level,
+    bool weighted,
+    const Sequence* ancestralSites,
+    unsigned int nbThreads)
+{
+  checkStatistics_(statistics, ancestralSites != nullptr);
+  SiteCountTable table(view, weighted);
+  if (ancestralSites)
+    table.setAncestralStates(view, *ancestralSites);
+  vector<Result> results = initResults_(statistics, table, nbReplicates);
+
+  size_t nbSeq = view.getNumberOfSequences();
+  size_t sampleSize = view.getSampleSize(weighted);
+  // Cumulated weights of the sequences.
+  vector<double> weights(nbSeq);
+  for (size_t i = 0; i < nbSeq; ++i)
+  {
+    weights[i] = (i > 0 ? weights[i - 1] : 0.) + (weighted ? static_cast<double>(view.getSequenceCount(i)) : 1.);
+  }
+  // Each thread refills its own copy of the table.
+  nbThreads = ParallelTools::getNumberOfThreads(nbThreads, nbReplicates);
+  vector<SiteCountTable> tables(nbThreads, table);
+  vector<vector<unsigned int>> draws(nbThreads, vector<unsigned int>(nbSeq));
+  ParallelTools::parallelFor(nbReplicates, nbThreads,
+      [&](size_t r, unsigned int t) {
+        CounterBasedGenerator gen = getReplicateGenerator(seed, r);
+        fill(draws[t].begin(), draws[t].end(), 0);
+        for (size_t k = 0; k < sampleSize; ++k)
+        {
+          draws[t][gen.drawIndex(weights)]++;
+        }
+        tables[t].fill(view, draws[t]);
+        for (auto& res : results)
+        {
+          res.replicates[r] = computeStatistic(res.statistic, tables[t]);
+        }
+      });
+  percentileIntervals_(results, level);
+  return results;
+}
+
+/******************************************************************************/
+
+vector<SequenceResampling::Result> SequenceResampling::bootstrapSites(
+    const PolymorphismSequenceView& view,
+    const vector<string>& statistics,
+    size_t nbReplicates,
+    size_t blockLength,
+    uint64_t seed,
+    double level,
+    bool weighted,
+    const Sequence* ancestralSites,
+    unsigned int nbThreads)
+{
+  checkStatistics_(statistics, ancestralSites != nullptr);
+  SiteCountTable original(view, weighted);
+  if (ancestralSites)
+    original.setAncestralStates(view, *ancestralSites);
+  size_t nbSites = original.getNumberOfSites();
+  if (blockLength == 0 || blockLength > nbSites)
+    throw Exception("SequenceResampling::bootstrapSites: block length must be between 1 and the number of sites.");
+  vector<Result> results = initResults_(statistics, original, nbReplicates);
+
+  nbThreads = ParallelTools::getNumberOfThreads(nbThreads, nbReplicates);
+  vector<SiteCountTable> replicates(nbThreads, SiteCountTable(0, original.getNumberOfStates()));
+  vector<vector<size_t>> sites(nbThreads, vector<size_t>(nbSites));
+  ParallelTools::parallelFor(nbReplicates, nbThreads,
+      [&](size_t r, unsigned int t) {
+        CounterBasedGenerator gen = getReplicateGenerator(seed, r);
+        size_t i = 0;
+        while (i < nbSites)
+        {
+          size_t b = static_cast<size_t>(gen.drawInteger(nbSites - blockLength + 1));
+          for (size_t j = 0; j < blockLength && i < nbSites; ++j)
+          {
+            sites[t][i++] = b + j;
+          }
+        }
+        replicates[t].selectSites(original, sites[t]);
+        for (auto& res : results)
+        {
+          res.replicates[r] = computeStatistic(res.statistic, replicates[t]);
+        }
+      });
+  percentileIntervals_(results, level);
+  return results;
+}
+
+/******************************************************************************/
+
+vector<SequenceResampling::Result> SequenceResampling::jackknifeSequences(
+    const PolymorphismSequenceView& view,
+    const vector<string>& statistics,
+    double level,
+    bool weighted,
+    const Sequence* ancestralSites,
+    unsigned int nbThreads)
+{
+  checkStatistics_(statistics, ancestralSites != nullptr);
+  SiteCountTable table(view, weighted);
+  if (ancestralSites)
+    table.setAncestralStates(view, *ancestralSites);
+  size_t nbSeq = view.getNumberOfSequences();
+  vector<Result> results = initResults_(statistics, table, nbSeq);
+
+  vector<unsigned int> weights(nbSeq, 1);
+  if (weighted)
+  {
+    for (size_t i = 0; i < nbSeq; ++i)
+    {
+      weights[i] = view.getSequenceCount(i);
+    }
+  }
+  nbThreads = ParallelTools::getNumberOfThreads(nbThreads, nbSeq);
+  vector<SiteCountTable> tables(nbThreads, table);
+  vector<vector<unsigned int>> draws(nbThreads, weights);
+  ParallelTools::parallelFor(nbSeq, nbThreads,
+      [&](size_t r, unsigned int t) {
+        if (weights[r] == 0)
+          return;
+        draws[t][r]--;
+        tables[t].fill(view, draws[t]);
+        draws[t][r]++;
+        for (auto& res : results)
+        {
+          res.replicates[r] = computeStatistic(res.statistic, tables[t]);
+        }
+      });
+  // Each replicate stands for as many individuals as the count of its sequence.
+  vector<double> multiplicities(weights.begin(), weights.end());
+  jackknifeIntervals_(results, multiplicities, level);
+  return results;
+}
+
+/******************************************************************************/
+
+vector<SequenceResampling::Result> SequenceResampling::jackknifeSites(
+    const PolymorphismSequenceView& view,
+    const vector<string>& statistics,
+    size_t blockLength,
+    double level,
+    bool weighted,
+    const Sequence* ancestralSites,
+    unsigned int nbThreads)
+{
+  checkStatistics_(statistics, ancestralSites != nullptr);
+  if (blockLength == 0)
+    throw Exception("SequenceResampling::jackknifeSites: block length must be positive.");
+  SiteCountTable original(view, weighted);
+  if (ancestralSites)
+    original.setAncestralStates(view, *ancestralSites);
+  size_t nbSites = original.getNumberOfSites();
+  size_t nbBlocks = (nbSites + blockLength - 1) / blockLength;
+  vector<Result> results = initResults_(statistics, original, nbBlocks);
+
+  nbThreads = ParallelTools::getNumberOfThreads(nbThreads, nbBlocks);
+  vector<SiteCountTable> replicates(nbThreads, SiteCountTable(0, original.getNumberOfStates()));
+  vector<vector<size_t>> sites(nbThreads);
+  ParallelTools::parallelFor(nbBlocks, nbThreads,
+      [&](size_t r, unsigned int t) {
+        sites[t].clear();
+        for (size_t i = 0; i < nbSites; ++i)
+        {
+          if (i / blockLength != r)
+            sites[t].push_back(i);
+        }
+        replicates[t].selectSites(original, sites[t]);
+        for (auto& res : results)
+        {
+          res.replicates[r] = computeStatistic(res.statistic, replicates[t]);
+        }
+      });
+  jackknifeIntervals_(results, vector<double>(nbBlocks, 1.), level);
+  return results;
+}
+
+/******************************************************************************/
+
+double SequenceResampling::computeStatistic(
+    const string& statistic,
+    const SiteCountTable& table)
+{
+  try
+  {
+    if (statistic == "S")
+      return static_cast<double>(SequenceStatistics::numberOfPolymorphicSites(table));
+    else if (statistic == "eta")
+      return static_cast<double>(SequenceStatistics::totalNumberOfMutations(table));
+    else if (statistic == "singletons")
+      return static_cast<double>(SequenceStatistics::numberOfSingletons(table));
+    else if (statistic == "thetaW")
+      return SequenceStatistics::watterson75(table);
+    else if (statistic == "pi")
+      return SequenceStatistics::tajima83(table);
+    else if (statistic == "tajimaD")
+      return SequenceStatistics::tajimaDss(table);
+    else if (statistic == "fuLiDStar")
+      return SequenceStatistics::fuLiDStar(table);
+    else if (statistic == "fuLiFStar")
+      return SequenceStatistics::fuLiFStar(table);
+    else if (statistic == "thetaH")
+      return SequenceStatistics::fayWu2000(table);
+    else if (statistic == "fayWuH")
+      return SequenceStatistics::tajima83(table) - SequenceStatistics::fayWu2000(table);
+  }
+  catch (ZeroDivisionException& e)
+  {
+    return numeric_limits<double>::quiet_NaN();
+  }
+  throw Exception("SequenceResampling::computeStatistic: unknown statistic '" + statistic + "'.");
+}
+
+/******************************************************************************/
+
+void SequenceResampling::checkStatistics_(const vector<string>& statistics, bool ancestral)
+{
+  static const vector<string> names = {
+    "S", "eta", "singletons", "thetaW", "pi", "tajimaD", "fuLiDStar", "fuLiFStar", "thetaH", "fayWuH"
+  };
+  for (const auto& name : statistics)
+  {
+    if (!ancestral && (name == "thetaH" || name == "fayWuH"))
+      throw Exception("SequenceResampling: statistic '" + name + "' needs an ancestral sequence.");
+    if (find(names.begin(), names.end(), name) == names.end())
+      throw Exception("SequenceResampling: unknown statistic '" + name + "'.");
+  }
+}
+
+/******************************************************************************/
+
+vector<SequenceResampling::Result> SequenceResampling::initResults_(
+    const vector<string>& statistics,
+    const SiteCountTable& table,
+    size_t nbReplicates)
+{
+  double nan = numeric_limits<double>::quiet_NaN();
+  vector<Result> results(statistics.size());
+  for (size_t s = 0; s < statistics.size(); ++s)
+  {
+    results[s].statistic = statistics[s];
+    results[s].estimate = computeStatistic(statistics[s], table);
+    results[s].replicates.assign(nbReplicates, nan);
+    results[s].nbValidReplicates = 0;
+    results[s].mean = nan;
+    results[s].standardError = nan;
+    results[s].lower = nan;
+    results[s].upper = nan;
+  }
+  return results;
+}
+
+/******************************************************************************/
+
+void SequenceResampling::percentileIntervals_(vector<Result>& results, double level)
+{
+  double alpha = (1. - level) / 2.;
+  for (auto& res : results)
+  {
+    vector<double> valid;
+    for (auto x : res.replicates)
+    {
+      if (!std::isnan(x))
+        valid.push_back(x);
+    }
+    res.nbValidReplicates = valid.size();
+    if (valid.empty())
+      continue;
+    sort(valid.begin(), valid.end());
+    double m = static_cast<double>(valid.size());
+    double mean = 0.;
+    for (auto x : valid)
+    {
+      mean += x;
+    }
+    mean /= m;
+    double var = 0.;
+    for (auto x : valid)
+    {
+      var += (x - mean) * (x - mean);
+    }
+    res.mean = mean;
+    res.standardError = valid.size() > 1 ? sqrt(var / (m - 1.)) : 0.;
+    // Linear interpolation between order statistics
+    auto quantile = [&valid, m](double p) {
+      double pos = p * (m - 1.);
+      size_t i = static_cast<size_t>(floor(pos));
+      if (i + 1 >= valid.size())
+        return valid.back();
+      double f = pos - static_cast<double>(i);
+      return valid[i] + f * (valid[i + 1] - valid[i]);
+    };
+    res.lower = quantile(alpha);
+    res.upper = quantile(1. - alpha);
+  }
+}
+
+/******************************************************************************/
+
+void SequenceResampling::jackknifeIntervals_(
+    vector<Result>& results,
+    const vector<double>& multiplicities,
+    double level)
+{
+  double z = RandomTools::qNorm(1. - (1. - level) / 2.);
+  for (auto& res : results)
+  {
+    double n = 0., mean = 0.;
+    res.nbValidReplicates = 0;
+    for (size_t r = 0; r < res.replicates.size(); ++r)
+    {
+      if (std::isnan(res.replicates[r]))
+        continue;
+      res.nbValidReplicates++;
+      n += multiplicities[r];
+      mean += multiplicities[r] * res.replicates[r];
+    }
+    if (res.nbValidReplicates == 0)
+      continue;
+    mean /= n;
+    double ss = 0.;
+    for (size_t r = 0; r < res.replicates.size(); ++r)
+    {
+      if (!std::isnan(res.replicates[r]))
+        ss += multiplicities[r] * (res.replicates[r] - mean) * (res.replicates[r] - mean);
+    }
+    res.mean = mean;
+    res.standardError = sqrt((n - 1.) / n * ss);
+    res.lower = res.estimate - z * res.standardError;
+    res.upper = res.estimate + z * res.standardError;
+  }
+}
@@ -0,0 +1,248 @@
+// SPDX-FileCopyrightText: The Bio++ Development Group
+//
+// SPDX-License-Identifier: CECILL-2.1
+
+#ifndef _SEQUENCERESAMPLING_H_
+#define _SEQUENCERESAMPLING_H_
+
+#include <Bpp/Exceptions.h>
+
+// From the STL
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "CounterBasedGenerator.h"
+#include "PolymorphismSequenceView.h"
+#include "SiteCountTable.h"
+
+namespace bpp
+{
+/**
+ * @brief Bootstrap and jackknife confidence intervals for sequence statistics.
+ *
+ * Replicates are drawn as index vectors on a PolymorphismSequenceView and
+ * never copy any sequence:
+ * - when sequences are resampled, a SiteCountTable is refilled from the
+ *   view with the number of times each sequence was drawn;
+ * - when sites are resampled, the rows of a SiteCountTable computed once
+ *   are copied into the replicate table.
+ *
+ * Statistics are designated by their names, and computed with the
+ * SiteCountTable methods of SequenceStatistics:
+ * - "S": number of polymorphic sites,
+ * - "eta": total number of mutations,
+ * - "singletons": number of singletons,
+ * - "thetaW": Watterson (1975) estimator of theta,
+ * - "pi": Tajima (1983) estimator of theta,
+ * - "tajimaD": Tajima's D, from the number of segregating sites,
+ * - "fuLiDStar": Fu and Li's D*,
+ * - "fuLiFStar": Fu and Li's F*,
+ * - "thetaH": Fay and Wu (2000) estimator Theta H,
+ * - "fayWuH": Fay and Wu's H, i.e. pi - Theta H.
+ *
+ * The last two need the ancestral states of the sites (see
+ * SiteCountTable::setAncestralState): the resampling methods only accept
+ * them if an ancestral sequence is given.
+ *
+ * Each replicate uses its own random number generator, the stream of a
+ * CounterBasedGenerator identified by the user seed and the replicate number,
+ * so that results are reproducible and do not depend on the order in which
+ * replicates are computed. Replicates can therefore be distributed between
+ * threads, each of which fills its own replicate table.
+ * Replicates for which a statistic is not defined (for instance Tajima's D
+ * without any polymorphic site) are set to NaN, and are not used to compute
+ * the intervals.
+ */
+class SequenceResampling
+{
+public:
+  /**
+   * @brief The result of a resampling procedure for one statistic.
+   */
+  struct Result
+  {
+    std::string statistic;
+    /** @brief The value of the statistic on the original data. */
+    double estimate;
+    /** @brief The values of the statistic on each replicate. */
+    std::vector<double> replicates;
+    /** @brief The number of replicates where the statistic is defined. */
+    size_t nbValidReplicates;
+    /** @brief The mean of the valid replicates. */
+    double mean;
+    /** @brief The standard error of the estimate. */
+    double standardError;
+    /** @brief The bounds of the confidence interval. */
+    double lower;
+    double upper;
+  };
+
+public:
+  /**
+   * @brief Bootstrap over sequences.
+   *
+   * Each replicate draws with replacement as many sequences as in the view.
+   * If weighted is true, individuals are drawn instead: the sample size is
+   * the sum of the counts of the sequences, and each sequence is drawn with
+   * a probability proportional to its count.
+   * Intervals are percentile intervals.
+   *
+   * @param view The sequences and sites to use.
+   * @param statistics The names of the statistics to compute.
+   * @param nbReplicates The number of bootstrap replicates.
+   * @param seed The seed of the random number generators.
+   * @param level The confidence level of the intervals.
+   * @param weighted Whether sequences are weighted by their counts.
+   * @param ancestralSites The ancestral state of each site of the container
+   * of the view, needed by "thetaH" and "fayWuH", or nullptr.
+   * @param nbThreads The number of threads, or 0 to use all hardware threads.
+   * @return One Result per statistic, in the same order.
+   * @throw Exception if a statistic name is unknown, or needs an ancestral
+   * sequence which is not given.
+   */
+  static std::vector<Result> bootstrapSequences(
+      const PolymorphismSequenceView& view,
+      const std::vector<std::string>& statistics,
+      size_t nbReplicates,
+      uint64_t seed,
+      double level = 0.95,
+      bool weighted = false,
+      const Sequence* ancestralSites = nullptr,
+      unsigned int nbThreads = 1);
+
+  /**
+   * @brief Block bootstrap over sites.
+   *
+   * Each replicate concatenates blocks of blockLength consecutive sites,
+   * starting at random positions, until it has as many sites as the view.
+   * Use blockLength = 1 to resample independent sites.
+   * Intervals are percentile intervals.
+   *
+   * @param view The sequences and sites to use.
+   * @param statistics The names of the statistics to compute.
+   * @param nbReplicates The number of bootstrap replicates.
+   * @param blockLength The number of consecutive sites in a block.
+   * @param seed The seed of the random number generators.
+   * @param level The confidence level of the intervals.
+   * @param weighted Whether sequences are weighted by their counts.
+   * @param ancestralSites The ancestral state of each site of the container
+   * of the view, needed by "thetaH" and "fayWuH", or nullptr.
+   * @param nbThreads The number of threads, or 0 to use all hardware threads.
+   * @return One Result per statistic, in the same order.
+   * @throw Exception if a statistic name is unknown, or needs an ancestral
+   * sequence which is not given, or if blockLength is not in
+   * [1, number of sites].
+   */
+  static std::vector<Result> bootstrapSites(
+      const PolymorphismSequenceView& view,
+      const std::vector<std::string>& statistics,
+      size_t nbReplicates,
+      size_t blockLength,
+      uint64_t seed,
+      double level = 0.95,
+      bool weighted = false,
+      const Sequence* ancestralSites = nullptr,
+      unsigned int nbThreads = 1);
+
+  /**
+   * @brief Delete-one jackknife over sequences.
+   *
+   * There is one replicate per sequence of the view. The standard error is
+   * the jackknife standard error, and the interval is the corresponding
+   * normal interval around the estimate.
+   *
+   * @param view The sequences and sites to use.
+   * @param statistics The names of the statistics to compute.
+   * @param level The confidence level of the intervals.
+   * @param weighted Whether sequences are weighted by their counts. One
+   * individual of the sequence is then removed in each replicate.
+   * @param ancestralSites The ancestral state of each site of the container
+   * of the view, needed by "thetaH" and "fayWuH", or nullptr.
+   * @param nbThreads The number of threads, or 0 to use all hardware threads.
+   * @return One Result per statistic, in the same order.
+   * @throw Exception if a statistic name is unknown, or needs an ancestral
+   * sequence which is not given.
+   */
+  static std::vector<Result> jackknifeSequences(
+      const PolymorphismSequenceView& view,
+      const std::vector<std::string>& statistics,
+      double level = 0.95,
+      bool weighted = false,
+      const Sequence* ancestralSites = nullptr,
+      unsigned int nbThreads = 1);
+
+  /**
+   * @brief Delete-one-block jackknife over sites.
+   *
+   * Sites are split into consecutive non-overlapping blocks of blockLength
+   * sites (the last one may be shorter), and each replicate removes one
+   * block. Standard errors and intervals are computed as in
+   * jackknifeSequences.
+   *
+   * @param view The sequences and sites to use.
+   * @param statistics The names of the statistics to compute.
+   * @param blockLength The number of sites in a block.
+   * @param level The confidence level of the intervals.
+   * @param weighted Whether sequences are weighted by their counts.
+   * @param ancestralSites The ancestral state of each site of the container
+   * of the view, needed by "thetaH" and "fayWuH", or nullptr.
+   * @param nbThreads The number of threads, or 0 to use all hardware threads.
+   * @return One Result per statistic, in the same order.
+   * @throw Exception if a statistic name is unknown, or needs an ancestral
+   * sequence which is not given, or if blockLength is 0.
+   */
+  static std::vector<Result> jackknifeSites(
+      const PolymorphismSequenceView& view,
+      const std::vector<std::string>& statistics,
+      size_t blockLength,
+      double level = 0.95,
+      bool weighted = false,
+      const Sequence* ancestralSites = nullptr,
+      unsigned int nbThreads = 1);
+
+  /**
+   * @brief Compute a statistic by name on a SiteCountTable.
+   *
+   * @return The value of the statistic, or NaN if it is not defined.
+   * @throw Exception if the name is unknown.
+   */
+  static double computeStatistic(
+      const std::string& statistic,
+      const SiteCountTable& table);
+
+  /**
+   * @brief Get the random number generator used for a replicate.
+   *
+   * @param seed The user seed.
+   * @param replicate The replicate number.
+   */
+  static CounterBasedGenerator getReplicateGenerator(uint64_t seed, size_t replicate)
+  {
+    return CounterBasedGenerator(seed, static_cast<uint64_t>(replicate));
+  }
+
+private:
+  /**
+   * @param ancestral Whether the tables have ancestral states.
+   */
+  static void checkStatistics_(const std::vector<std::string>& statistics, bool ancestral);
+
+  static std::vector<Result> initResults_(
+      const std::vector<std::string>& statistics,
+      const SiteCountTable& table,
+      size_t nbReplicates);
+
+  static void percentileIntervals_(std::vector<Result>& results, double level);
+
+  /**
+   * @param multiplicities The number of observations each replicate stands for.
+   */
+  static void jackknifeIntervals_(
+      std::vector<Result>& results,
+      const std::vector<double>& multiplicities,
+      double level);
+};
+} // end of namespace bpp;
+
+#endif // _SEQUENCERESAMPLING_H_
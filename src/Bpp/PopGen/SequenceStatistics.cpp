@@ -5,10 +5,16 @@
 #include "SequenceStatistics.h" // class's header file
 #include "PolymorphismSequenceContainerTools.h"
 #include "PolymorphismSequenceContainer.h"
+#include "GapProfile.h"
+#include "ParallelTools.h"
+#include "SequenceMatrix.h"
+#include "SiteStatisticsAccumulator.h"
 
 // From the STL:
 #include <ctype.h>
+#include <algorithm>
 #include <cmath>
+#include <limits>
 #include <iostream>
 #include <vector>
 
@@ -93,7 +99,7 @@ unsigned int SequenceStatistics::numberOfParsimonyInformativeSites(const Polymor
   return s;
 }
 
-unsigned int SequenceStatistics::numberOfSingletons(const PolymorphismSequenceContainer& psc, bool gapflag)
+unsigned int SequenceStatistics::numberOfSingletons(const PolymorphismSequenceContainer& psc, bool gapflag, bool weighted)
 {
   unique_ptr<ConstSiteIterator> si;
   if (gapflag)
@@ -104,7 +110,7 @@ unsigned int SequenceStatistics::numberOfSingletons(const PolymorphismSequenceCo
   while (si->hasMoreSites())
   {
     auto& site = si->nextSite();
-    nus += getNumberOfSingletons_(site);
+    nus += getNumberOfSingletons_(site, psc, weighted);
   }
   return nus;
 }
@@ -146,7 +152,8 @@ unsigned int SequenceStatistics::totalNumberOfMutations(const PolymorphismSequen
 
 unsigned int SequenceStatistics::totalNumberOfMutationsOnExternalBranches(
     const PolymorphismSequenceContainer& ing,
-    const PolymorphismSequenceContainer& outg)
+    const PolymorphismSequenceContainer& outg,
+    bool weighted)
 {
   if (ing.getNumberOfSites() != outg.getNumberOfSites())
     throw Exception("ing and outg must have the same size");
@@ -159,12 +166,12 @@ unsigned int SequenceStatistics::totalNumberOfMutationsOnExternalBranches(
     auto& siteOut = so->nextSite();
     // use fully resolved sites
     if (SiteTools::isComplete(siteIn) &&  SiteTools::isComplete(siteOut))
-      nmuts += getNumberOfDerivedSingletons_(siteIn, siteOut); // singletons that are not in outgroup
+      nmuts += getNumberOfDerivedSingletons_(siteIn, siteOut, ing, weighted); // singletons that are not in outgroup
   }
   return nmuts;
 }
 
-double SequenceStatistics::heterozygosity(const PolymorphismSequenceContainer& psc, bool gapflag)
+double SequenceStatistics::heterozygosity(const PolymorphismSequenceContainer& psc, bool gapflag, bool weighted)
 {
   unique_ptr<ConstSiteIterator> si;
   if (gapflag)
@@ -175,12 +182,12 @@ double SequenceStatistics::heterozygosity(const PolymorphismSequenceContainer& p
   while (si->hasMoreSites())
   {
     auto& site = si->nextSite();
-    s += SiteTools::heterozygosity(site);
+    s += weighted ? getHeterozygosity_(site, psc) : SiteTools::heterozygosity(site);
   }
   return s;
 }
 
-double SequenceStatistics::squaredHeterozygosity(const PolymorphismSequenceContainer& psc, bool gapflag)
+double SequenceStatistics::squaredHeterozygosity(const PolymorphismSequenceContainer& psc, bool gapflag, bool weighted)
 {
   unique_ptr<ConstSiteIterator> si;
   if (gapflag)
@@ -191,7 +198,7 @@ double SequenceStatistics::squaredHeterozygosity(const PolymorphismSequenceConta
   while (si->hasMoreSites())
   {
     auto& site = si->nextSite();
-    double h = SiteTools::heterozygosity(site);
+    double h = weighted ? getHeterozygosity_(site, psc) : SiteTools::heterozygosity(site);
     s += h * h;
   }
   return s;
@@ -243,10 +250,10 @@ std::vector<unsigned int> SequenceStatistics::gcPolymorphism(const PolymorphismS
 // Diversity statistics
 // ******************************************************************************
 
-double SequenceStatistics::watterson75(const PolymorphismSequenceContainer& psc, bool gapflag, bool ignoreUnknown, bool scaled)
+double SequenceStatistics::watterson75(const PolymorphismSequenceContainer& psc, bool gapflag, bool ignoreUnknown, bool scaled, bool weighted)
 {
   double ThetaW;
-  size_t n = psc.getNumberOfSequences();
+  size_t n = getSampleSize_(psc, weighted);
   map<string, double> values = getUsefulValues_(n);
   double s = 0;
   if (scaled)
@@ -257,7 +264,7 @@ double SequenceStatistics::watterson75(const PolymorphismSequenceContainer& psc,
   return ThetaW;
 }
 
-double SequenceStatistics::tajima83(const PolymorphismSequenceContainer& psc, bool gapflag, bool ignoreUnknown, bool scaled)
+double SequenceStatistics::tajima83(const PolymorphismSequenceContainer& psc, bool gapflag, bool ignoreUnknown, bool scaled, bool weighted)
 {
   size_t alphabetSize = psc.getAlphabet()->getSize();
   unique_ptr<ConstSiteIterator> si;
@@ -275,7 +282,7 @@ double SequenceStatistics::tajima83(const PolymorphismSequenceContainer& psc, bo
     {
       double value = 0.;
       map<int, size_t> count;
-      SymbolListTools::getCounts(site, count);
+      getCounts_(site, psc, weighted, count);
       map<int, size_t> tmp_k;
       size_t tmp_n = 0;
       for (auto& it : count)
@@ -298,7 +305,7 @@ double SequenceStatistics::tajima83(const PolymorphismSequenceContainer& psc, bo
   return scaled ? value2 / l : value2;
 }
 
-double SequenceStatistics::fayWu2000(const PolymorphismSequenceContainer& psc, const Sequence& ancestralSites)
+double SequenceStatistics::fayWu2000(const PolymorphismSequenceContainer& psc, const Sequence& ancestralSites, bool weighted)
 {
   if (psc.getNumberOfSites() != ancestralSites.size())
     throw Exception("SequenceStatistics::FayWu2000: ancestralSites and psc don't have the same size!!!'" );
@@ -319,7 +326,7 @@ double SequenceStatistics::fayWu2000(const PolymorphismSequenceContainer& psc, c
         continue;
 
       map<int, size_t> count;
-      SymbolListTools::getCounts(site, count);
+      getCounts_(site, psc, weighted, count);
       map<int, size_t> tmp_k;
       size_t tmp_n = 0;
       for (auto& it : count)
@@ -347,86 +354,22 @@ double SequenceStatistics::fayWu2000(const PolymorphismSequenceContainer& psc, c
 
 unsigned int SequenceStatistics::dvk(const PolymorphismSequenceContainer& psc, bool gapflag)
 {
-  /*
-   * Sylvain Gaillard 17/03/2010:
-   * This implementation uses unneeded SequenceContainer recopy and works on
-   * string. It needs to be improved.
-   */
-  unique_ptr<PolymorphismSequenceContainer> sc;
-  if (gapflag)
-    sc = PolymorphismSequenceContainerTools::getSitesWithoutGaps(psc);
-  else
-    sc = make_unique<PolymorphismSequenceContainer>(psc);
-  // int K = 0;
-  vector<string> pscvector;
-  pscvector.push_back(sc->sequence(0).toString());
-  // K++;
-  for (size_t i = 1; i < sc->getNumberOfSequences(); ++i)
-  {
-    bool uniq = true;
-    string query = sc->sequence(i).toString();
-    for (auto& it : pscvector)
-    {
-      if (query.compare(it) == 0)
-      {
-        uniq = false;
-        break;
-      }
-    }
-    if (uniq)
-    {
-      // K++;
-      pscvector.push_back(query);
-    }
-  }
-  // return K;
-  return static_cast<unsigned int>(pscvector.size());
+  return static_cast<unsigned int>(getHaplotypeCounts_(psc, gapflag, false).size());
 }
 
 double SequenceStatistics::dvh(const PolymorphismSequenceContainer& psc, bool gapflag)
 {
-  /*
-   * Sylvain Gaillard 17/03/2010:
-   * This implementation uses unneeded SequenceContainer recopy and works on
-   * string. It needs to be improved.
-   */
-  unique_ptr<PolymorphismSequenceContainer> sc;
-  if (gapflag)
-    sc = PolymorphismSequenceContainerTools::getSitesWithoutGaps(psc);
-  else
-    sc = make_unique<PolymorphismSequenceContainer>(psc);
-  double H = 0.;
-  size_t nbSeq;
-  vector<string> pscvector;
-  vector<size_t> effvector;
-  pscvector.push_back(sc->sequence(0).toString());
-  effvector.push_back(sc->getSequenceCount(0));
-  nbSeq = sc->getSequenceCount(0);
-  for (size_t i = 1; i < sc->getNumberOfSequences(); ++i)
-  {
-    nbSeq += sc->getSequenceCount(i);
-    bool uniq = true;
-    string query = sc->sequence(i).toString();
-    for (size_t j = 0; j < pscvector.size(); ++j)
-    {
-      if (query.compare(pscvector[j]) == 0)
-      {
-        effvector[j] += sc->getSequenceCount(i);
-        uniq = false;
-        break;
-      }
-    }
-    if (uniq)
-    {
-      pscvector.push_back(query);
-      effvector.push_back(sc->getSequenceCount(i));
-    }
+  vector<size_t> counts = getHaplotypeCounts_(psc, gapflag, true);
+  double nbSeq = 0.;
+  for (auto c : counts)
+  {
+    nbSeq += static_cast<double>(c);
   }
-  for (size_t i = 0; i < effvector.size(); ++i)
+  double H = 1.;
+  for (auto c : counts)
   {
-    H -= (static_cast<double>(effvector[i]) / static_cast<double>(nbSeq)) * ( static_cast<double>(effvector[i]) / static_cast<double>(nbSeq));
+    H -= (static_cast<double>(c) / nbSeq) * (static_cast<double>(c) / nbSeq);
   }
-  H += 1.;
   return H;
 }
 
@@ -585,10 +528,10 @@ unsigned int SequenceStatistics::numberOfSynonymousPolymorphicCodons(const Polym
   return s;
 }
 
-double SequenceStatistics::watterson75Synonymous(const PolymorphismSequenceContainer& psc, const GeneticCode& gc)
+double SequenceStatistics::watterson75Synonymous(const PolymorphismSequenceContainer& psc, const GeneticCode& gc, bool weighted)
 {
   double ThetaW = 0.;
-  size_t n = psc.getNumberOfSequences();
+  size_t n = getSampleSize_(psc, weighted);
   unsigned int s = numberOfSynonymousSubstitutions(psc, gc);
   map<string, double> values = getUsefulValues_(n);
   ThetaW = static_cast<double>(s) / values["a1"];
@@ -597,10 +540,11 @@ double SequenceStatistics::watterson75Synonymous(const PolymorphismSequenceConta
 
 double SequenceStatistics::watterson75NonSynonymous(
     const PolymorphismSequenceContainer& psc,
-    const GeneticCode& gc)
+    const GeneticCode& gc,
+    bool weighted)
 {
   double ThetaW;
-  size_t n = psc.getNumberOfSequences();
+  size_t n = getSampleSize_(psc, weighted);
   unsigned int s = numberOfNonSynonymousSubstitutions(psc, gc);
   map<string, double> values = getUsefulValues_(n);
   ThetaW = static_cast<double>(s) / values["a1"];
@@ -610,14 +554,48 @@ double SequenceStatistics::watterson75NonSynonymous(
 double SequenceStatistics::piSynonymous(
     const PolymorphismSequenceContainer& psc,
     const GeneticCode& gc,
-    bool minchange)
+    bool minchange,
+    bool weighted)
+{
+  CodonDifferenceTable table(gc, minchange);
+  return piSynonymous(psc, table, weighted);
+}
+
+double SequenceStatistics::piSynonymous(
+    const PolymorphismSequenceContainer& psc,
+    const CodonDifferenceTable& table,
+    bool weighted)
 {
   double S = 0.;
+  vector<size_t> buffer(table.getSize(), 0);
+  vector<pair<int, size_t>> counts;
   CompleteSiteContainerIterator si(psc);
   while (si.hasMoreSites())
   {
     const auto& site = si.nextSite();
-    S += CodonSiteTools::piSynonymous(site, gc, minchange);
+    if (!getCodonCounts_(site, psc, weighted, table, buffer, counts))
+    {
+      S += CodonSiteTools::piSynonymous(site, table.getGeneticCode(), table.getMinChange());
+      continue;
+    }
+    if (counts.size() < 2)
+      continue;
+    size_t n = 0;
+    for (const auto& c : counts)
+    {
+      n += c.second;
+    }
+    double pi = 0.;
+    for (const auto& c1 : counts)
+    {
+      for (const auto& c2 : counts)
+      {
+        if (c1.first != c2.first)
+          pi += static_cast<double>(c1.second * c2.second) * table.getNumberOfSynonymousDifferences(c1.first, c2.first);
+      }
+    }
+    // Same normalisation as CodonSiteTools::piSynonymous
+    S += pi / (static_cast<double>(n) * static_cast<double>(n - 1));
   }
   return S;
 }
@@ -625,14 +603,57 @@ double SequenceStatistics::piSynonymous(
 double SequenceStatistics::piNonSynonymous(
     const PolymorphismSequenceContainer& psc,
     const GeneticCode& gc,
-    bool minchange)
+    bool minchange,
+    bool weighted)
+{
+  CodonDifferenceTable table(gc, minchange);
+  return piNonSynonymous(psc, table, weighted);
+}
+
+double SequenceStatistics::piNonSynonymous(
+    const PolymorphismSequenceContainer& psc,
+    const CodonDifferenceTable& table,
+    bool weighted)
 {
+  const GeneticCode& gc = table.getGeneticCode();
   double S = 0.;
+  vector<size_t> buffer(table.getSize(), 0);
+  vector<pair<int, size_t>> counts;
   CompleteSiteContainerIterator si(psc);
   while (si.hasMoreSites())
   {
     const auto& site = si.nextSite();
-    S += CodonSiteTools::piNonSynonymous(site, gc, minchange);
+    if (!getCodonCounts_(site, psc, weighted, table, buffer, counts))
+    {
+      S += CodonSiteTools::piNonSynonymous(site, gc, table.getMinChange());
+      continue;
+    }
+    if (counts.size() < 2)
+      continue;
+    // Synonymous polymorphism only
+    bool synonymous = true;
+    for (size_t i = 1; synonymous && i < counts.size(); ++i)
+    {
+      synonymous = gc.areSynonymous(counts[0].first, counts[i].first);
+    }
+    if (synonymous)
+      continue;
+    size_t n = 0;
+    for (const auto& c : counts)
+    {
+      n += c.second;
+    }
+    double pi = 0.;
+    for (const auto& c1 : counts)
+    {
+      for (const auto& c2 : counts)
+      {
+        if (c1.first != c2.first)
+          pi += static_cast<double>(c1.second * c2.second) * table.getNumberOfNonSynonymousDifferences(c1.first, c2.first);
+      }
+    }
+    // Same normalisation as CodonSiteTools::piNonSynonymous
+    S += pi / (static_cast<double>(n) * static_cast<double>(n - 1));
   }
   return S;
 }
@@ -640,30 +661,83 @@ double SequenceStatistics::piNonSynonymous(
 double SequenceStatistics::meanNumberOfSynonymousSites(
     const PolymorphismSequenceContainer& psc,
     const GeneticCode& gc,
-    double ratio)
+    double ratio,
+    bool weighted)
 {
   double S = 0.;
+  // Number of synonymous positions of each codon, computed on first use
+  vector<double> positions(gc.codonAlphabet().getSize(), -1.);
   CompleteSiteContainerIterator si(psc);
   while (si.hasMoreSites())
   {
     const auto& site = si.nextSite();
-    S += CodonSiteTools::meanNumberOfSynonymousPositions(site, gc, ratio);
+    double s = 0.;
+    double n = 0.;
+    for (size_t i = 0; i < site.size(); ++i)
+    {
+      int c = site[i];
+      if (c < 0 || static_cast<size_t>(c) >= positions.size() || gc.isStop(c))
+      {
+        s = -1.;
+        break;
+      }
+      double& p = positions[static_cast<size_t>(c)];
+      if (p < 0.)
+        p = CodonSiteTools::numberOfSynonymousPositions(c, gc, ratio);
+      double w = weighted ? static_cast<double>(psc.getSequenceCount(i)) : 1.;
+      s += w * p;
+      n += w;
+    }
+    if (s < 0.)
+      S += CodonSiteTools::meanNumberOfSynonymousPositions(site, gc, ratio);
+    else
+      S += s / n;
   }
   return S;
 }
 
-double SequenceStatistics::meanNumberOfNonSynonymousSites(const PolymorphismSequenceContainer& psc, const GeneticCode& gc, double ratio)
+double SequenceStatistics::meanNumberOfSynonymousSites(
+    const PolymorphismSequenceContainer& psc,
+    const CodonDifferenceTable& table,
+    bool weighted)
 {
   double S = 0.;
-  int n = 0;
+  vector<size_t> buffer(table.getSize(), 0);
+  vector<pair<int, size_t>> counts;
   CompleteSiteContainerIterator si(psc);
   while (si.hasMoreSites())
   {
     const auto& site = si.nextSite();
-    n = n + 3;
-    S += CodonSiteTools::meanNumberOfSynonymousPositions(site, gc, ratio);
+    if (!getCodonCounts_(site, psc, weighted, table, buffer, counts))
+    {
+      S += CodonSiteTools::meanNumberOfSynonymousPositions(site, table.getGeneticCode(), table.getRatio());
+      continue;
+    }
+    double s = 0.;
+    double n = 0.;
+    for (const auto& c : counts)
+    {
+      s += static_cast<double>(c.second) * table.getNumberOfSynonymousPositions(c.first);
+      n += static_cast<double>(c.second);
+    }
+    S += s / n;
   }
-  return static_cast<double>(n - S);
+  return S;
+}
+
+double SequenceStatistics::meanNumberOfNonSynonymousSites(const PolymorphismSequenceContainer& psc, const GeneticCode& gc, double ratio, bool weighted)
+{
+  double n = 3. * static_cast<double>(PolymorphismSequenceContainerTools::getNumberOfCompleteSites(psc, false));
+  return n - meanNumberOfSynonymousSites(psc, gc, ratio, weighted);
+}
+
+double SequenceStatistics::meanNumberOfNonSynonymousSites(
+    const PolymorphismSequenceContainer& psc,
+    const CodonDifferenceTable& table,
+    bool weighted)
+{
+  double n = 3. * static_cast<double>(PolymorphismSequenceContainerTools::getNumberOfCompleteSites(psc, false));
+  return n - meanNumberOfSynonymousSites(psc, table, weighted);
 }
 
 unsigned int SequenceStatistics::numberOfSynonymousSubstitutions(const PolymorphismSequenceContainer& psc, const GeneticCode& gc, double freqmin)
@@ -723,6 +797,10 @@ vector<unsigned int> SequenceStatistics::mkTable(
     const GeneticCode& gc,
     double freqmin)
 {
+  // Outgroup sequences of the ingroup container are merged with the outgroup,
+  // which cannot be expressed as a view.
+  if (!ingroup.hasOutgroup())
+    return mkTable(PolymorphismSequenceView(ingroup), PolymorphismSequenceView(outgroup), gc, freqmin);
   PolymorphismSequenceContainer pscTot(ingroup);
   for (size_t i = 0; i < outgroup.getNumberOfSequences(); ++i)
   {
@@ -756,31 +834,113 @@ double SequenceStatistics::neutralityIndex(const PolymorphismSequenceContainer&
     return -1;
 }
 
+SequenceStatistics::PairwiseDnDs SequenceStatistics::pairwiseDnDs(
+    const PolymorphismSequenceContainer& psc,
+    const GeneticCode& gc,
+    bool jukesCantor,
+    bool minchange,
+    unsigned int nbThreads)
+{
+  CodonDifferenceTable table(gc, minchange);
+  return pairwiseDnDs(psc, table, jukesCantor, nbThreads);
+}
+
+SequenceStatistics::PairwiseDnDs SequenceStatistics::pairwiseDnDs(
+    const PolymorphismSequenceContainer& psc,
+    const CodonDifferenceTable& table,
+    bool jukesCantor,
+    unsigned int nbThreads)
+{
+  if (!AlphabetTools::isCodonAlphabet(psc.alphabet()))
+    throw AlphabetMismatchException("SequenceStatistics::pairwiseDnDs(). PolymorphismSequenceContainer must be with a codon alphabet.", &psc.alphabet(), AlphabetTools::DNA_CODON_ALPHABET.get());
+  const CodonAlphabet& codonAlphabet = table.getGeneticCode().codonAlphabet();
+  if (psc.alphabet().getAlphabetType() != codonAlphabet.getAlphabetType())
+    throw AlphabetMismatchException("SequenceStatistics::pairwiseDnDs(). The alphabet of the container does not match the genetic code of the table.", &psc.alphabet(), &codonAlphabet);
+  size_t n = psc.getNumberOfSequences();
+  size_t l = psc.getNumberOfSites();
+
+  // Sequence-major copy of the codons, with -1 for codons to skip
+  vector<int> codons(n * l, -1);
+  for (size_t k = 0; k < l; ++k)
+  {
+    const Site& site = psc.site(k);
+    for (size_t i = 0; i < n; ++i)
+    {
+      if (table.isSenseCodon(site[i]))
+        codons[i * l + k] = site[i];
+    }
+  }
+
+  auto correct = [jukesCantor](double p) {
+      if (!jukesCantor || std::isnan(p))
+        return p;
+      double x = 1. - 4. * p / 3.;
+      return x > 0. ? -0.75 * log(x) : NAN;
+    };
+
+  PairwiseDnDs dnds;
+  vector<string> names = psc.getSequenceNames();
+  dnds.dN = make_unique<DistanceMatrix>(names);
+  dnds.dS = make_unique<DistanceMatrix>(names);
+  dnds.ratio = make_unique<DistanceMatrix>(names);
+  // Row i only writes the cells (i, j) and (j, i) with j >= i, so rows are
+  // distributed between threads.
+  ParallelTools::parallelFor(n, ParallelTools::getNumberOfThreads(nbThreads, n),
+      [&](size_t i, unsigned int) {
+        (*dnds.ratio)(i, i) = NAN;
+        const int* ci = &codons[i * l];
+        for (size_t j = i + 1; j < n; ++j)
+        {
+          const int* cj = &codons[j * l];
+          double synDiff = 0., nonSynDiff = 0., synSites = 0., nonSynSites = 0.;
+          for (size_t k = 0; k < l; ++k)
+          {
+            int a = ci[k];
+            int b = cj[k];
+            if (a < 0 || b < 0)
+              continue;
+            double s = (table.getNumberOfSynonymousPositions(a) + table.getNumberOfSynonymousPositions(b)) / 2.;
+            synSites += s;
+            nonSynSites += 3. - s;
+            if (a != b)
+            {
+              synDiff += table.getNumberOfSynonymousDifferences(a, b);
+              nonSynDiff += table.getNumberOfNonSynonymousDifferences(a, b);
+            }
+          }
+          double dS = correct(synSites > 0. ? synDiff / synSites : NAN);
+          double dN = correct(nonSynSites > 0. ? nonSynDiff / nonSynSites : NAN);
+          double ratio = (dS > 0.) ? dN / dS : NAN;
+          (*dnds.dS)(i, j) = (*dnds.dS)(j, i) = dS;
+          (*dnds.dN)(i, j) = (*dnds.dN)(j, i) = dN;
+          (*dnds.ratio)(i, j) = (*dnds.ratio)(j, i) = ratio;
+        }
+      });
+  return dnds;
+}
+
 // ******************************************************************************
 // Statistical tests
 // ******************************************************************************
 
-double SequenceStatistics::tajimaDss(const PolymorphismSequenceContainer& psc, bool gapflag, bool ignoreUnknown)
+double SequenceStatistics::tajimaDss(const PolymorphismSequenceContainer& psc, bool gapflag, bool ignoreUnknown, bool weighted)
 {
   unsigned int Sp = numberOfPolymorphicSites(psc, gapflag, ignoreUnknown);
   if (Sp == 0)
     throw ZeroDivisionException("SequenceStatistics::tajimaDss. S should not be 0.");
   double S = static_cast<double>(Sp);
-  double tajima = tajima83(psc, gapflag, ignoreUnknown);
-  double watterson = watterson75(psc, gapflag, ignoreUnknown);
-  size_t n = psc.getNumberOfSequences();
-  map<string, double> values = getUsefulValues_(n);
-  return (tajima - watterson) / sqrt((values["e1"] * S) + (values["e2"] * S * (S - 1)));
+  double tajima = tajima83(psc, gapflag, ignoreUnknown, false, weighted);
+  return tajimaD_(getSampleSize_(psc, weighted), S, tajima);
 }
 
-double SequenceStatistics::tajimaDtnm(const PolymorphismSequenceContainer& psc, bool gapflag, bool ignoreUnknown)
+double SequenceStatistics::tajimaDtnm(const PolymorphismSequenceContainer& psc, bool gapflag, bool ignoreUnknown, bool weighted)
 {
   unsigned int etaP = totalNumberOfMutations(psc, gapflag);
   if (etaP == 0)
     throw ZeroDivisionException("SequenceStatistics::tajimaDtnm. Eta should not be 0.");
   double eta = static_cast<double>(etaP);
-  double tajima = tajima83(psc, gapflag, ignoreUnknown);
-  size_t n = psc.getNumberOfSequences();
+  double tajima = tajima83(psc, gapflag, ignoreUnknown, false, weighted);
+  size_t n = getSampleSize_(psc, weighted);
   map<string, double> values = getUsefulValues_(n);
   double eta_a1 = eta / values["a1"];
   return (tajima - eta_a1) / sqrt((values["e1"] * eta) + (values["e2"] * eta * (eta - 1)));
@@ -790,12 +950,9 @@ double SequenceStatistics::fuLiD(
     const PolymorphismSequenceContainer& ingroup,
     const PolymorphismSequenceContainer& outgroup,
     bool useNbSingletons,
-    bool useNbSegregatingSites)
+    bool useNbSegregatingSites,
+    bool weighted)
 {
-  size_t n = ingroup.getNumberOfSequences();
-  map<string, double> values = getUsefulValues_(n);
-  double vD = getVD_(n, values["a1"], values["a2"], values["cn"]);
-  double uD = getUD_(values["a1"], vD);
   unsigned int etaP = 0;
   if (useNbSegregatingSites)
     etaP = numberOfPolymorphicSites(ingroup);
@@ -806,22 +963,17 @@ double SequenceStatistics::fuLiD(
   double eta = static_cast<double>(etaP);
   double etae = 0.;
   if (useNbSingletons)
-    etae = static_cast<double>(numberOfSingletons(outgroup));
+    etae = static_cast<double>(numberOfSingletons(outgroup, true, weighted));
   else
-    etae = static_cast<double>(totalNumberOfMutationsOnExternalBranches(ingroup, outgroup)); // added by Khalid 13/07/2005
-  return (eta - (values["a1"] * etae)) / sqrt((uD * eta) + (vD * eta * eta));
+    etae = static_cast<double>(totalNumberOfMutationsOnExternalBranches(ingroup, outgroup, weighted)); // added by Khalid 13/07/2005
+  return fuLiD_(getSampleSize_(ingroup, weighted), eta, etae);
 }
 
 double SequenceStatistics::fuLiDStar(
     const PolymorphismSequenceContainer& group,
-    bool useNbSegregatingSites)
+    bool useNbSegregatingSites,
+    bool weighted)
 {
-  size_t n = group.getNumberOfSequences();
-  double nn = static_cast<double>(n);
-  double _n = nn / (nn - 1.);
-  map<string, double> values = getUsefulValues_(n);
-  double vDs = getVDstar_(n, values["a1"], values["a2"], values["dn"]);
-  double uDs = getUDstar_(n, values["a1"], vDs);
   unsigned int etaP = 0;
   if (useNbSegregatingSites)
     etaP = numberOfPolymorphicSites(group);
@@ -830,29 +982,18 @@ double SequenceStatistics::fuLiDStar(
   if (etaP == 0)
     throw ZeroDivisionException("eta should not be null");
   double eta = static_cast<double>(etaP);
-  double etas = static_cast<double>(numberOfSingletons(group));
-
-  // Fu & Li 1993
-  return ((_n * eta) - (values["a1"] * etas)) / sqrt(uDs * eta + vDs * eta * eta);
-
-  // Simonsen et al. 1995
-  /*
-     return ((eta / values["a1"]) - (etas * ((n - 1) / n))) / sqrt(uDs * eta + vDs * eta * eta);
-   */
+  double etas = static_cast<double>(numberOfSingletons(group, true, weighted));
+  return fuLiDStar_(getSampleSize_(group, weighted), eta, etas);
 }
 
 double SequenceStatistics::fuLiF(
     const PolymorphismSequenceContainer& ingroup,
     const PolymorphismSequenceContainer& outgroup,
     bool useNbSingletons,
-    bool useNbSegregatingSites)
+    bool useNbSegregatingSites,
+    bool weighted)
 {
-  size_t n = ingroup.getNumberOfSequences();
-  double nn = static_cast<double>(n);
-  map<string, double> values = getUsefulValues_(n);
-  double pi = tajima83(ingroup, true);
-  double vF = (values["cn"] + values["b2"] - 2. / (nn - 1.)) / (pow(values["a1"], 2) + values["a2"]);
-  double uF = ((1. + values["b1"] - (4. * ((nn + 1.) / ((nn - 1.) * (nn - 1.)))) * (values["a1n"] - (2. * nn) / (nn + 1.))) / values["a1"]) - vF;
+  double pi = tajima83(ingroup, true, true, false, weighted);
   unsigned int etaP = 0;
   if (useNbSegregatingSites)
     etaP = numberOfPolymorphicSites(ingroup);
@@ -863,27 +1004,18 @@ double SequenceStatistics::fuLiF(
   double eta = static_cast<double>(etaP);
   double etae = 0.;
   if (useNbSingletons)
-    etae = static_cast<double>(numberOfSingletons(outgroup));
+    etae = static_cast<double>(numberOfSingletons(outgroup, true, weighted));
   else
-    etae = static_cast<double>(totalNumberOfMutationsOnExternalBranches(ingroup, outgroup)); // added by Khalid 13/07/2005
-  return (pi - etae) / sqrt(uF * eta + vF * eta * eta);
+    etae = static_cast<double>(totalNumberOfMutationsOnExternalBranches(ingroup, outgroup, weighted)); // added by Khalid 13/07/2005
+  return fuLiF_(getSampleSize_(ingroup, weighted), eta, etae, pi);
 }
 
 double SequenceStatistics::fuLiFStar(
     const PolymorphismSequenceContainer& group,
-    bool useNbSegregatingSites)
+    bool useNbSegregatingSites,
+    bool weighted)
 {
-  double n = static_cast<double>(group.getNumberOfSequences());
-  map<string, double> values = getUsefulValues_(group.getNumberOfSequences());
-  double pi = tajima83(group, true);
-
-  // Fu & Li 1993
-  //  double vFs = (values["dn"] + values["b2"] - (2. / (nn - 1.)) * (4. * values["a2"] - 6. + 8. / nn)) / (pow(values["a1"], 2) + values["a2"]);
-  //  double uFs = (((nn / (nn - 1.)) + values["b1"] - (4. / (nn * (nn - 1.))) + 2. * ((nn + 1.) / (pow((nn - 1.), 2))) * (values["a1n"] - 2. * nn / (nn + 1.))) / values["a1"]) - vFs;
-
-  // Simonsen et al. 1995
-  double vFs = (((2 * n * n * n + 110 * n * n - 255 * n + 153) / (9 * n * n * (n - 1))) + ((2 * (n - 1) * values["a1"]) / (n * n)) - 8 * values["a2"] / n) / (pow(values["a1"], 2) + values["a2"]);
-  double uFs = (((4 * n * n + 19 * n + 3 - 12 * (n + 1) * values["a1n"]) / (3 * n * (n - 1))) / values["a1"]) - vFs;
+  double pi = tajima83(group, true, true, false, weighted);
   unsigned int etaP = 0;
   if (useNbSegregatingSites)
     etaP = numberOfPolymorphicSites(group);
@@ -892,44 +1024,522 @@ double SequenceStatistics::fuLiFStar(
   if (etaP == 0)
     throw ZeroDivisionException("eta should not be null");
   double eta = static_cast<double>(etaP);
-  double etas = static_cast<double>(numberOfSingletons(group));
-  // Fu & Li 1993
-  // Simonsen et al. 1995
-  return (pi - ((n - 1.) / n * etas)) / sqrt(uFs * eta + vFs * eta * eta);
+  double etas = static_cast<double>(numberOfSingletons(group, true, weighted));
+  return fuLiFStar_(getSampleSize_(group, weighted), eta, etas, pi);
 }
 
 double SequenceStatistics::fstHudson92(
     const PolymorphismSequenceContainer& psc,
     size_t id1,
-    size_t id2)
+    size_t id2,
+    bool weighted)
+{
+  PolymorphismSequenceView pop1 = PolymorphismSequenceContainerTools::getGroupView(psc, id1);
+  PolymorphismSequenceView pop2 = PolymorphismSequenceContainerTools::getGroupView(psc, id2);
+  SiteCountTable table1(pop1, weighted);
+  SiteCountTable table2(pop2, weighted);
+
+  double meanPiIntra = (tajima83(table1, false) + tajima83(table2, false)) / 2;
+
+  // Mean proportion of differences between sequences of the two
+  // populations, each pair being compared over the sites where both are
+  // resolved.
+  bool complete = true;
+  for (size_t i = 0; complete && i < table1.getNumberOfSites(); ++i)
+  {
+    complete = table1.isComplete(i) && table2.isComplete(i);
+  }
+  double meanDistance = 0.;
+  if (complete)
+  {
+    // All pairs are compared at all sites: the mean proportion is the mean
+    // over sites of the probability that two sequences differ.
+    double diff = 0.;
+    for (size_t i = 0; i < table1.getNumberOfSites(); ++i)
+    {
+      diff += getDxy_(table1, table2, i);
+    }
+    meanDistance = diff / static_cast<double>(table1.getNumberOfSites());
+  }
+  else
+  {
+    // Pairs have their own sites: compare them on the sequence-major copy.
+    shared_ptr<const SequenceMatrix> matrix = psc.getSequenceMatrix();
+    int nbStates = static_cast<int>(psc.alphabet().getSize());
+    double diff = 0., n = 0.;
+    for (size_t i = 0; i < pop1.getNumberOfSequences(); ++i)
+    {
+      const int* s1 = matrix->getSequence(pop1.getSequencePosition(i));
+      for (size_t j = 0; j < pop2.getNumberOfSequences(); ++j)
+      {
+        const int* s2 = matrix->getSequence(pop2.getSequencePosition(j));
+        size_t nbCompared = 0, nbDiff = 0;
+        for (size_t k = 0; k < matrix->getNumberOfSites(); ++k)
+        {
+          if (s1[k] < 0 || s1[k] >= nbStates || s2[k] < 0 || s2[k] >= nbStates)
+            continue;
+          nbCompared++;
+          if (s1[k] != s2[k])
+            nbDiff++;
+        }
+        double w = weighted ? static_cast<double>(pop1.getSequenceCount(i)) * static_cast<double>(pop2.getSequenceCount(j)) : 1.;
+        // A pair without common site makes the mean undefined, as before.
+        diff += w * static_cast<double>(nbDiff) / static_cast<double>(nbCompared);
+        n += w;
+      }
+    }
+    meanDistance = diff / n;
+  }
+  double piInter = meanDistance * static_cast<double>(psc.getNumberOfSites());
+
+  return 1.0 - meanPiIntra / piInter;
+}
+
+vector<double> SequenceStatistics::fstHudson92PerSite(
+    const PolymorphismSequenceContainer& psc,
+    size_t id1,
+    size_t id2,
+    bool weighted)
 {
-  vector<double> vdiff;
-  double piIntra1, piIntra2, meanPiIntra, piInter, Fst;
+  SiteCountTable table1(PolymorphismSequenceContainerTools::getGroupView(psc, id1), weighted);
+  SiteCountTable table2(PolymorphismSequenceContainerTools::getGroupView(psc, id2), weighted);
 
-  auto Pop1 = PolymorphismSequenceContainerTools::extractGroup(psc, id1);
-  auto Pop2 = PolymorphismSequenceContainerTools::extractGroup(psc, id2);
+  vector<double> fst(table1.getNumberOfSites(), numeric_limits<double>::quiet_NaN());
+  double n1 = static_cast<double>(table1.getSampleSize());
+  double n2 = static_cast<double>(table2.getSampleSize());
+  for (size_t i = 0; i < fst.size(); ++i)
+  {
+    if (!table1.isComplete(i) || !table2.isComplete(i))
+      continue;
+    double dxy = getDxy_(table1, table2, i);
+    if (!(dxy > 0.))
+      continue;
+    double same1 = 0., same2 = 0.;
+    for (size_t k = 0; k < table1.getNumberOfStates(); ++k)
+    {
+      double c1 = static_cast<double>(table1.getCount(i, k));
+      double c2 = static_cast<double>(table2.getCount(i, k));
+      same1 += c1 * (c1 - 1.);
+      same2 += c2 * (c2 - 1.);
+    }
+    double pi1 = 1. - same1 / (n1 * (n1 - 1.));
+    double pi2 = 1. - same2 / (n2 * (n2 - 1.));
+    fst[i] = 1. - (pi1 + pi2) / 2. / dxy;
+  }
+  return fst;
+}
 
-  piIntra1 = SequenceStatistics::tajima83(*Pop1, true);
-  piIntra2 = SequenceStatistics::tajima83(*Pop2, true);
+// ******************************************************************************
+// Statistics on views
+// ******************************************************************************
 
-  meanPiIntra = (piIntra1 + piIntra2) / 2;
+unsigned int SequenceStatistics::numberOfPolymorphicSites(const PolymorphismSequenceView& view)
+{
+  unsigned int s = 0;
+  map<int, size_t> counts;
+  for (size_t i = 0; i < view.getNumberOfSites(); ++i)
+  {
+    counts.clear();
+    if (getCounts_(view, i, false, counts) && counts.size() > 1)
+      s++;
+  }
+  return s;
+}
 
-  double n = 0;
-  for (size_t i = 0; i < Pop1->getNumberOfSequences(); ++i)
+unsigned int SequenceStatistics::numberOfSingletons(const PolymorphismSequenceView& view, bool weighted)
+{
+  unsigned int nus = 0;
+  map<int, size_t> counts;
+  for (size_t i = 0; i < view.getNumberOfSites(); ++i)
+  {
+    counts.clear();
+    if (!getCounts_(view, i, weighted, counts))
+      continue;
+    for (const auto& it : counts)
+    {
+      if (it.second == 1)
+        nus++;
+    }
+  }
+  return nus;
+}
+
+unsigned int SequenceStatistics::totalNumberOfMutations(const PolymorphismSequenceView& view)
+{
+  unsigned int tnm = 0;
+  map<int, size_t> counts;
+  for (size_t i = 0; i < view.getNumberOfSites(); ++i)
+  {
+    counts.clear();
+    if (getCounts_(view, i, false, counts))
+      tnm += static_cast<unsigned int>(counts.size() - 1);
+  }
+  return tnm;
+}
+
+unsigned int SequenceStatistics::totalNumberOfMutationsOnExternalBranches(
+    const PolymorphismSequenceView& ing,
+    const PolymorphismSequenceView& outg,
+    bool weighted)
+{
+  if (ing.getNumberOfSites() != outg.getNumberOfSites())
+    throw Exception("ing and outg must have the same size");
+  unsigned int nmuts = 0;
+  map<int, size_t> countsIn, countsOut;
+  for (size_t i = 0; i < ing.getNumberOfSites(); ++i)
+  {
+    countsIn.clear();
+    countsOut.clear();
+    // use fully resolved sites, with a single state in the outgroup
+    if (!getCounts_(ing, i, weighted, countsIn) || !getCounts_(outg, i, false, countsOut) || countsOut.size() != 1)
+      continue;
+    for (const auto& it : countsIn)
+    {
+      if (it.second == 1 && countsOut.find(it.first) == countsOut.end())
+        nmuts++;
+    }
+  }
+  return nmuts;
+}
+
+double SequenceStatistics::watterson75(const PolymorphismSequenceView& view, bool scaled, bool weighted)
+{
+  map<string, double> values = getUsefulValues_(view.getSampleSize(weighted));
+  double s = static_cast<double>(numberOfPolymorphicSites(view));
+  if (scaled)
+  {
+    double l = 0.;
+    map<int, size_t> counts;
+    for (size_t i = 0; i < view.getNumberOfSites(); ++i)
+    {
+      counts.clear();
+      if (getCounts_(view, i, false, counts))
+        l++;
+    }
+    s /= l;
+  }
+  return s / values["a1"];
+}
+
+double SequenceStatistics::tajima83(const PolymorphismSequenceView& view, bool scaled, bool weighted)
+{
+  double value2 = 0.;
+  double l = 0.;
+  map<int, size_t> counts;
+  for (size_t i = 0; i < view.getNumberOfSites(); ++i)
+  {
+    counts.clear();
+    if (!getCounts_(view, i, weighted, counts))
+      continue;
+    l++;
+    if (counts.size() < 2)
+      continue;
+    size_t n = 0;
+    for (const auto& it : counts)
+    {
+      n += it.second;
+    }
+    double value = 0.;
+    for (const auto& it : counts)
+    {
+      value += static_cast<double>(it.second * (it.second - 1)) / static_cast<double>(n * (n - 1));
+    }
+    value2 += 1. - value;
+  }
+  return scaled ? value2 / l : value2;
+}
+
+double SequenceStatistics::tajimaDss(const PolymorphismSequenceView& view, bool weighted)
+{
+  unsigned int Sp = numberOfPolymorphicSites(view);
+  if (Sp == 0)
+    throw ZeroDivisionException("SequenceStatistics::tajimaDss. S should not be 0.");
+  return tajimaD_(view.getSampleSize(weighted), static_cast<double>(Sp), tajima83(view, false, weighted));
+}
+
+double SequenceStatistics::fuLiD(
+    const PolymorphismSequenceView& ingroup,
+    const PolymorphismSequenceView& outgroup,
+    bool useNbSingletons,
+    bool useNbSegregatingSites,
+    bool weighted)
+{
+  unsigned int etaP = useNbSegregatingSites ? numberOfPolymorphicSites(ingroup) : totalNumberOfMutations(ingroup);
+  if (etaP == 0)
+    throw ZeroDivisionException("SequenceStatistics::fuLiD. Eta should not be 0.");
+  double etae = 0.;
+  if (useNbSingletons)
+    etae = static_cast<double>(numberOfSingletons(outgroup, weighted));
+  else
+    etae = static_cast<double>(totalNumberOfMutationsOnExternalBranches(ingroup, outgroup, weighted));
+  return fuLiD_(ingroup.getSampleSize(weighted), static_cast<double>(etaP), etae);
+}
+
+double SequenceStatistics::fuLiDStar(
+    const PolymorphismSequenceView& group,
+    bool useNbSegregatingSites,
+    bool weighted)
+{
+  unsigned int etaP = useNbSegregatingSites ? numberOfPolymorphicSites(group) : totalNumberOfMutations(group);
+  if (etaP == 0)
+    throw ZeroDivisionException("eta should not be null");
+  double etas = static_cast<double>(numberOfSingletons(group, weighted));
+  return fuLiDStar_(group.getSampleSize(weighted), static_cast<double>(etaP), etas);
+}
+
+double SequenceStatistics::fuLiF(
+    const PolymorphismSequenceView& ingroup,
+    const PolymorphismSequenceView& outgroup,
+    bool useNbSingletons,
+    bool useNbSegregatingSites,
+    bool weighted)
+{
+  double pi = tajima83(ingroup, false, weighted);
+  unsigned int etaP = useNbSegregatingSites ? numberOfPolymorphicSites(ingroup) : totalNumberOfMutations(ingroup);
+  if (etaP == 0)
+    throw ZeroDivisionException("eta should not be null");
+  double etae = 0.;
+  if (useNbSingletons)
+    etae = static_cast<double>(numberOfSingletons(outgroup, weighted));
+  else
+    etae = static_cast<double>(totalNumberOfMutationsOnExternalBranches(ingroup, outgroup, weighted));
+  return fuLiF_(ingroup.getSampleSize(weighted), static_cast<double>(etaP), etae, pi);
+}
+
+double SequenceStatistics::fuLiFStar(
+    const PolymorphismSequenceView& group,
+    bool useNbSegregatingSites,
+    bool weighted)
+{
+  double pi = tajima83(group, false, weighted);
+  unsigned int etaP = useNbSegregatingSites ? numberOfPolymorphicSites(group) : totalNumberOfMutations(group);
+  if (etaP == 0)
+    throw ZeroDivisionException("eta should not be null");
+  double etas = static_cast<double>(numberOfSingletons(group, weighted));
+  return fuLiFStar_(group.getSampleSize(weighted), static_cast<double>(etaP), etas, pi);
+}
+
+vector<unsigned int> SequenceStatistics::mkTable(
+    const PolymorphismSequenceView& ingroup,
+    const PolymorphismSequenceView& outgroup,
+    const GeneticCode& gc,
+    double freqmin)
+{
+  if (ingroup.getNumberOfSites() != outgroup.getNumberOfSites())
+    throw Exception("SequenceStatistics::mkTable: ingroup and outgroup must have the same number of sites.");
+  size_t st = 0, sns = 0, NfixS = 0, NfixA = 0;
+  for (size_t i = 0; i < ingroup.getNumberOfSites(); ++i)
+  {
+    auto siteIn = ingroup.getSite(i);
+    auto siteOut = outgroup.getSite(i);
+    if (!SiteTools::isComplete(*siteIn) || !SiteTools::isComplete(*siteOut))
+      continue;
+    st  += CodonSiteTools::numberOfSubstitutions(*siteIn, gc, freqmin);
+    sns += CodonSiteTools::numberOfNonSynonymousSubstitutions(*siteIn, gc, freqmin);
+    vector<size_t> v = CodonSiteTools::fixedDifferences(*siteIn, *siteOut, getConsensusState_(*siteIn), getConsensusState_(*siteOut), gc);
+    NfixS += v[0];
+    NfixA += v[1];
+  }
+  vector<unsigned int> v(4);
+  v[0] = static_cast<unsigned int>(sns);
+  v[1] = static_cast<unsigned int>(st - sns);
+  v[2] = static_cast<unsigned int>(NfixA);
+  v[3] = static_cast<unsigned int>(NfixS);
+  return v;
+}
+
+// ******************************************************************************
+// Statistics on site count tables
+// ******************************************************************************
+
+unsigned int SequenceStatistics::numberOfPolymorphicSites(const SiteCountTable& table)
+{
+  unsigned int s = 0;
+  for (size_t i = 0; i < table.getNumberOfSites(); ++i)
+  {
+    if (table.isComplete(i) && table.getNumberOfAlleles(i) > 1)
+      s++;
+  }
+  return s;
+}
+
+unsigned int SequenceStatistics::numberOfSingletons(const SiteCountTable& table)
+{
+  unsigned int nus = 0;
+  for (size_t i = 0; i < table.getNumberOfSites(); ++i)
+  {
+    if (!table.isComplete(i))
+      continue;
+    const unsigned int* c = table.getCounts(i);
+    for (size_t k = 0; k < table.getNumberOfStates(); ++k)
+    {
+      if (c[k] == 1)
+        nus++;
+    }
+  }
+  return nus;
+}
+
+unsigned int SequenceStatistics::totalNumberOfMutations(const SiteCountTable& table)
+{
+  unsigned int tnm = 0;
+  for (size_t i = 0; i < table.getNumberOfSites(); ++i)
+  {
+    size_t nbAlleles = table.getNumberOfAlleles(i);
+    if (table.isComplete(i) && nbAlleles > 0)
+      tnm += static_cast<unsigned int>(nbAlleles - 1);
+  }
+  return tnm;
+}
+
+double SequenceStatistics::watterson75(const SiteCountTable& table, bool scaled)
+{
+  map<string, double> values = getUsefulValues_(table.getSampleSize());
+  double s = static_cast<double>(numberOfPolymorphicSites(table));
+  if (scaled)
+  {
+    double l = 0.;
+    for (size_t i = 0; i < table.getNumberOfSites(); ++i)
+    {
+      if (table.isComplete(i))
+        l++;
+    }
+    s /= l;
+  }
+  return s / values["a1"];
+}
+
+double SequenceStatistics::tajima83(const SiteCountTable& table, bool scaled)
+{
+  double value2 = 0.;
+  double l = 0.;
+  double n = static_cast<double>(table.getSampleSize());
+  for (size_t i = 0; i < table.getNumberOfSites(); ++i)
   {
-    const Sequence& s1 = Pop1->sequence(i);
-    for (size_t j = 0; j < Pop2->getNumberOfSequences(); ++j)
+    if (!table.isComplete(i))
+      continue;
+    l++;
+    if (table.getNumberOfAlleles(i) < 2)
+      continue;
+    const unsigned int* c = table.getCounts(i);
+    double value = 0.;
+    for (size_t k = 0; k < table.getNumberOfStates(); ++k)
     {
-      n++;
-      const auto& s2 = Pop2->sequence(j);
-      vdiff.push_back(SiteContainerTools::computeSimilarity(s1, s2, true, "no gap", true));
+      double ck = static_cast<double>(c[k]);
+      value += ck * (ck - 1.) / (n * (n - 1.));
     }
+    value2 += 1. - value;
   }
-  piInter = (VectorTools::sum(vdiff) / n) * static_cast<double>(psc.getNumberOfSites());
+  return scaled ? value2 / l : value2;
+}
+
+double SequenceStatistics::tajimaDss(const SiteCountTable& table)
+{
+  unsigned int Sp = numberOfPolymorphicSites(table);
+  if (Sp == 0)
+    throw ZeroDivisionException("SequenceStatistics::tajimaDss. S should not be 0.");
+  return tajimaD_(table.getSampleSize(), static_cast<double>(Sp), tajima83(table, false));
+}
+
+double SequenceStatistics::fuLiDStar(const SiteCountTable& table, bool useNbSegregatingSites)
+{
+  unsigned int etaP = useNbSegregatingSites ? numberOfPolymorphicSites(table) : totalNumberOfMutations(table);
+  if (etaP == 0)
+    throw ZeroDivisionException("eta should not be null");
+  double etas = static_cast<double>(numberOfSingletons(table));
+  return fuLiDStar_(table.getSampleSize(), static_cast<double>(etaP), etas);
+}
 
-  Fst = 1.0 - meanPiIntra / piInter;
+double SequenceStatistics::fuLiFStar(const SiteCountTable& table, bool useNbSegregatingSites)
+{
+  unsigned int etaP = useNbSegregatingSites ? numberOfPolymorphicSites(table) : totalNumberOfMutations(table);
+  if (etaP == 0)
+    throw ZeroDivisionException("eta should not be null");
+  double etas = static_cast<double>(numberOfSingletons(table));
+  return fuLiFStar_(table.getSampleSize(), static_cast<double>(etaP), etas, tajima83(table, false));
+}
 
-  return Fst;
+double SequenceStatistics::fayWu2000(const SiteCountTable& table)
+{
+  double n = static_cast<double>(table.getSampleSize());
+  if (n < 2.)
+    return 0.;
+  double value = 0.;
+  for (size_t i = 0; i < table.getNumberOfSites(); ++i)
+  {
+    int anc = table.getAncestralState(i);
+    if (!table.isComplete(i) || anc < 0)
+      continue;
+    const unsigned int* c = table.getCounts(i);
+    for (size_t k = 0; k < table.getNumberOfStates(); ++k)
+    {
+      /* if derived allele */
+      if (static_cast<int>(k) != anc)
+      {
+        double ck = static_cast<double>(c[k]);
+        value += 2. * ck * ck / (n * (n - 1.));
+      }
+    }
+  }
+  return value;
+}
+
+// ******************************************************************************
+// Statistics with missing data
+// ******************************************************************************
+
+SequenceStatistics::MissingDataEstimates SequenceStatistics::missingDataEstimators(
+    const SiteCountTable& table,
+    size_t minSampleSize)
+{
+  SiteStatisticsAccumulator accumulator(minSampleSize);
+  accumulator.add(table);
+  return accumulator.getEstimates();
+}
+
+SequenceStatistics::MissingDataEstimates SequenceStatistics::missingDataEstimators(
+    const PolymorphismSequenceView& view,
+    bool weighted,
+    size_t minSampleSize)
+{
+  return missingDataEstimators(SiteCountTable(view, weighted), minSampleSize);
+}
+
+SequenceStatistics::MissingDataEstimates SequenceStatistics::missingDataEstimators(
+    SiteCountSource& source,
+    size_t minSampleSize)
+{
+  SiteStatisticsAccumulator accumulator(minSampleSize);
+  SiteCountTable table(0, 0);
+  accumulator.add(source, table);
+  return accumulator.getEstimates();
+}
+
+const SequenceStatistics::SampleSizeCoefficients_& SequenceStatistics::getSampleSizeCoefficients_(
+    size_t n,
+    vector<SampleSizeCoefficients_>& cache)
+{
+  if (n >= cache.size())
+    cache.resize(n + 1);
+  SampleSizeCoefficients_& coef = cache[n];
+  if (!coef.computed)
+  {
+    double nn = static_cast<double>(n);
+    map<string, double> values = getUsefulValues_(n);
+    coef.a1 = values["a1"];
+    coef.e1 = values["e1"];
+    coef.e2 = values["e2"];
+    coef.vD = getVD_(n, values["a1"], values["a2"], values["cn"]);
+    coef.uD = getUD_(values["a1"], coef.vD);
+    coef.vF = (values["cn"] + values["b2"] - 2. / (nn - 1.)) / (values["a1"] * values["a1"] + values["a2"]);
+    coef.uF = ((1. + values["b1"] - (4. * ((nn + 1.) / ((nn - 1.) * (nn - 1.)))) * (values["a1n"] - (2. * nn) / (nn + 1.))) / values["a1"]) - coef.vF;
+    coef.vDs = getVDstar_(n, values["a1"], values["a2"], values["dn"]);
+    coef.uDs = getUDstar_(n, values["a1"], coef.vDs);
+    coef.vFs = getVFstar_(n, values["a1"], values["a2"]);
+    coef.uFs = getUFstar_(n, values["a1"], values["a1n"], coef.vFs);
+    coef.computed = true;
+  }
+  return coef;
 }
 
 // ******************************************************************************
@@ -1494,11 +2104,57 @@ unsigned int SequenceStatistics::getNumberOfMutations_(const Site& site)
   return tmp_count;
 }
 
-unsigned int SequenceStatistics::getNumberOfSingletons_(const Site& site)
+void SequenceStatistics::getCounts_(
+    const Site& site,
+    const PolymorphismSequenceContainer& psc,
+    bool weighted,
+    map<int, size_t>& counts)
+{
+  if (!weighted)
+  {
+    SymbolListTools::getCounts(site, counts);
+    return;
+  }
+  for (size_t i = 0; i < site.size(); ++i)
+  {
+    counts[site[i]] += psc.getSequenceCount(i);
+  }
+}
+
+size_t SequenceStatistics::getSampleSize_(const PolymorphismSequenceContainer& psc, bool weighted)
+{
+  if (!weighted)
+    return psc.getNumberOfSequences();
+  size_t n = 0;
+  for (size_t i = 0; i < psc.getNumberOfSequences(); ++i)
+  {
+    n += psc.getSequenceCount(i);
+  }
+  return n;
+}
+
+double SequenceStatistics::getHeterozygosity_(const Site& site, const PolymorphismSequenceContainer& psc)
+{
+  map<int, size_t> counts;
+  getCounts_(site, psc, true, counts);
+  double n = static_cast<double>(getSampleSize_(psc, true));
+  double h = 1.;
+  for (const auto& it : counts)
+  {
+    double f = static_cast<double>(it.second) / n;
+    h -= f * f;
+  }
+  return h;
+}
+
+unsigned int SequenceStatistics::getNumberOfSingletons_(
+    const Site& site,
+    const PolymorphismSequenceContainer& psc,
+    bool weighted)
 {
   unsigned int nus = 0;
   map<int, size_t> states_count;
-  SymbolListTools::getCounts(site, states_count);
+  getCounts_(site, psc, weighted, states_count);
   for (map<int, size_t>::iterator it = states_count.begin(); it != states_count.end(); it++)
   {
     if (it->second == 1)
@@ -1507,12 +2163,16 @@ unsigned int SequenceStatistics::getNumberOfSingletons_(const Site& site)
   return nus;
 }
 
-unsigned int SequenceStatistics::getNumberOfDerivedSingletons_(const Site& site_in, const Site& site_out)
+unsigned int SequenceStatistics::getNumberOfDerivedSingletons_(
+    const Site& site_in,
+    const Site& site_out,
+    const PolymorphismSequenceContainer& ingroup,
+    bool weighted)
 {
   unsigned int nus = 0;
   map<int, size_t> states_count;
   map<int, size_t> outgroup_states_count;
-  SymbolListTools::getCounts(site_in, states_count);
+  getCounts_(site_in, ingroup, weighted, states_count);
   SymbolListTools::getCounts(site_out, outgroup_states_count);
   // if there is more than one variant in the outgroup we will not be able to recover the ancestral state
   if (outgroup_states_count.size() == 1)
@@ -1529,6 +2189,125 @@ unsigned int SequenceStatistics::getNumberOfDerivedSingletons_(const Site& site_
   return nus;
 }
 
+bool SequenceStatistics::getCounts_(
+    const PolymorphismSequenceView& view,
+    size_t sitePosition,
+    bool weighted,
+    map<int, size_t>& counts)
+{
+  view.getSiteCounts(sitePosition, counts, weighted);
+  int size = static_cast<int>(view.getContainer().alphabet().getSize());
+  for (const auto& it : counts)
+  {
+    if (it.first < 0 || it.first >= size)
+      return false;
+  }
+  return true;
+}
+
+int SequenceStatistics::getConsensusState_(const Site& site)
+{
+  // Same choice as SiteContainerTools::getConsensus: most frequent state,
+  // the smallest one in case of ties.
+  map<int, size_t> counts;
+  SymbolListTools::getCounts(site, counts);
+  size_t max = 0;
+  int cons = -1;
+  for (const auto& it : counts)
+  {
+    if (it.second > max && it.first != -1)
+    {
+      max = it.second;
+      cons = it.first;
+    }
+  }
+  return cons;
+}
+
+bool SequenceStatistics::getCodonCounts_(
+    const Site& site,
+    const PolymorphismSequenceContainer& psc,
+    bool weighted,
+    const CodonDifferenceTable& table,
+    vector<size_t>& buffer,
+    vector<pair<int, size_t>>& counts)
+{
+  counts.clear();
+  bool sense = true;
+  for (size_t i = 0; i < site.size(); ++i)
+  {
+    size_t count = weighted ? psc.getSequenceCount(i) : 1;
+    if (count == 0)
+      continue;
+    int c = site[i];
+    if (!table.isSenseCodon(c))
+    {
+      sense = false;
+      break;
+    }
+    if (buffer[static_cast<size_t>(c)] == 0)
+      counts.push_back(pair<int, size_t>(c, 0));
+    buffer[static_cast<size_t>(c)] += count;
+  }
+  for (auto& c : counts)
+  {
+    c.second = buffer[static_cast<size_t>(c.first)];
+    buffer[static_cast<size_t>(c.first)] = 0;
+  }
+  return sense;
+}
+
+vector<size_t> SequenceStatistics::getHaplotypeCounts_(
+    const PolymorphismSequenceContainer& psc,
+    bool gapflag,
+    bool weighted)
+{
+  shared_ptr<const SequenceMatrix> matrix = psc.getSequenceMatrix();
+  // Gapped sites are found from the sites, and skipped in the rows.
+  vector<size_t> sites;
+  bool allSites = true;
+  if (gapflag)
+  {
+    sites = GapProfile(PolymorphismSequenceView(psc)).getGapFreeSites();
+    allSites = (sites.size() == matrix->getNumberOfSites());
+  }
+  // Sort the sequences, so that identical ones are next to each other.
+  vector<size_t> order(matrix->getNumberOfSequences());
+  for (size_t i = 0; i < order.size(); ++i)
+  {
+    order[i] = i;
+  }
+  sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+    return allSites ? matrix->isLess(a, b) : matrix->isLess(a, b, sites);
+  });
+  vector<size_t> counts;
+  for (size_t k = 0; k < order.size(); ++k)
+  {
+    if (k == 0 || !(allSites ? matrix->areIdentical(order[k - 1], order[k]) : matrix->areIdentical(order[k - 1], order[k], sites)))
+      counts.push_back(0);
+    counts.back() += weighted ? psc.getSequenceCount(order[k]) : 1;
+  }
+  return counts;
+}
+
+double SequenceStatistics::getDxy_(const SiteCountTable& table1, const SiteCountTable& table2, size_t site)
+{
+  const unsigned int* counts1 = table1.getCounts(site);
+  const unsigned int* counts2 = table2.getCounts(site);
+  double n1 = 0., n2 = 0., same = 0.;
+  for (size_t k = 0; k < table1.getNumberOfStates(); ++k)
+  {
+    double c1 = static_cast<double>(counts1[k]);
+    double c2 = static_cast<double>(counts2[k]);
+    n1 += c1;
+    n2 += c2;
+    same += c1 * c2;
+  }
+  if (n1 == 0. || n2 == 0.)
+    return numeric_limits<double>::quiet_NaN();
+  return 1. - same / (n1 * n2);
+}
+
 std::map<std::string, double> SequenceStatistics::getUsefulValues_(size_t n)
 {
   double nn = static_cast<double>(n);
@@ -1576,6 +2355,62 @@ std::map<std::string, double> SequenceStatistics::getUsefulValues_(size_t n)
   return values;
 }
 
+double SequenceStatistics::tajimaD_(size_t n, double S, double pi)
+{
+  map<string, double> values = getUsefulValues_(n);
+  double watterson = S / values["a1"];
+  return (pi - watterson) / sqrt((values["e1"] * S) + (values["e2"] * S * (S - 1)));
+}
+
+double SequenceStatistics::fuLiD_(size_t n, double eta, double etae)
+{
+  map<string, double> values = getUsefulValues_(n);
+  double vD = getVD_(n, values["a1"], values["a2"], values["cn"]);
+  double uD = getUD_(values["a1"], vD);
+  return (eta - (values["a1"] * etae)) / sqrt((uD * eta) + (vD * eta * eta));
+}
+
+double SequenceStatistics::fuLiDStar_(size_t n, double eta, double etas)
+{
+  double nn = static_cast<double>(n);
+  double _n = nn / (nn - 1.);
+  map<string, double> values = getUsefulValues_(n);
+  double vDs = getVDstar_(n, values["a1"], values["a2"], values["dn"]);
+  double uDs = getUDstar_(n, values["a1"], vDs);
+
+  // Fu & Li 1993
+  return ((_n * eta) - (values["a1"] * etas)) / sqrt(uDs * eta + vDs * eta * eta);
+
+  // Simonsen et al. 1995
+  /*
+     return ((eta / values["a1"]) - (etas * ((n - 1) / n))) / sqrt(uDs * eta + vDs * eta * eta);
+   */
+}
+
+double SequenceStatistics::fuLiF_(size_t n, double eta, double etae, double pi)
+{
+  double nn = static_cast<double>(n);
+  map<string, double> values = getUsefulValues_(n);
+  double vF = (values["cn"] + values["b2"] - 2. / (nn - 1.)) / (pow(values["a1"], 2) + values["a2"]);
+  double uF = ((1. + values["b1"] - (4. * ((nn + 1.) / ((nn - 1.) * (nn - 1.)))) * (values["a1n"] - (2. * nn) / (nn + 1.))) / values["a1"]) - vF;
+  return (pi - etae) / sqrt(uF * eta + vF * eta * eta);
+}
+
+double SequenceStatistics::fuLiFStar_(size_t nn, double eta, double etas, double pi)
+{
+  double n = static_cast<double>(nn);
+  map<string, double> values = getUsefulValues_(nn);
+
+  // Fu & Li 1993
+  //  double vFs = (values["dn"] + values["b2"] - (2. / (nn - 1.)) * (4. * values["a2"] - 6. + 8. / nn)) / (pow(values["a1"], 2) + values["a2"]);
+  //  double uFs = (((nn / (nn - 1.)) + values["b1"] - (4. / (nn * (nn - 1.))) + 2. * ((nn + 1.) / (pow((nn - 1.), 2))) * (values["a1n"] - 2. * nn / (nn + 1.))) / values["a1"]) - vFs;
+
+  // Simonsen et al. 1995
+  double vFs = getVFstar_(nn, values["a1"], values["a2"]);
+  double uFs = getUFstar_(nn, values["a1"], values["a1n"], vFs);
+  return (pi - ((n - 1.) / n * etas)) / sqrt(uFs * eta + vFs * eta * eta);
+}
+
 double SequenceStatistics::getVD_(size_t n, double a1, double a2, double cn)
 {
   double nn = static_cast<double>(n);
@@ -1618,6 +2453,20 @@ double SequenceStatistics::getVDstar_(size_t n, double a1, double a2, double dn)
   return vDs;
 }
 
+double SequenceStatistics::getVFstar_(size_t nn, double a1, double a2)
+{
+  double n = static_cast<double>(nn);
+  // Simonsen et al. 1995
+  return (((2 * n * n * n + 110 * n * n - 255 * n + 153) / (9 * n * n * (n - 1))) + ((2 * (n - 1) * a1) / (n * n)) - 8 * a2 / n) / (pow(a1, 2) + a2);
+}
+
+double SequenceStatistics::getUFstar_(size_t nn, double a1, double a1n, double vFs)
+{
+  double n = static_cast<double>(nn);
+  // Simonsen et al. 1995
+  return (((4 * n * n + 19 * n + 3 - 12 * (n + 1) * a1n) / (3 * n * (n - 1))) / a1) - vFs;
+}
+
 double SequenceStatistics::getUDstar_(size_t n, double a1, double vDs)
 {
   if (n < 3)
@@ -1637,18 +2486,18 @@ double SequenceStatistics::leftHandHudson_(const PolymorphismSequenceContainer&
 {
   auto newpsc = PolymorphismSequenceContainerTools::getCompleteSites(psc);
   size_t nbseq = newpsc->getNumberOfSequences();
+  // The number of segregating sites between two complete sequences is their
+  // number of differences, read from the rows of the sequence-major copy.
+  shared_ptr<const SequenceMatrix> matrix = newpsc->getSequenceMatrix();
   double S1 = 0;
   double S2 = 0;
   for (size_t i = 0; i < nbseq - 1; ++i)
   {
     for (size_t j = i + 1; j < nbseq; ++j)
     {
-      SequenceSelection ss(2);
-      ss[0] = i;
-      ss[1] = j;
-      auto psc2 = PolymorphismSequenceContainerTools::getSelectedSequences(*newpsc, ss);
-      S1 += SequenceStatistics::watterson75(*psc2, true);
-      S2 += SequenceStatistics::watterson75(*psc2, true) * SequenceStatistics::watterson75(*psc2, true);
+      double S = static_cast<double>(matrix->getNumberOfDifferences(i, j));
+      S1 += S;
+      S2 += S * S;
     }
   }
   double Sk = (2 * S2 - pow(2 * S1 / static_cast<double>(nbseq), 2.)) / pow(nbseq, 2.);
@@ -13,26 +13,85 @@
 #include <Bpp/Seq/Container/SiteContainerIterator.h>
 #include <Bpp/Seq/Container/SiteContainer.h>
 #include <Bpp/Seq/Container/SiteContainerTools.h>
+#include <Bpp/Seq/DistanceMatrix.h>
 
+#include "CodonDifferenceTable.h"
 #include "PolymorphismSequenceContainer.h"
 #include "PolymorphismSequenceContainerTools.h"
+#include "PolymorphismSequenceView.h"
+#include "SiteCountSource.h"
+#include "SiteCountTable.h"
 
 // From the STL
 #include <string>
 #include <map>
 #include <vector>
+#include <memory>
 
 namespace bpp
 {
 using ConstSiteIterator = TemplateSiteIteratorInterface<const Site>;
 
+class MultiPopulationStatistics;
+class SiteStatisticsAccumulator;
+
 /**
  * @brief Static class providing methods to compute statistics on sequences data.
  *
+ * Estimators depending on allele frequencies take an optional weighted
+ * argument. When it is set, each sequence counts as many times as given by
+ * PolymorphismSequenceContainer::getSequenceCount, so that containers of
+ * collapsed haplotypes give the same results as the expanded ones.
+ *
  * @author Sylvain Gaillard
  */
 class SequenceStatistics
 {
+public:
+  /**
+   * @brief Pairwise dN, dS and dN/dS matrices, as returned by pairwiseDnDs.
+   */
+  struct PairwiseDnDs
+  {
+    std::unique_ptr<DistanceMatrix> dN;
+    std::unique_ptr<DistanceMatrix> dS;
+    std::unique_ptr<DistanceMatrix> ratio;
+  };
+
+  /**
+   * @brief Estimators computed with per-site sample sizes, as returned by
+   * missingDataEstimators.
+   *
+   * Tests are NaN when they are not defined (no polymorphic site or no
+   * mutation).
+   */
+  struct MissingDataEstimates
+  {
+    /** @brief The number of sites with enough resolved states. */
+    size_t nbSites;
+    /** @brief The mean number of resolved states over these sites. */
+    double meanSampleSize;
+    unsigned int nbPolymorphicSites;
+    unsigned int nbMutations;
+    unsigned int nbSingletons;
+    double thetaW;
+    double pi;
+    /** @brief Theta H, over the sites with a known ancestral state. */
+    double thetaH;
+    double tajimaD;
+    double fuLiDStar;
+    double fuLiFStar;
+    /** @brief Pi minus theta H, over the sites with a known ancestral state. */
+    double fayWuH;
+    /**
+     * @brief Fu and Li's D and F, over the sites with a known ancestral
+     * state, where the mutations on external branches are the derived
+     * singletons.
+     */
+    double fuLiD;
+    double fuLiF;
+  };
+
 public:
   /**
    * @brief Compute the number of polymorphic site in an alignment
@@ -92,11 +151,14 @@ public:
    * @param psc a PolymorphismSequenceContainer
    * @param gapflag a boolean set by default to true if you don't want to
    * take gap into account
+   * @param weighted a boolean (false by default) to weight each sequence
+   * by its count (see PolymorphismSequenceContainer::getSequenceCount)
    * @author Sylvain Gaillard
    */
   static unsigned int numberOfSingletons(
       const PolymorphismSequenceContainer& psc,
-      bool gapflag = true);
+      bool gapflag = true,
+      bool weighted = false);
 
   /**
    * @brief Count the total number of mutations in an alignment.
@@ -122,11 +184,14 @@ public:
    *
    * @param ing a PolymorphismSequenceContainer the ingroup alignment
    * @param outg a PolymorphismSequenceContainer the outgroup alignment
+   * @param weighted a boolean (false by default) to weight each sequence
+   * by its count (see PolymorphismSequenceContainer::getSequenceCount)
    * @author Khalid Belkhir
    */
   static unsigned int totalNumberOfMutationsOnExternalBranches(
       const PolymorphismSequenceContainer& ing,
-      const PolymorphismSequenceContainer& outg);
+      const PolymorphismSequenceContainer& outg,
+      bool weighted = false);
 
   /**
    * @brief Compute the number of triplet in an alignment
@@ -144,10 +209,13 @@ public:
    *
    * @param psc a PolymorphismSequenceContainer
    * @param gapflag a boolean set by default to true if you don't want to take gap into account
+   * @param weighted a boolean (false by default) to weight each sequence
+   * by its count (see PolymorphismSequenceContainer::getSequenceCount)
    */
   static double heterozygosity(
       const PolymorphismSequenceContainer& psc,
-      bool gapflag = true);
+      bool gapflag = true,
+      bool weighted = false);
 
   /**
    * @brief Compute the sum of per site squared heterozygosity in an alignment
@@ -155,10 +223,13 @@ public:
    * @param psc a PolymorphismSequenceContainer
    * @param gapflag a boolean set by default to true if you don't want
    * to take gap into account
+   * @param weighted a boolean (false by default) to weight each sequence
+   * by its count (see PolymorphismSequenceContainer::getSequenceCount)
    */
   static double squaredHeterozygosity(
       const PolymorphismSequenceContainer& psc,
-      bool gapflag = true);
+      bool gapflag = true,
+      bool weighted = false);
 
   /**
    * @brief Compute the mean GC content in an alignment
@@ -202,13 +273,16 @@ public:
    * unknown states
    * @param scaled Tell if theta should be normalized per nucleotide
    * (divided by the length of the sequence).
+   * @param weighted a boolean (false by default) to weight each sequence
+   * by its count (see PolymorphismSequenceContainer::getSequenceCount)
    * @author Sylvain Gaillard, Julien Dutheil
    */
   static double watterson75(
       const PolymorphismSequenceContainer& psc,
       bool gapflag = true,
       bool ignoreUnknown = true,
-      bool scaled = false);
+      bool scaled = false,
+      bool weighted = false);
 
   /**
    * @brief Compute diversity estimator Theta of Tajima (1983, Genetics, 105 pp437-460)
@@ -229,13 +303,16 @@ public:
    * unknown states
    * @param scaled Tell if theta should be normalized per nucleotide
    * (divided by the length of the sequence).
+   * @param weighted a boolean (false by default) to weight each sequence
+   * by its count (see PolymorphismSequenceContainer::getSequenceCount)
    * @author Sylvain Gaillard, Julien Dutheil
    */
   static double tajima83(
       const PolymorphismSequenceContainer& psc,
       bool gapflag = true,
       bool ignoreUnknown = true,
-      bool scaled = false);
+      bool scaled = false,
+      bool weighted = false);
 
   /**
    * @brief Compute diversity estimator Theta H (eq. 3) of Fay and Wu (2000, Genetics, 155: 1405-1413)
@@ -243,11 +320,14 @@ public:
    * @param psc a PolymorphismSequenceContainer
    * @param ancestralSites a Sequence containing the ancestral states
    * (reconstructed independently) to fold the mutation in the psc SequenceContainer.
+   * @param weighted a boolean (false by default) to weight each sequence
+   * by its count (see PolymorphismSequenceContainer::getSequenceCount)
      @author Benoit Nabholz
    */
   static double fayWu2000(
       const PolymorphismSequenceContainer& psc,
-      const Sequence& ancestralSites);
+      const Sequence& ancestralSites,
+      bool weighted = false);
 
   /**
    * @brief Return the number of haplotype in the sample.
@@ -257,9 +337,6 @@ public:
    * @param gapflag flag set by default to true if you don't want to
    * take gap into account
    * @author Éric Bazin
-   * @todo
-   *  - remove unneeded Sequence Container recopy
-   *  - work on Sequence rather than string
    */
   static unsigned int dvk(
       const PolymorphismSequenceContainer& psc,
@@ -273,9 +350,6 @@ public:
    * @param gapflag flag set by default to true if you don't want to
    * take gaps into account
    * @author Éric Bazin
-   * @todo
-   *  - remove unneeded Sequence Container recopy
-   *  - work on Sequence rather on string
    */
   static double dvh(
       const PolymorphismSequenceContainer& psc,
@@ -365,11 +439,14 @@ public:
    *
    * @param psc a PolymorphismSequenceContainer
    * @param gc a GeneticCode
+   * @param weighted a boolean (false by default) to weight each sequence
+   * by its count (see PolymorphismSequenceContainer::getSequenceCount)
    * @author Sylvain Glémin
    */
   static double watterson75Synonymous(
       const PolymorphismSequenceContainer& psc,
-      const GeneticCode& gc);
+      const GeneticCode& gc,
+      bool weighted = false);
 
   /**
    * @brief Compute the Watterson(1975, Theor Popul Biol, 7 pp256-276) estimator for non synonymous positions
@@ -383,11 +460,14 @@ public:
    *
    * @param psc a PolymorphismSequenceContainer
    * @param gc a GeneticCode
+   * @param weighted a boolean (false by default) to weight each sequence
+   * by its count (see PolymorphismSequenceContainer::getSequenceCount)
    * @author Sylvain Glémin
    */
   static double watterson75NonSynonymous(
       const PolymorphismSequenceContainer& psc,
-      const GeneticCode& gc);
+      const GeneticCode& gc,
+      bool weighted = false);
 
   /**
    * @brief Compute the synonymous nucleotide diversity, pi
@@ -397,17 +477,36 @@ public:
    * weighted.
    * If minchange = true the path with the minimum number of non-synonymous
    * change is chosen.
+   * Each site is reduced to its distinct codons and their counts, and codons
+   * are compared using a CodonDifferenceTable.
    *
    * @param psc a PolymorphismSequenceContainer
    * @param gc a GeneticCode
    * @param minchange a boolean set to false
+   * @param weighted a boolean (false by default) to weight each sequence
+   * by its count (see PolymorphismSequenceContainer::getSequenceCount)
    * @author Sylvain Glémin
    * @author Éric Bazin
    */
   static double piSynonymous(
       const PolymorphismSequenceContainer& psc,
       const GeneticCode& gc,
-      bool minchange = false);
+      bool minchange = false,
+      bool weighted = false);
+
+  /**
+   * @brief Same as above, with a prebuilt CodonDifferenceTable.
+   *
+   * The minchange option is the one used to build the table. Reuse the same
+   * table to avoid recomputing codon comparisons across calls.
+   *
+   * @param weighted a boolean (false by default) to weight each sequence
+   * by its count (see PolymorphismSequenceContainer::getSequenceCount)
+   */
+  static double piSynonymous(
+      const PolymorphismSequenceContainer& psc,
+      const CodonDifferenceTable& table,
+      bool weighted = false);
 
   /**
    * @brief Compute the non-synonymous nucleotide diversity, pi
@@ -417,17 +516,35 @@ public:
    * weighted.
    * If minchange = true the path with the minimum number of non-synonymous
    * change is chosen.
+   * Each site is reduced to its distinct codons and their counts, and codons
+   * are compared using a CodonDifferenceTable.
    *
    * @param psc a PolymorphismSequenceContainer
    * @param gc a GeneticCode
    * @param minchange a boolean set by default to false
+   * @param weighted a boolean (false by default) to weight each sequence
+   * by its count (see PolymorphismSequenceContainer::getSequenceCount)
    * @author Sylvain Glémin
    * @author Éric Bazin
    */
   static double piNonSynonymous(
       const PolymorphismSequenceContainer& psc,
       const GeneticCode& gc,
-      bool minchange = false);
+      bool minchange = false,
+      bool weighted = false);
+
+  /**
+   * @brief Same as above, with a prebuilt CodonDifferenceTable.
+   *
+   * The minchange option is the one used to build the table.
+   *
+   * @param weighted a boolean (false by default) to weight each sequence
+   * by its count (see PolymorphismSequenceContainer::getSequenceCount)
+   */
+  static double piNonSynonymous(
+      const PolymorphismSequenceContainer& psc,
+      const CodonDifferenceTable& table,
+      bool weighted = false);
 
   /**
    * @brief compute the mean number of synonymous site in an alignment
@@ -440,13 +557,29 @@ public:
    * @param psc a PolymorphismSequenceContainer
    * @param gc a GeneticCode
    * @param ratio a double
+   * @param weighted a boolean (false by default) to weight each sequence
+   * by its count (see PolymorphismSequenceContainer::getSequenceCount)
    * @author Sylvain Glémin
    * @author Éric Bazin
    */
   static double meanNumberOfSynonymousSites(
       const PolymorphismSequenceContainer& psc,
       const GeneticCode& gc,
-      double ratio = 1.);
+      double ratio = 1.,
+      bool weighted = false);
+
+  /**
+   * @brief Same as above, with a prebuilt CodonDifferenceTable.
+   *
+   * The ratio is the one used to build the table.
+   *
+   * @param weighted a boolean (false by default) to weight each sequence
+   * by its count (see PolymorphismSequenceContainer::getSequenceCount)
+   */
+  static double meanNumberOfSynonymousSites(
+      const PolymorphismSequenceContainer& psc,
+      const CodonDifferenceTable& table,
+      bool weighted = false);
 
   /**
    * @brief compute the mean number of non-synonymous site in an alignment
@@ -459,12 +592,28 @@ public:
    * @param psc a PolymorphismSequenceContainer
    * @param gc a GeneticCode
    * @param ratio a double
+   * @param weighted a boolean (false by default) to weight each sequence
+   * by its count (see PolymorphismSequenceContainer::getSequenceCount)
    * @author Éric Bazin
    */
   static double meanNumberOfNonSynonymousSites(
       const PolymorphismSequenceContainer& psc,
       const GeneticCode& gc,
-      double ratio = 1.);
+      double ratio = 1.,
+      bool weighted = false);
+
+  /**
+   * @brief Same as above, with a prebuilt CodonDifferenceTable.
+   *
+   * The ratio is the one used to build the table.
+   *
+   * @param weighted a boolean (false by default) to weight each sequence
+   * by its count (see PolymorphismSequenceContainer::getSequenceCount)
+   */
+  static double meanNumberOfNonSynonymousSites(
+      const PolymorphismSequenceContainer& psc,
+      const CodonDifferenceTable& table,
+      bool weighted = false);
 
   /**
    * @brief compute the number of synonymous substitutions in an alignment
@@ -565,6 +714,47 @@ public:
       const GeneticCode& gc,
       double freqmin = 0.);
 
+  /**
+   * @brief Compute pairwise synonymous and non-synonymous distances between all sequences
+   *
+   * For each pair of sequences, the numbers of synonymous and non-synonymous
+   * differences and sites are computed following Nei & Gojobori (1986,
+   * Mol. Biol. Evol. 3 pp418-426). Codons with gaps, unresolved states or
+   * stop codons in any of the two sequences are skipped for that pair.
+   * Codon comparisons are looked up in a CodonDifferenceTable.
+   *
+   * @param psc a PolymorphismSequenceContainer with a codon alphabet
+   * @param gc a GeneticCode
+   * @param jukesCantor a boolean (true by default) to apply the Jukes &
+   * Cantor correction to the proportions of differences
+   * @param minchange a boolean (false by default) passed to
+   * CodonSiteTools::numberOfSynonymousDifferences
+   * @param nbThreads The number of threads between which the rows of the
+   * matrices are distributed, or 0 to use all hardware threads.
+   * @return A PairwiseDnDs structure holding the three n x n matrices. The
+   * ratio is NaN when dS is zero, and corrected distances are NaN when
+   * saturated.
+   * @throw AlphabetMismatchException if the container does not have a codon alphabet
+   */
+  static PairwiseDnDs pairwiseDnDs(
+      const PolymorphismSequenceContainer& psc,
+      const GeneticCode& gc,
+      bool jukesCantor = true,
+      bool minchange = false,
+      unsigned int nbThreads = 1);
+
+  /**
+   * @brief Same as above, using a prebuilt CodonDifferenceTable.
+   *
+   * @throw AlphabetMismatchException if the alphabet of the container is
+   * not the codon alphabet of the genetic code of the table.
+   */
+  static PairwiseDnDs pairwiseDnDs(
+      const PolymorphismSequenceContainer& psc,
+      const CodonDifferenceTable& table,
+      bool jukesCantor = true,
+      unsigned int nbThreads = 1);
+
   /**
    * @brief Return the Tajima's D test (Tajima 1989, Genetics 123 pp 585-595).
    *
@@ -579,13 +769,16 @@ public:
    * take gap into account
    * @param ignoreUnknown a boolean set by default to true to ignore
    * unknown states
+   * @param weighted a boolean (false by default) to weight each sequence
+   * by its count (see PolymorphismSequenceContainer::getSequenceCount)
    * @throw ZeroDivisionException if S == 0
    * @author Sylvain Gaillard
    */
   static double tajimaDss(
       const PolymorphismSequenceContainer& psc,
       bool gapflag = true,
-      bool ignoreUnknown = true);
+      bool ignoreUnknown = true,
+      bool weighted = false);
 
   /**
    * @brief Return the Tajima's D test (Tajima 1989, Genetics 123 pp 585-595).
@@ -599,13 +792,16 @@ public:
    * take gap into account
    * @param ignoreUnknown a boolean set by default to true to ignore
    * unknown states
+   * @param weighted a boolean (false by default) to weight each sequence
+   * by its count (see PolymorphismSequenceContainer::getSequenceCount)
    * @throw ZeroDivisionException if eta == 0
    * @author Sylvain Gaillard
    */
   static double tajimaDtnm(
       const PolymorphismSequenceContainer& psc,
       bool gapflag = true,
-      bool ignoreUnknown = true);
+      bool ignoreUnknown = true,
+      bool weighted = false);
 
   /**
    * @brief Return the Fu and Li D test (Fu & Li 1993, Genetics, 133 pp693-709).
@@ -616,6 +812,8 @@ public:
    * external branches.
    * @param useNbSegregatingSites use the number of seggregating sites, otherwise use the total number of mutations.
    * These two quantities are identical under the infinite site model, but the number of segregating sites will underestimate the total number of mutations in case of multiple substitutions at the same site.
+   * @param weighted a boolean (false by default) to weight each sequence
+   * by its count (see PolymorphismSequenceContainer::getSequenceCount)
    * @throw ZeroDivisionException if eta == 0
    * @author Sylvain Gaillard
    * @author Khalid Belkhir
@@ -629,7 +827,8 @@ public:
       const PolymorphismSequenceContainer& ingroup,
       const PolymorphismSequenceContainer& outgroup,
       bool useNbSingletons = true,
-      bool useNbSegregatingSites = false);
+      bool useNbSegregatingSites = false,
+      bool weighted = false);
 
   /**
    * @brief Return the Fu and Li D<sup>*</sup> test (Fu & Li 1993, Genetics, 133 pp693-709).
@@ -637,12 +836,15 @@ public:
    * @param group a PolymorphismSequenceContainer
    * @param useNbSegregatingSites use the number of seggregating sites, otherwise use the total number of mutations.
    * These two quantities are identical under the infinite site model, but the number of segregating sites will underestimate the total number of mutations in case of multiple substitutions at the same site.
+   * @param weighted a boolean (false by default) to weight each sequence
+   * by its count (see PolymorphismSequenceContainer::getSequenceCount)
    * @author Sylvain Gaillard
    * @author Julien Dutheil
    */
   static double fuLiDStar(
       const PolymorphismSequenceContainer& group,
-      bool useNbSegregatingSites = false);
+      bool useNbSegregatingSites = false,
+      bool weighted = false);
 
   /**
    * @brief Return the Fu and Li F test (Fu & Li 1993, Genetics, 133 pp693-709).
@@ -654,6 +856,8 @@ public:
    * external branches.
    * @param useNbSegregatingSites use the number of seggregating sites, otherwise use the total number of mutations.
    * These two quantities are identical under the infinite site model, but the number of segregating sites will underestimate the total number of mutations in case of multiple substitutions at the same site.
+   * @param weighted a boolean (false by default) to weight each sequence
+   * by its count (see PolymorphismSequenceContainer::getSequenceCount)
    * @author Sylvain Gaillard
    * @author Khalid Belkhir
    * @author Julien Dutheil
@@ -666,7 +870,8 @@ public:
       const PolymorphismSequenceContainer& ingroup,
       const PolymorphismSequenceContainer& outgroup,
       bool useNbSingletons = true,
-      bool useNbSegregatingSites = false);
+      bool useNbSegregatingSites = false,
+      bool weighted = false);
 
   /**
    * @brief Return the Fu and Li F<sup>*</sup> test (Fu & Li 1993, Genetics, 133 pp693-709).
@@ -674,12 +879,15 @@ public:
    * @param group a PolymorphismSequenceContainer
    * @param useNbSegregatingSites use the number of seggregating sites, otherwise use the total number of mutations.
    * These two quantities are identical under the infinite site model, but the number of segregating sites will underestimate the total number of mutations in case of multiple substitutions at the same site.
+   * @param weighted a boolean (false by default) to weight each sequence
+   * by its count (see PolymorphismSequenceContainer::getSequenceCount)
    * @author Sylvain Gaillard
    * @author Julien Dutheil
    */
   static double fuLiFStar(
       const PolymorphismSequenceContainer& group,
-      bool useNbSegregatingSites);
+      bool useNbSegregatingSites,
+      bool weighted = false);
 
   /**
    * Fst of Hudson, Slatkin and Maddison
@@ -694,15 +902,272 @@ public:
    * mean number of differences between sequences sampled from the two
    * different subpopulations sampled.
    *
+   * @f$H_w@f$ is the mean of the Tajima (1983) estimators of the two
+   * populations, over the sites without gap or unresolved state in each of
+   * them. @f$H_b@f$ is the mean over all pairs of sequences of the two
+   * populations of their proportion of differences, over the sites where
+   * both are resolved, times the total number of sites. Without gap or
+   * unresolved state in the two populations, @f$H_b@f$ is computed from the
+   * state counts at each site, in time linear in the number of sequences.
+   * Otherwise pairs are compared on the sequence-major copy of the
+   * container, and the result is NaN if a pair has no resolved site in
+   * common, or if there is no site.
+   *
    * @param psc a PolymorphismSequenceContainer will at least two populations
    * @param id1 is the id of the population 1
    * @param id2 is the id of the population 2
+   * @param weighted a boolean (false by default) to weight each sequence
+   * by its count (see PolymorphismSequenceContainer::getSequenceCount)
    * @author Benoit Nabholz
    */
   static double fstHudson92(
       const PolymorphismSequenceContainer& psc,
       size_t id1,
-      size_t id2);
+      size_t id2,
+      bool weighted = false);
+
+  /**
+   * @brief Fst of Hudson, Slatkin and Maddison at each site.
+   *
+   * The per-site version of fstHudson92: @f$1 - \frac{(\pi_1 + \pi_2) / 2}{d_{xy}}@f$,
+   * where @f$\pi_1@f$ and @f$\pi_2@f$ are the probabilities that two
+   * sequences of the same population differ at the site, and @f$d_{xy}@f$
+   * the probability that two sequences of different populations differ.
+   * Per-site values are noisy; to combine sites, sum the numerators and the
+   * denominators rather than averaging the ratios.
+   *
+   * @param psc a PolymorphismSequenceContainer will at least two populations
+   * @param id1 is the id of the population 1
+   * @param id2 is the id of the population 2
+   * @param weighted a boolean (false by default) to weight each sequence
+   * by its count (see PolymorphismSequenceContainer::getSequenceCount)
+   * @return One value per site, NaN for the sites with a gap or an
+   * unresolved state in either population, or where all sequences are identical.
+   */
+  static std::vector<double> fstHudson92PerSite(
+      const PolymorphismSequenceContainer& psc,
+      size_t id1,
+      size_t id2,
+      bool weighted = false);
+
+  /**
+   * @name Statistics on views
+   *
+   * These methods compute the same statistics as their counterparts on a
+   * PolymorphismSequenceContainer, but directly on a PolymorphismSequenceView,
+   * without copying the selected sequences. Only the sites which are complete
+   * in the view are used (i.e. the gapflag = true behaviour), and sequences
+   * may be weighted by their counts in the parent container. Views can be
+   * restricted to some sites, for instance with the site selection views of
+   * PolymorphismSequenceContainerTools.
+   *
+   * @{
+   */
+
+  /**
+   * @brief Compute the number of polymorphic sites of a view.
+   */
+  static unsigned int numberOfPolymorphicSites(const PolymorphismSequenceView& view);
+
+  /**
+   * @brief Compute the number of singletons of a view.
+   */
+  static unsigned int numberOfSingletons(const PolymorphismSequenceView& view, bool weighted = false);
+
+  /**
+   * @brief Compute the total number of mutations of a view.
+   */
+  static unsigned int totalNumberOfMutations(const PolymorphismSequenceView& view);
+
+  /**
+   * @brief Compute the number of mutations on external branches of two views.
+   *
+   * @throw Exception if the two views do not have the same number of sites.
+   */
+  static unsigned int totalNumberOfMutationsOnExternalBranches(
+      const PolymorphismSequenceView& ing,
+      const PolymorphismSequenceView& outg,
+      bool weighted = false);
+
+  /**
+   * @brief Compute the Watterson (1975) estimator of theta on a view.
+   */
+  static double watterson75(
+      const PolymorphismSequenceView& view,
+      bool scaled = false,
+      bool weighted = false);
+
+  /**
+   * @brief Compute the Tajima (1983) estimator of theta on a view.
+   */
+  static double tajima83(
+      const PolymorphismSequenceView& view,
+      bool scaled = false,
+      bool weighted = false);
+
+  /**
+   * @brief Compute the Tajima's D test statistic on a view, from the number
+   * of segregating sites.
+   *
+   * @throw ZeroDivisionException if there is no polymorphic site.
+   */
+  static double tajimaDss(
+      const PolymorphismSequenceView& view,
+      bool weighted = false);
+
+  /**
+   * @brief Compute the Fu and Li D test statistic on two views.
+   */
+  static double fuLiD(
+      const PolymorphismSequenceView& ingroup,
+      const PolymorphismSequenceView& outgroup,
+      bool useNbSingletons = true,
+      bool useNbSegregatingSites = false,
+      bool weighted = false);
+
+  /**
+   * @brief Compute the Fu and Li D* test statistic on a view.
+   */
+  static double fuLiDStar(
+      const PolymorphismSequenceView& group,
+      bool useNbSegregatingSites = false,
+      bool weighted = false);
+
+  /**
+   * @brief Compute the Fu and Li F test statistic on two views.
+   */
+  static double fuLiF(
+      const PolymorphismSequenceView& ingroup,
+      const PolymorphismSequenceView& outgroup,
+      bool useNbSingletons = true,
+      bool useNbSegregatingSites = false,
+      bool weighted = false);
+
+  /**
+   * @brief Compute the Fu and Li F* test statistic on a view.
+   */
+  static double fuLiFStar(
+      const PolymorphismSequenceView& group,
+      bool useNbSegregatingSites = false,
+      bool weighted = false);
+
+  /**
+   * @brief Compute the McDonald and Kreitman table on two views of codon
+   * sequences, typically the ingroup and the outgroup of the same container.
+   *
+   * @return A vector of 4 values: Pa, Ps, Da and Ds.
+   * @throw Exception if the two views do not have the same number of sites.
+   */
+  static std::vector<unsigned int> mkTable(
+      const PolymorphismSequenceView& ingroup,
+      const PolymorphismSequenceView& outgroup,
+      const GeneticCode& gc,
+      double freqmin = 0.);
+
+  /** @} */
+
+  /**
+   * @name Statistics on site count tables
+   *
+   * These methods compute statistics from a SiteCountTable, using only its
+   * complete sites. The sample size is SiteCountTable::getSampleSize().
+   * They are mostly meant for resampling procedures, where the table is
+   * refilled for each replicate.
+   *
+   * @see SequenceResampling
+   * @{
+   */
+
+  static unsigned int numberOfPolymorphicSites(const SiteCountTable& table);
+
+  static unsigned int numberOfSingletons(const SiteCountTable& table);
+
+  static unsigned int totalNumberOfMutations(const SiteCountTable& table);
+
+  static double watterson75(const SiteCountTable& table, bool scaled = false);
+
+  static double tajima83(const SiteCountTable& table, bool scaled = false);
+
+  /**
+   * @throw ZeroDivisionException if there is no polymorphic site.
+   */
+  static double tajimaDss(const SiteCountTable& table);
+
+  /**
+   * @throw ZeroDivisionException if there is no mutation.
+   */
+  static double fuLiDStar(const SiteCountTable& table, bool useNbSegregatingSites = false);
+
+  /**
+   * @throw ZeroDivisionException if there is no mutation.
+   */
+  static double fuLiFStar(const SiteCountTable& table, bool useNbSegregatingSites = false);
+
+  /**
+   * @brief Compute the Fay and Wu (2000) estimator Theta H, using only the
+   * complete sites with a known ancestral state.
+   */
+  static double fayWu2000(const SiteCountTable& table);
+
+  /** @} */
+
+  /**
+   * @name Statistics with missing data
+   *
+   * With the gapflag option, a site with a single gap or unresolved state is
+   * discarded, which leaves few sites in low-coverage data. These methods
+   * instead compute every estimator at each site with the number n_i of
+   * resolved states at that site, in a single pass over a SiteCountTable:
+   * - theta W sums 1 / a1(n_i) over polymorphic sites,
+   * - pi and theta H use n_i in the frequency terms,
+   * - the numerators of Fu and Li's D* and F*, and of D and F over the sites
+   *   with a known ancestral state, are summed over sites with their own
+   *   coefficients,
+   * - the variance of each test is Sum_i u(n_i) x_i + (Sum_i sqrt(v(n_i)) x_i)^2,
+   *   where x_i is the number of segregating sites or of mutations at site i
+   *   (for Tajima's D, the S(S-1) term only counts distinct pairs of sites).
+   * All of these reduce to the usual formulas when no state is missing.
+   * Coefficients are computed once for each sample size found in the sites.
+   *
+   * Only the sites with at least minSampleSize resolved states are used.
+   * @{
+   */
+
+  /**
+   * @param table The site counts, with the ancestral states needed for theta
+   * H, Fay and Wu's H and Fu and Li's D and F.
+   * @param minSampleSize The minimum number of resolved states at a site
+   * (at least 2).
+   */
+  static MissingDataEstimates missingDataEstimators(
+      const SiteCountTable& table,
+      size_t minSampleSize = 2);
+
+  /**
+   * @param view The sequences and sites to use. Sites are counted in place,
+   * without copying the sequences.
+   * @param weighted If true, each sequence counts as many times as its count
+   * in the parent container.
+   * @param minSampleSize The minimum number of resolved states at a site
+   * (at least 2).
+   */
+  static MissingDataEstimates missingDataEstimators(
+      const PolymorphismSequenceView& view,
+      bool weighted = false,
+      size_t minSampleSize = 2);
+
+  /**
+   * @param source A source of site counts, read chunk by chunk from its
+   * current position, so that memory use is bounded by its chunk size.
+   * @param minSampleSize The minimum number of resolved states at a site
+   * (at least 2).
+   * @see SiteStatisticsAccumulator
+   */
+  static MissingDataEstimates missingDataEstimators(
+      SiteCountSource& source,
+      size_t minSampleSize = 2);
+
+  /** @} */
 
 
   /**
@@ -1088,15 +1553,95 @@ public:
       size_t n);
 
 private:
+  friend class MultiPopulationStatistics;
+  friend class SiteStatisticsAccumulator;
+
+  /**
+   * @brief The coefficients of the estimators for one sample size, see
+   * missingDataEstimators.
+   */
+  struct SampleSizeCoefficients_
+  {
+    bool computed = false;
+    double a1 = 0.;
+    double e1 = 0.;
+    double e2 = 0.;
+    double uD = 0.;
+    double vD = 0.;
+    double uF = 0.;
+    double vF = 0.;
+    double uDs = 0.;
+    double vDs = 0.;
+    double uFs = 0.;
+    double vFs = 0.;
+  };
+
+  static const SampleSizeCoefficients_& getSampleSizeCoefficients_(
+      size_t n,
+      std::vector<SampleSizeCoefficients_>& cache);
+
+  /**
+   * @brief Count the distinct sequences of a container.
+   *
+   * @param psc a PolymorphismSequenceContainer
+   * @param gapflag if true, only sites without gaps are compared
+   * @param weighted if true, each sequence is counted as many times as its count
+   * @return The number of sequences of each haplotype.
+   */
+  static std::vector<size_t> getHaplotypeCounts_(
+      const PolymorphismSequenceContainer& psc,
+      bool gapflag,
+      bool weighted);
+
+  /**
+   * @brief Probability that two resolved sequences taken in two tables
+   * differ at a site, or NaN if one table has none.
+   */
+  static double getDxy_(const SiteCountTable& table1, const SiteCountTable& table2, size_t site);
+
   /**
    * @brief Count the number of mutation for a site.
    */
   static unsigned int getNumberOfMutations_(const Site& site);
 
+  /**
+   * @brief Count the states of a site of a container.
+   *
+   * @param site a site of psc
+   * @param psc the container the site belongs to
+   * @param weighted if true, each state is counted as many times as the
+   * count of its sequence in psc
+   * @param counts the map where counts are added
+   */
+  static void getCounts_(
+      const Site& site,
+      const PolymorphismSequenceContainer& psc,
+      bool weighted,
+      std::map<int, size_t>& counts);
+
+  /**
+   * @return The number of sequences in a container, or the sum of their
+   * counts if weighted is true.
+   */
+  static size_t getSampleSize_(
+      const PolymorphismSequenceContainer& psc,
+      bool weighted);
+
+  /**
+   * @brief Compute the heterozygosity of a site, weighting each sequence by
+   * its count.
+   */
+  static double getHeterozygosity_(
+      const Site& site,
+      const PolymorphismSequenceContainer& psc);
+
   /**
    * @brief Count the number of singleton for a site.
    */
-  static unsigned int getNumberOfSingletons_(const Site& site);
+  static unsigned int getNumberOfSingletons_(
+      const Site& site,
+      const PolymorphismSequenceContainer& psc,
+      bool weighted);
 
   /**
    * @brief Count the number of singleton for a site.
@@ -1107,7 +1652,63 @@ private:
    */
   static unsigned getNumberOfDerivedSingletons_(
       const Site& site_in,
-      const Site& site_out);
+      const Site& site_out,
+      const PolymorphismSequenceContainer& ingroup,
+      bool weighted);
+
+  /**
+   * @brief Collapse a codon site into its distinct codons and their counts.
+   *
+   * @param site a codon site
+   * @param psc the container the site belongs to
+   * @param weighted if true, codons are weighted by the counts of their sequences
+   * @param table the CodonDifferenceTable to check codons with
+   * @param buffer a vector of table.getSize() zeros, left unchanged on return
+   * @param counts the (codon, count) pairs, in order of first occurrence.
+   * In weighted mode, sequences with a count of 0 are skipped.
+   * @return false if the site contains a codon which is not a sense codon,
+   * in which case counts is not usable.
+   */
+  static bool getCodonCounts_(
+      const Site& site,
+      const PolymorphismSequenceContainer& psc,
+      bool weighted,
+      const CodonDifferenceTable& table,
+      std::vector<size_t>& buffer,
+      std::vector<std::pair<int, size_t>>& counts);
+
+  /**
+   * @brief Count the states of a site of a view.
+   *
+   * @return false if the site contains a gap or an unresolved state in the view.
+   */
+  static bool getCounts_(
+      const PolymorphismSequenceView& view,
+      size_t sitePosition,
+      bool weighted,
+      std::map<int, size_t>& counts);
+
+  /**
+   * @return The most frequent state of a site, the smallest one in case of
+   * ties, as in SiteContainerTools::getConsensus.
+   */
+  static int getConsensusState_(const Site& site);
+
+  /**
+   * @name Core formulas of the neutrality tests
+   *
+   * @param n the sample size
+   * @param S, eta the number of segregating sites or of mutations
+   * @param etae, etas the number of mutations on external branches or of singletons
+   * @param pi the Tajima (1983) estimator of theta
+   * @{
+   */
+  static double tajimaD_(size_t n, double S, double pi);
+  static double fuLiD_(size_t n, double eta, double etae);
+  static double fuLiDStar_(size_t n, double eta, double etas);
+  static double fuLiF_(size_t n, double eta, double etae, double pi);
+  static double fuLiFStar_(size_t n, double eta, double etas, double pi);
+  /** @} */
 
   /**
    * @brief Get useful values for theta estimators.
@@ -1211,6 +1812,36 @@ private:
       double a1,
       double vDs);
 
+  /**
+   * @brief Get the vF* value of F* equation in Simonsen et al. 1995, Genetics, 141 pp413-429)
+   *
+   * @param n the number of observed sequences
+   * @param a1 as describe in getUsefulValues
+   * @param a2 as describe in getUsefulValues
+   *
+   * @return the vF* value as double
+   */
+  static double getVFstar_(
+      size_t n,
+      double a1,
+      double a2);
+
+  /**
+   * @brief Get the uF* value of F* equation in Simonsen et al. 1995, Genetics, 141 pp413-429)
+   *
+   * @param n the number of observed sequences
+   * @param a1 as describe in getUsefulValues
+   * @param a1n as describe in getUsefulValues
+   * @param vFs as provided by getVFstar_
+   *
+   * @return the uF* value as double
+   */
+  static double getUFstar_(
+      size_t n,
+      double a1,
+      double a1n,
+      double vFs);
+
   /**
    * @brief give the left hand term of equation (4) in Hudson (Hudson 1987, Genet. Res., 50 pp245-250)
    * This term is used in hudson87
@@ -0,0 +1,66 @@
+// SPDX-FileCopyrightText: The Bio++ Development Group
+//
+// SPDX-License-Identifier: CECILL-2.1
+
+#ifndef _SITECOUNTSOURCE_H_
+#define _SITECOUNTSOURCE_H_
+
+// From the STL
+#include <string>
+#include <vector>
+
+#include "SiteCountTable.h"
+
+namespace bpp
+{
+/**
+ * @brief The interface of a source of site counts read chunk by chunk.
+ *
+ * A source delivers the sites of an alignment in consecutive chunks of at
+ * most getChunkSize() sites, each chunk being written into a SiteCountTable
+ * which can be reused from one chunk to the next. Memory use is therefore
+ * bounded by the chunk size, whatever the length of the alignment, and
+ * additive estimators can be accumulated over chunks (see
+ * SiteStatisticsAccumulator).
+ */
+class SiteCountSource
+{
+public:
+  virtual ~SiteCountSource() {}
+
+public:
+  /**
+   * @return The number of sequences counted at each site.
+   */
+  virtual size_t getNumberOfSequences() const = 0;
+
+  virtual std::vector<std::string> getSequenceNames() const = 0;
+
+  /**
+   * @return The total number of sites of the alignment.
+   */
+  virtual size_t getNumberOfSites() const = 0;
+
+  /**
+   * @return The maximum number of sites in a chunk.
+   */
+  virtual size_t getChunkSize() const = 0;
+
+  /**
+   * @brief Count the next chunk of sites.
+   *
+   * @param table The table where the chunk is written. It is resized to the
+   * number of sites of the chunk.
+   * @return false if all sites have already been read, in which case the
+   * table is left unchanged.
+   */
+  virtual bool nextChunk(SiteCountTable& table) = 0;
+
+  /**
+   * @brief Go back to the first site.
+   */
+  virtual void reset() = 0;
+};
+} // end of namespace bpp;
+
+#endif // _SITECOUNTSOURCE_H_
@@ -0,0 +1,146 @@
+// SPDX-FileCopyrightText: The Bio++ Development Group
+//
+// SPDX-License-Identifier: CECILL-2.1
+
+#include "SiteCountTable.h"
+
+#include <algorithm>
+
+using namespace bpp;
+using namespace std;
+
+SiteCountTable::SiteCountTable(size_t nbSites, size_t nbStates) :
+  nbStates_(nbStates),
+  nbSites_(nbSites),
+  sampleSize_(0),
+  counts_(nbSites * nbStates, 0),
+  missing_(nbSites, 0),
+  ancestral_(nbSites, -1)
+{}
+
+/******************************************************************************/
+
+SiteCountTable::SiteCountTable(const PolymorphismSequenceView& view, bool weighted) :
+  nbStates_(view.getContainer().alphabet().getSize()),
+  nbSites_(view.getNumberOfSites()),
+  sampleSize_(0),
+  counts_(nbSites_ * nbStates_, 0),
+  missing_(nbSites_, 0),
+  ancestral_(nbSites_, -1)
+{
+  vector<unsigned int> weights(view.getNumberOfSequences(), 1);
+  if (weighted)
+  {
+    for (size_t i = 0; i < weights.size(); ++i)
+    {
+      weights[i] = view.getSequenceCount(i);
+    }
+  }
+  fill(view, weights);
+}
+
+/******************************************************************************/
+
+size_t SiteCountTable::getNumberOfAlleles(size_t site) const
+{
+  const unsigned int* c = getCounts(site);
+  size_t n = 0;
+  for (size_t k = 0; k < nbStates_; ++k)
+  {
+    if (c[k] > 0)
+      n++;
+  }
+  return n;
+}
+
+/******************************************************************************/
+
+void SiteCountTable::fill(
+    const PolymorphismSequenceView& view,
+    const vector<unsigned int>& weights)
+{
+  if (weights.size() != view.getNumberOfSequences())
+    throw BadSizeException("SiteCountTable::fill: one weight per sequence is required.", weights.size(), view.getNumberOfSequences());
+  resize_(view.getNumberOfSites(), view.getContainer().alphabet().getSize());
+  std::fill(counts_.begin(), counts_.end(), 0);
+  std::fill(missing_.begin(), missing_.end(), 0);
+  sampleSize_ = 0;
+  for (auto w : weights)
+  {
+    sampleSize_ += w;
+  }
+  const PolymorphismSequenceContainer& psc = view.getContainer();
+  int size = static_cast<int>(nbStates_);
+  for (size_t i = 0; i < nbSites_; ++i)
+  {
+    const Site& site = psc.site(view.getSitePosition(i));
+    unsigned int* c = &counts_[i * nbStates_];
+    for (size_t j = 0; j < weights.size(); ++j)
+    {
+      if (weights[j] == 0)
+        continue;
+      int state = site[view.getSequencePosition(j)];
+      if (state >= 0 && state < size)
+        c[state] += weights[j];
+      else
+        missing_[i] += weights[j];
+    }
+  }
+}
+
+/******************************************************************************/
+
+void SiteCountTable::reset(size_t nbSites, size_t nbStates, size_t sampleSize)
+{
+  resize_(nbSites, nbStates);
+  std::fill(counts_.begin(), counts_.end(), 0);
+  std::fill(missing_.begin(), missing_.end(), 0);
+  std::fill(ancestral_.begin(), ancestral_.end(), -1);
+  sampleSize_ = sampleSize;
+}
+
+/******************************************************************************/
+
+void SiteCountTable::setAncestralStates(
+    const PolymorphismSequenceView& view,
+    const Sequence& ancestralSites)
+{
+  if (ancestralSites.size() != view.getContainer().getNumberOfSites())
+    throw BadSizeException("SiteCountTable::setAncestralStates: ancestral sequence and container don't have the same size.", ancestralSites.size(), view.getContainer().getNumberOfSites());
+  int size = static_cast<int>(nbStates_);
+  for (size_t i = 0; i < nbSites_; ++i)
+  {
+    int state = ancestralSites[view.getSitePosition(i)];
+    ancestral_[i] = (state >= 0 && state < size) ? state : -1;
+  }
+}
+
+/******************************************************************************/
+
+void SiteCountTable::selectSites(
+    const SiteCountTable& source,
+    const vector<size_t>& sites)
+{
+  resize_(sites.size(), source.nbStates_);
+  sampleSize_ = source.sampleSize_;
+  for (size_t i = 0; i < sites.size(); ++i)
+  {
+    if (sites[i] >= source.nbSites_)
+      throw IndexOutOfBoundsException("SiteCountTable::selectSites.", sites[i], 0, source.nbSites_);
+    const unsigned int* c = source.getCounts(sites[i]);
+    copy(c, c + nbStates_, counts_.begin() + static_cast<ptrdiff_t>(i * nbStates_));
+    missing_[i] = source.missing_[sites[i]];
+    ancestral_[i] = source.ancestral_[sites[i]];
+  }
+}
+
+/******************************************************************************/
+
+void SiteCountTable::resize_(size_t nbSites, size_t nbStates)
+{
+  nbSites_ = nbSites;
+  nbStates_ = nbStates;
+  counts_.resize(nbSites * nbStates);
+  missing_.resize(nbSites);
+  ancestral_.resize(nbSites, -1);
+}
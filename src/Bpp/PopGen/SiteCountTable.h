@@ -0,0 +1,189 @@
+// SPDX-FileCopyrightText: The Bio++ Development Group
+//
+// SPDX-License-Identifier: CECILL-2.1
+
+#ifndef _SITECOUNTTABLE_H_
+#define _SITECOUNTTABLE_H_
+
+#include <Bpp/Exceptions.h>
+
+// From the STL
+#include <vector>
+
+#include "PolymorphismSequenceView.h"
+
+namespace bpp
+{
+/**
+ * @brief Per-site state counts of a set of sequences.
+ *
+ * The table stores, for each site, the number of sequences carrying each
+ * resolved state of the alphabet, and the number of sequences with a gap or
+ * an unresolved state. Counts are stored in a single flat array (one row of
+ * getNumberOfStates() values per site), so that a table can be refilled for
+ * every replicate of a resampling procedure without any allocation.
+ *
+ * An ancestral state can also be stored for each site, for statistics which
+ * need to orient mutations (-1 if unknown, the default).
+ *
+ * A site is complete if no sequence has a missing state at this site.
+ * As for the gapflag = true option of SequenceStatistics, statistics computed
+ * from a table only use complete sites.
+ *
+ * @see SequenceStatistics
+ * @see SequenceResampling
+ */
+class SiteCountTable
+{
+private:
+  size_t nbStates_;
+  size_t nbSites_;
+  size_t sampleSize_;
+  std::vector<unsigned int> counts_;
+  std::vector<unsigned int> missing_;
+  std::vector<int> ancestral_;
+
+public:
+  /**
+   * @brief Build an empty table.
+   *
+   * @param nbSites The number of sites.
+   * @param nbStates The number of resolved states, typically the size of the alphabet.
+   */
+  SiteCountTable(size_t nbSites, size_t nbStates);
+
+  /**
+   * @brief Build the table of a view.
+   *
+   * @param view The sequences and sites to count.
+   * @param weighted If true, each sequence is counted as many times as its
+   * count in the parent container.
+   */
+  SiteCountTable(const PolymorphismSequenceView& view, bool weighted = false);
+
+  virtual ~SiteCountTable() {}
+
+public:
+  size_t getNumberOfSites() const { return nbSites_; }
+
+  size_t getNumberOfStates() const { return nbStates_; }
+
+  /**
+   * @return The number of sequences counted at each site, including missing states.
+   */
+  size_t getSampleSize() const { return sampleSize_; }
+
+  unsigned int getCount(size_t site, size_t state) const
+  {
+    return counts_[site * nbStates_ + state];
+  }
+
+  /**
+   * @return A pointer to the getNumberOfStates() counts of a site.
+   */
+  const unsigned int* getCounts(size_t site) const
+  {
+    return &counts_[site * nbStates_];
+  }
+
+  /**
+   * @return The number of gaps and unresolved states at a site.
+   */
+  unsigned int getNumberOfMissing(size_t site) const { return missing_[site]; }
+
+  bool isComplete(size_t site) const { return missing_[site] == 0; }
+
+  /**
+   * @brief Set the count of a state at a site.
+   *
+   * The sample size is not updated, see reset().
+   */
+  void setCount(size_t site, size_t state, unsigned int count)
+  {
+    counts_[site * nbStates_ + state] = count;
+  }
+
+  /**
+   * @brief Count a state at a site.
+   *
+   * States outside [0, getNumberOfStates()) are counted as missing.
+   * The sample size is not updated, see reset().
+   */
+  void addState(size_t site, int state, unsigned int weight = 1)
+  {
+    if (state >= 0 && static_cast<size_t>(state) < nbStates_)
+      counts_[site * nbStates_ + static_cast<size_t>(state)] += weight;
+    else
+      missing_[site] += weight;
+  }
+
+  /**
+   * @return The ancestral state of a site, or -1 if unknown.
+   */
+  int getAncestralState(size_t site) const { return ancestral_[site]; }
+
+  void setAncestralState(size_t site, int state) { ancestral_[site] = state; }
+
+  /**
+   * @brief Set the ancestral states of the sites of a view.
+   *
+   * @param view The view the table was computed from.
+   * @param ancestralSites A sequence with the ancestral state of each site of
+   * the parent container of the view.
+   * @throw BadSizeException if the sequence and the parent container do not
+   * have the same number of sites.
+   */
+  void setAncestralStates(
+      const PolymorphismSequenceView& view,
+      const Sequence& ancestralSites);
+
+  /**
+   * @return The number of states observed at a site.
+   */
+  size_t getNumberOfAlleles(size_t site) const;
+
+  /**
+   * @brief Count the states of a view, each sequence being counted a given
+   * number of times.
+   *
+   * The table is resized to the number of sites of the view if needed.
+   * Ancestral states are left unchanged, so that they are kept when the
+   * same view is counted with different weights.
+   *
+   * @param view The sequences and sites to count.
+   * @param weights The number of times each sequence of the view is counted.
+   * @throw BadSizeException if the number of weights is not the number of
+   * sequences in the view.
+   */
+  void fill(
+      const PolymorphismSequenceView& view,
+      const std::vector<unsigned int>& weights);
+
+  /**
+   * @brief Resize the table and set all counts to 0 and all ancestral states to -1.
+   *
+   * @param nbSites The number of sites.
+   * @param nbStates The number of resolved states.
+   * @param sampleSize The number of sequences at each site.
+   */
+  void reset(size_t nbSites, size_t nbStates, size_t sampleSize);
+
+  /**
+   * @brief Copy some sites of another table into this one.
+   *
+   * The table is resized to the number of selected sites if needed. Sites
+   * can be selected several times, which is used by site bootstrap.
+   *
+   * @param source The table to copy sites from.
+   * @param sites The positions of the sites in source.
+   */
+  void selectSites(
+      const SiteCountTable& source,
+      const std::vector<size_t>& sites);
+
+private:
+  void resize_(size_t nbSites, size_t nbStates);
+};
+} // end of namespace bpp;
+
+#endif // _SITECOUNTTABLE_H_
@@ -0,0 +1,210 @@
+// SPDX-FileCopyrightText: The Bio++ Development Group
+//
+// SPDX-License-Identifier: CECILL-2.1
+
+#include "SiteStatisticsAccumulator.h"
+
+// From the STL
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+using namespace bpp;
+using namespace std;
+
+SiteStatisticsAccumulator::SiteStatisticsAccumulator(size_t minSampleSize) :
+  minSampleSize_(max(minSampleSize, static_cast<size_t>(2))),
+  nbSites_(0),
+  sumSampleSizes_(0.),
+  nbPolymorphicSites_(0),
+  nbMutations_(0),
+  nbSingletons_(0),
+  thetaW_(0.),
+  pi_(0.),
+  piOriented_(0.),
+  thetaH_(0.),
+  numDs_(0.), numFs_(0.),
+  linD_(0.), sqrtD_(0.), diagD_(0.),
+  linDs_(0.), sqrtDs_(0.),
+  linFs_(0.), sqrtFs_(0.),
+  nbOrientedPolymorphicSites_(0),
+  numDo_(0.), numFo_(0.),
+  linDo_(0.), sqrtDo_(0.),
+  linFo_(0.), sqrtFo_(0.),
+  coefficients_()
+{}
+
+/******************************************************************************/
+
+void SiteStatisticsAccumulator::add(const SiteCountTable& table)
+{
+  for (size_t i = 0; i < table.getNumberOfSites(); ++i)
+  {
+    const unsigned int* c = table.getCounts(i);
+    size_t n = 0, nbAlleles = 0;
+    unsigned int singletons = 0;
+    double sumSquares = 0.;
+    for (size_t k = 0; k < table.getNumberOfStates(); ++k)
+    {
+      if (c[k] == 0)
+        continue;
+      n += c[k];
+      nbAlleles++;
+      if (c[k] == 1)
+        singletons++;
+      double ck = static_cast<double>(c[k]);
+      sumSquares += ck * (ck - 1.);
+    }
+    if (n < minSampleSize_)
+      continue;
+    double nn = static_cast<double>(n);
+    nbSites_++;
+    sumSampleSizes_ += nn;
+    double pi = 1. - sumSquares / (nn * (nn - 1.));
+    pi_ += pi;
+
+    int anc = table.getAncestralState(i);
+    if (anc >= 0)
+    {
+      double h = 0.;
+      for (size_t k = 0; k < table.getNumberOfStates(); ++k)
+      {
+        /* if derived allele */
+        if (static_cast<int>(k) != anc)
+        {
+          double ck = static_cast<double>(c[k]);
+          h += 2. * ck * ck / (nn * (nn - 1.));
+        }
+      }
+      thetaH_ += h;
+      piOriented_ += pi;
+    }
+
+    if (nbAlleles < 2)
+      continue;
+    const SequenceStatistics::SampleSizeCoefficients_& coef = SequenceStatistics::getSampleSizeCoefficients_(n, coefficients_);
+    double eta = static_cast<double>(nbAlleles - 1);
+    double etas = static_cast<double>(singletons);
+    nbPolymorphicSites_++;
+    nbMutations_ += static_cast<unsigned int>(nbAlleles - 1);
+    nbSingletons_ += singletons;
+    thetaW_ += 1. / coef.a1;
+
+    linD_ += coef.e1;
+    sqrtD_ += sqrt(coef.e2);
+    diagD_ += coef.e2;
+
+    numDs_ += (nn / (nn - 1.)) * eta - coef.a1 * etas;
+    linDs_ += coef.uDs * eta;
+    sqrtDs_ += sqrt(max(coef.vDs, 0.)) * eta;
+
+    numFs_ += pi - ((nn - 1.) / nn) * etas;
+    linFs_ += coef.uFs * eta;
+    sqrtFs_ += sqrt(max(coef.vFs, 0.)) * eta;
+
+    if (anc >= 0)
+    {
+      // Mutations on external branches: derived singletons.
+      double etae = static_cast<double>(singletons);
+      if (static_cast<size_t>(anc) < table.getNumberOfStates() && c[anc] == 1)
+        etae -= 1.;
+      nbOrientedPolymorphicSites_++;
+      numDo_ += eta - coef.a1 * etae;
+      linDo_ += coef.uD * eta;
+      sqrtDo_ += sqrt(max(coef.vD, 0.)) * eta;
+      numFo_ += pi - etae;
+      linFo_ += coef.uF * eta;
+      sqrtFo_ += sqrt(max(coef.vF, 0.)) * eta;
+    }
+  }
+}
+
+/******************************************************************************/
+
+void SiteStatisticsAccumulator::add(SiteCountSource& source, SiteCountTable& table)
+{
+  while (source.nextChunk(table))
+  {
+    add(table);
+  }
+}
+
+/******************************************************************************/
+
+void SiteStatisticsAccumulator::add(const SiteStatisticsAccumulator& accumulator)
+{
+  if (accumulator.minSampleSize_ != minSampleSize_)
+    throw Exception("SiteStatisticsAccumulator::add: accumulators do not have the same minimum sample size.");
+  nbSites_ += accumulator.nbSites_;
+  sumSampleSizes_ += accumulator.sumSampleSizes_;
+  nbPolymorphicSites_ += accumulator.nbPolymorphicSites_;
+  nbMutations_ += accumulator.nbMutations_;
+  nbSingletons_ += accumulator.nbSingletons_;
+  thetaW_ += accumulator.thetaW_;
+  pi_ += accumulator.pi_;
+  piOriented_ += accumulator.piOriented_;
+  thetaH_ += accumulator.thetaH_;
+  numDs_ += accumulator.numDs_;
+  numFs_ += accumulator.numFs_;
+  linD_ += accumulator.linD_;
+  sqrtD_ += accumulator.sqrtD_;
+  diagD_ += accumulator.diagD_;
+  linDs_ += accumulator.linDs_;
+  sqrtDs_ += accumulator.sqrtDs_;
+  linFs_ += accumulator.linFs_;
+  sqrtFs_ += accumulator.sqrtFs_;
+  nbOrientedPolymorphicSites_ += accumulator.nbOrientedPolymorphicSites_;
+  numDo_ += accumulator.numDo_;
+  numFo_ += accumulator.numFo_;
+  linDo_ += accumulator.linDo_;
+  sqrtDo_ += accumulator.sqrtDo_;
+  linFo_ += accumulator.linFo_;
+  sqrtFo_ += accumulator.sqrtFo_;
+}
+
+/******************************************************************************/
+
+void SiteStatisticsAccumulator::clear()
+{
+  *this = SiteStatisticsAccumulator(minSampleSize_);
+}
+
+/******************************************************************************/
+
+SequenceStatistics::MissingDataEstimates SiteStatisticsAccumulator::getEstimates() const
+{
+  double nan = numeric_limits<double>::quiet_NaN();
+  SequenceStatistics::MissingDataEstimates est;
+  est.nbSites = nbSites_;
+  est.meanSampleSize = nbSites_ > 0 ? sumSampleSizes_ / static_cast<double>(nbSites_) : 0.;
+  est.nbPolymorphicSites = nbPolymorphicSites_;
+  est.nbMutations = nbMutations_;
+  est.nbSingletons = nbSingletons_;
+  est.thetaW = thetaW_;
+  est.pi = pi_;
+  est.thetaH = thetaH_;
+  est.fayWuH = piOriented_ - thetaH_;
+  if (nbPolymorphicSites_ > 0)
+  {
+    est.tajimaD = (pi_ - thetaW_) / sqrt(linD_ + sqrtD_ * sqrtD_ - diagD_);
+    est.fuLiDStar = numDs_ / sqrt(linDs_ + sqrtDs_ * sqrtDs_);
+    est.fuLiFStar = numFs_ / sqrt(linFs_ + sqrtFs_ * sqrtFs_);
+  }
+  else
+  {
+    est.tajimaD = nan;
+    est.fuLiDStar = nan;
+    est.fuLiFStar = nan;
+  }
+  if (nbOrientedPolymorphicSites_ > 0)
+  {
+    est.fuLiD = numDo_ / sqrt(linDo_ + sqrtDo_ * sqrtDo_);
+    est.fuLiF = numFo_ / sqrt(linFo_ + sqrtFo_ * sqrtFo_);
+  }
+  else
+  {
+    est.fuLiD = nan;
+    est.fuLiF = nan;
+  }
+  return est;
+}
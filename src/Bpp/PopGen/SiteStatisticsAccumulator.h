@@ -0,0 +1,103 @@
+// SPDX-FileCopyrightText: The Bio++ Development Group
+//
+// SPDX-License-Identifier: CECILL-2.1
+
+#ifndef _SITESTATISTICSACCUMULATOR_H_
+#define _SITESTATISTICSACCUMULATOR_H_
+
+// From the STL
+#include <vector>
+
+#include "SequenceStatistics.h"
+#include "SiteCountSource.h"
+#include "SiteCountTable.h"
+
+namespace bpp
+{
+/**
+ * @brief Accumulate the site-additive terms of the neutrality estimators.
+ *
+ * Theta W, pi, theta H, the numbers of segregating sites, mutations and
+ * singletons, and the terms of the variances of Tajima's D and Fu and Li's
+ * D*, F*, D and F are all sums over sites. They can therefore be accumulated over
+ * chunks of sites, read one after the other from a SiteCountSource, and the
+ * tests computed at the end. Accumulators built over different parts of an
+ * alignment can also be merged.
+ *
+ * Estimators are computed with the per-site sample sizes, as described in
+ * SequenceStatistics::missingDataEstimators, over the sites with at least
+ * minSampleSize resolved states. Setting minSampleSize to the number of
+ * sequences restricts them to complete sites, and gives the same values as
+ * the SiteCountTable overloads of SequenceStatistics.
+ */
+class SiteStatisticsAccumulator
+{
+private:
+  size_t minSampleSize_;
+  size_t nbSites_;
+  double sumSampleSizes_;
+  unsigned int nbPolymorphicSites_;
+  unsigned int nbMutations_;
+  unsigned int nbSingletons_;
+  double thetaW_;
+  double pi_;
+  double piOriented_;
+  double thetaH_;
+  // Numerators and variance terms of the tests.
+  double numDs_, numFs_;
+  double linD_, sqrtD_, diagD_;
+  double linDs_, sqrtDs_;
+  double linFs_, sqrtFs_;
+  // The same for Fu and Li's D and F, over the sites with a known ancestral state.
+  unsigned int nbOrientedPolymorphicSites_;
+  double numDo_, numFo_;
+  double linDo_, sqrtDo_;
+  double linFo_, sqrtFo_;
+  std::vector<SequenceStatistics::SampleSizeCoefficients_> coefficients_;
+
+public:
+  /**
+   * @param minSampleSize The minimum number of resolved states at a site
+   * (at least 2).
+   */
+  explicit SiteStatisticsAccumulator(size_t minSampleSize = 2);
+
+  virtual ~SiteStatisticsAccumulator() {}
+
+public:
+  size_t getMinimumSampleSize() const { return minSampleSize_; }
+
+  /**
+   * @brief Add the sites of a table.
+   */
+  void add(const SiteCountTable& table);
+
+  /**
+   * @brief Add all the remaining sites of a source, chunk by chunk.
+   *
+   * @param source The source to read.
+   * @param table The table used to read chunks, which is reused for each chunk.
+   */
+  void add(SiteCountSource& source, SiteCountTable& table);
+
+  /**
+   * @brief Add the sites accumulated by another accumulator.
+   *
+   * @throw Exception if the two accumulators do not have the same minimum
+   * sample size.
+   */
+  void add(const SiteStatisticsAccumulator& accumulator);
+
+  /**
+   * @brief Remove all sites.
+   */
+  void clear();
+
+  /**
+   * @return The estimators over all the sites added so far.
+   */
+  SequenceStatistics::MissingDataEstimates getEstimates() const;
+};
+} // end of namespace bpp;
+
+#endif // _SITESTATISTICSACCUMULATOR_H_
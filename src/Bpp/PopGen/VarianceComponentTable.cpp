@@ -0,0 +1,232 @@
+// SPDX-FileCopyrightText: The Bio++ Development Group
+//
+// SPDX-License-Identifier: CECILL-2.1
+
+#include "ParallelTools.h"
+#include "VarianceComponentTable.h"
+
+// From the STL
+#include <cmath>
+
+using namespace bpp;
+using namespace std;
+
+VarianceComponentTable::VarianceComponentTable(const AlleleCountTable& table, const set<size_t>& groups, unsigned int nbThreads) :
+  groups_(groups),
+  nbLoci_(table.getNumberOfLoci()),
+  alleleOffsets_(1, 0),
+  alleleKeys_(),
+  components_(),
+  frequencies_(),
+  polymorphic_(table.getNumberOfLoci(), 0),
+  defined_(table.getNumberOfLoci(), 0),
+  groupIndices_(table.getGroupIndices(groups)),
+  alleles_(),
+  values_()
+{
+  for (size_t l = 0; l < nbLoci_; ++l)
+  {
+    for (size_t a = 0; a < table.getNumberOfAlleles(l); ++a)
+    {
+      alleleKeys_.push_back(table.getAlleleKey(l, a));
+    }
+    alleleOffsets_.push_back(alleleKeys_.size());
+  }
+  components_.resize(alleleKeys_.size());
+  frequencies_.resize(alleleKeys_.size());
+
+  vector<size_t> loci(nbLoci_);
+  for (size_t l = 0; l < nbLoci_; ++l)
+  {
+    loci[l] = l;
+  }
+  update(table, loci, nbThreads);
+}
+
+/******************************************************************************/
+
+void VarianceComponentTable::update(const AlleleCountTable& table, const vector<size_t>& loci, unsigned int nbThreads)
+{
+  for (auto l : loci)
+  {
+    if (l >= nbLoci_)
+      throw IndexOutOfBoundsException("VarianceComponentTable::update: locusPosition out of bounds.", l, 0, nbLoci_);
+  }
+  nbThreads = ParallelTools::getNumberOfThreads(nbThreads, loci.size());
+  if (alleles_.size() < nbThreads)
+  {
+    alleles_.resize(nbThreads);
+    values_.resize(nbThreads);
+  }
+  ParallelTools::parallelFor(loci.size(), nbThreads,
+      [&](size_t i, unsigned int t) {
+        size_t l = loci[i];
+        vector<size_t>& alleles = alleles_[t];
+        vector<MultilocusGenotypeStatistics::VarComp>& values = values_[t];
+        size_t offset = alleleOffsets_[l];
+        size_t nbAlleles = getNumberOfAlleles(l);
+        double total = 0.;
+        for (size_t a = 0; a < nbAlleles; ++a)
+        {
+          components_[offset + a] = {0., 0., 0.};
+          frequencies_[offset + a] = 0.;
+          for (auto g : groupIndices_)
+          {
+            frequencies_[offset + a] += table.getAlleleCount(l, a, g);
+          }
+          total += frequencies_[offset + a];
+        }
+        for (size_t a = 0; a < nbAlleles && total > 0.; ++a)
+        {
+          frequencies_[offset + a] /= total;
+        }
+
+        MultilocusGenotypeStatistics::getAlleles_(table, l, groupIndices_, alleles);
+        polymorphic_[l] = alleles.size() >= 2;
+        defined_[l] = true;
+        if (!polymorphic_[l])
+          return;
+        try
+        {
+          MultilocusGenotypeStatistics::getVarianceComponents_(table, l, groupIndices_, groups_.size(), alleles, values);
+        }
+        catch (ZeroDivisionException&)
+        {
+          defined_[l] = false;
+          return;
+        }
+        for (size_t k = 0; k < alleles.size(); ++k)
+        {
+          components_[offset + alleles[k]] = values[k];
+        }
+      });
+}
+
+/******************************************************************************/
+
+MultilocusGenotypeStatistics::Fstats VarianceComponentTable::getAlleleFstats(size_t locus, size_t allele) const
+{
+  const MultilocusGenotypeStatistics::VarComp& v = getVarianceComponents(locus, allele);
+  double abc = v.a + v.b + v.c;
+  double bc = v.b + v.c;
+  MultilocusGenotypeStatistics::Fstats f;
+  f.Fit = abc == 0 ? NAN : 1. - v.c / abc;
+  f.Fst = abc == 0 ? NAN : v.a / abc;
+  f.Fis = bc == 0 ? NAN : 1. - v.c / bc;
+  return f;
+}
+
+/******************************************************************************/
+
+MultilocusGenotypeStatistics::VarComp VarianceComponentTable::getSumOfVarianceComponents(const vector<size_t>& locusPositions) const
+{
+  return sumVarianceComponents_(locusPositions, "VarianceComponentTable::getSumOfVarianceComponents");
+}
+
+/******************************************************************************/
+
+MultilocusGenotypeStatistics::VarComp VarianceComponentTable::sumVarianceComponents_(
+    const vector<size_t>& locusPositions,
+    const string& method) const
+{
+  MultilocusGenotypeStatistics::VarComp sums = {0., 0., 0.};
+  for (auto l : locusPositions)
+  {
+    checkLocus_(l, method);
+    if (!polymorphic_[l])
+      continue;
+    for (size_t i = alleleOffsets_[l]; i < alleleOffsets_[l + 1]; ++i)
+    {
+      sums.a += components_[i].a;
+      sums.b += components_[i].b;
+      sums.c += components_[i].c;
+    }
+  }
+  return sums;
+}
+
+/******************************************************************************/
+
+MultilocusGenotypeStatistics::Fstats VarianceComponentTable::getFstats(const vector<size_t>& locusPositions) const
+{
+  MultilocusGenotypeStatistics::VarComp sums = sumVarianceComponents_(locusPositions, "VarianceComponentTable::getFstats");
+  double abc = sums.a + sums.b + sums.c;
+  double bc = sums.b + sums.c;
+  MultilocusGenotypeStatistics::Fstats f;
+  f.Fit = abc == 0 ? NAN : 1. - sums.c / abc;
+  f.Fst = abc == 0 ? NAN : sums.a / abc;
+  f.Fis = bc == 0 ? NAN : 1. - sums.c / bc;
+  return f;
+}
+
+/******************************************************************************/
+
+double VarianceComponentTable::getFst(const vector<size_t>& locusPositions) const
+{
+  MultilocusGenotypeStatistics::VarComp sums = sumVarianceComponents_(locusPositions, "VarianceComponentTable::getFst");
+  if ((sums.a + sums.b + sums.c) == 0)
+    throw ZeroDivisionException("VarianceComponentTable::getFst.");
+  return sums.a / (sums.a + sums.b + sums.c);
+}
+
+/******************************************************************************/
+
+double VarianceComponentTable::getFis(const vector<size_t>& locusPositions) const
+{
+  MultilocusGenotypeStatistics::VarComp sums = sumVarianceComponents_(locusPositions, "VarianceComponentTable::getFis");
+  if ((sums.b + sums.c) == 0)
+    throw ZeroDivisionException("VarianceComponentTable::getFis.");
+  return 1.0 - sums.c / (sums.b + sums.c);
+}
+
+/******************************************************************************/
+
+double VarianceComponentTable::getFit(const vector<size_t>& locusPositions) const
+{
+  MultilocusGenotypeStatistics::VarComp sums = sumVarianceComponents_(locusPositions, "VarianceComponentTable::getFit");
+  if ((sums.a + sums.b + sums.c) == 0)
+    throw ZeroDivisionException("VarianceComponentTable::getFit.");
+  return 1.0 - sums.c / (sums.a + sums.b + sums.c);
+}
+
+/******************************************************************************/
+
+double VarianceComponentTable::getRHFst(const vector<size_t>& locusPositions) const
+{
+  double RH = 0.;
+  double nbAlleles = 0.;
+  for (auto l : locusPositions)
+  {
+    checkLocus_(l, "VarianceComponentTable::getRHFst");
+    if (!polymorphic_[l])
+      continue;
+    // Fst of each allele weighted by 1 - its mean frequency, and the
+    // number of independent alleles
+    double locusRH = 0.;
+    int locusAlleles = 0;
+    for (size_t i = alleleOffsets_[l]; i < alleleOffsets_[l + 1]; ++i)
+    {
+      double abc = components_[i].a + components_[i].b + components_[i].c;
+      if (abc != 0)
+      {
+        locusRH += (1 - frequencies_[i]) * components_[i].a / abc;
+        locusAlleles++;
+      }
+    }
+    RH += locusRH;
+    nbAlleles += locusAlleles - 1.;
+  }
+  if (nbAlleles == 0)
+    throw ZeroDivisionException("VarianceComponentTable::getRHFst.");
+  return RH / nbAlleles;
+}
+
+/******************************************************************************/
+
+void VarianceComponentTable::checkLocus_(size_t locusPosition, const string& method) const
+{
+  if (locusPosition >= nbLoci_)
+    throw IndexOutOfBoundsException(method + ": locusPosition out of bounds.", locusPosition, 0, nbLoci_);
+  if (!defined_[locusPosition])
+    throw ZeroDivisionException(method + ".");
+}
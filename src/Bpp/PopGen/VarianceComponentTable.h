@@ -0,0 +1,202 @@
+// SPDX-FileCopyrightText: The Bio++ Development Group
+//
+// SPDX-License-Identifier: CECILL-2.1
+
+#ifndef _VARIANCECOMPONENTTABLE_H_
+#define _VARIANCECOMPONENTTABLE_H_
+
+#include <Bpp/Exceptions.h>
+
+// From the STL
+#include <set>
+#include <string>
+#include <vector>
+
+#include "AlleleCountTable.h"
+#include "MultilocusGenotypeStatistics.h"
+
+namespace bpp
+{
+/**
+ * @brief Variance components of Weir and Cockerham (1984) at all loci for a set of groups.
+ *
+ * The variance components a, b and c are computed once for each (locus,
+ * allele) pair from an AlleleCountTable, and stored in a flat array with
+ * the alleles of the table. The multilocus F-statistics of any set of loci,
+ * Robertson and Hill's Fst, and the per-locus and per-allele values are
+ * then sums over this array, without computing the components again.
+ *
+ * Loci which are monomorphic in the groups have all their components equal
+ * to 0, and are ignored by multilocus statistics as in
+ * MultilocusGenotypeStatistics. Loci at which the components cannot be
+ * computed (a group has no allele or no bi-allelic genotype, or the mean
+ * group size is not above 1) are undefined: statistics including them
+ * throw a ZeroDivisionException, as getVarianceComponents does.
+ *
+ * @see MultilocusGenotypeStatistics::getVarianceComponentTable
+ */
+class VarianceComponentTable
+{
+private:
+  std::set<size_t> groups_;
+  size_t nbLoci_;
+  std::vector<size_t> alleleOffsets_;
+  std::vector<size_t> alleleKeys_;
+  std::vector<MultilocusGenotypeStatistics::VarComp> components_;
+  std::vector<double> frequencies_;
+  // Not std::vector<bool>, whose elements cannot be written concurrently.
+  std::vector<char> polymorphic_;
+  std::vector<char> defined_;
+  std::vector<size_t> groupIndices_;
+  // Scratch buffers of each thread of update.
+  std::vector<std::vector<size_t>> alleles_;
+  std::vector<std::vector<MultilocusGenotypeStatistics::VarComp>> values_;
+
+public:
+  /**
+   * @param table The allele counts.
+   * @param groups The ids of the groups.
+   * @param nbThreads The number of threads, or 0 to use all hardware threads.
+   */
+  VarianceComponentTable(const AlleleCountTable& table, const std::set<size_t>& groups, unsigned int nbThreads = 1);
+
+  virtual ~VarianceComponentTable() {}
+
+public:
+  /**
+   * @brief Compute again the components of some loci.
+   *
+   * This is used by permutation tests, after the counts of a table have
+   * been updated with AlleleCountTable::recount. The table must have the
+   * alleles and groups of the one this object was built from.
+   *
+   * Loci may be distributed between several threads, each with its own
+   * scratch buffers, as each locus only writes its own components. The
+   * buffers are kept between calls, so that updating the same loci again
+   * does not allocate memory.
+   *
+   * @param table The allele counts.
+   * @param loci The loci to compute.
+   * @param nbThreads The number of threads, or 0 to use all hardware threads.
+   * @throw IndexOutOfBoundsException if a locus position is out of range.
+   */
+  void update(const AlleleCountTable& table, const std::vector<size_t>& loci, unsigned int nbThreads = 1);
+
+  size_t getNumberOfLoci() const { return nbLoci_; }
+
+  const std::set<size_t>& getGroups() const { return groups_; }
+
+  /**
+   * @return The number of alleles at a locus, with the alleles absent from
+   * the groups, whose components are 0.
+   */
+  size_t getNumberOfAlleles(size_t locus) const
+  {
+    return alleleOffsets_[locus + 1] - alleleOffsets_[locus];
+  }
+
+  /**
+   * @return The key of the allele with a given index at a locus.
+   */
+  size_t getAlleleKey(size_t locus, size_t allele) const
+  {
+    return alleleKeys_[alleleOffsets_[locus] + allele];
+  }
+
+  /**
+   * @return The frequency of an allele in all groups pooled.
+   */
+  double getAlleleFrequency(size_t locus, size_t allele) const
+  {
+    return frequencies_[alleleOffsets_[locus] + allele];
+  }
+
+  /**
+   * @return true if at least two alleles are present in the groups at a locus.
+   */
+  bool isPolymorphic(size_t locus) const { return polymorphic_[locus] != 0; }
+
+  /**
+   * @return true if the components of a locus could be computed.
+   */
+  bool isDefined(size_t locus) const { return defined_[locus] != 0; }
+
+  /**
+   * @return The components of an allele at a locus.
+   */
+  const MultilocusGenotypeStatistics::VarComp& getVarianceComponents(size_t locus, size_t allele) const
+  {
+    return components_[alleleOffsets_[locus] + allele];
+  }
+
+  /**
+   * @return The F-statistics of an allele at a locus, NaN if not defined,
+   * as in MultilocusGenotypeStatistics::getAllelesFstats.
+   */
+  MultilocusGenotypeStatistics::Fstats getAlleleFstats(size_t locus, size_t allele) const;
+
+  /**
+   * @brief Sum the components of all alleles over some loci.
+   *
+   * @throw IndexOutOfBoundsException if a locus position is out of range.
+   * @throw ZeroDivisionException if a locus is undefined.
+   */
+  MultilocusGenotypeStatistics::VarComp getSumOfVarianceComponents(const std::vector<size_t>& locusPositions) const;
+
+  /**
+   * @brief The multilocus F-statistics of some loci, NaN if not defined.
+   *
+   * @throw IndexOutOfBoundsException if a locus position is out of range.
+   * @throw ZeroDivisionException if a locus is undefined.
+   */
+  MultilocusGenotypeStatistics::Fstats getFstats(const std::vector<size_t>& locusPositions) const;
+
+  /**
+   * @brief The multilocus @f$\theta_{WC}@f$ of some loci, as MultilocusGenotypeStatistics::getWCMultilocusFst.
+   *
+   * @throw IndexOutOfBoundsException if a locus position is out of range.
+   * @throw ZeroDivisionException if a locus is undefined or all loci are monomorphic.
+   */
+  double getFst(const std::vector<size_t>& locusPositions) const;
+
+  /**
+   * @brief The multilocus Fis of some loci, as MultilocusGenotypeStatistics::getWCMultilocusFis.
+   *
+   * @throw IndexOutOfBoundsException if a locus position is out of range.
+   * @throw ZeroDivisionException if a locus is undefined or all loci are monomorphic.
+   */
+  double getFis(const std::vector<size_t>& locusPositions) const;
+
+  /**
+   * @brief The multilocus Fit of some loci.
+   *
+   * @throw IndexOutOfBoundsException if a locus position is out of range.
+   * @throw ZeroDivisionException if a locus is undefined or all loci are monomorphic.
+   */
+  double getFit(const std::vector<size_t>& locusPositions) const;
+
+  /**
+   * @brief The multilocus @f$\theta_{RH}@f$ of some loci, as MultilocusGenotypeStatistics::getRHMultilocusFst.
+   *
+   * @throw IndexOutOfBoundsException if a locus position is out of range.
+   * @throw ZeroDivisionException if a locus is undefined or all loci are monomorphic.
+   */
+  double getRHFst(const std::vector<size_t>& locusPositions) const;
+
+private:
+  /**
+   * @brief Sum the components of all alleles over some loci, see getSumOfVarianceComponents.
+   */
+  MultilocusGenotypeStatistics::VarComp sumVarianceComponents_(
+      const std::vector<size_t>& locusPositions,
+      const std::string& method) const;
+
+  /**
+   * @throw IndexOutOfBoundsException if a locus position is out of range.
+   * @throw ZeroDivisionException if the locus is undefined.
+   */
+  void checkLocus_(size_t locusPosition, const std::string& method) const;
+};
+} // end of namespace bpp;
+
+#endif // _VARIANCECOMPONENTTABLE_H_
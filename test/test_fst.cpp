@@ -0,0 +1,118 @@
+// SPDX-FileCopyrightText: The Bio++ Development Group
+//
+// SPDX-License-Identifier: CECILL-2.1
+
+#include <Bpp/Seq/Alphabet/AlphabetTools.h>
+#include <Bpp/Seq/Container/SiteContainerTools.h>
+#include <Bpp/PopGen/CounterBasedGenerator.h>
+#include <Bpp/PopGen/PolymorphismSequenceContainer.h>
+#include <Bpp/PopGen/PolymorphismSequenceContainerTools.h>
+#include <Bpp/PopGen/SequenceStatistics.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+
+using namespace bpp;
+using namespace std;
+
+// fstHudson92 as computed before per-site counts were used: every pair of
+// sequences of the two populations is compared.
+double fstPairwise(const PolymorphismSequenceContainer& psc, size_t id1, size_t id2)
+{
+  auto pop1 = PolymorphismSequenceContainerTools::extractGroup(psc, id1);
+  auto pop2 = PolymorphismSequenceContainerTools::extractGroup(psc, id2);
+  double meanPiIntra = (SequenceStatistics::tajima83(*pop1, true) + SequenceStatistics::tajima83(*pop2, true)) / 2;
+  double diff = 0., n = 0.;
+  for (size_t i = 0; i < pop1->getNumberOfSequences(); ++i)
+  {
+    for (size_t j = 0; j < pop2->getNumberOfSequences(); ++j)
+    {
+      diff += SiteContainerTools::computeSimilarity(pop1->sequence(i), pop2->sequence(j), true, "no gap", true);
+      n++;
+    }
+  }
+  double piInter = (diff / n) * static_cast<double>(psc.getNumberOfSites());
+  return 1.0 - meanPiIntra / piInter;
+}
+
+// Random sequences in three groups, with a proportion of gaps and
+// unresolved states.
+unique_ptr<PolymorphismSequenceContainer> simulate(uint64_t seed, size_t nbSites, double missing)
+{
+  auto psc = make_unique<PolymorphismSequenceContainer>(AlphabetTools::DNA_ALPHABET);
+  CounterBasedGenerator generator(seed);
+  string ancestral(nbSites, 'A');
+  for (auto& c : ancestral)
+  {
+    c = "ACGT"[generator.drawInteger(4)];
+  }
+  for (size_t i = 0; i < 18; ++i)
+  {
+    string str = ancestral;
+    for (auto& c : str)
+    {
+      // Each group has its own mutation rate, so that Fst is not 0.
+      if (generator.drawUniform() < 0.05 * static_cast<double>(i % 3 + 1))
+        c = "ACGT"[generator.drawInteger(4)];
+      if (generator.drawUniform() < missing)
+        c = generator.drawUniform() < 0.5 ? '-' : 'N';
+    }
+    string name = "seq" + to_string(i);
+    auto seq = make_unique<Sequence>(name, str, AlphabetTools::DNA_ALPHABET);
+    psc->addSequence(name, seq);
+    psc->setGroupId(i, i % 3);
+  }
+  return psc;
+}
+
+bool check(const string& name, double expected, double observed)
+{
+  bool ok = abs(observed - expected) <= 1e-12 * max(1., abs(expected));
+  cout << name << ": " << expected << " " << observed << (ok ? "" : " FAILED") << endl;
+  return ok;
+}
+
+int main()
+{
+  bool ok = true;
+  for (double missing : {0., 0.02, 0.2})
+  {
+    for (uint64_t seed = 1; seed <= 5; ++seed)
+    {
+      auto psc = simulate(seed, 200, missing);
+      for (size_t id1 = 0; id1 < 3; ++id1)
+      {
+        for (size_t id2 = id1 + 1; id2 < 3; ++id2)
+        {
+          string name = "missing " + to_string(missing) + ", seed " + to_string(seed) + ", groups " + to_string(id1) + "-" + to_string(id2);
+          ok &= check(name, fstPairwise(*psc, id1, id2), SequenceStatistics::fstHudson92(*psc, id1, id2));
+        }
+      }
+    }
+  }
+
+  // Weighting sequences by their counts gives the same result as repeating them.
+  for (double missing : {0., 0.2})
+  {
+    auto psc = simulate(6, 150, missing);
+    PolymorphismSequenceContainer repeated(*psc);
+    for (size_t i = 0; i < psc->getNumberOfSequences(); ++i)
+    {
+      unsigned int count = static_cast<unsigned int>(i % 4 + 1);
+      psc->setSequenceCount(i, count);
+      for (unsigned int k = 1; k < count; ++k)
+      {
+        string name = psc->sequence(i).getName() + "_" + to_string(k);
+        auto seq = make_unique<Sequence>(name, psc->sequence(i).getContent(), AlphabetTools::DNA_ALPHABET);
+        repeated.addSequence(name, seq);
+        repeated.setGroupId(repeated.getNumberOfSequences() - 1, psc->getGroupId(i));
+      }
+    }
+    ok &= check("weighted, missing " + to_string(missing), SequenceStatistics::fstHudson92(repeated, 0, 1), SequenceStatistics::fstHudson92(*psc, 0, 1, true));
+  }
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,110 @@
+// SPDX-FileCopyrightText: The Bio++ Development Group
+//
+// SPDX-License-Identifier: CECILL-2.1
+
+#include <Bpp/PopGen/CounterBasedGenerator.h>
+#include <Bpp/PopGen/GenotypeMatrix.h>
+#include <Bpp/PopGen/PolymorphismMultiGContainerTools.h>
+
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <random>
+
+using namespace bpp;
+using namespace std;
+
+// Every allocation made by the program is counted.
+static size_t nbAllocations = 0;
+
+void* operator new(size_t size)
+{
+  nbAllocations++;
+  void* p = malloc(size > 0 ? size : 1);
+  if (!p)
+    throw bad_alloc();
+  return p;
+}
+
+void* operator new[](size_t size)
+{
+  return operator new(size);
+}
+
+void operator delete(void* p) noexcept
+{
+  free(p);
+}
+
+void operator delete[](void* p) noexcept
+{
+  free(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+  free(p);
+}
+
+void operator delete[](void* p, size_t) noexcept
+{
+  free(p);
+}
+
+// Run all the permutations of a genotype matrix many times with the same
+// target and workspace, and return the number of allocations.
+template<class URBG>
+size_t countAllocations(const GenotypeMatrix& source, GenotypeMatrix& target, PolymorphismMultiGContainerTools::PermutationWorkspace& workspace, URBG& generator)
+{
+  size_t before = nbAllocations;
+  for (size_t i = 0; i < 100; ++i)
+  {
+    PolymorphismMultiGContainerTools::permuteMultiG(source, target, workspace, generator);
+    PolymorphismMultiGContainerTools::permuteMonoG(source, target, workspace, generator);
+    PolymorphismMultiGContainerTools::permuteIntraGroupMonoG(source, target, workspace, generator);
+    PolymorphismMultiGContainerTools::permuteAlleles(source, target, workspace, generator);
+    PolymorphismMultiGContainerTools::permuteIntraGroupAlleles(source, target, workspace, generator);
+  }
+  return nbAllocations - before;
+}
+
+int main()
+{
+  // Diploid individuals in four groups, with missing and haploid genotypes.
+  size_t nbIndividuals = 500, nbLoci = 50;
+  GenotypeMatrix source(nbIndividuals, nbLoci, 2);
+  CounterBasedGenerator generator(1);
+  for (size_t i = 0; i < nbIndividuals; ++i)
+  {
+    source.setGroupId(i, i % 4);
+    for (size_t l = 0; l < nbLoci; ++l)
+    {
+      size_t r = static_cast<size_t>(generator.drawInteger(10));
+      size_t a1 = static_cast<size_t>(generator.drawInteger(6));
+      size_t a2 = static_cast<size_t>(generator.drawInteger(6));
+      if (r == 1)
+        source.setAlleleKeys(l, i, {a1});
+      else if (r > 1)
+        source.setAlleleKeys(l, i, {a1, a2});
+    }
+  }
+
+  bool ok = true;
+  GenotypeMatrix target(source);
+  PolymorphismMultiGContainerTools::PermutationWorkspace workspace(source, {0, 1, 3});
+  size_t nb = countAllocations(source, target, workspace, generator);
+  cout << "CounterBasedGenerator, all loci: " << nb << " allocations" << endl;
+  ok &= nb == 0;
+
+  PolymorphismMultiGContainerTools::PermutationWorkspace someLoci(source, {0, 2}, {1, 7, 30});
+  nb = countAllocations(source, target, someLoci, generator);
+  cout << "CounterBasedGenerator, some loci: " << nb << " allocations" << endl;
+  ok &= nb == 0;
+
+  mt19937 mt(1);
+  nb = countAllocations(source, target, workspace, mt);
+  cout << "std::mt19937, all loci: " << nb << " allocations" << endl;
+  ok &= nb == 0;
+
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}